@@ -22,7 +22,7 @@ Bola::Bola(const std::string& ruta, const Nivel* nivel) throw (Excepcion): Actor
 {
 	_estado_actual = "mover";
 	_velocidad = (f32)sqrt(_vx * _vx + _vy * _vy);
-	_direccion = (f32)acos((_velocidad * _velocidad + _vx * _vx - _vy * _vy )/(2 * _velocidad * _vx));
+	_direccion = trigonometria::angulo((s32)(_vx * trigonometria::UNIDAD), (s32)(_vy * trigonometria::UNIDAD));
 	parser->cargar(ruta);
 	_max_vel = (f32)parser->atributoF32("max_vel", parser->raiz());
 }
@@ -49,7 +49,7 @@ f32 Bola::maxVelocidad(void) const
 	return _max_vel;
 }
 
-f32 Bola::direccion(void) const
+u32 Bola::direccion(void) const
 {
 	return _direccion;
 }
@@ -57,14 +57,14 @@ f32 Bola::direccion(void) const
 void Bola::setVelocidad(f32 v)
 {
 	_velocidad = v;
-	_vx = _velocidad * sin(_direccion);
-	_vy = _velocidad * cos(_direccion);
+	_vx = _velocidad * trigonometria::seno(_direccion) / trigonometria::UNIDAD;
+	_vy = _velocidad * trigonometria::coseno(_direccion) / trigonometria::UNIDAD;
 }
 
-void Bola::setDireccion(f32 d)
+void Bola::setDireccion(u32 d)
 {
-	_direccion = d;
-	_vx = _velocidad * sin(_direccion);
-	_vy = _velocidad * cos(_direccion);
+	_direccion = d & (trigonometria::VUELTA - 1);
+	_vx = _velocidad * trigonometria::seno(_direccion) / trigonometria::UNIDAD;
+	_vy = _velocidad * trigonometria::coseno(_direccion) / trigonometria::UNIDAD;
 }
 
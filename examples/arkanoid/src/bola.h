@@ -26,10 +26,11 @@
 	 * @brief Representación de la bola con la que se destruyen los ladrillos.
 	 *
 	 * @details Esta clase deriva de la clase abstracta Actor, y gestiona la bola que destruye los ladrillos en el
-	 * juego. El movimiento de la bola consiste en un vector, representado por un ángulo respecto a la abscisa positiva
-	 * (0,infinito), y un módulo (que determina la velocidad de la bola). Según estos dos atributos del vector, se
-	 * calculan en el escenario los rebotes de la bola (ángulo y módulo nuevos), de tal manera que los cálculos se
-	 * resumen en operaciones relativamente sencillas de trigonometría. El vector, una vez calculados sus nuevos
+	 * juego. El movimiento de la bola consiste en un vector, representado por un ángulo (en unidades de
+	 * trigonometria::VUELTA partes por vuelta, a partir del eje vertical) y un módulo (que determina la velocidad de
+	 * la bola). Según estos dos atributos del vector, se calculan en el escenario los rebotes de la bola (ángulo y
+	 * módulo nuevos) con trigonometria::rebotar(), de tal manera que los cálculos se resumen en sumas y restas de
+	 * enteros. El vector, una vez calculados sus nuevos
 	 * atributos, se descompone en sus dos componentes horizontal y vertical, que se asignan a las velocidades
 	 * horizontal y vertical del actor bola, respectivamente.
 	 *
@@ -70,9 +71,9 @@
 
 			/**
 			 * Metodo consultor para el ángulo del vector de movimiento de la bola
-			 * @return Valor del ángulo del vector de movimiento de la bola
+			 * @return Valor del ángulo del vector de movimiento de la bola, entre 0 y trigonometria::VUELTA - 1
 			 */
-			f32 direccion(void) const;
+			u32 direccion(void) const;
 
 			/**
 			 * Metodo modificador para la velocidad (módulo del vector de movimiento) de la bola
@@ -82,9 +83,9 @@
 
 			/**
 			 * Metodo modificador para la dirección (ángulo del vector de movimiento) de la bola
-			 * @param d Nuevo valor del ángulo que tendrá el vector de movimiento de la bola.
+			 * @param d Nuevo valor del ángulo que tendrá el vector de movimiento de la bola; se reduce a una vuelta
 			 */
-			void setDireccion(f32 d);
+			void setDireccion(u32 d);
 
 		private:
 
@@ -92,9 +93,9 @@
 			// horizontal y vertical son, respectivamente, _vx y _vy.
 			f32 _velocidad;
 
-			// La direccion de la bola es el ángulo en radianes que forma su vector de movimiento
-			// respecto a unos ejes cartesianos
-			f32 _direccion;
+			// La direccion de la bola es el ángulo que forma su vector de movimiento respecto al eje vertical,
+			// en unidades de trigonometria::VUELTA partes por vuelta
+			u32 _direccion;
 
 			f32 _max_vel;
 	};
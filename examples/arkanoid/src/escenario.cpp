@@ -19,6 +19,15 @@
 #include "arkanoid.h"
 using namespace std;
 
+namespace
+{
+	// Direcciones de las normales de las superficies contra las que rebota la bola (la Y crece hacia abajo)
+	const u32 HACIA_ABAJO = 0;
+	const u32 HACIA_DERECHA = trigonometria::VUELTA / 4;
+	const u32 HACIA_ARRIBA = trigonometria::VUELTA / 2;
+	const u32 HACIA_IZQUIERDA = 3 * trigonometria::VUELTA / 4;
+}
+
 Escenario::Escenario(const std::string& ruta, const Arkanoid* juego) throw (Excepcion)
 : Nivel(ruta), _num_ladrillos(0), _multiplicador(1), _bola(NULL), _arkanoid(juego), _control(BOTONES)
 {
@@ -140,15 +149,15 @@ void Escenario::actualizarNpj(void)
 			{
 				// Colision horizontal derecha
 				if(_bola->x() + _bola->ancho() >= _x1)
-					_bola->setDireccion(_bola->direccion() + (M_PI/2.0 - _bola->direccion()) * 2.0 + M_PI);
+					_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_IZQUIERDA));
 
 				// Colision horizontal izquierda
 				else if(_bola->x() <= _x0)
-					_bola->setDireccion(_bola->direccion() + (3*M_PI/2.0 - _bola->direccion()) * 2.0 + M_PI);
+					_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_DERECHA));
 
 				// Colision vertical arriba
 				else if(_bola->y() <= _y0)
-					_bola->setDireccion(_bola->direccion() + (M_PI*2.0 - _bola->direccion()) * 2.0 + M_PI);
+					_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_ABAJO));
 
 				// Colision vertical abajo
 				else if(_bola->y() + _bola->alto() >= _y1)
@@ -161,18 +170,11 @@ void Escenario::actualizarNpj(void)
 
 				// Colision en diagonal
 				else
-					_bola->setDireccion(_bola->direccion() + M_PI);
+					_bola->setDireccion(_bola->direccion() + trigonometria::VUELTA / 2);
 
-				if(_bola != NULL)
-				{
-					// Asegurar que el ángulo de la bola no es mayor que 2PI o menor que cero
-					while(_bola->direccion() > M_PI*2.0)
-						_bola->setDireccion(_bola->direccion() - M_PI*2.0);
-					while(_bola->direccion() < 0.0)
-						_bola->setDireccion(_bola->direccion() + M_PI*2.0);
-					if(_bola->direccion() == M_PI/2.0)
-						_bola->setDireccion(_bola->direccion() + M_PI/10);
-				}
+				// Evitar que la bola quede moviéndose en horizontal
+				if(_bola != NULL and _bola->direccion() == HACIA_DERECHA)
+					_bola->setDireccion(_bola->direccion() + trigonometria::VUELTA / 20);
 			}
 			// Colision con la pala
 			else if(_bola != NULL and _bola->colision(*_pala))
@@ -182,16 +184,14 @@ void Escenario::actualizarNpj(void)
 				f32 centroBola = _bola->x() + _bola->ancho() / 2;
 				f32 centroPala = _pala->x() + _pala->ancho() / 2;
 				f32 lugarColision = (f32)(centroPala - centroBola) / (_pala->ancho() / 2);
-				f32 anguloBola = lugarColision * M_PI/6.0 + M_PI;
-				_bola->setDireccion(_bola->direccion() + (anguloBola - _bola->direccion()) * 2.0 + M_PI);
-				while(_bola->direccion() > M_PI*2.0)
-					_bola->setDireccion(_bola->direccion() - M_PI*2.0);
+				u32 normal = HACIA_ARRIBA + (s32)(lugarColision * trigonometria::VUELTA / 12);
+				_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), normal));
 
 				// Asegurar que la dirección de la bola no es demasiado horizontal
-				if(_bola->direccion() < (M_PI - (M_PI/2.0 - M_PI/6.0)))
-					_bola->setDireccion(M_PI - (M_PI/2.0 - M_PI/6.0));
-				else if(_bola->direccion() > (M_PI + (M_PI/2.0 - M_PI/6.0)))
-					_bola->setDireccion(M_PI + (M_PI/2.0 - M_PI/6.0));
+				if(_bola->direccion() < trigonometria::VUELTA / 3)
+					_bola->setDireccion(trigonometria::VUELTA / 3);
+				else if(_bola->direccion() > 2 * trigonometria::VUELTA / 3)
+					_bola->setDireccion(2 * trigonometria::VUELTA / 3);
 			}
 		}
 		// Si el actor es un ladrillo
@@ -210,24 +210,24 @@ void Escenario::actualizarNpj(void)
 				{
 					// La bola esta debajo del ladrillo
 					if(bola_y > ladrillo_y)
-						_bola->setDireccion(_bola->direccion() + (M_PI*2.0 - _bola->direccion()) * 2.0 + M_PI);
+						_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_ABAJO));
 					// La bola esta arriba del ladrillo
 					else
-						_bola->setDireccion(_bola->direccion() + (M_PI - _bola->direccion()) * 2.0 + M_PI);
+						_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_ARRIBA));
 				}
 				// La bola no esta en la vertical del ladrillo, esta en la horizontal
 				else if(bola_y >= (*i)->y() and bola_y <= (*i)->y() + (*i)->alto())
 				{
 					// La bola esta a la derecha del ladrillo
 					if(bola_x > ladrillo_x)
-						_bola->setDireccion(_bola->direccion() + (3*M_PI/2.0 - _bola->direccion()) * 2.0 + M_PI);
+						_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_DERECHA));
 					// La bola esta a la izquierda del ladrillo
 					else
-						_bola->setDireccion(_bola->direccion() + (M_PI/2.0 - _bola->direccion()) * 2.0 + M_PI);
+						_bola->setDireccion(trigonometria::rebotar(_bola->direccion(), HACIA_IZQUIERDA));
 				}
 				// Colision en diagonal
 				else
-					_bola->setDireccion(_bola->direccion() + M_PI);
+					_bola->setDireccion(_bola->direccion() + trigonometria::VUELTA / 2);
 
 				// Aumentar la velocidad si se elimina un ladrillo, pero no superar la velocidad maxima
 				if(_bola->velocidad() < _bola->maxVelocidad())
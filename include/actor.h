@@ -20,13 +20,17 @@
 
 	#include <gctypes.h>
 	#include <map>
+	#include <new>
 	#include <set>
 	#include <string>
 	#include <valarray>
+	#include <vector>
 	#include "animacion.h"
 	#include "colision.h"
 	#include "excepcion.h"
 	#include "galeria.h"
+	#include "mascara.h"
+	#include "memoria.h"
 	#include "parser.h"
 
 	class Nivel;
@@ -130,6 +134,20 @@
 	 * "normal", como ya se indicó anteriormente. Para más información sobre los parámetros de los constructores de
 	 * cajas de colisión o animaciones, consultar la documentación de cada una de estas clases.
 	 *
+	 * Una animación puede incluir, además, el atributo opcional paleta, con una lista de cambios de color de la forma
+	 * paleta="RRGGBBAA:RRGGBBAA,..." (color original y color nuevo, en hexadecimal). Si la imagen de la animación
+	 * está indexada (ver clase Imagen), la animación se dibuja con una variante de su paleta en la que se han
+	 * sustituido esos colores, sin duplicar la textura; así, varios enemigos pueden compartir una misma imagen con
+	 * colores distintos. Si la imagen no está indexada, el atributo no tiene efecto.
+	 *
+	 * El elemento colisiones puede incluir, además, el atributo opcional mascara="1". En ese caso, cuando las figuras
+	 * de colisión de dos actores se tocan, se comprueba además si se tocan los píxeles opacos de sus cuadros de
+	 * animación actuales, utilizando la máscara de colisión de cada imagen (ver clase Mascara), que se crea al cargar
+	 * las animaciones. Si sólo uno de los dos actores tiene máscara, se comprueba si algún píxel opaco suyo cae dentro
+	 * del rectángulo que contiene a la figura del otro (una mira con una figura punto, por ejemplo, sólo acierta si
+	 * apunta a un píxel opaco). Las figuras siguen siendo necesarias: hacen de primera comprobación, muy rápida, y la
+	 * máscara sólo se consulta cuando ésta tiene éxito.
+	 *
 	 * Por último, cabe destacar que al derivar la clase Actor, se le pueden añadir nuevos atributos y métodos según se
 	 * considere necesario, consiguiendo así partir de una base como es la propia clase Actor, pero pudiendo llegar a
 	 * la complejidad que se desee.
@@ -165,10 +183,11 @@
 			 * @param nivel Puntero constante al nivel en el que se mueve el actor.
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir un archivo
 			 * @throw CodigoEx Se lanza si se detectan dos animaciones para un mismo estado.
+			 * @throw ImagenEx Se lanza si sucede un error al cargar la imagen de una animación
 			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 * @throw XmlEx Se lanza si hay un error relacionado con un árbol XML
 			 */
-			Actor(const std::string& ruta, const Nivel* nivel) throw (ArchivoEx, CodigoEx, TarjetaEx, XmlEx);
+			Actor(const std::string& ruta, const Nivel* nivel) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx, XmlEx);
 
 			/**
 			 * Destructor virtual de la clase Actor. Libera la memoria ocupada por las cajas de colisión y por
@@ -176,6 +195,21 @@
 			 */
 			virtual ~Actor(void);
 
+			/**
+			 * Operador new de la clase Actor. Reserva la memoria de las instancias de Actor y de todas sus clases
+			 * derivadas con la etiqueta memoria::ACTORES, para llevar la cuenta de la memoria que ocupan los actores.
+			 * @param tam Tamaño en bytes de la instancia
+			 * @return Memoria reservada para la instancia
+			 * @throw std::bad_alloc Se lanza si no hay memoria suficiente
+			 */
+			static void* operator new(size_t tam) throw (std::bad_alloc);
+
+			/**
+			 * Operador delete de la clase Actor. Libera la memoria reservada con el operador new de la clase.
+			 * @param p Memoria de la instancia
+			 */
+			static void operator delete(void* p) throw ();
+
 			/**
 			 * Método consultor que devuelve el valor de la coordenada X actual del actor.
 			 * @return Coordenada X del actor.
@@ -307,7 +341,8 @@
 
 			/**
 			 * Método para saber si el actor al que pertenece la función colisiona con otro externo. Un actor
-			 * colisiona con otro si lo hacen entre sí, al menos, una figura de colisión de cada uno de ellos.
+			 * colisiona con otro si lo hacen entre sí, al menos, una figura de colisión de cada uno de ellos y, si
+			 * alguno de los dos utiliza máscara de colisión, también se tocan sus píxeles opacos.
 			 * @param a Actor externo con el que se quiere evaluar si hay colisión.
 			 * @return Verdadero si hay colisión entre los actores, y falso en caso contrario.
 			 */
@@ -329,20 +364,30 @@
 			 * @param ruta Ruta absoluta al archivo XML que contiene la información del actor.
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir un archivo
 			 * @throw CodigoEx Se lanza si se detectan dos animaciones para un mismo estado.
+			 * @throw ImagenEx Se lanza si sucede un error al cargar la imagen de una animación
 			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 * @throw XmlEx Se lanza si el árbol XML con los datos de la animación esuviera incompleto.
 			 */
-			void cargarDatosIniciales(const std::string& ruta) throw (ArchivoEx, TarjetaEx, CodigoEx, XmlEx);
+			void cargarDatosIniciales(const std::string& ruta) throw (ArchivoEx, TarjetaEx, CodigoEx, ImagenEx, XmlEx);
 
 			/**
 			 * Método que, a partir de un elemento de un árbol XML, lee las animaciones de un actor. Cada
 			 * animación se espera que tenga una serie de elementos en el árbol XML, y se asocia con un
-			 * estado concreto del actor. Un estado sólo puede tener una animación asociada.
+			 * estado concreto del actor. Un estado sólo puede tener una animación asociada. Cada imagen que se
+			 * utiliza en una animación queda retenida en la Galeria hasta que se destruye el actor.
 			 * @param nodo Elemento de un árbol XML que contiene las animaciones de un actor.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de una imagen
 			 * @throw CodigoEx Se lanza si se detectan dos animaciones para un mismo estado.
+			 * @throw ImagenEx Se lanza si sucede un error al cargar la imagen de una animación
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 * @throw XmlEx Se lanza si el árbol XML con los datos de la animación esuviera incompleto.
 			 */
-			void leerAnimaciones(TiXmlElement* nodo) throw (CodigoEx, XmlEx);
+			void leerAnimaciones(TiXmlElement* nodo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx, XmlEx);
+
+			/**
+			 * Método que libera en la Galeria todas las imágenes retenidas por las animaciones del actor.
+			 */
+			void liberarImagenes(void);
 
 			/**
 			 * Método que, a partir de un elemento de un árbol XML, lee las cajas de colisión de un actor. Cada
@@ -352,6 +397,30 @@
 			 */
 			void leerColisiones(TiXmlElement* nodo);
 
+			/**
+			 * Método que devuelve la animación del estado actual del actor, o la del estado normal si el estado
+			 * actual no tiene animación.
+			 * @return Referencia constante a la animación
+			 */
+			const Animacion& animacionActual(void) const;
+
+			/**
+			 * Método que devuelve el cuadro actual de la animación del actor dentro de la máscara de su imagen,
+			 * colocado en la posición que tendrá el actor tras su siguiente movimiento.
+			 * @return Cuadro de la máscara y su posición en el escenario
+			 */
+			Mascara::Cuadro cuadroMascara(void) const;
+
+			/**
+			 * Método que comprueba si algún píxel opaco del cuadro actual del actor cae dentro del rectángulo que
+			 * contiene a una figura de otro actor.
+			 * @param f Figura de colisión del otro actor
+			 * @param x Coordenada X del escenario a la que se desplaza la figura
+			 * @param y Coordenada Y del escenario a la que se desplaza la figura
+			 * @return Verdadero si hay algún píxel opaco dentro del rectángulo, falso en caso contrario
+			 */
+			bool contieneFigura(const Figura& f, s32 x, s32 y) const;
+
 			/**
 			 * Número de píxeles que se desplaza horizontalmente el actor en cada actualización 
 			 */
@@ -404,6 +473,11 @@
 			 */
 			bool _invertida;
 
+			/**
+			 * Indica si las colisiones del actor se comprueban también con la máscara de colisión de sus imágenes.
+			 */
+			bool _mascara;
+
 			/**
 			 * Diccionario de colisiones del actor, que asocia un estado con un conjunto de cajas de colisión.
 			 */
@@ -414,6 +488,11 @@
 			 */
 			Animaciones _map_animaciones;
 
+			/**
+			 * Códigos de las imágenes retenidas en la Galeria por las animaciones del actor.
+			 */
+			std::vector<std::string> _imagenes;
+
 			/**
 			 * Referencia al nivel en el que está participando el actor.
 			 */
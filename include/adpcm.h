@@ -0,0 +1,126 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _ADPCM_H_
+#define _ADPCM_H_
+
+	#include <cstring>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para codificar y decodificar sonido en formato IMA ADPCM de 4 bits.
+	 *
+	 * @details Un efecto de sonido en PCM de 16 bits ocupa cuatro veces más que el mismo efecto codificado en ADPCM
+	 * de 4 bits por muestra. Este espacio de nombres contiene el códec que utiliza la clase Sonido para reproducir
+	 * efectos comprimidos, y que también utiliza la herramienta pcm2adpcm (ver directorio tools) para convertir los
+	 * archivos PCM crudos en archivos ADPCM. Como no depende de ninguna biblioteca de la consola, el mismo código se
+	 * compila para la Wii y para el PC, de tal manera que codificador y decodificador nunca se desincronizan.
+	 *
+	 * Un archivo ADPCM de libWiiEsp comienza con una cabecera de 32 bytes (ver estructura Cabecera), seguida de una
+	 * serie de bloques independientes. Cada bloque contiene, para cada canal, el estado inicial del decodificador
+	 * (predicción de 16 bits en big endian, índice de paso de 8 bits y un byte de relleno), y a continuación las
+	 * muestras del bloque a 4 bits por muestra. En estéreo, cada byte guarda una muestra de cada canal (el canal
+	 * izquierdo en los 4 bits de mayor peso); en mono, cada byte guarda dos muestras consecutivas (la primera en los
+	 * 4 bits de mayor peso). Al ser independientes, los bloques se pueden decodificar de uno en uno en el momento de
+	 * la reproducción, sin necesidad de descomprimir el efecto completo en memoria.
+	 *
+	 * Todos los campos de la cabecera se almacenan en big endian, que es el orden nativo de la consola.
+	 *
+	 */
+	namespace adpcm
+	{
+		/**
+		 * Tamaño en bytes de la cabecera de un archivo ADPCM.
+		 */
+		static const u32 TAM_CABECERA = 32;
+
+		/**
+		 * Máximo número de muestras por canal que puede tener un bloque.
+		 */
+		static const u16 MAX_MUESTRAS_BLOQUE = 1024;
+
+		/**
+		 * @brief Cabecera de un archivo ADPCM, con sus campos ya convertidos al orden de bytes de la máquina.
+		 */
+		typedef struct cabecera
+		{
+			u8 version;
+			u8 canales;
+			u16 muestras_bloque;
+			u32 frecuencia;
+			u32 muestras;
+			u32 bloques;
+		} Cabecera;
+
+		/**
+		 * @brief Estado del codificador o decodificador para un canal.
+		 */
+		typedef struct estado
+		{
+			s16 prediccion;
+			u8 indice;
+		} Estado;
+
+		/**
+		 * Lee la cabecera de un archivo ADPCM desde memoria y comprueba que sea válida.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param tam Tamaño en bytes de la zona de memoria
+		 * @param c Cabecera donde se guardarán los campos leídos
+		 * @return Verdadero si la cabecera es válida, el número de bloques corresponde al de muestras y el archivo
+		 * contiene todos sus bloques, falso en caso contrario
+		 */
+		bool leerCabecera(const u8* datos, u32 tam, Cabecera& c);
+
+		/**
+		 * Escribe una cabecera de archivo ADPCM en memoria.
+		 * @param c Cabecera que se quiere escribir
+		 * @param destino Zona de memoria de, al menos, TAM_CABECERA bytes
+		 */
+		void escribirCabecera(const Cabecera& c, u8* destino);
+
+		/**
+		 * Calcula el tamaño en bytes de un bloque codificado.
+		 * @param canales Número de canales (1 o 2)
+		 * @param muestras_bloque Número de muestras por canal del bloque (número par)
+		 * @return Tamaño en bytes del bloque
+		 */
+		u32 tamBloque(u8 canales, u16 muestras_bloque);
+
+		/**
+		 * Codifica un bloque de muestras PCM de 16 bits con signo.
+		 * @param entrada Muestras PCM, entrelazadas si hay dos canales
+		 * @param canales Número de canales (1 o 2)
+		 * @param muestras Número de muestras por canal del bloque (número par)
+		 * @param estados Estado del codificador de cada canal, que se actualiza al codificar
+		 * @param bloque Zona de memoria de tamBloque() bytes donde se escribe el bloque codificado
+		 */
+		void codificarBloque(const s16* entrada, u8 canales, u16 muestras, Estado* estados, u8* bloque);
+
+		/**
+		 * Decodifica un bloque a muestras PCM de 16 bits con signo, en el orden de bytes de la máquina.
+		 * @param bloque Bloque codificado
+		 * @param canales Número de canales (1 o 2)
+		 * @param muestras Número de muestras por canal del bloque (número par)
+		 * @param salida Zona de memoria para muestras * canales valores de 16 bits, entrelazados si hay dos canales
+		 */
+		void decodificarBloque(const u8* bloque, u8 canales, u16 muestras, s16* salida);
+	}
+
+#endif
+
@@ -138,8 +138,11 @@
 			 * @param filas Número de filas en la rejilla de la imagen i
 			 * @param columnas Número de columnas en la rejilla de la imagen i
 			 * @param retardo Número de frames que tienen que pasar para que se produzca un avance en la animación
+			 * @param paleta Variante de la paleta de la imagen con la que se dibuja la animación, si la imagen está
+			 * indexada (ver Imagen::variante()); la variante 0 es la paleta original
 			 */
-			Animacion(const Imagen& i, const std::string& secuencia, u8 filas = 1, u8 columnas = 1, u8 retardo = 1);
+			Animacion(const Imagen& i, const std::string& secuencia, u8 filas = 1, u8 columnas = 1, u8 retardo = 1,
+						u8 paleta = 0);
 
 			/**
 			 * Indica si la animación se encuentra en el primer paso.
@@ -171,6 +174,18 @@
 			 */
 			const Imagen& imagen(void) const;
 
+			/**
+			 * Devuelve la columna de la imagen en la que comienza el cuadro del paso actual.
+			 * @return Columna, en píxeles, de la esquina superior izquierda del cuadro actual.
+			 */
+			u16 cuadroX(void) const;
+
+			/**
+			 * Devuelve la fila de la imagen en la que comienza el cuadro del paso actual.
+			 * @return Fila, en píxeles, de la esquina superior izquierda del cuadro actual.
+			 */
+			u16 cuadroY(void) const;
+
 			/**
 			 * Avanza al paso siguiente del actual. Si el actual es el último, se sitúa en el primero.
 			 */
@@ -194,7 +209,7 @@
 
 			const Imagen* _imagen;
 			u16 _ancho_cuadro, _alto_cuadro;
-			u8 _filas, _columnas, _paso, _retardo, _cont_retardo;
+			u8 _filas, _columnas, _paso, _retardo, _cont_retardo, _paleta;
 			std::vector<s8> _cuadros;
 	};
 
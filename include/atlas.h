@@ -0,0 +1,133 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _ATLAS_H_
+#define _ATLAS_H_
+
+	#include <vector>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que reparte rectángulos dentro de una página de textura, para agrupar varias imágenes en un atlas.
+	 *
+	 * @details Cada imagen de la galería es una textura independiente, y cambiar de textura entre dos dibujos obliga
+	 * al procesador gráfico a cargar un nuevo objeto de textura. Si las imágenes pequeñas de una escena (sprites,
+	 * ladrillos, objetos...) se agrupan en una o dos texturas grandes, llamadas páginas, la escena se dibuja casi sin
+	 * cambiar de textura, ya que la clase Screen no vuelve a cargar la textura que ya está cargada. Esta clase decide
+	 * dónde se coloca cada imagen dentro de una página; la herramienta agrupar (ver directorio tools) la utiliza para
+	 * construir las páginas en el PC, y la clase Galeria permite definir cada imagen como un recorte de una página
+	 * (ver clase Imagen). Igual que el códec ADPCM o LZ4, no depende de ninguna biblioteca de la consola y se compila
+	 * tanto para la Wii como para el PC, así que también se puede utilizar durante la carga de un juego.
+	 *
+	 * Se pueden dejar unos píxeles de margen alrededor de cada rectángulo, para que el filtrado lineal de la textura
+	 * no mezcle los bordes de una imagen con los de sus vecinas.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * El reparto sigue el algoritmo MaxRects: la clase mantiene la lista de los rectángulos libres máximos de la
+	 * página (los que no se pueden agrandar sin pisar algo ya colocado), que se pueden solapar entre sí. Cada nuevo
+	 * rectángulo se coloca en la esquina superior izquierda del rectángulo libre donde deja un lado sobrante más
+	 * corto (best short side fit). Después, cada rectángulo libre que se solape con el recién colocado se divide en
+	 * hasta cuatro rectángulos libres, los que quedan a su izquierda, a su derecha, encima y debajo, y se eliminan los
+	 * rectángulos libres contenidos en otros. Para aprovechar mejor la página, conviene colocar primero los
+	 * rectángulos más grandes.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * Atlas pagina(512, 512, 2);
+	 * Atlas::Rectangulo r;
+	 * if(pagina.colocar(64, 32, r))
+	 * {
+	 *   // Copiar la imagen de 64x32 píxeles a partir de (r.x, r.y)
+	 * }
+	 * @endcode
+	 *
+	 */
+	class Atlas
+	{
+		public:
+
+			/**
+			 * @brief Rectángulo de una página, en píxeles.
+			 */
+			typedef struct rectangulo
+			{
+				u16 x;
+				u16 y;
+				u16 ancho;
+				u16 alto;
+			} Rectangulo;
+
+			/**
+			 * Constructor de la clase Atlas. Crea una página vacía.
+			 * @param ancho Ancho en píxeles de la página
+			 * @param alto Alto en píxeles de la página
+			 * @param margen Píxeles libres que se dejan a la derecha y debajo de cada rectángulo
+			 */
+			Atlas(u16 ancho, u16 alto, u16 margen = 0);
+
+			/**
+			 * Método que busca sitio para un rectángulo en la página, y lo marca como ocupado.
+			 * @param ancho Ancho en píxeles del rectángulo
+			 * @param alto Alto en píxeles del rectángulo
+			 * @param r Variable donde se guarda la posición del rectángulo, si se ha podido colocar
+			 * @return Verdadero si el rectángulo se ha colocado, falso si no cabe en la página
+			 */
+			bool colocar(u16 ancho, u16 alto, Rectangulo& r);
+
+			/**
+			 * Método que deja la página vacía, como recién creada.
+			 */
+			void vaciar(void);
+
+			/**
+			 * Método consultor del número de píxeles ocupados de la página, sin contar los márgenes.
+			 * @return Número de píxeles ocupados
+			 */
+			u32 ocupados(void) const;
+
+			/**
+			 * Método consultor del ancho de la página.
+			 * @return Ancho en píxeles de la página
+			 */
+			u16 ancho(void) const;
+
+			/**
+			 * Método consultor del alto de la página.
+			 * @return Alto en píxeles de la página
+			 */
+			u16 alto(void) const;
+
+		private:
+
+			// Dividir los rectángulos libres que se solapan con uno recién ocupado
+			void ocupar(const Rectangulo& ocupado);
+			// Eliminar los rectángulos libres contenidos en otros
+			void podar(void);
+
+			std::vector<Rectangulo> _libres;
+			u32 _ocupados;
+			u16 _ancho;
+			u16 _alto;
+			u16 _margen;
+	};
+
+#endif
+
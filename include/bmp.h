@@ -0,0 +1,123 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _BMP_H_
+#define _BMP_H_
+
+	#include <cstring>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para decodificar mapas de bits (BMP) directamente en texturas RGB5A3 de la consola.
+	 *
+	 * @details La clase Imagen carga sus texturas desde archivos BMP sin comprimir. El procesador gráfico de la Wii
+	 * no trabaja con filas de píxeles, sino con tiles de 4x4 píxeles (ver clase Screen), así que decodificar un
+	 * bitmap consiste en leer sus píxeles, convertir cada uno de BGR a RGB5A3 (aplicando el color transparente) y
+	 * colocarlo en su posición dentro de su tile. Estas funciones hacen todo ello en una sola pasada sobre el archivo
+	 * ya leído en memoria, fila a fila, escribiendo cada grupo de 4 píxeles directamente en la fila de su tile, sin
+	 * una copia lineal intermedia que después haya que reorganizar.
+	 *
+	 * Se admiten bitmaps sin comprimir de 8 bits (con paleta), 24 bits (BGR) y 32 bits (BGRA), almacenados tanto de
+	 * abajo a arriba (lo habitual) como de arriba a abajo (alto negativo en la cabecera). En los de 32 bits, el canal
+	 * alpha sólo se tiene en cuenta si la cabecera lo declara con una máscara de bits; en ese caso, los píxeles
+	 * semitransparentes se codifican en el modo de 4 bits por componente y 3 de alpha de RGB5A3.
+	 *
+	 * Igual que el códec ADPCM o LZ4, este código no depende de ninguna biblioteca de la consola y se compila tanto
+	 * para la Wii como para el PC, de tal manera que la herramienta medirbmp (ver directorio tools) puede comprobar y
+	 * medir en el PC exactamente el mismo decodificador que utiliza la consola.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Los campos de las cabeceras se leen byte a byte en little endian, así que no hace falta tener en cuenta el
+	 * orden de bytes de la máquina. Para cada profundidad de color hay un núcleo de conversión que procesa una fila
+	 * en grupos de 4 píxeles (el ancho de un tile): los bitmaps de 8 bits convierten primero su paleta a una tabla de
+	 * 256 colores RGB5A3 (con el color transparente ya aplicado), y cada píxel es una consulta a esa tabla; los de 24
+	 * y 32 bits comparan cada píxel con el color transparente en una sola comparación de 24 bits. El destino de la
+	 * fila y de la columna se calcula una vez por grupo, y no una vez por píxel.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * bmp::Info info;
+	 * if(bmp::leerCabecera(datos, tam, info))
+	 * {
+	 *     u16* texels = (u16*)memoria::reservar(bmp::tamTextura(info), memoria::TEXTURAS);
+	 *     bmp::decodificar(datos, info, 0xFF00FFFF, texels);
+	 * }
+	 * @endcode
+	 *
+	 */
+	namespace bmp
+	{
+		/**
+		 * @brief Información de un mapa de bits, obtenida de sus cabeceras.
+		 */
+		typedef struct info
+		{
+			u16 ancho;				/**< Ancho en píxeles */
+			u16 alto;				/**< Alto en píxeles */
+			u16 bpp;				/**< Bits por píxel: 8, 24 o 32 */
+			bool invertida;			/**< Verdadero si las filas están almacenadas de abajo a arriba */
+			bool alpha;				/**< Verdadero si los píxeles de 32 bits tienen canal alpha */
+			u32 inicio;				/**< Posición del primer byte de píxeles en el archivo */
+			u32 paso;				/**< Bytes que ocupa cada fila en el archivo, incluido el relleno */
+			u32 colores;			/**< Número de colores de la paleta (sólo 8 bits) */
+			u32 paleta;				/**< Posición de la paleta en el archivo (sólo 8 bits) */
+		} Info;
+
+		/**
+		 * Lee las cabeceras de un mapa de bits que se encuentra en memoria y comprueba que sea un formato admitido,
+		 * que sus medidas sean múltiplo de 4 y que el archivo contenga todos sus píxeles.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param tam Tamaño en bytes del archivo
+		 * @param info Información donde se guardarán los datos leídos
+		 * @return Verdadero si el mapa de bits es válido y se puede decodificar, falso en caso contrario
+		 */
+		bool leerCabecera(const u8* datos, u32 tam, Info& info);
+
+		/**
+		 * Calcula el tamaño en bytes de la textura RGB5A3 de un mapa de bits.
+		 * @param info Información del mapa de bits
+		 * @return Tamaño en bytes de la textura
+		 */
+		u32 tamTextura(const Info& info);
+
+		/**
+		 * Decodifica los píxeles de un mapa de bits en una textura RGB5A3 organizada en tiles de 4x4 píxeles, lista
+		 * para el procesador gráfico.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param info Información del mapa de bits, obtenida con leerCabecera()
+		 * @param transparente Color que se considera transparente, en formato 0xRRGGBBAA (se ignora el alpha)
+		 * @param destino Zona de memoria de tamTextura() bytes donde se escribe la textura
+		 */
+		void decodificar(const u8* datos, const Info& info, u32 transparente, u16* destino);
+
+		/**
+		 * Convierte un color de 8 bits por componente a RGB5A3.
+		 * @param r Componente rojo
+		 * @param g Componente verde
+		 * @param b Componente azul
+		 * @param a Componente alpha (255 es opaco)
+		 * @return Color en formato RGB5A3
+		 */
+		u16 rgb5a3(u8 r, u8 g, u8 b, u8 a);
+	}
+
+#endif
+
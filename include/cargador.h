@@ -0,0 +1,337 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _CARGADOR_H_
+#define _CARGADOR_H_
+
+	#include <cstdlib>
+	#include <deque>
+	#include <map>
+	#include <string>
+	#include <vector>
+	#include <gctypes.h>
+	#include <gccore.h>
+	#include <tinyxml.h>
+	#include "excepcion.h"
+	#include "galeria.h"
+	#include "logger.h"
+	#include "manifiesto.h"
+	#include "parser.h"
+	#include "sdcard.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que carga recursos y niveles en segundo plano, mientras el juego sigue dibujando frames.
+	 *
+	 * @details Leer un recurso de la tarjeta SD y decodificarlo puede llevar bastante más tiempo que un frame, de
+	 * tal manera que, si se carga todo lo necesario para un nivel justo antes de comenzarlo, la pantalla se queda
+	 * congelada durante la carga. El Cargador realiza ese trabajo en un hilo aparte, y permite que el bucle principal
+	 * siga dibujando una pantalla de carga (con una barra de progreso, una animación, etc.) mientras tanto.
+	 *
+	 * Cada petición al Cargador devuelve un Futuro, un pequeño objeto que permite consultar si la petición ya ha
+	 * terminado, si ha fallado (y por qué), o esperar a que termine. Las peticiones pueden ser de dos tipos:
+	 *
+	 * - Un recurso de la galería, identificado por su tipo y su código. Cuando termina, el recurso queda cargado en
+	 * la galería exactamente igual que si se hubiera solicitado por primera vez, y la siguiente petición a la galería
+	 * lo encuentra ya en memoria.
+	 * - Un nivel, identificado por la ruta de su archivo TMX. El archivo se lee y se analiza en segundo plano, y se
+	 * entrega al Parser, de tal manera que el constructor de la clase Nivel no tiene que volver a leerlo. También se
+	 * construye en segundo plano el Manifiesto del nivel (lo que incluye leer los XML de sus actores), se reservan en
+	 * la galería todos sus recursos, para que no se descarten mientras tanto (por ejemplo, al destruir el nivel
+	 * anterior), y se piden automáticamente al Cargador. El constructor de la clase Nivel recoge después ese
+	 * manifiesto con entregarManifiesto(), en lugar de construirlo de nuevo.
+	 *
+	 * Los métodos progreso(), pendientes() y terminado() resumen el estado de todas las peticiones realizadas desde la
+	 * última vez que el Cargador quedó sin trabajo, incluidos los recursos pedidos automáticamente por un nivel, y son
+	 * los que debe consultar una pantalla de carga.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * El Cargador implementa el patrón Singleton. La primera petición crea el hilo de carga (un hilo LWP de la libOgc),
+	 * que atiende las peticiones de una en una desde una cola protegida por un mutex, y duerme en una variable de
+	 * condición mientras la cola está vacía. El hilo de carga tiene menos prioridad que el hilo principal, así que sólo
+	 * avanza mientras el hilo principal está bloqueado (por ejemplo, esperando el retrazo vertical en Screen::flip()),
+	 * y no le roba tiempo a los frames.
+	 *
+	 * El hilo de carga sólo hace el trabajo que no necesita el procesador gráfico ni modifica el estado compartido
+	 * de la biblioteca: leer los archivos, decodificar los píxeles de las imágenes en memoria alineada y analizar el
+	 * XML de los niveles. No escribe en el log ni toca la galería. Cada petición terminada pasa a una segunda cola, y
+	 * el método actualizar(), que se ejecuta en el hilo principal, completa el trabajo: crea las texturas de las
+	 * imágenes (ver Imagen::crearTextura()) y las caras de las fuentes, entrega los recursos a la galería y los
+	 * documentos al Parser, y escribe los errores en el log. La clase Juego llama a actualizar() una vez por frame,
+	 * así que normalmente no es necesario llamarlo a mano.
+	 *
+	 * Si no se puede crear el hilo de carga, el Cargador sigue funcionando, pero cada petición se atiende en el
+	 * momento de realizarla, como si se cargara sin él.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // Pedir el siguiente nivel y la fuente del marcador
+	 * Cargador::Futuro nivel = cargador->nivel("/apps/wiipang/niveles/nivel2.tmx");
+	 * cargador->recurso(Galeria::FUENTE, "arial");
+	 * // En cada frame de la pantalla de carga, dibujar una barra proporcional al progreso
+	 * screen->dibujarLinea(100, 310, 100 + cargador->progreso() * 440, 310, 1, 20, 0xFFFFFFFF);
+	 * // Cuando todo haya terminado, crear el nivel; el TMX y sus imágenes ya están en memoria
+	 * if(cargador->terminado() and not nivel.fallido())
+	 *     _nivel = new MiNivel("/apps/wiipang/niveles/nivel2.tmx");
+	 * @endcode
+	 *
+	 */
+	class Cargador
+	{
+		public:
+
+			/**
+			 * @brief Objeto que representa el resultado de una petición al Cargador.
+			 * @details Un Futuro se puede copiar libremente. Un Futuro construido por defecto no corresponde a
+			 * ninguna petición, y se considera terminado y sin errores.
+			 */
+			class Futuro
+			{
+				public:
+
+					/**
+					 * Constructor por defecto, que crea un Futuro sin petición asociada.
+					 */
+					Futuro(void): _id(0) { };
+
+					/**
+					 * Método que indica si la petición ha terminado, con éxito o sin él.
+					 * @return Verdadero si el hilo principal ya ha completado la petición, falso en caso contrario
+					 */
+					bool listo(void) const;
+
+					/**
+					 * Método que indica si la petición ha terminado con un error.
+					 * @return Verdadero si la petición ha fallado, falso en caso contrario
+					 */
+					bool fallido(void) const;
+
+					/**
+					 * Método consultor del mensaje de error de una petición fallida.
+					 * @return Mensaje de error, o una cadena vacía si la petición no ha fallado
+					 */
+					std::string error(void) const;
+
+					/**
+					 * Método que bloquea el hilo principal hasta que la petición haya terminado.
+					 */
+					void esperar(void) const;
+
+				private:
+
+					friend class Cargador;
+
+					Futuro(u32 id): _id(id) { };
+
+					u32 _id;
+			};
+
+			/**
+			 * Prioridad del hilo de carga, menor que la del hilo principal de la libOgc.
+			 */
+			static const u8 PRIORIDAD = 40;
+
+			/**
+			 * Tamaño en bytes de la pila del hilo de carga.
+			 */
+			static const u32 TAM_PILA = 64 * 1024;
+
+			/**
+			 * Función estática que devuelve la instancia activa del Cargador y, si no existe ninguna, la crea.
+			 * @return Puntero a la instancia activa del Cargador
+			 */
+			static Cargador* get_instance(void)
+			{
+				if(_instance == 0)
+				{
+					_instance = new Cargador();
+					atexit(destroy);
+				}
+				return _instance;
+			}
+
+			/**
+			 * Función estática que destruye la instancia activa del Cargador, llamando a su destructor.
+			 */
+			static void destroy(void)
+			{
+				delete _instance;
+				_instance = 0;
+			}
+
+			/**
+			 * Método que pide la carga en segundo plano de un recurso de la galería. Si el recurso ya está cargado,
+			 * el Futuro devuelto ya está terminado; si ya se había pedido, se devuelve el Futuro de esa petición.
+			 * @param tipo Tipo del recurso
+			 * @param codigo Código del recurso en la galería
+			 * @return Futuro de la petición
+			 * @throw CodigoEx Se lanza si el código no está registrado en la galería
+			 */
+			Futuro recurso(Galeria::Tipo tipo, const std::string& codigo) throw (CodigoEx);
+
+			/**
+			 * Método que pide la lectura en segundo plano del archivo TMX de un nivel y de su manifiesto, y después
+			 * la de todos los recursos del manifiesto.
+			 * @param ruta Ruta absoluta hasta el archivo TMX, tal y como se pasará al constructor del nivel
+			 * @return Futuro de la petición del archivo TMX
+			 */
+			Futuro nivel(const std::string& ruta);
+
+			/**
+			 * Método que entrega el manifiesto de un nivel pedido con nivel(), con sus recursos reservados en la
+			 * galería. Si la petición del nivel aún no ha terminado, espera a que lo haga. Lo utiliza el constructor
+			 * de la clase Nivel.
+			 * @param ruta Ruta absoluta hasta el archivo TMX, tal y como se pasó a nivel()
+			 * @param m Manifiesto donde se copia el del nivel, si existe
+			 * @return Verdadero si se ha entregado el manifiesto, falso si el nivel no se ha pedido (o ha fallado)
+			 */
+			bool entregarManifiesto(const std::string& ruta, Manifiesto& m);
+
+			/**
+			 * Método que completa en el hilo principal las peticiones que el hilo de carga ya ha terminado. Lo llama
+			 * la clase Juego una vez por frame.
+			 */
+			void actualizar(void);
+
+			/**
+			 * Método que bloquea el hilo principal hasta que terminen todas las peticiones pendientes.
+			 */
+			void esperar(void);
+
+			/**
+			 * Método que indica si no queda ninguna petición pendiente.
+			 * @return Verdadero si todas las peticiones han terminado, falso en caso contrario
+			 */
+			bool terminado(void) const;
+
+			/**
+			 * Método consultor del progreso de las peticiones realizadas desde que el Cargador quedó sin trabajo.
+			 * @return Fracción de peticiones terminadas, entre 0 y 1 (1 si no hay peticiones)
+			 */
+			f32 progreso(void) const;
+
+			/**
+			 * Método consultor del número de peticiones pendientes.
+			 * @return Número de peticiones que aún no han terminado
+			 */
+			u32 pendientes(void) const;
+
+		protected:
+
+			/**
+			 * Constructor de la clase Cargador. Se encuentra en la zona protegida debido a la implementación del
+			 * patrón Singleton.
+			 */
+			Cargador(void);
+
+			/**
+			 * Destructor de la clase Cargador. Detiene el hilo de carga y libera todo lo que no se haya entregado.
+			 */
+			~Cargador(void);
+
+			/**
+			 * Constructor de copia protegido, para evitar la copia de la instancia.
+			 * @param c Cargador a copiar
+			 */
+			Cargador(const Cargador& c);
+
+			/**
+			 * Operador de asignación protegido, para evitar la copia de la instancia.
+			 * @param c Cargador a asignar
+			 * @return Referencia al Cargador
+			 */
+			Cargador& operator=(const Cargador& c);
+
+		private:
+
+			// La galería espera a los recursos pendientes cuando se le solicitan
+			friend class Galeria;
+			friend class Futuro;
+
+			// Estados de una petición
+			enum Estado { ESPERA, HECHO, FALLO };
+
+			// Petición de carga; los campos de resultado los rellena el hilo de carga
+			typedef struct trabajo
+			{
+				u32 id;
+				bool nivel;
+				Galeria::Tipo tipo;
+				std::string codigo;
+				std::string ruta;
+				u8 volumen;
+				u8 prioridad;
+				u8 instancias;
+				Estado estado;
+				std::string error;
+				void* recurso;
+				u8* datos;
+				u32 tam;
+				TiXmlDocument* doc;
+				Manifiesto* manifiesto;
+			} Trabajo;
+
+			typedef std::map<u32, Trabajo*> Trabajos;
+			typedef std::map<std::string, Manifiesto*> Manifiestos;
+
+			// Registrar una petición y entregarla al hilo de carga
+			Futuro encolar(Trabajo* t);
+			// Crear el hilo de carga, si no existe
+			void iniciar(void);
+			// Bucle del hilo de carga
+			static void* hilo(void* cargador);
+			void trabajar(void);
+			// Trabajo de una petición que se realiza en el hilo de carga; nunca lanza excepciones
+			void ejecutar(Trabajo* t);
+			// Trabajo de una petición terminada que se realiza en el hilo principal
+			void completar(Trabajo* t);
+			// Liberar los resultados que una petición no haya entregado
+			void descartar(Trabajo* t);
+			// Esperar a una petición concreta, o a la petición de un recurso de la galería
+			void esperar(u32 id);
+			void esperarRecurso(Galeria::Tipo tipo, const std::string& codigo);
+			// Esperar a que el hilo de carga termine alguna petición
+			void dormir(void);
+
+			static Cargador* _instance;
+
+			// Estado del hilo principal
+			Trabajos _trabajos;
+			Manifiestos _manifiestos;
+			std::map<u32, std::string> _errores;
+			u32 _ultimo;
+			u32 _pedidos;
+			u32 _completados;
+			bool _sincrono;
+
+			// Estado compartido con el hilo de carga, protegido por el mutex
+			std::deque<Trabajo*> _cola;
+			std::vector<Trabajo*> _terminados;
+			bool _salir;
+
+			lwp_t _hilo;
+			mutex_t _mutex;
+			cond_t _hay_trabajo;
+			cond_t _hay_terminados;
+	};
+
+	#define cargador Cargador::get_instance()
+
+#endif
+
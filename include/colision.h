@@ -150,6 +150,17 @@
 			 */
 			virtual bool hayColision(Rectangulo* f, s16 dx1, s16 dy1, s16 dx2, s16 dy2) = 0;
 
+			/**
+			 * Método virtual puro que calcula el rectángulo, con los bordes incluidos, que contiene a la figura, en
+			 * coordenadas relativas a la posición del actor. La clase Actor lo utiliza para comprobar una figura con
+			 * la máscara de colisión de otro actor (ver clase Mascara).
+			 * @param x0 Columna del borde izquierdo
+			 * @param y0 Fila del borde superior
+			 * @param x1 Columna del borde derecho
+			 * @param y1 Fila del borde inferior
+			 */
+			virtual void caja(s32& x0, s32& y0, s32& x1, s32& y1) const = 0;
+
 			/**
 			 * Destructor virtual de la clase Figura.
 			 */
@@ -245,6 +256,15 @@
 			 */
 			bool hayColision(Punto* p, s16 dx1, s16 dy1, s16 dx2, s16 dy2) { return false; }
 
+			/**
+			 * Método que calcula el rectángulo, con los bordes incluidos, que contiene al punto.
+			 * @param x0 Columna del borde izquierdo
+			 * @param y0 Fila del borde superior
+			 * @param x1 Columna del borde derecho
+			 * @param y1 Fila del borde inferior
+			 */
+			void caja(s32& x0, s32& y0, s32& x1, s32& y1) const { x0 = x1 = _x; y0 = y1 = _y; };
+
 			/**
 			 * Método modificador que devuelve una referencia a la coordenada X del punto.
 			 * @return Referencia a la coordenada X del punto.
@@ -351,6 +371,15 @@
 			 */
 			bool hayColision(Punto* p, s16 dx1, s16 dy1, s16 dx2, s16 dy2);
 
+			/**
+			 * Método que calcula el rectángulo, con los bordes incluidos, que contiene al rectángulo.
+			 * @param x0 Columna del borde izquierdo
+			 * @param y0 Fila del borde superior
+			 * @param x1 Columna del borde derecho
+			 * @param y1 Fila del borde inferior
+			 */
+			void caja(s32& x0, s32& y0, s32& x1, s32& y1) const;
+
 			/**
 			 * Método modificador que devuelve una referencia al punto superior izquierdo del rectángulo
 			 * @return Referencia al punto superior izquierdo del rectángulo
@@ -485,6 +514,15 @@
 			 */
 			bool hayColision(Punto* p, s16 dx1, s16 dy1, s16 dx2, s16 dy2);
 
+			/**
+			 * Método que calcula el rectángulo, con los bordes incluidos, que contiene al círculo.
+			 * @param x0 Columna del borde izquierdo
+			 * @param y0 Fila del borde superior
+			 * @param x1 Columna del borde derecho
+			 * @param y1 Fila del borde inferior
+			 */
+			void caja(s32& x0, s32& y0, s32& x1, s32& y1) const;
+
 			/**
 			 * Método modificador que devuelve una referencia al centro del circulo
 			 * @return Referencia al centro del circulo
@@ -0,0 +1,179 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _CONTADORES_H_
+#define _CONTADORES_H_
+
+	#include <cstring>
+	#include <string>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que cuenta, frame a frame, el trabajo que se le pide al procesador gráfico.
+	 *
+	 * @details El tiempo que tarda un frame en dibujarse depende sobre todo de cuántas órdenes recibe el procesador
+	 * gráfico, y no de lo que se ve en pantalla: un texto dibujado punto a punto o un nivel con cientos de tiles
+	 * pueden parecer escenas sencillas y, sin embargo, costar miles de bloques de vértices y de cambios de estado. La
+	 * clase Screen tiene un objeto de esta clase (ver Screen::contadores()) y, en cada una de sus funciones de dibujo
+	 * y de cambio de estado, suma uno a los contadores correspondientes:
+	 *
+	 * - DIBUJOS: llamadas a las funciones de dibujo de Screen (dibujarTextura(), dibujarCuadro(), dibujarPunto()...).
+	 * - BLOQUES: bloques de vértices enviados al procesador gráfico (GX_Begin).
+	 * - VERTICES: vértices enviados dentro de esos bloques.
+	 * - TEXTURAS: objetos de textura cargados (GX_LoadTexObj); no cuenta los que ya estaban cargados.
+	 * - PALETAS: paletas cargadas (GX_LoadTlut).
+	 * - CONFIGURACIONES: reconfiguraciones de la TEV y de los descriptores de vértices, al pasar de dibujar color a
+	 * dibujar texturas o viceversa.
+	 *
+	 * Al final de cada frame (Screen::flip()), los contadores del frame se guardan en un historial de los últimos
+	 * HISTORIA frames, del que se obtienen el mínimo, la media y el máximo de cada contador, y se ponen a cero. El
+	 * método informe() resume todo en un texto, que Screen::informe() vuelca en el log del sistema.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Esta clase sólo suma enteros: no depende de ninguna biblioteca de la consola, y se compila tanto para la Wii
+	 * como para el PC (igual que el códec ADPCM o LZ4), de forma que cualquier código que sustituya a Screen fuera de
+	 * la consola puede llevar exactamente las mismas cuentas y compararlas con las esperadas. El historial es un
+	 * buffer circular de HISTORIA frames; el mínimo, la media y el máximo se calculan al consultarlos.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // Volcar en el log el resumen de los últimos frames al pulsar un botón
+	 * if(mando->pulsado("menos"))
+	 *   screen->informe();
+	 *
+	 * // O consultar un contador concreto
+	 * if(screen->contadores().ultimo(Contadores::BLOQUES) > 1000)
+	 *   logger->aviso("Demasiados bloques de vértices en el último frame");
+	 * @endcode
+	 *
+	 */
+	class Contadores
+	{
+		public:
+
+			/**
+			 * Contadores disponibles.
+			 */
+			typedef enum contador
+			{
+				DIBUJOS,
+				BLOQUES,
+				VERTICES,
+				TEXTURAS,
+				PALETAS,
+				CONFIGURACIONES,
+				NUM_CONTADORES
+			} Contador;
+
+			/**
+			 * Número de frames que guarda el historial.
+			 */
+			static const u32 HISTORIA = 64;
+
+			/**
+			 * Constructor de la clase Contadores. Crea los contadores a cero y el historial vacío.
+			 */
+			Contadores(void);
+
+			/**
+			 * Método que suma una cantidad a un contador del frame en curso.
+			 * @param c Contador al que se suma
+			 * @param n Cantidad que se suma
+			 */
+			void sumar(Contador c, u32 n = 1)
+			{
+				_actual[c] += n;
+			}
+
+			/**
+			 * Método que da por terminado el frame en curso: guarda sus contadores en el historial y los pone a cero.
+			 */
+			void cerrarFrame(void);
+
+			/**
+			 * Método que vacía el historial y pone a cero los contadores del frame en curso.
+			 */
+			void reiniciar(void);
+
+			/**
+			 * Método consultor de un contador del frame en curso.
+			 * @param c Contador que se quiere consultar
+			 * @return Valor del contador desde el comienzo del frame
+			 */
+			u32 actual(Contador c) const;
+
+			/**
+			 * Método consultor de un contador del último frame terminado.
+			 * @param c Contador que se quiere consultar
+			 * @return Valor del contador en el último frame, o cero si aún no ha terminado ninguno
+			 */
+			u32 ultimo(Contador c) const;
+
+			/**
+			 * Método consultor del valor mínimo de un contador en los frames del historial.
+			 * @param c Contador que se quiere consultar
+			 * @return Valor mínimo, o cero si el historial está vacío
+			 */
+			u32 minimo(Contador c) const;
+
+			/**
+			 * Método consultor del valor medio de un contador en los frames del historial.
+			 * @param c Contador que se quiere consultar
+			 * @return Valor medio, o cero si el historial está vacío
+			 */
+			u32 medio(Contador c) const;
+
+			/**
+			 * Método consultor del valor máximo de un contador en los frames del historial.
+			 * @param c Contador que se quiere consultar
+			 * @return Valor máximo, o cero si el historial está vacío
+			 */
+			u32 maximo(Contador c) const;
+
+			/**
+			 * Método consultor del número de frames que hay en el historial.
+			 * @return Número de frames, como mucho HISTORIA
+			 */
+			u32 frames(void) const;
+
+			/**
+			 * Función que obtiene el nombre de un contador.
+			 * @param c Contador
+			 * @return Nombre del contador, en minúsculas
+			 */
+			static const char* nombre(Contador c);
+
+			/**
+			 * Método que resume el historial en un texto, con una línea por contador: su nombre, su valor en el último
+			 * frame, y su mínimo, media y máximo en el historial.
+			 * @return Texto del resumen, sin salto de línea al final
+			 */
+			std::string informe(void) const;
+
+		private:
+
+			u32 _actual[NUM_CONTADORES];
+			u32 _historia[HISTORIA][NUM_CONTADORES];
+			u32 _frames;
+	};
+
+#endif
+
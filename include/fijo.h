@@ -0,0 +1,260 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _FIJO_H_
+#define _FIJO_H_
+
+	#include <gctypes.h>
+	#include "trigonometria.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que representa un número en coma fija de 16.16 bits.
+	 *
+	 * @details El procesador de la Wii calcula con números reales bastante deprisa, pero las funciones matemáticas de
+	 * la biblioteca estándar (sqrt(), sin(), pow()...) se calculan en doble precisión y por software, y son lentas
+	 * para llamarlas muchas veces en cada frame. Además, un cálculo con números reales no da exactamente el mismo
+	 * resultado en la consola y en el PC, así que no se puede comprobar fuera de la consola. Un número de la clase
+	 * Fijo es un entero de 32 bits con 16 bits de parte entera (con signo) y 16 bits de parte fraccionaria, es decir,
+	 * el número multiplicado por UNO (65536): se suma y se resta como un entero, y se multiplica y se divide con un
+	 * entero de 64 bits y un desplazamiento. Sirve para valores entre -32768 y 32767, con una precisión de 1/65536,
+	 * más que suficiente para posiciones y velocidades en píxeles.
+	 *
+	 * La raíz cuadrada y el inverso (1/x) se calculan sólo con operaciones enteras, y la clase VectorFijo reúne las
+	 * operaciones habituales con vectores (producto escalar, módulo, normalización y reflexión), junto con las
+	 * funciones del grupo trigonometria para pasar de un ángulo a un vector y viceversa.
+	 *
+	 * Igual que el grupo trigonometria, este código no depende de ninguna biblioteca de la consola y se compila tanto
+	 * para la Wii como para el PC, así que la herramienta medirfijo (ver directorio tools) comprueba en el PC su
+	 * precisión y su velocidad, comparándolo con las funciones de la biblioteca estándar.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * No hay conversiones implícitas desde enteros ni desde reales: un Fijo se construye siempre con desdeEntero(),
+	 * desdeReal() o desdeBruto() (a partir de su valor ya multiplicado por UNO), para que un entero no se confunda
+	 * nunca con un valor en coma fija. La multiplicación y la división redondean hacia menos infinito, como el
+	 * desplazamiento de bits.
+	 *
+	 * La raíz cuadrada y el inverso normalizan el valor (con la instrucción que cuenta los ceros a la izquierda),
+	 * toman una primera aproximación de una tabla pequeña, interpolando entre sus dos valores más cercanos, y la
+	 * refinan con un paso de Newton-Raphson, en el que sólo se multiplica. La raíz corrige después la última unidad,
+	 * así que es exacta (redondeada hacia abajo) en los 16 bits de fracción; el inverso no, y se equivoca, como
+	 * mucho, en la última unidad. El procesador de la consola no calcula raíces ni divide enteros de 64 bits (el
+	 * operador / llama a una función de la biblioteca de C), así que el inverso es bastante más rápido cuando se
+	 * dividen varios valores pequeños entre el mismo número.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // Posición y velocidad de una bola en coma fija
+	 * VectorFijo posicion(Fijo::desdeEntero(320), Fijo::desdeEntero(240));
+	 * VectorFijo velocidad = VectorFijo::polar(trigonometria::VUELTA / 8, Fijo::desdeReal(4.5f));
+	 *
+	 * // En cada frame
+	 * posicion += velocidad;
+	 * if(posicion.x >= Fijo::desdeEntero(640))
+	 *   velocidad = velocidad.reflejar(VectorFijo(Fijo::desdeEntero(-1), Fijo()));
+	 * screen->dibujarCirculo(posicion.x.entero(), posicion.y.entero(), 1, 4, 0xFFFFFFFF);
+	 * @endcode
+	 *
+	 */
+	class Fijo
+	{
+		public:
+
+			/**
+			 * Bits de la parte fraccionaria.
+			 */
+			static const u32 BITS = 16;
+
+			/**
+			 * Valor bruto que representa al 1.
+			 */
+			static const s32 UNO = 65536;
+
+			/**
+			 * Constructor de la clase Fijo. Crea un número con valor 0.
+			 */
+			Fijo(void): _v(0) { };
+
+			/**
+			 * Crea un número a partir de su valor bruto, es decir, del número multiplicado por UNO.
+			 * @param v Valor bruto
+			 * @return Número en coma fija
+			 */
+			static Fijo desdeBruto(s32 v) { Fijo f; f._v = v; return f; };
+
+			/**
+			 * Crea un número a partir de un entero.
+			 * @param n Entero, entre -32768 y 32767
+			 * @return Número en coma fija
+			 */
+			static Fijo desdeEntero(s32 n) { return desdeBruto(n * UNO); };
+
+			/**
+			 * Crea un número a partir de un real, redondeando al valor en coma fija más cercano.
+			 * @param r Real, entre -32768 y 32767
+			 * @return Número en coma fija
+			 */
+			static Fijo desdeReal(f32 r) { return desdeBruto((s32)(r * UNO + (r < 0 ? -0.5f : 0.5f))); };
+
+			/**
+			 * Método consultor del valor bruto del número.
+			 * @return Número multiplicado por UNO
+			 */
+			s32 bruto(void) const { return _v; };
+
+			/**
+			 * Método que obtiene la parte entera del número, redondeando hacia menos infinito.
+			 * @return Parte entera del número
+			 */
+			s32 entero(void) const { return _v >> BITS; };
+
+			/**
+			 * Método que obtiene el entero más cercano al número.
+			 * @return Número redondeado
+			 */
+			s32 redondear(void) const { return (_v + UNO / 2) >> BITS; };
+
+			/**
+			 * Método que convierte el número en un real.
+			 * @return Número real
+			 */
+			f32 real(void) const { return (f32)_v / UNO; };
+
+			/**
+			 * Método que calcula la raíz cuadrada del número, redondeada hacia abajo.
+			 * @return Raíz cuadrada del número, o 0 si el número es negativo
+			 */
+			Fijo raiz(void) const;
+
+			/**
+			 * Método que calcula el inverso del número (1/x), con un error de una unidad bruta como mucho.
+			 * @return Inverso del número; si no cabe en un Fijo (el número es 0 o está muy cerca de 0), el mayor o el
+			 * menor valor representable, con el signo del número
+			 */
+			Fijo inverso(void) const;
+
+			Fijo operator-(void) const { return desdeBruto(-_v); };
+			Fijo operator+(const Fijo& f) const { return desdeBruto(_v + f._v); };
+			Fijo operator-(const Fijo& f) const { return desdeBruto(_v - f._v); };
+			Fijo operator*(const Fijo& f) const { return desdeBruto((s32)(((s64)_v * f._v) >> BITS)); };
+			Fijo operator/(const Fijo& f) const { return desdeBruto((s32)(((s64)_v << BITS) / f._v)); };
+			Fijo& operator+=(const Fijo& f) { _v += f._v; return *this; };
+			Fijo& operator-=(const Fijo& f) { _v -= f._v; return *this; };
+			Fijo& operator*=(const Fijo& f) { return (*this = *this * f); };
+			Fijo& operator/=(const Fijo& f) { return (*this = *this / f); };
+			bool operator==(const Fijo& f) const { return _v == f._v; };
+			bool operator!=(const Fijo& f) const { return _v != f._v; };
+			bool operator<(const Fijo& f) const { return _v < f._v; };
+			bool operator<=(const Fijo& f) const { return _v <= f._v; };
+			bool operator>(const Fijo& f) const { return _v > f._v; };
+			bool operator>=(const Fijo& f) const { return _v >= f._v; };
+
+		private:
+
+			s32 _v;
+	};
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que representa un vector de dos dimensiones con componentes en coma fija.
+	 *
+	 * @details Las componentes son públicas, como las de un punto. Las direcciones siguen el criterio del grupo
+	 * trigonometria: el vector de dirección a es (seno(a), coseno(a)), y angulo() obtiene la dirección de un vector.
+	 * El módulo se calcula con 64 bits, así que no se desborda aunque el cuadrado del módulo no quepa en un Fijo.
+	 *
+	 */
+	class VectorFijo
+	{
+		public:
+
+			/**
+			 * Constructor de la clase VectorFijo.
+			 * @param vx Componente horizontal
+			 * @param vy Componente vertical
+			 */
+			VectorFijo(Fijo vx = Fijo(), Fijo vy = Fijo()): x(vx), y(vy) { };
+
+			/**
+			 * Crea un vector a partir de su dirección y su módulo.
+			 * @param angulo Dirección del vector, en unidades de trigonometria::VUELTA partes por vuelta
+			 * @param modulo Módulo del vector
+			 * @return Vector
+			 */
+			static VectorFijo polar(u32 angulo, Fijo modulo) {
+				return VectorFijo(Fijo::desdeBruto((s32)(((s64)modulo.bruto() * trigonometria::seno(angulo))
+															/ trigonometria::UNIDAD)),
+								Fijo::desdeBruto((s32)(((s64)modulo.bruto() * trigonometria::coseno(angulo))
+															/ trigonometria::UNIDAD)));
+			};
+
+			/**
+			 * Método que calcula el producto escalar con otro vector.
+			 * @param v Otro vector
+			 * @return Producto escalar
+			 */
+			Fijo punto(const VectorFijo& v) const { return x * v.x + y * v.y; };
+
+			/**
+			 * Método que calcula el módulo del vector.
+			 * @return Módulo del vector
+			 */
+			Fijo modulo(void) const;
+
+			/**
+			 * Método que obtiene la dirección del vector.
+			 * @return Dirección del vector, en unidades de trigonometria::VUELTA partes por vuelta
+			 */
+			u32 angulo(void) const { return trigonometria::angulo(x.bruto(), y.bruto()); };
+
+			/**
+			 * Método que obtiene el vector de módulo 1 con la misma dirección.
+			 * @return Vector normalizado, o el vector nulo si el vector es nulo
+			 */
+			VectorFijo normalizar(void) const;
+
+			/**
+			 * Método que calcula la reflexión del vector contra una superficie, por ejemplo la velocidad de un actor
+			 * después de rebotar.
+			 * @param normal Vector de módulo 1 perpendicular a la superficie
+			 * @return Vector reflejado
+			 */
+			VectorFijo reflejar(const VectorFijo& normal) const {
+				Fijo d = punto(normal) + punto(normal);
+				return VectorFijo(x - d * normal.x, y - d * normal.y);
+			};
+
+			VectorFijo operator-(void) const { return VectorFijo(-x, -y); };
+			VectorFijo operator+(const VectorFijo& v) const { return VectorFijo(x + v.x, y + v.y); };
+			VectorFijo operator-(const VectorFijo& v) const { return VectorFijo(x - v.x, y - v.y); };
+			VectorFijo operator*(const Fijo& f) const { return VectorFijo(x * f, y * f); };
+			VectorFijo& operator+=(const VectorFijo& v) { x += v.x; y += v.y; return *this; };
+			VectorFijo& operator-=(const VectorFijo& v) { x -= v.x; y -= v.y; return *this; };
+			bool operator==(const VectorFijo& v) const { return x == v.x and y == v.y; };
+			bool operator!=(const VectorFijo& v) const { return x != v.x or y != v.y; };
+
+			/**
+			 * Componentes del vector.
+			 */
+			Fijo x, y;
+	};
+
+#endif
+
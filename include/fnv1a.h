@@ -0,0 +1,82 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _FNV1A_H_
+#define _FNV1A_H_
+
+	#include <string>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para calcular el hash FNV-1a de 32 bits de una cadena de caracteres.
+	 *
+	 * @details La galería identifica cada recurso mediante el hash de su código, de tal manera que las búsquedas
+	 * comparan enteros en lugar de cadenas. La versión que recibe una cadena de C es constexpr, así que el hash de un
+	 * literal se calcula durante la compilación; la versión que recibe un std::string se calcula en ejecución, y ambas
+	 * producen siempre el mismo resultado. El mismo hash ordena el índice de los paquetes de recursos (ver paquete.h),
+	 * así que este archivo no depende de ninguna biblioteca de la consola y se compila también para el PC, con la
+	 * herramienta empaquetar.
+	 *
+	 * @code
+	 * // Calculado por el compilador
+	 * const u32 ID_ARIAL = fnv1a::hash("arial");
+	 * // Calculado en ejecución, con el mismo resultado
+	 * u32 id = fnv1a::hash(std::string("arial"));
+	 * @endcode
+	 *
+	 */
+	namespace fnv1a
+	{
+		/**
+		 * Valor inicial del hash FNV-1a de 32 bits.
+		 */
+		static const u32 BASE = 2166136261u;
+
+		/**
+		 * Número primo del hash FNV-1a de 32 bits.
+		 */
+		static const u32 PRIMO = 16777619u;
+
+		/**
+		 * Calcula el hash FNV-1a de una cadena de C; si la cadena es un literal, se calcula durante la compilación
+		 * @param s Cadena terminada en el carácter nulo
+		 * @param h Hash de los caracteres anteriores (no se debe indicar)
+		 * @return Hash de 32 bits de la cadena
+		 */
+		constexpr u32 hash(const char* s, u32 h = BASE)
+		{
+			return (*s == 0) ? h : hash(s + 1, (h ^ (u8)*s) * PRIMO);
+		}
+
+		/**
+		 * Calcula el hash FNV-1a de una cadena de alto nivel
+		 * @param s Cadena de la que se quiere calcular el hash
+		 * @return Hash de 32 bits de la cadena
+		 */
+		u32 inline hash(const std::string& s)
+		{
+			u32 h = BASE;
+			for(u32 i = 0 ; i < s.length() ; ++i)
+				h = (h ^ (u8)s[i]) * PRIMO;
+			return h;
+		}
+	}
+
+#endif
+
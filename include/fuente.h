@@ -147,6 +147,17 @@
 			 */
 			Fuente(const std::string& ruta) throw (ArchivoEx, TarjetaEx);
 
+			/**
+			 * Constructor de la clase Fuente a partir del contenido de un archivo de fuentes que ya está en memoria
+			 * (normalmente, leído por el hilo de la clase Cargador). La fuente pasa a ser la propietaria de la
+			 * zona de memoria, que debe haberse reservado con memoria::reservar(), y la libera al destruirse.
+			 * @param ruta Ruta del archivo de fuentes, sólo se utiliza en los mensajes de error
+			 * @param datos Contenido completo del archivo de fuentes
+			 * @param tam Tamaño en bytes del contenido
+			 * @throw ArchivoEx Se lanza si FreeType no reconoce el contenido como una fuente válida
+			 */
+			Fuente(const std::string& ruta, u8* datos, u32 tam) throw (ArchivoEx);
+
 			/**
 			 * Método para escribir en pantalla un texto con la fuente almacenada en la instancia.
 			 * @param texto Cadena de texto de alto nivel que se quiere escribir en la pantalla
@@ -169,6 +180,12 @@
 			 */
 			void escribir(const std::wstring& texto, u8 tam, s16 x, s16 y, s16 z, u32 color) const;
 
+			/**
+			 * Método consultor de la memoria que ocupa la fuente, que se estima como el tamaño de su archivo.
+			 * @return Número de bytes del archivo de la fuente.
+			 */
+			u32 bytes(void) const;
+
 			/**
 			 * Destructor de la clase Fuente
 			 */
@@ -177,8 +194,13 @@
 		private:
 			// Función que dibuja un carácter concreto, en unas coordenadas y un color determinados
 			void dibujarCaracter(FT_Bitmap *bitmap, s16 x, s16 y, s16 z, u32 color) const;
+			// Crear la 'face' de la fuente a partir del contenido del archivo, que ya está en memoria
+			void iniciar(const std::string& ruta) throw (ArchivoEx);
+
 			FT_Face _face;
 			bool _kerning;
+			u8* _datos;
+			u32 _tam;
 	};
 
 #endif
@@ -20,13 +20,17 @@
 
 	#include <iterator>
 	#include <map>
+	#include <sstream>
 	#include <string>
+	#include <vector>
 	#include "excepcion.h"
 	#include "fuente.h"
 	#include "imagen.h"
+	#include "logger.h"
 	#include "musica.h"
 	#include "parser.h"
 	#include "sonido.h"
+	#include "util.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
@@ -34,15 +38,16 @@
 	 * @brief Clase que gestiona los recursos media del sistema, y facilita su carga en memoria y el acceso a ellos.
 	 * 
 	 * @details Esta clase consiste en un conjunto de diccionarios (en C++, maps), uno por cada tipo de recurso media
-	 * que se vaya a utilizar en el desarrollo del juego. La carga de éstos se realiza al principio de la ejecución a
-	 * partir de un archivo XML con un formato concreto. Además, esta clase implementa un patrón Singleton, de tal
-	 * manera que los recursos media están disponibles en todo momento, y en cualquier parte del sistema.
+	 * que se vaya a utilizar en el desarrollo del juego. Los diccionarios se rellenan al principio de la ejecución a
+	 * partir de un archivo XML con un formato concreto, pero cada recurso no se carga en memoria hasta que se utiliza
+	 * por primera vez. Además, esta clase implementa un patrón Singleton, de tal manera que los recursos media están
+	 * disponibles en todo momento, y en cualquier parte del sistema.
 	 *
 	 * En estos momentos, los cuatro recursos que se contemplan son: imágenes, sonidos, pistas de música y fuentes de
 	 * texto. Cada uno de estos recursos se encuentra disponible mediante un código único de identificación, en formato
 	 * std::string, y que se lee desde el ya mencionado archivo de datos XML. Si en un futuro se decidiera implementar
-	 * un nuevo tipo de recurso, basta con implementar su correspondiente diccionario, la función de lectura desde el
-	 * XML, y las funciones consultoras.
+	 * un nuevo tipo de recurso, basta con añadir su tipo a la enumeración Tipo, y completar las funciones de lectura
+	 * desde el XML, de carga y de descarga, y las funciones consultoras.
 	 *
 	 * Dos recursos de distinto tipo pueden tener identificadores idénticos, ya que se archivan cada uno en su
 	 * diccionario.Por otra parte, los recursos se crean mediante su constructor, y con los parámetros que cada uno de
@@ -52,14 +57,65 @@
 	 * formato std::string), y los valores numéricos (enteros de 8 bits sin signo) que indican el volumen de cada uno
 	 * de los dos canales de reproducción.
 	 *
+	 * Carga bajo demanda, referencias y presupuesto de memoria
+	 *
+	 * Mantener en memoria durante toda la ejecución todos los recursos del juego desperdicia mucha memoria, ya que hay
+	 * recursos que sólo se utilizan en un nivel concreto (el fondo o la música de ese nivel, por ejemplo). Por eso, un
+	 * recurso se carga la primera vez que se solicita, y cada recurso lleva la cuenta de cuántos usuarios lo retienen.
+	 * Las clases que guardan un recurso durante un tiempo prolongado (por ejemplo, un Nivel retiene su fondo, su
+	 * tileset y su música, y un Actor retiene las imágenes de sus animaciones) deben llamar al método retener() al
+	 * comenzar a usarlo, y al método liberar() cuando ya no lo necesiten. Un recurso retenido nunca se descarga.
+	 *
+	 * La galería dispone de un presupuesto de memoria en bytes, que se puede fijar con el atributo opcional
+	 * 'presupuesto' (en kilobytes) de la etiqueta raíz del XML, o con el método setPresupuesto(). Un presupuesto igual
+	 * a cero indica que no hay límite, y es el valor por defecto. Cada vez que se carga un recurso, si la memoria
+	 * ocupada por todos los recursos cargados supera el presupuesto, se descargan los recursos que no estén retenidos
+	 * por nadie, empezando por el que lleve más tiempo sin utilizarse, hasta volver a estar dentro del presupuesto o no
+	 * quedar recursos que se puedan descargar. Un recurso descargado se vuelve a cargar de forma transparente la
+	 * próxima vez que se solicite. La memoria de una imagen incluye la de su máscara de colisión si ésta se ha creado a
+	 * través de la galería, con el método mascara(), que es lo que hace la clase Actor.
+	 *
+	 * Por lo tanto, la referencia que devuelven los métodos consultores de un recurso no retenido sólo es válida hasta
+	 * la siguiente petición a la galería, y no se debe guardar. Por ejemplo, la instrucción
+	 * galeria->fuente("arial").escribir(...) es correcta, pero guardar un puntero a esa fuente sin retenerla no lo es.
+	 *
+	 * Sin presupuesto, un recurso que deja de estar retenido sigue cargado. El método descartar() lo descarga en ese
+	 * mismo momento si nadie lo retiene; es lo que hace la clase Manifiesto con los recursos de un nivel al
+	 * destruirlo, de tal manera que la memoria ocupada en cada momento es la del nivel en curso, y no la de todos los
+	 * niveles por los que ha pasado el juego.
+	 *
+	 * El método residentes() indica la memoria ocupada por los recursos cargados de cada tipo, y el método informe()
+	 * vuelca en el log del sistema un resumen de la memoria ocupada y del número de recursos cargados de cada tipo.
+	 *
+	 * Los recursos también se pueden cargar en segundo plano mediante la clase Cargador. Mientras un recurso está
+	 * pedido al Cargador, su entrada queda marcada como pendiente; si se solicita a la galería antes de que el Cargador
+	 * lo entregue, la galería espera a que termine en lugar de leer el archivo por segunda vez.
+	 *
+	 * Manejadores e identificadores
+	 *
+	 * Buscar un recurso por su código tiene un coste que no importa en la mayoría de los casos, pero que se nota en
+	 * las partes del código que se ejecutan muchas veces por frame. Para esos casos, el recurso se puede resolver una
+	 * sola vez con el método resolver(), que devuelve un manejador con tipo (ManejadorImagen, ManejadorMusica,
+	 * ManejadorSonido o ManejadorFuente). Acceder a un recurso a través de su manejador es un simple acceso a un
+	 * vector, y el compilador impide utilizar el manejador de una imagen para pedir un sonido. Un manejador sigue
+	 * siendo válido aunque su recurso se descargue, ya que identifica la entrada de la galería y no el recurso.
+	 *
+	 * El método resolver() acepta el código del recurso o su identificador, que es el hash FNV-1a de 32 bits del
+	 * código (ver espacio de nombres fnv1a). Si el identificador se calcula a partir de un literal, el compilador
+	 * lo resuelve durante la compilación, y no queda ninguna cadena en el código del juego. Dos códigos distintos de
+	 * un mismo tipo no pueden tener el mismo identificador; si ocurriera, la inicialización de la galería lanzaría
+	 * una excepción, y bastaría con cambiar uno de los dos códigos.
+	 *
 	 * Funcionamiento interno
 	 *
-	 * Los diccionarios sobre los que trabaja esta clase consisten en parejas formadas por una cadena de caracteres de
-	 * alto nivel (del tipo ya mencionado, std::string), que actúa como clave identificativa, y un puntero a la zona de
-	 * memoria donde se encuentra el recurso correspondiente. Cuando se solicita a la clase un recurso media, esta
-	 * operación se hace a partir del código del media. El método comprueba que el código recibido corresponde a un
-	 * recurso, lo busca y devuelve el puntero que apunta a él; si el código no estuviera registrado en el diccionario,
-	 * se lanzaría una excepción.
+	 * Las entradas de cada tipo de recurso se guardan en un vector, y cada entrada contiene el código del recurso, los
+	 * datos necesarios para cargarlo (ruta, formato, volumen, etc.), un puntero al recurso (nulo si no está cargado),
+	 * la memoria que ocupa, el número de referencias y el instante de su último uso, medido con un contador que se
+	 * incrementa en cada petición. Un diccionario por tipo asocia el identificador de cada código con la posición de
+	 * su entrada en el vector, y un manejador no es más que esa posición. Cuando se solicita un recurso por su código,
+	 * se calcula su identificador, se busca la posición una sola vez (comparando enteros), se carga el recurso si hace
+	 * falta, se actualiza el instante de uso y se devuelve el recurso; si el código no estuviera registrado, se
+	 * lanzaría una excepción.
 	 *
 	 * La clase necesita que la tarjeta SD esté montada para poder acceder a los archivos que contienen los recursos;
 	 * en caso contrario, se lanzará una excepción al intentar acceder a éstos.
@@ -67,17 +123,42 @@
 	 * A la hora de inicializar la galería de recursos, se le debe pasar como parámetro la ruta absoluta (en la tarjeta
 	 * SD) hasta el archivo XML en el que se encuentra la información de los media. Este archivo debe tener un nodo
 	 * raíz cuyos hijos serán, cada uno de ellos, un recurso media. El método que se encarga de recorrer la información
-	 * e ir creando cada recurso a partir de ésta irá leyendo cada etiqueta de recurso, la identificará por su tipo, y
-	 * según sea éste, intentará leer unos u otros atributos de la etiqueta. A continuación se muestra un ejemplo de
-	 * etiqueta válida para cada uno de los cuatro tipos de recursos contemplados en estos momentos por la clase:
+	 * e ir registrando cada recurso a partir de ésta irá leyendo cada etiqueta de recurso, la identificará por su
+	 * tipo, y según sea éste, intentará leer unos u otros atributos de la etiqueta. A continuación se muestra un
+	 * ejemplo de etiqueta válida para cada uno de los cuatro tipos de recursos contemplados en estos momentos por la
+	 * clase:
+	 *
+	 * @code
+	 * <galeria presupuesto="8192">
+	 *   <imagen codigo="fondo" formato="bmp" ruta="/apps/wiipang/media/fondo.bmp" />
+	 *   <imagen codigo="bola" formato="png" ruta="/apps/wiipang/media/bola.png" />
+	 *   <musica codigo="rock" volumen="128" ruta="/apps/wiipang/media/rock.mp3" />
+	 *   <sonido codigo="sound" volumen="255" prioridad="200" instancias="2" ruta="/apps/wiipang/media/sound.pcm" />
+	 *   <fuente codigo="arial" ruta="/apps/wiipang/media/arial.ttf" />
+	 * </galeria>
+	 * @endcode
+	 *
+	 * El formato de una imagen puede ser 'bmp', 'png' o 'tex' (textura cocinada con la herramienta cocinar, ver clase
+	 * Imagen); en cualquier caso, al cargarla se reconoce por la firma del archivo.
+	 *
+	 * Una imagen también puede ser un recorte de otra imagen de la galería, llamada página, si en lugar de 'ruta' y
+	 * 'formato' tiene los atributos 'atlas' (código de la página) y 'x', 'y', 'ancho' y 'alto' (posición del recorte
+	 * en ella). La herramienta agrupar reúne de esta forma las imágenes pequeñas de una galería en unas pocas
+	 * texturas, y reescribe el archivo XML:
 	 *
 	 * @code
-	 * <imagen codigo="fondo" formato="bmp" ruta="/apps/wiipang/media/fondo.bmp" />
-	 * <musica codigo="rock" volumen="128" ruta="/apps/wiipang/media/rock.mp3" />
-	 * <sonido codigo="sound" volumen="255" ruta="/apps/wiipang/media/sound.pcm" />
-	 * <fuente codigo="arial" ruta="/apps/wiipang/media/arial.ttf" />
+	 *   <imagen codigo="bola" atlas="atlas0" x="0" y="0" ancho="32" alto="32" />
+	 *   <imagen codigo="atlas0" formato="tex" ruta="/apps/wiipang/media/atlas0.tex" />
 	 * @endcode
 	 *
+	 * Para el resto de la biblioteca, un recorte es una imagen como cualquier otra (ver Imagen::recortar()). Mientras
+	 * un recorte está cargado, la galería retiene su página, que se carga con el primero de sus recortes y se puede
+	 * descargar cuando no queda ninguno; pedir un recorte al Cargador carga su página en segundo plano.
+	 *
+	 * Los atributos 'prioridad' (entre 0 y 255, por defecto 128) e 'instancias' (entre 0 y 255, por defecto 0, sin
+	 * límite) de los sonidos son opcionales, y los utiliza la clase Mezclador para repartir las voces de sonido. La
+	 * ruta de un sonido puede apuntar tanto a un archivo PCM crudo como a uno comprimido con la herramienta pcm2adpcm.
+	 *
 	 * Añadir un nuevo recurso media al sistema es tan sencillo como copiar el archivo a la tarjeta SD (se recomienda
 	 * mantener una carpeta donde se almacenen todos los recursos, por ejemplo, una llamada 'media'), y después añadir
 	 * la etiqueta correspondiente al archivo que contenga la información de la galería. De esta forma se evita tener
@@ -85,7 +166,7 @@
 	 * separación de código y datos.
 	 *
 	 * Por último, al crear la galería, se establece que, cuando se salga del programa, se llame a su destructor que, a
-	 * su vez, llama a los destructores de cada uno de los recursos almacenados, de tal manera que se evitan fugas de
+	 * su vez, llama a los destructores de cada uno de los recursos cargados, de tal manera que se evitan fugas de
 	 * memoria.
 	 *
 	 * Ejemplo de uso
@@ -93,10 +174,19 @@
 	 * // Inicialización de la galería a partir de un XML
 	 * galeria->inicializar("/apps/wiipang/xml/galeria.xml");
 	 * // Ejemplo de acceso a cada uno de los recursos
-	 * galeria->sonido("sound")->play();
-	 * galeria->fuente("arial")->escribir("¡Funciona!", 30, 80, 100, 10, 0x00FF00FF);
-	 * galeria->imagen("fondo")->dibujar(0, 0, 900);
-	 * galeria->musica("rock")->play();
+	 * galeria->sonido("sound").play();
+	 * galeria->fuente("arial").escribir("¡Funciona!", 30, 80, 100, 10, 0x00FF00FF);
+	 * galeria->imagen("fondo").dibujar(0, 0, 900);
+	 * galeria->musica("rock").play();
+	 * // Retener el fondo mientras dure el nivel, y liberarlo al terminar
+	 * galeria->retener(Galeria::IMAGEN, "fondo");
+	 * // ...
+	 * galeria->liberar(Galeria::IMAGEN, "fondo");
+	 * // Resolver el fondo una sola vez, con su identificador calculado durante la compilación
+	 * Galeria::ManejadorImagen fondo = galeria->resolver<Galeria::IMAGEN>(fnv1a::hash("fondo"));
+	 * galeria->imagen(fondo).dibujar(0, 0, 900);
+	 * // Volcar en el log la memoria ocupada por cada tipo de recurso
+	 * galeria->informe();
 	 * @endcode
 	 * 
 	 */
@@ -104,6 +194,67 @@
 	{
 		public:
 
+			/**
+			 * Tipos de recursos media que gestiona la galería.
+			 */
+			enum Tipo { IMAGEN, MUSICA, SONIDO, FUENTE };
+
+			/**
+			 * Número de tipos de recursos media que gestiona la galería.
+			 */
+			static const u8 NUM_TIPOS = 4;
+
+			/**
+			 * @brief Manejador de un recurso de la galería, obtenido con el método resolver().
+			 * @details El tipo del recurso forma parte del tipo del manejador. Un manejador construido por defecto
+			 * no corresponde a ningún recurso, y utilizarlo provoca una excepción CodigoEx.
+			 */
+			template <Tipo T> class Manejador
+			{
+				public:
+
+					/**
+					 * Constructor por defecto, que crea un manejador no válido.
+					 */
+					Manejador(void): _indice(NINGUNO) { };
+
+					/**
+					 * Método que indica si el manejador corresponde a algún recurso.
+					 * @return Verdadero si el manejador se ha obtenido con resolver(), falso en caso contrario
+					 */
+					bool valido(void) const { return _indice != NINGUNO; };
+
+				private:
+
+					friend class Galeria;
+
+					static const u32 NINGUNO = 0xFFFFFFFF;
+
+					explicit Manejador(u32 indice): _indice(indice) { };
+
+					u32 _indice;
+			};
+
+			/**
+			 * Manejador de una imagen.
+			 */
+			typedef Manejador<IMAGEN> ManejadorImagen;
+
+			/**
+			 * Manejador de una pista de música.
+			 */
+			typedef Manejador<MUSICA> ManejadorMusica;
+
+			/**
+			 * Manejador de un efecto de sonido.
+			 */
+			typedef Manejador<SONIDO> ManejadorSonido;
+
+			/**
+			 * Manejador de una fuente de texto.
+			 */
+			typedef Manejador<FUENTE> ManejadorFuente;
+
 			/**
 			 * Función estática que devuelve la instancia activa de la galeria de medias en el sistema. En el caso
 			 * de no haber ninguna instancia, se crea y se devuelve. Implementación del patrón Singleton.
@@ -128,46 +279,235 @@
 			}
 
 			/**
-			 * Método para inicializar la galería, y cargar los medias en la biblioteca de medias.
+			 * Método para inicializar la galería, registrando los medias en la biblioteca de medias. Los medias no
+			 * se cargan hasta que se utilizan por primera vez.
 			 * @param ruta Ruta absoluta hasta el archivo XML en el que se encuentra la información de los media
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir un archivo
-			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de una imagen
+			 * @throw ImagenEx Se lanza si se declara una imagen en un formato no soportado
 			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 * @throw XmlEx Se lanza si hay un error relacionado con un árbol XML
 			 */
 			void inicializar(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx, XmlEx);
 
 			/**
-			 * Método que devuelve un puntero a la imagen que tenga el código que se indica
+			 * Método que devuelve la imagen que tenga el código que se indica, cargándola si es necesario
 			 * @param codigo Código de la imagen que se quiere obtener
-			 * @return Puntero a la imagen que corresponde al código introducido
+			 * @return Referencia constante a la imagen que corresponde al código introducido
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la imagen
+			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ninguna imagen
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de la imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Imagen& imagen(const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que devuelve la máscara de colisión de una imagen, cargando la imagen y creando la máscara si es
+			 * necesario. La memoria de la máscara se suma a la de la imagen en el presupuesto de la galería, cosa que
+			 * no ocurre si se crea directamente con Imagen::mascara().
+			 * @param codigo Código de la imagen cuya máscara se quiere obtener
+			 * @return Referencia constante a la máscara de la imagen
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la imagen
 			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ninguna imagen
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de la imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			const Imagen& imagen(const std::string& codigo) throw (CodigoEx);
+			const Mascara& mascara(const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
 
 			/**
-			 * Método que devuelve un puntero a la pista de música que tenga el código que se indica
+			 * Método que devuelve la pista de música que tenga el código que se indica, cargándola si es necesario
 			 * @param codigo Código de la pista de música que se quiere obtener
-			 * @return Puntero a la pista de música que corresponde al código introducido
+			 * @return Referencia constante a la pista de música que corresponde al código introducido
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la pista de música
 			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ninguna pista de música
+			 * @throw ImagenEx Nunca se lanza para una pista de música, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			const Musica& musica(const std::string& codigo) throw (CodigoEx);
+			const Musica& musica(const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
 
 			/**
-			 * Método que devuelve un puntero al sonido que tenga el código que se indica
+			 * Método que devuelve el sonido que tenga el código que se indica, cargándolo si es necesario
 			 * @param codigo Código del sonido que se quiere obtener
-			 * @return Puntero al sonido que corresponde al código introducido
+			 * @return Referencia constante al sonido que corresponde al código introducido
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo del sonido
 			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ningún sonido
+			 * @throw ImagenEx Nunca se lanza para un sonido, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			const Sonido& sonido(const std::string& codigo) throw (CodigoEx);
+			const Sonido& sonido(const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
 
 			/**
-			 * Método que devuelve un puntero a la fuente que tenga el código que se indica
+			 * Método que devuelve la fuente que tenga el código que se indica, cargándola si es necesario
 			 * @param codigo Código de la fuente que se quiere obtener
-			 * @return Puntero a la fuente que corresponde al código introducido
+			 * @return Referencia constante a la fuente que corresponde al código introducido
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la fuente
 			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ninguna fuente de texto
+			 * @throw ImagenEx Nunca se lanza para una fuente, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Fuente& fuente(const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que obtiene el manejador de un recurso a partir de su código. No carga el recurso.
+			 * @param codigo Código del recurso
+			 * @return Manejador del recurso, con el tipo indicado como parámetro de la plantilla
+			 * @throw CodigoEx Se lanza si el código no corresponde a ningún recurso del tipo indicado
 			 */
-			const Fuente& fuente(const std::string& codigo) throw (CodigoEx);
+			template <Tipo T> Manejador<T> resolver(const std::string& codigo) throw (CodigoEx)
+			{
+				return Manejador<T>(buscar(T, codigo));
+			}
+
+			/**
+			 * Método que obtiene el manejador de un recurso a partir de su identificador. No carga el recurso.
+			 * @param id Identificador del recurso, es decir, fnv1a::hash() de su código
+			 * @return Manejador del recurso, con el tipo indicado como parámetro de la plantilla
+			 * @throw CodigoEx Se lanza si el identificador no corresponde a ningún recurso del tipo indicado
+			 */
+			template <Tipo T> Manejador<T> resolver(u32 id) throw (CodigoEx)
+			{
+				return Manejador<T>(buscar(T, id));
+			}
+
+			/**
+			 * Método que devuelve la imagen de un manejador, cargándola si es necesario
+			 * @param m Manejador de la imagen
+			 * @return Referencia constante a la imagen
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la imagen
+			 * @throw CodigoEx Se lanza si el manejador no es válido
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de la imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Imagen& imagen(ManejadorImagen m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que devuelve la pista de música de un manejador, cargándola si es necesario
+			 * @param m Manejador de la pista de música
+			 * @return Referencia constante a la pista de música
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la pista de música
+			 * @throw CodigoEx Se lanza si el manejador no es válido
+			 * @throw ImagenEx Nunca se lanza para una pista de música, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Musica& musica(ManejadorMusica m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que devuelve el sonido de un manejador, cargándolo si es necesario
+			 * @param m Manejador del sonido
+			 * @return Referencia constante al sonido
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo del sonido
+			 * @throw CodigoEx Se lanza si el manejador no es válido
+			 * @throw ImagenEx Nunca se lanza para un sonido, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Sonido& sonido(ManejadorSonido m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que devuelve la fuente de un manejador, cargándola si es necesario
+			 * @param m Manejador de la fuente
+			 * @return Referencia constante a la fuente
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de la fuente
+			 * @throw CodigoEx Se lanza si el manejador no es válido
+			 * @throw ImagenEx Nunca se lanza para una fuente, se incluye por coherencia con el resto de tipos
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			const Fuente& fuente(ManejadorFuente m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que retiene un recurso, cargándolo si es necesario. Un recurso retenido no se descarga nunca,
+			 * hasta que se libere tantas veces como se haya retenido.
+			 * @param tipo Tipo del recurso que se quiere retener
+			 * @param codigo Código del recurso que se quiere retener
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo del recurso
+			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ningún recurso del tipo indicado
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de una imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void retener(Tipo tipo, const std::string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que retiene el recurso de un manejador, cargándolo si es necesario.
+			 * @param m Manejador del recurso que se quiere retener
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo del recurso
+			 * @throw CodigoEx Se lanza si el manejador no es válido
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de una imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			template <Tipo T> void retener(Manejador<T> m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+			{
+				acceder(T, m._indice).referencias++;
+			}
+
+			/**
+			 * Método que libera una retención de un recurso. Cuando un recurso no tiene retenciones, pasa a ser
+			 * candidato a descargarse si se supera el presupuesto de memoria. Si el código no corresponde a ningún
+			 * recurso, o el recurso no está retenido, no se hace nada.
+			 * @param tipo Tipo del recurso que se quiere liberar
+			 * @param codigo Código del recurso que se quiere liberar
+			 */
+			void liberar(Tipo tipo, const std::string& codigo);
+
+			/**
+			 * Método que libera una retención del recurso de un manejador. Si el manejador no es válido, o el
+			 * recurso no está retenido, no se hace nada.
+			 * @param m Manejador del recurso que se quiere liberar
+			 */
+			template <Tipo T> void liberar(Manejador<T> m)
+			{
+				soltar(T, m._indice);
+			}
+
+			/**
+			 * Método que retiene un recurso sin cargarlo. El recurso no se descargará mientras tenga retenciones,
+			 * pero no se carga hasta que se solicite (o hasta que lo entregue el Cargador). Cada reserva se deshace
+			 * con una llamada a liberar(), igual que una retención.
+			 * @param tipo Tipo del recurso que se quiere reservar
+			 * @param codigo Código del recurso que se quiere reservar
+			 * @throw CodigoEx Se lanza si el código recibido no corresponde a ningún recurso del tipo indicado
+			 */
+			void reservar(Tipo tipo, const std::string& codigo) throw (CodigoEx);
+
+			/**
+			 * Método que descarga un recurso en este momento, sin esperar a que se supere el presupuesto de memoria.
+			 * Sólo se descarga si está cargado, no está retenido por nadie, no se está cargando en segundo plano y,
+			 * si es una pista de música, no está sonando; en cualquier otro caso, no se hace nada.
+			 * @param tipo Tipo del recurso que se quiere descargar
+			 * @param codigo Código del recurso que se quiere descargar
+			 */
+			void descartar(Tipo tipo, const std::string& codigo);
+
+			/**
+			 * Método que establece el presupuesto de memoria de la galería, descargando en ese momento los recursos
+			 * no retenidos que sea necesario.
+			 * @param bytes Memoria máxima en bytes para los recursos cargados (0 indica que no hay límite)
+			 */
+			void setPresupuesto(u32 bytes);
+
+			/**
+			 * Método consultor del presupuesto de memoria de la galería.
+			 * @return Memoria máxima en bytes para los recursos cargados (0 indica que no hay límite)
+			 */
+			u32 presupuesto(void) const;
+
+			/**
+			 * Método consultor de la memoria ocupada por los recursos cargados de un tipo.
+			 * @param tipo Tipo de los recursos de los que se quiere conocer la memoria ocupada
+			 * @return Memoria en bytes ocupada por los recursos cargados del tipo indicado
+			 */
+			u32 residentes(Tipo tipo) const;
+
+			/**
+			 * Método que indica si un recurso se encuentra cargado en memoria en este momento.
+			 * @param tipo Tipo del recurso
+			 * @param codigo Código del recurso
+			 * @return Verdadero si el recurso existe y está cargado, falso en caso contrario
+			 */
+			bool cargado(Tipo tipo, const std::string& codigo) const;
+
+			/**
+			 * Método que vuelca en el log del sistema (nivel INFO), para cada tipo de recurso, el número de recursos
+			 * cargados y la memoria que ocupan, junto con el total y el presupuesto de memoria.
+			 */
+			void informe(void) const;
 
 		protected:
 
@@ -175,7 +515,7 @@
 			 * Constructor de la clase Galeria. Se encuentra en la zona protegida debido a la 
 			 * implementación del patrón Singleton.
 			 */
-			Galeria(void) { };
+			Galeria(void);
 
 			/**
 			 * Destructor de la clase Galeria. Se encuentra en la zona protegida debido a la implementación 
@@ -197,16 +537,74 @@
 
 		private:
 
-			void leerImagen(TiXmlElement* nodo) throw (ArchivoEx, ImagenEx, TarjetaEx, XmlEx);
-			void leerMusica(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx);
-			void leerSonido(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx);
-			void leerFuente(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx);
+			// Datos necesarios para cargar un recurso, y estado del recurso en memoria
+			// La clase Cargador crea recursos en segundo plano y los entrega a la galería
+			friend class Cargador;
+
+			typedef struct entrada
+			{
+				std::string codigo;
+				std::string ruta;
+				std::string formato;
+				std::string atlas;
+				u16 x;
+				u16 y;
+				u16 ancho;
+				u16 alto;
+				u8 volumen;
+				u8 prioridad;
+				u8 instancias;
+				void* recurso;
+				u32 bytes;
+				u32 referencias;
+				u64 uso;
+				bool pendiente;
+			} Entrada;
+
+			typedef std::vector<Entrada> Entradas;
+			typedef std::map<u32, u32> Indices;
+
+			void leerImagen(TiXmlElement* nodo) throw (ImagenEx, XmlEx);
+			void leerMusica(TiXmlElement* nodo) throw (XmlEx);
+			void leerSonido(TiXmlElement* nodo) throw (XmlEx);
+			void leerFuente(TiXmlElement* nodo) throw (XmlEx);
+
+			// Añadir una entrada al final del vector de su tipo e indexarla por el hash de su código
+			void registrar(Tipo tipo, const std::string& codigo, Entrada& e) throw (XmlEx);
+			// Posición de un recurso en el vector de su tipo, a partir de su código o de su identificador
+			bool localizar(Tipo tipo, const std::string& codigo, u32& indice) const;
+			u32 buscar(Tipo tipo, const std::string& codigo) const throw (CodigoEx);
+			u32 buscar(Tipo tipo, u32 id) const throw (CodigoEx);
+			// Obtener la entrada de un recurso, cargarlo si no lo está y marcarlo como recién utilizado
+			Entrada& acceder(Tipo tipo, u32 indice) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+			// Quitar una retención a un recurso
+			void soltar(Tipo tipo, u32 indice);
+			// Crear el recurso de una entrada a partir de sus datos
+			void cargar(Tipo tipo, Entrada& e) throw (ArchivoEx, ImagenEx, TarjetaEx);
+			// Destruir el recurso de una entrada
+			void descargar(Tipo tipo, Entrada& e);
+			// Destruir un recurso cualquiera según su tipo
+			void destruir(Tipo tipo, void* recurso);
+			// Memoria que ocupa un recurso ya creado
+			u32 medir(Tipo tipo, const void* recurso) const;
+
+			// Código del recurso que hay que leer de la tarjeta para cargar otro: la página de un recorte, o él mismo
+			std::string archivo(Tipo tipo, const std::string& codigo) const throw (CodigoEx);
+			// Marcar un recurso como pedido al Cargador y copiar sus datos; falso si ya está cargado o pedido
+			bool pedir(Tipo tipo, const std::string& codigo, Entrada& copia) throw (CodigoEx);
+			// Recibir del Cargador un recurso ya creado
+			void adoptar(Tipo tipo, const std::string& codigo, void* recurso);
+			// Anular la petición de un recurso que el Cargador no ha podido crear
+			void cancelar(Tipo tipo, const std::string& codigo);
+			// Descargar recursos no retenidos, del menos al más recientemente usado, hasta cumplir el presupuesto
+			void ajustar(const Entrada* protegida);
 
 			static Galeria* _instance;
-			std::map<std::string, Imagen*> _map_imagen;
-			std::map<std::string, Musica*> _map_musica;
-			std::map<std::string, Sonido*> _map_sonido;
-			std::map<std::string, Fuente*> _map_fuente;
+			Entradas _entradas[NUM_TIPOS];
+			Indices _indices[NUM_TIPOS];
+			u32 _residentes[NUM_TIPOS];
+			u32 _presupuesto;
+			u64 _reloj;
 	};
 
 	#define galeria Galeria::get_instance()
@@ -18,12 +18,18 @@
 #ifndef _IMAGEN_H_
 #define _IMAGEN_H_
 
-	#include <fstream>
+	#include <cstdlib>
+	#include <cstring>
 	#include <malloc.h>
 	#include <string>
+	#include <vector>
+	#include "bmp.h"
 	#include "excepcion.h"
+	#include "mascara.h"
+	#include "pngdec.h"
 	#include "screen.h"
 	#include "sdcard.h"
+	#include "textura.h"
 	#include "util.h"
 
 	/**
@@ -53,11 +59,11 @@
 	 * un entero de 32 bits, sin signo, y con la forma 0xRRGGBBAA.
 	 *
 	 * Otra limitación importante, aunque esta ya no es de la consola si no de la propia biblioteca, es que, de momento,
-	 * sólo se pueden cargar imágenes en formato bitmap (BMP), de 24 bits de color directo, y 8 bits por cada componente
-	 * de color. El por qué de esta restricción es exclusivamente el tiempo que habría que dedicar a desarrollar métodos
-	 * de carga para cualquier formato de BMP (algunos formatos de bitmap trabajan con color indirecto y paletas de
-	 * color), JPG o PNG (como ejemplos más comunes). De todas formas, en sucesivas versiones de la clase se irán
-	 * desarrollando estas funcionalidades para dotarla de mayor potencia.
+	 * sólo se pueden cargar imágenes en formato bitmap (BMP) sin comprimir, de 8 bits con paleta, o de 24 o 32 bits de
+	 * color directo, con 8 bits por cada componente de color, e imágenes PNG no entrelazadas de cualquier tipo de
+	 * color. Un PNG ocupa bastante menos que el mismo bitmap, así que se lee antes de la tarjeta SD, y además puede
+	 * tener transparencia real (canal alpha o bloque tRNS), que se respeta en lugar de utilizar el color transparente.
+	 * Otros formatos de imagen, como JPG, se irán incorporando en sucesivas versiones de la clase.
 	 *
 	 * El formato de color para un píxel que utiliza de forma nativa la Nintendo Wii es RGB5A3. Este formato, de 16
 	 * bits, consiste en que cada componente del píxel se representa con 5 bits, y el último bit es el canal alpha (la
@@ -80,33 +86,57 @@
 	 * dirección de un objeto GXTexObj, que es el atributo que realmente se utilizará para dibujar en la pantalla.
 	 *
 	 * El proceso de cargar una imagen es sencillo. En primer lugar, se crea una instancia de la clase, y después se
-	 * llama al método cargarBMP(), pasándole como parámetro un std::string que indique la ruta absoluta hasta el
-	 * archivo de imagen a cargar (debe estar en la SD). Cuando se vaya a implementar el soporte para otro formato de
-	 * imagen, habrá que definir un método similar, pero específico para el formato nuevo, como por ejemplo cargarPNG()
-	 * o cargarJPG().
+	 * llama al método cargar(), pasándole como parámetro un std::string que indique la ruta absoluta hasta el
+	 * archivo de imagen a cargar (debe estar en la SD). El formato se reconoce por la firma del propio archivo, y no
+	 * por su extensión; los métodos cargarBmp() y cargarPng() hacen lo mismo, pero sólo admiten su formato. Cuando se
+	 * vaya a implementar el soporte para otro formato de imagen, habrá que definir un método similar, pero específico
+	 * para el formato nuevo, como por ejemplo cargarJpg(), y reconocer su firma en cargar().
 	 *
 	 * El método de carga de bitmaps comprueba primero que la tarjeta SD esté montada y operativa (ver clase Sdcard). A
-	 * continuación, abre el archivo que se le ha indicado en la ruta, y trata de leer los 14 primeros bytes del archivo
-	 * (que corresponden con la cabecera de archivo de todo bitmap). Se comprueba, mediante el campo de tipo de la
-	 * cabecera, que el archivo es efectivamente un BMP, en caso contrario, se cierra el flujo de entrada y se lanza una
-	 * excepción. Si todo va bien, se procede a leer los siguientes 40 bytes, que son la cabecera de la propia imagen
-	 * (que no del archivo, que es la otra). Se toman de ésta los valores de ancho y alto en píxeles de la imagen, y la
-	 * profundidad de color. Como ya se ha comentado antes, si el ancho y el alto no son múltiplos de ocho, no se puede
-	 * continuar, y por tanto, se lanza una excepción.
-	 *
-	 * El dato de la profundidad de color es importante, ya que permite diferenciar entre los distintos formatos de
-	 * BMP que existen. Ya se ha comentado que, de momento, sólo se da soporte a los bitmaps de 24 bits de color, así
-	 * que, si el dato es correcto, se reserva la memoria alineada y se llama al método correspondiente; en caso
-	 * contrario, se lanza una excepción.
-	 *
-	 * El método cargarBmp24() se encarga de la tarea específica de leer desde la entrada un bitmap de 24 bits. Si se
-	 * quisiera ampliar la clase, dotándola de la posibilidad de leer otros formatos de bitmap, únicamente habría que
-	 * añadir la comprobación en el método cargarBmp(), y crear el método específico de carga del formato.
-	 *
-	 * Un bitmap de 24 bits de color, con 8 bits de color directo por componente, se carga leyendo la información de la
-	 * imagen de 3 bytes en 3 bytes. Posteriormente, se trabaja a nivel de bit (con operadores de desplazamiento) para
-	 * transformar el formato de píxel del BMP (BGR) en RGB5A3, y se van guardando, en orden de llegada, los píxeles con
-	 * este último formato en la zona de memoria reservada.
+	 * continuación, lee de una sola vez el archivo completo mediante Sdcard::leer() (desde el paquete de recursos, si
+	 * hay alguno montado que lo contenga), y toma los 14 primeros bytes (que corresponden con la cabecera de archivo de
+	 * todo bitmap). Se comprueba, mediante el campo de tipo de la cabecera, que el archivo es efectivamente un BMP, en
+	 * caso contrario, se libera el contenido leído y se lanza una excepción. Si todo va bien, se lee la cabecera de
+	 * la propia imagen (que no del archivo, que es la otra), de la que se toman los valores de ancho y alto en píxeles
+	 * de la imagen, y la profundidad de color. Como ya se ha comentado antes, si el ancho y el alto no son múltiplos
+	 * de ocho, no se puede continuar, y por tanto, se lanza una excepción. Lo mismo sucede si la profundidad de color
+	 * o la compresión no están entre las admitidas, o si el archivo no contiene todos sus píxeles.
+	 *
+	 * Tanto la lectura de las cabeceras como la decodificación de los píxeles se realizan con las funciones del
+	 * espacio de nombres bmp (ver bmp.h), que recorren el archivo fila a fila, convierten cada píxel del BMP (BGR, o
+	 * un índice de la paleta) en RGB5A3, y lo escriben directamente en su posición dentro de los tiles de 4×4 que
+	 * espera el procesador gráfico, de tal manera que la textura no se tiene que reorganizar después.
+	 *
+	 * Las imágenes PNG se leen de la misma forma, y se decodifican con las funciones del espacio de nombres png (ver
+	 * pngdec.h), que descomprimen el archivo fila a fila y también escriben cada píxel directamente en su tile, sin
+	 * tener nunca en memoria la imagen descomprimida completa.
+	 *
+	 * Una vez decodificada, si la imagen tiene 256 colores distintos o menos (lo habitual en tilesets y sprites, y
+	 * siempre en los bitmaps de 8 bits y los PNG con paleta), se convierte sin pérdida en una textura de índices de
+	 * paleta: CI4, con una paleta de 16 colores, o CI8, con una de 256 (ver textura.h). Los índices ocupan la cuarta
+	 * parte o la mitad que los píxeles RGB5A3, y la paleta sólo 32 o 512 bytes. Para ello, se recorre la textura
+	 * guardando cada color en una pequeña tabla hash, y se abandona la conversión en cuanto aparece el color número
+	 * 257. Este comportamiento se puede desactivar con la variable de clase Imagen::indexar. Las imágenes con muchos
+	 * colores se pueden reducir a 256 antes de copiarlas a la tarjeta SD con la herramienta paletizar (ver directorio
+	 * tools).
+	 *
+	 * Una imagen con paleta puede tener además variantes de su paleta, en las que algunos colores se sustituyen por
+	 * otros (ver variante()). Dibujar la imagen con una variante cuesta lo mismo que dibujarla con su paleta original,
+	 * así que es la forma más barata de tener, por ejemplo, ladrillos de distintos colores o jugadores de distintos
+	 * equipos con una sola imagen. Las variantes se pueden indicar también en el atributo 'paleta' de las animaciones
+	 * de un actor (ver clase Actor).
+	 *
+	 * Todo este trabajo se puede hacer en el PC antes de copiar los recursos a la tarjeta SD, con la herramienta
+	 * cocinar (ver directorio tools), que procesa todas las imágenes de una galería y guarda cada una como una textura
+	 * cocinada (ver textura.h): un archivo con una cabecera de 32 bytes, la textura ya organizada en bloques y, si
+	 * procede, su paleta. El método cargar() reconoce también la firma de estos archivos, y en ese caso la carga se
+	 * reduce a una única lectura en memoria alineada: la textura y la paleta se utilizan directamente desde el
+	 * archivo leído, sin decodificar ni copiar nada.
+	 *
+	 * Una imagen puede ser también un recorte de otra (ver recortar()), normalmente de una página de un atlas que
+	 * agrupa varias imágenes pequeñas (ver clase Atlas y herramienta agrupar). El recorte no tiene píxeles propios, y
+	 * se dibuja como un cuadro de la textura de su página; para el resto de la biblioteca, es una imagen más. La
+	 * galería crea los recortes de las imágenes que tienen el atributo 'atlas' (ver clase Galeria).
 	 *
 	 * Por último, se fijan los datos en la memoria desde la caché, y se crea el objeto de textura haciendo uso de la
 	 * función que proporciona la clase Screen. Dibujar una imagen es algo trivial, ya que se recurre a los métodos
@@ -119,7 +149,7 @@
 	 * // Crear una instancia de Imagen
 	 * Imagen i;
 	 * // Cargar un bitmap
-	 * i.cargarBMP( "/apps/wiipang/media/imagen.bmp" );
+	 * i.cargar( "/apps/wiipang/media/imagen.png" );
 	 * // Dibujar la textura en unas coordenadas (x, y, z)
 	 * i.dibujar( 100, 200, 15 );
 	 * @endcode
@@ -134,14 +164,41 @@
 			 */
 			static u32 alpha;
 
+			/**
+			 * Variable de clase que indica si las imágenes de 256 colores o menos se convierten en texturas de índices
+			 * de paleta al cargarlas. Por defecto, es verdadera.
+			 */
+			static bool indexar;
+
 			/**
 			 * Constructor de la clase Imagen. El objeto creado tiene todos sus atributos a cero.
 			 */
 			Imagen(void);
 
+			/**
+			 * Función para cargar una imagen desde un archivo BMP, PNG o de textura cocinada (ver textura.h) que debe
+			 * estar en la tarjeta SD. El formato se reconoce por la firma del archivo.
+			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void cargar(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Función que realiza la primera mitad de cargar(): lee la imagen de la tarjeta SD y decodifica sus
+			 * píxeles en memoria alineada, pero no crea la textura. No utiliza el procesador gráfico, así que se puede
+			 * llamar desde el hilo de la clase Cargador.
+			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void decodificar(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
+
 			/**
 			 * Función para cargar una imagen desde un archivo bitmap que debe estar en la tarjeta SD.
-			 * De momento, sólo se da soporte a los bitmaps de 24 bits de color directo (sin paleta).
+			 * De momento, sólo se da soporte a los bitmaps sin comprimir de 8 bits (con paleta), 24 y 32 bits.
 			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
 			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
@@ -149,14 +206,83 @@
 			 */
 			void cargarBmp(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
 
+			/**
+			 * Función que realiza la primera mitad de cargarBmp(): lee el bitmap de la tarjeta SD y decodifica sus
+			 * píxeles en memoria alineada, pero no crea la textura. No utiliza el procesador gráfico, así que se puede
+			 * llamar desde el hilo de la clase Cargador.
+			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void decodificarBmp(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Función para cargar una imagen desde un archivo PNG que debe estar en la tarjeta SD. Se admiten todos
+			 * los tipos de color, pero no las imágenes entrelazadas.
+			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void cargarPng(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Función que realiza la primera mitad de cargarPng(), igual que decodificarBmp().
+			 * @param ruta Ruta absoluta hasta el fichero que contiene la imagen.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la propia imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void decodificarPng(const std::string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Función que realiza la segunda mitad de cargarBmp(): crea la textura a partir de los píxeles ya
+			 * decodificados. Se debe llamar desde el hilo principal. Si la imagen no tiene píxeles, o ya tiene
+			 * textura, no hace nada.
+			 */
+			void crearTextura(void);
+
+			/**
+			 * Función que convierte la imagen en un recorte de otra imagen más grande (una página de un atlas, ver
+			 * clase Atlas). Un recorte no tiene textura propia: se dibuja con la textura y las paletas de su página,
+			 * así que dibujar seguidos varios recortes de una misma página no obliga a cargar ninguna textura. La
+			 * página debe existir mientras exista el recorte.
+			 * @param pagina Imagen de la que se toma el recorte, que no puede ser a su vez un recorte
+			 * @param x Coordenada X del recorte dentro de la página
+			 * @param y Coordenada Y del recorte dentro de la página
+			 * @param ancho Ancho en píxeles del recorte
+			 * @param alto Alto en píxeles del recorte
+			 * @throw ImagenEx Se lanza si la página es un recorte, o si el recorte se sale de la página
+			 */
+			void recortar(const Imagen& pagina, u16 x, u16 y, u16 ancho, u16 alto) throw (ImagenEx);
+
 			/**
 			 * Dibuja la imagen en la pantalla en unas coordenadas (x,y,z).
 			 * @param x Coordenada X del punto superior izquierdo del lugar donde se quiere dibujar la imagen.
 			 * @param y Coordenada Y del punto superior izquierdo del lugar donde se quiere dibujar la imagen.
 			 * @param z Coordenada Z (capa) en la que se dibujará la imagen. Entre 0 y 999.
+			 * @param paleta Variante de la paleta con la que se dibuja (ver variante()); 0 es la paleta original.
 			 * @return Verdadero si se ha dibujado la imagen, y falso en caso contrario.
 			 */
-			bool dibujar(s16 x, s16 y, s16 z) const;
+			bool dibujar(s16 x, s16 y, s16 z, u8 paleta = 0) const;
+
+			/**
+			 * Dibuja en la pantalla una parte de la imagen, por ejemplo, un cuadro de una animación o un tile de un
+			 * tileset. Las coordenadas del cuadro son relativas a la imagen, también si ésta es un recorte.
+			 * @param x Coordenada X del punto superior izquierdo del lugar donde se quiere dibujar el cuadro.
+			 * @param y Coordenada Y del punto superior izquierdo del lugar donde se quiere dibujar el cuadro.
+			 * @param z Coordenada Z (capa) en la que se dibujará el cuadro. Entre 0 y 999.
+			 * @param cuadroX Coordenada X del cuadro dentro de la imagen.
+			 * @param cuadroY Coordenada Y del cuadro dentro de la imagen.
+			 * @param cuadroAncho Ancho en píxeles del cuadro.
+			 * @param cuadroAlto Alto en píxeles del cuadro.
+			 * @param invertido Verdadero si se quiere dibujar el cuadro invertido respecto al eje vertical.
+			 * @param paleta Variante de la paleta con la que se dibuja (ver variante()); 0 es la paleta original.
+			 * @return Verdadero si se ha dibujado el cuadro, y falso en caso contrario.
+			 */
+			bool dibujarCuadro(s16 x, s16 y, s16 z, u16 cuadroX, u16 cuadroY, u16 cuadroAncho, u16 cuadroAlto,
+								bool invertido = false, u8 paleta = 0) const;
 
 			/**
 			 * Método observador para el ancho en píxeles de la imagen.
@@ -171,11 +297,68 @@
 			u16 alto(void) const;
 
 			/**
-			 * Método observador para la textura de la imagen.
+			 * Método observador para la textura de la imagen. La textura de un recorte es la de su página completa,
+			 * así que para dibujarlo hay que utilizar dibujar() o dibujarCuadro().
 			 * @return Objeto de textura de la imagen.
 			 */
 			GXTexObj* textura(void) const;
 
+			/**
+			 * Método observador de la página de la que la imagen es un recorte (ver recortar()).
+			 * @return Página de la imagen, o NULL si la imagen no es un recorte.
+			 */
+			const Imagen* pagina(void) const;
+
+			/**
+			 * Método que indica si la imagen se ha guardado como una textura de índices de paleta.
+			 * @return Verdadero si la textura es CI4 o CI8, falso si es RGB5A3.
+			 */
+			bool indexada(void) const;
+
+			/**
+			 * Método observador del número de colores distintos de una imagen con paleta.
+			 * @return Número de colores de la paleta, o 0 si la imagen no tiene paleta.
+			 */
+			u16 colores(void) const;
+
+			/**
+			 * Método observador de la paleta de la imagen, que se debe indicar al dibujar su textura con la clase
+			 * Screen.
+			 * @param paleta Variante de la paleta (ver variante()); 0 es la paleta original.
+			 * @return Objeto de paleta, o NULL si la imagen no tiene paleta o la variante no existe.
+			 */
+			GXTlutObj* paleta(u8 paleta = 0) const;
+
+			/**
+			 * Método que obtiene una variante de la paleta de la imagen, en la que se sustituyen unos colores por
+			 * otros. Cada variante se crea la primera vez que se pide, y las siguientes peticiones de los mismos
+			 * cambios devuelven la misma variante. La paleta original y sus variantes pertenecen a la imagen, y se
+			 * liberan con ella.
+			 * @param cambios Lista de cambios separados por comas, cada uno con la forma RRGGBBAA:RRGGBBAA (color
+			 * original y color nuevo, en hexadecimal). Por ejemplo, "FF0000FF:0000FFFF" cambia el rojo por azul.
+			 * @return Número de la variante, que se indica al dibujar la imagen; 0 si la imagen no tiene paleta o no
+			 * se indica ningún cambio.
+			 * @throw ImagenEx Se lanza si la lista de cambios es incorrecta, o no se pueden crear más variantes
+			 */
+			u8 variante(const std::string& cambios) const throw (ImagenEx);
+
+			/**
+			 * Método que obtiene la máscara de colisión de la imagen (ver clase Mascara), con un bit por píxel que
+			 * indica si el píxel es opaco. La máscara se crea la primera vez que se pide, a partir de la textura ya
+			 * cargada, y pertenece a la imagen; la de un recorte se crea a partir de su zona de la página. La clase
+			 * Actor la pide al cargar las animaciones de los actores que comprueban sus colisiones píxel a píxel.
+			 * @return Máscara de colisión de la imagen
+			 */
+			const Mascara& mascara(void) const;
+
+			/**
+			 * Método observador de la memoria que ocupa la imagen cargada.
+			 * @return Número de bytes que ocupan los píxeles, las paletas, el objeto de textura y, si se ha creado,
+			 * la máscara de colisión de la imagen; en un recorte, cuyos píxeles son los de su página, sólo cuenta la
+			 * máscara.
+			 */
+			u32 bytes(void) const;
+
 			/**
 			 * Destructor de la clase Imagen. Libera la memoria ocupada por la textura y la información
 			 * de los píxeles.
@@ -197,44 +380,47 @@
 			Imagen& operator=(const Imagen& i);
 
 		private:
-			#pragma pack(push,bitmap_data,1)
-			// Estructura para la cabecera de un archivo BMP
-			typedef struct tagBitmapFileHeader
-			{
-				u16 bfType;
-				u32 bfSize;
-				u16 bfReserved1;
-				u16 bfReserved2;
-				u32 bfOffBits;
-			} BitmapFileHeader;
-
-			// Estructura para la cabecera de una imagen BMP
-			typedef struct tagBitmapInfoHeader
+			// Formatos de archivo que se pueden decodificar
+			enum Fichero { CUALQUIERA, BMP, PNG };
+
+			// Paleta de colores RGB5A3 de una textura de índices; la original no tiene cambios
+			struct Paleta
 			{
-				u32 biSize;
-				u32 biWidth;
-				u32 biHeight;
-				u16 biPlanes;
-				u16 biBitCount;
-				u32 biCompression;
-				u32 biSizeImage;
-				u32 biXPelsPerMeter;
-				u32 biYPelsPerMeter;
-				u32 biClrUsed;
-				u32 biClrImportant;
-			} BitmapInfoHeader;
-			#pragma pack(pop,bitmap_data)
-
-			// Cargar un BMP con color de 24 bits (8 bits por componente)
-			// Debe ser llamada únicamente desde CargarBmp()
-			void cargarBmp24(std::ifstream& archivo);
+				std::string cambios;
+				u16* colores;
+				GXTlutObj tlut;
+			};
+
+			// Leer el archivo y decodificarlo, comprobando que su firma corresponda al formato pedido
+			void decodificar(const std::string& ruta, Fichero fichero) throw (ArchivoEx, ImagenEx, TarjetaEx);
+			// Decodificar un archivo ya leído en memoria
+			void decodificarBmp(const u8* datos, u32 tam) throw (ImagenEx);
+			void decodificarPng(const u8* datos, u32 tam) throw (ImagenEx);
+			// Convertir la textura RGB5A3 recién decodificada en una de índices, si tiene 256 colores o menos
+			void convertirIndexada(void);
+			// Utilizar directamente una textura cocinada ya leída, que pasa a ser propiedad de la imagen
+			void usarCocinada(u8* datos, const textura::Cabecera& cabecera) throw (ImagenEx);
+			// Número de colores de la tabla de cada paleta: 16 en CI4 y 256 en CI8
+			u16 tamPaleta(void) const;
 			// Para dejar el objeto imagen como recién creado, liberando la memoria ocupada
 			void reset(void);
 
 			GXTexObj* _imagen;
-			u16* _pixelData;
+			void* _pixelData;
+			// Archivo completo de una textura cocinada, del que forman parte la textura y la paleta original
+			u8* _cocinada;
+			// Página de la que la imagen es un recorte, y posición del recorte en ella
+			const Imagen* _pagina;
+			u16 _x;
+			u16 _y;
+			textura::Formato _formato;
+			u16 _colores;
 			u16 _alto;
 			u16 _ancho;
+			// Paleta original y variantes; se crean al pedirlas, así que pueden cambiar en una imagen constante
+			mutable std::vector<Paleta> _paletas;
+			// Máscara de colisión; se crea al pedirla, igual que las variantes de la paleta
+			mutable Mascara* _mascara;
 	};
 
 #endif
@@ -0,0 +1,200 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _INFLADOR_H_
+#define _INFLADOR_H_
+
+	#include <cstring>
+	#include <gctypes.h>
+	#include "memoria.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que descomprime un flujo Deflate (o zlib) poco a poco, a medida que se van pidiendo los datos.
+	 *
+	 * @details El formato Deflate es el que utilizan las imágenes PNG y las capas de los mapas de Tiled guardadas con
+	 * compresión zlib. La copia de zlib que incluye FreeType se compila de forma privada dentro de la propia FreeType,
+	 * así que la biblioteca tiene su propio descompresor, que además está pensado para no necesitar nunca el resultado
+	 * completo en memoria: quien lo utiliza pide los bytes que necesita en cada momento (por ejemplo, una fila de
+	 * píxeles de una imagen PNG) y los procesa antes de pedir los siguientes. Igual que el códec ADPCM o LZ4, no
+	 * depende de ninguna biblioteca de la consola y se compila tanto para la Wii como para el PC.
+	 *
+	 * Los datos comprimidos pueden estar en una única zona de memoria, o repartidos en varios trozos (como los
+	 * bloques IDAT de una imagen PNG). En este último caso, se indica una función que entrega el siguiente trozo
+	 * cada vez que el descompresor agota el anterior.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * El descompresor es una máquina de estados que sólo se detiene entre dos símbolos: si una copia de datos
+	 * anteriores no cabe en lo que queda de la petición actual, la parte pendiente se guarda y se completa al
+	 * comienzo de la siguiente. Los últimos 32 KB descomprimidos se guardan en una ventana circular, que es todo lo
+	 * que necesitan las copias de Deflate. Los códigos de Huffman de hasta 9 bits (casi todos) se decodifican con una
+	 * sola consulta a una tabla, y los más largos, bit a bit con el método canónico. En los flujos zlib se comprueba
+	 * además la cabecera y la suma Adler-32 del final.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * Inflador z(datos, tam);
+	 * u8 fila[256];
+	 * while(z.leer(fila, sizeof(fila)) == sizeof(fila))
+	 * {
+	 *     // ... procesar la fila ...
+	 * }
+	 * if(z.error())
+	 *     // ... datos corruptos ...
+	 * @endcode
+	 *
+	 */
+	class Inflador
+	{
+		public:
+
+			/**
+			 * Función que entrega el siguiente trozo de datos comprimidos.
+			 * @param contexto Puntero que se indicó al construir el descompresor
+			 * @param datos Variable donde se guarda la dirección del trozo
+			 * @param tam Variable donde se guarda el tamaño en bytes del trozo
+			 * @return Verdadero si hay un trozo más, falso si ya no quedan datos
+			 */
+			typedef bool (*Fuente)(void* contexto, const u8*& datos, u32& tam);
+
+			/**
+			 * Constructor de la clase Inflador para datos comprimidos que se encuentran en una única zona de memoria.
+			 * @param datos Datos comprimidos
+			 * @param tam Tamaño en bytes de los datos comprimidos
+			 * @param zlib Verdadero si los datos tienen la cabecera y la suma de comprobación de zlib, falso si son
+			 * un flujo Deflate sin más
+			 * @param etiqueta Subsistema al que se asigna la memoria de la ventana (ver memoria.h)
+			 */
+			Inflador(const u8* datos, u32 tam, bool zlib = true, memoria::Etiqueta etiqueta = memoria::ARCHIVOS);
+
+			/**
+			 * Constructor de la clase Inflador para datos comprimidos repartidos en varios trozos.
+			 * @param fuente Función que entrega cada trozo de datos comprimidos
+			 * @param contexto Puntero que se pasa a la función en cada llamada
+			 * @param zlib Verdadero si los datos tienen la cabecera y la suma de comprobación de zlib, falso si son
+			 * un flujo Deflate sin más
+			 * @param etiqueta Subsistema al que se asigna la memoria de la ventana (ver memoria.h)
+			 */
+			Inflador(Fuente fuente, void* contexto, bool zlib = true,
+						memoria::Etiqueta etiqueta = memoria::ARCHIVOS);
+
+			/**
+			 * Destructor de la clase Inflador. Libera la ventana.
+			 */
+			~Inflador(void);
+
+			/**
+			 * Método que descomprime los siguientes bytes del flujo.
+			 * @param destino Memoria donde se escriben los bytes descomprimidos
+			 * @param tam Número de bytes que se quieren obtener
+			 * @return Número de bytes escritos; si es menor que tam, el flujo ha terminado o contiene un error
+			 */
+			u32 leer(u8* destino, u32 tam);
+
+			/**
+			 * Método que lee el resto del flujo, que no debe contener más datos, y comprueba su final (y la suma
+			 * Adler-32, si es un flujo zlib).
+			 * @return Verdadero si el flujo termina correctamente sin más datos, falso en caso contrario
+			 */
+			bool terminar(void);
+
+			/**
+			 * Método que indica si se ha llegado al final del flujo, y éste es correcto.
+			 * @return Verdadero si el flujo ha terminado correctamente, falso en caso contrario
+			 */
+			bool terminado(void) const;
+
+			/**
+			 * Método que indica si se ha encontrado un error en los datos comprimidos (o no había memoria para la
+			 * ventana).
+			 * @return Verdadero si hay un error, falso en caso contrario
+			 */
+			bool error(void) const;
+
+		protected:
+
+			/**
+			 * Constructor de copia de la clase Inflador. Se encuentra en la zona protegida para no permitir la copia.
+			 */
+			Inflador(const Inflador& i);
+
+			/**
+			 * Operador de asignación de la clase Inflador. Se encuentra en la zona protegida para no permitir la
+			 * asignación.
+			 */
+			Inflador& operator=(const Inflador& i);
+
+		private:
+
+			// Bits de los códigos que se decodifican con una sola consulta
+			static const u32 BITS_RAPIDA = 9;
+
+			// Código de Huffman canónico: número de códigos de cada longitud, símbolos ordenados por código, y tabla
+			// de consulta directa (símbolo << 4 | longitud) para los códigos cortos
+			struct Huffman
+			{
+				u16 cuenta[16];
+				u16 simbolos[288];
+				u16 rapida[1 << BITS_RAPIDA];
+			};
+
+			// Fases de la descompresión
+			enum Fase { CABECERA, BLOQUE, ALMACENADO, COMPRIMIDO, COLA, FIN, FALLO };
+
+			void iniciar(bool zlib, memoria::Etiqueta etiqueta);
+			bool rellenar(u32 n);
+			u32 bits(u32 n);
+			bool byte(u8& b);
+			s32 simbolo(const Huffman& h);
+			bool construir(Huffman& h, const u8* longitudes, u32 n);
+			bool leerCabecera(void);
+			bool leerBloque(void);
+			bool leerCodigos(void);
+			bool leerCola(void);
+			void emitir(u8 b, u8* destino, u32& escritos);
+
+			// Entrada
+			Fuente _fuente;
+			void* _contexto;
+			const u8* _pos;
+			const u8* _fin;
+			u32 _bits;
+			u32 _num_bits;
+
+			// Estado
+			Fase _fase;
+			bool _zlib;
+			bool _ultimo;
+			u32 _pendiente;
+			u32 _distancia;
+			Huffman _literales;
+			Huffman _distancias;
+
+			// Ventana con los últimos 32 KB, y suma Adler-32 de todo lo descomprimido
+			u8* _ventana;
+			u32 _posicion;
+			u32 _total;
+			u32 _s1;
+			u32 _s2;
+			u32 _sin_reducir;
+	};
+
+#endif
+
@@ -23,11 +23,14 @@
 	#include <sstream>
 	#include <string>
 	#include <vector>
+	#include "cargador.h"
 	#include "excepcion.h"
 	#include "galeria.h"
 	#include "lang.h"
 	#include "logger.h"
 	#include "mando.h"
+	#include "memoria.h"
+	#include "perfilador.h"
 	#include "util.h"
 
 	/**
@@ -58,7 +61,12 @@
 	 * se especifican las etiquetas de texto del sistema de idiomas y el nombre del idioma por defecto (más detalles en
 	 * la descripción de la clase Lang), y por último, la configuración de jugadores, consistente en cuatro atributos
 	 * de tipo cadena de caracteres en los que se deben especificar los códigos identificadores para cada uno de los
-	 * jugadores.
+	 * jugadores. De forma opcional, se puede indicar la ruta absoluta de un paquete de recursos creado con la
+	 * herramienta empaquetar (ver clase Paquete), en cuyo caso todos los recursos que contenga se leerán desde él.
+	 * También es opcional la etiqueta perfil, cuyos atributos activo y visible (0 o 1) activan el perfilador de frames
+	 * y muestran su gráfica en pantalla (ver clase Perfilador), y el atributo latencia de la etiqueta fps, que con
+	 * valor 1 permite a la CPU calcular un frame mientras el procesador gráfico dibuja el anterior (ver
+	 * Screen::setLatencia()).
 	 *
 	 * A continuación, se muestra un ejemplo del archivo de configuración esperado:
 	 *
@@ -67,7 +75,9 @@
 	 * <conf>
 	 *   <log valor="/apps/wiipang/info.log" nivel="3" />
 	 *   <alpha valor="0xFF00FFFF" />
-	 *   <fps valor="25" />
+	 *   <fps valor="25" latencia="1" />
+	 *   <perfil activo="1" visible="0" />
+	 *   <paquete valor="/apps/wiipang/datos.pak" />
 	 *   <galeria valor="/apps/wiipang/xml/galeria.xml" />
 	 *   <lang valor="/apps/wiipang/xml/lang.xml" defecto="english" />
 	 *   <jugadores pj1="pj1" pj2="pj2" pj3="" pj4="" />
@@ -87,8 +97,8 @@
 	 * una cadena vacía como identificador. Posteriormente, guarda cada mando asociado al código del jugador
 	 * correspondiente en el diccionario de Controles.
 	 *
-	 * Por último, se cargan todos los recursos media en la Galeria, y las etiquetas de texto para los idiomas del
-	 * sistema en la clase Lang.
+	 * Por último, se monta el paquete de recursos (si se ha indicado alguno), y se cargan todos los recursos media en
+	 * la Galeria, y las etiquetas de texto para los idiomas del sistema en la clase Lang.
 	 *
 	 * Después de haber inicializado la consola partiendo del archivo de configuración, el método virtual run()
 	 * proporciona una implementación básica del bucle principal del programa, en la que se controlan las posibles
@@ -19,23 +19,45 @@
 #define _LIBWIIESP_H_
 
 	#include "actor.h"
+	#include "adpcm.h"
 	#include "animacion.h"
+	#include "atlas.h"
+	#include "bmp.h"
+	#include "cargador.h"
 	#include "colision.h"
+	#include "contadores.h"
 	#include "excepcion.h"
+	#include "fijo.h"
+	#include "fnv1a.h"
 	#include "fuente.h"
 	#include "galeria.h"
 	#include "imagen.h"
+	#include "inflador.h"
 	#include "juego.h"
 	#include "lang.h"
 	#include "logger.h"
+	#include "lz4.h"
+	#include "manifiesto.h"
+	#include "mascara.h"
 	#include "mando.h"
+	#include "memoria.h"
+	#include "mezclador.h"
 	#include "musica.h"
 	#include "nivel.h"
+	#include "paquete.h"
 	#include "parser.h"
+	#include "perfilador.h"
+	#include "pngdec.h"
+	#include "rasterizador.h"
+	#include "ritmo.h"
 	#include "screen.h"
 	#include "sdcard.h"
 	#include "sonido.h"
+	#include "textura.h"
+	#include "tiled.h"
+	#include "trigonometria.h"
 	#include "util.h"
+	#include "voces.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
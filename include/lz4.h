@@ -0,0 +1,112 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _LZ4_H_
+#define _LZ4_H_
+
+	#include <cstring>
+	#include <vector>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para comprimir y descomprimir datos con el algoritmo LZ4.
+	 *
+	 * @details Leer de la tarjeta SD es la parte más lenta de la carga de un juego, y los recursos más habituales
+	 * (imágenes BMP, mapas TMX, efectos de sonido PCM) se almacenan sin comprimir. LZ4 es un algoritmo de compresión
+	 * muy sencillo, cuya descompresión sólo copia bytes, así que la consola descomprime bastante más rápido de lo que
+	 * tarda en leer de la tarjeta los bytes que se ahorran. La herramienta empaquetar (ver directorio tools) comprime
+	 * con este código cada archivo del paquete de recursos que se beneficie de ello, y la clase Paquete lo descomprime
+	 * al leerlo, sin que el resto de la biblioteca lo note. Igual que el códec ADPCM, no depende de ninguna biblioteca
+	 * de la consola y se compila tanto para la Wii como para el PC.
+	 *
+	 * Un flujo comprimido es una serie de bloques, cada uno de los cuales se descomprime en TAM_BLOQUE bytes (salvo
+	 * el último, que puede ser menor). Cada bloque comienza con su tamaño en bytes (32 bits en big endian, como el
+	 * resto de formatos de la biblioteca); si el bit de mayor peso de ese tamaño está activo, el bloque se guarda
+	 * sin comprimir. El contenido de un bloque comprimido sigue el formato de bloque estándar de LZ4, con la única
+	 * particularidad de que sus copias pueden hacer referencia a los 64 KB anteriores aunque pertenezcan a bloques
+	 * previos. Así, para descomprimir un archivo basta con leer un bloque cada vez en una memoria pequeña y
+	 * descomprimirlo directamente en su posición del destino final, sin necesidad de tener en memoria el archivo
+	 * comprimido completo.
+	 *
+	 */
+	namespace lz4
+	{
+		/**
+		 * Tamaño en bytes de los datos descomprimidos de cada bloque (salvo el último).
+		 */
+		static const u32 TAM_BLOQUE = 65536;
+
+		/**
+		 * Bit que indica, en el tamaño de un bloque, que éste se ha guardado sin comprimir.
+		 */
+		static const u32 SIN_COMPRIMIR = 0x80000000;
+
+		/**
+		 * Calcula el máximo tamaño que puede ocupar un bloque comprimido, sin contar los 4 bytes de su tamaño.
+		 * @param tam Tamaño de los datos sin comprimir del bloque
+		 * @return Tamaño máximo del bloque comprimido
+		 */
+		u32 cotaBloque(u32 tam);
+
+		/**
+		 * Comprime un conjunto de datos en un flujo de bloques LZ4.
+		 * @param datos Datos que se quieren comprimir
+		 * @param tam Tamaño en bytes de los datos
+		 * @param salida Vector al que se añade el flujo comprimido
+		 */
+		void comprimir(const u8* datos, u32 tam, std::vector<u8>& salida);
+
+		/**
+		 * Descomprime un bloque en su posición del destino final.
+		 * @param bloque Contenido del bloque, sin los 4 bytes de su tamaño
+		 * @param tam Tamaño del bloque, tal y como se ha leído antes de su contenido (incluido el bit SIN_COMPRIMIR)
+		 * @param inicio Comienzo del destino final, hasta donde pueden llegar las copias del bloque
+		 * @param destino Posición del destino en la que se escriben los datos del bloque
+		 * @param tam_destino Tamaño exacto de los datos descomprimidos del bloque
+		 * @return Verdadero si el bloque es correcto y ocupa exactamente tam_destino bytes, falso en caso contrario
+		 */
+		bool descomprimirBloque(const u8* bloque, u32 tam, const u8* inicio, u8* destino, u32 tam_destino);
+
+		/**
+		 * Descomprime un flujo completo que se encuentra en memoria.
+		 * @param datos Flujo comprimido
+		 * @param tam Tamaño en bytes del flujo comprimido
+		 * @param destino Memoria donde se escriben los datos descomprimidos
+		 * @param tam_destino Tamaño exacto de los datos descomprimidos
+		 * @return Verdadero si el flujo es correcto, falso en caso contrario
+		 */
+		bool descomprimir(const u8* datos, u32 tam, u8* destino, u32 tam_destino);
+
+		/**
+		 * Lee el tamaño de un bloque.
+		 * @param datos Dirección de memoria donde comienza el bloque
+		 * @return Tamaño del bloque, incluido el bit SIN_COMPRIMIR
+		 */
+		u32 leerTamBloque(const u8* datos);
+
+		/**
+		 * Calcula cuántos bytes ocupa un bloque en el flujo comprimido, sin contar los 4 bytes de su tamaño.
+		 * @param tam Tamaño del bloque, tal y como se ha leído antes de su contenido (incluido el bit SIN_COMPRIMIR)
+		 * @return Número de bytes del contenido del bloque
+		 */
+		u32 bytesBloque(u32 tam);
+	}
+
+#endif
+
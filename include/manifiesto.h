@@ -0,0 +1,190 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _MANIFIESTO_H_
+#define _MANIFIESTO_H_
+
+	#include <cstdlib>
+	#include <set>
+	#include <string>
+	#include <utility>
+	#include <vector>
+	#include <gctypes.h>
+	#include <tinyxml.h>
+	#include "excepcion.h"
+	#include "galeria.h"
+	#include "sdcard.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que recoge la lista de recursos de la galería que utiliza un nivel.
+	 *
+	 * @details Un nivel utiliza sólo una parte de los recursos del juego: su imagen de fondo, su tileset, su música y
+	 * las imágenes de las animaciones de sus actores. El Manifiesto de un nivel es la lista exacta de esos recursos,
+	 * y permite cargarlos todos antes de comenzar el nivel (en lugar de ir cargándolos durante la partida, o de tener
+	 * cargados desde el principio los de todos los niveles), y descargarlos al terminarlo. De esta forma, la memoria
+	 * que ocupan los recursos en cada momento es la del nivel en curso, y no la de todo el juego.
+	 *
+	 * El manifiesto se construye a partir del archivo TMX del nivel y de los archivos XML de los actores a los que
+	 * hace referencia, y recoge los siguientes recursos:
+	 *
+	 * - Las propiedades del mapa imagen_fondo e imagen_tileset (imágenes) y musica (pista de música), las mismas que
+	 * lee la clase Nivel.
+	 * - Las propiedades opcionales del mapa imagenes, musicas, sonidos y fuentes, cuyo valor es una lista de códigos
+	 * de la galería separados por comas. Sirven para los recursos que el nivel utiliza desde el código del juego (un
+	 * efecto de sonido, la fuente del marcador, etc.) y que no se pueden deducir de ningún archivo.
+	 * - Las imágenes de las animaciones (atributo img) de cada actor de la capa de objetos, cuyo archivo XML se indica
+	 * en la propiedad xml del objeto, igual que en la clase Nivel.
+	 * - Las imágenes de las animaciones de los actores cuyo archivo XML se indica en una propiedad del mapa que
+	 * comience por 'xml' (por ejemplo, xml_bola), que son los actores que el juego crea durante la partida.
+	 *
+	 * Cada recurso aparece una sola vez en el manifiesto, aunque lo utilicen varios actores.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * El manifiesto lee los archivos XML de los actores en documentos propios, sin utilizar la clase Parser, y no
+	 * accede a la galería mientras se construye, así que se puede construir desde el hilo de carga de la clase
+	 * Cargador (de hecho, es lo que hace Cargador::nivel()). Cada archivo XML de actor se lee una sola vez, aunque lo
+	 * utilicen varios objetos.
+	 *
+	 * Una vez construido, el método retener() retiene (y, por tanto, carga) en la galería todos los recursos del
+	 * manifiesto, y el método liberar() deshace las retenciones y descarta de la galería los recursos que hayan
+	 * quedado sin retener (ver Galeria::descartar()); los recursos que siga reteniendo otro usuario, por ejemplo el
+	 * manifiesto del siguiente nivel, permanecen cargados. El método reservar() retiene los recursos sin cargarlos, y
+	 * lo utiliza el Cargador para que los recursos del siguiente nivel no se descarten mientras se cargan; una
+	 * llamada posterior a retener() sustituye las reservas por retenciones.
+	 *
+	 * La clase Nivel construye y retiene el manifiesto de su archivo TMX en su constructor, y lo libera en su
+	 * destructor, así que normalmente no es necesario utilizar esta clase directamente.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * Manifiesto m;
+	 * m.leer("/apps/wiipang/xml/nivel1.tmx");
+	 * // Cargar todo lo necesario antes de empezar
+	 * m.retener();
+	 * // ... partida ...
+	 * // Descargar lo que ya no se necesite
+	 * m.liberar();
+	 * @endcode
+	 *
+	 */
+	class Manifiesto
+	{
+		public:
+
+			/**
+			 * Recurso del manifiesto: su tipo y su código en la galería.
+			 */
+			typedef std::pair<Galeria::Tipo, std::string> Recurso;
+
+			/**
+			 * Lista de recursos del manifiesto, sin repetidos, en el orden en que aparecen.
+			 */
+			typedef std::vector<Recurso> Recursos;
+
+			/**
+			 * Constructor de la clase Manifiesto. Crea un manifiesto vacío.
+			 */
+			Manifiesto(void);
+
+			/**
+			 * Método que lee el archivo TMX de un nivel y construye su manifiesto, añadiéndolo al que ya hubiera.
+			 * @param ruta Ruta absoluta hasta el archivo TMX en la tarjeta SD
+			 * @throw ArchivoEx Se lanza si hay algún error al leer el archivo TMX o el XML de algún actor
+			 * @throw TarjetaEx Se lanza si la tarjeta SD no está montada
+			 */
+			void leer(const std::string& ruta) throw (ArchivoEx, TarjetaEx);
+
+			/**
+			 * Método que construye el manifiesto de un nivel a partir de su archivo TMX ya analizado, añadiéndolo al
+			 * que ya hubiera.
+			 * @param mapa Elemento raíz (etiqueta map) del archivo TMX
+			 * @throw ArchivoEx Se lanza si hay algún error al leer el XML de algún actor
+			 * @throw TarjetaEx Se lanza si la tarjeta SD no está montada
+			 */
+			void leer(const TiXmlElement* mapa) throw (ArchivoEx, TarjetaEx);
+
+			/**
+			 * Método que añade un recurso al manifiesto, si no estaba ya.
+			 * @param tipo Tipo del recurso
+			 * @param codigo Código del recurso en la galería
+			 */
+			void anadir(Galeria::Tipo tipo, const std::string& codigo);
+
+			/**
+			 * Método que indica si un recurso forma parte del manifiesto.
+			 * @param tipo Tipo del recurso
+			 * @param codigo Código del recurso en la galería
+			 * @return Verdadero si el recurso está en el manifiesto, falso en caso contrario
+			 */
+			bool contiene(Galeria::Tipo tipo, const std::string& codigo) const;
+
+			/**
+			 * Método consultor de los recursos del manifiesto.
+			 * @return Lista de recursos, sin repetidos
+			 */
+			const Recursos& recursos(void) const;
+
+			/**
+			 * Método que retiene en la galería, cargándolos si es necesario, todos los recursos del manifiesto. Si
+			 * estaban reservados, las reservas se sustituyen por retenciones. Si ya estaban retenidos, no hace nada.
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo de un recurso
+			 * @throw CodigoEx Se lanza si algún código no corresponde a ningún recurso de la galería
+			 * @throw ImagenEx Se lanza si sucede un error relacionado con la carga de una imagen
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
+			 */
+			void retener(void) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
+
+			/**
+			 * Método que retiene en la galería todos los recursos del manifiesto, sin cargarlos. Si ya estaban
+			 * retenidos o reservados, no hace nada.
+			 * @throw CodigoEx Se lanza si algún código no corresponde a ningún recurso de la galería
+			 */
+			void reservar(void) throw (CodigoEx);
+
+			/**
+			 * Método que libera las retenciones (o las reservas) de todos los recursos del manifiesto, y descarta
+			 * de la galería los que nadie más retenga. Si los recursos no estaban retenidos, no hace nada.
+			 */
+			void liberar(void);
+
+			/**
+			 * Método que indica si los recursos del manifiesto están retenidos o reservados en la galería.
+			 * @return Verdadero si están retenidos o reservados, falso en caso contrario
+			 */
+			bool retenido(void) const;
+
+		private:
+
+			// Estados del manifiesto respecto a la galería
+			enum Estado { LIBRE, RESERVADO, RETENIDO };
+
+			// Leer un archivo XML completo en un documento propio
+			static void cargarXml(const std::string& ruta, TiXmlDocument& doc) throw (ArchivoEx, TarjetaEx);
+			// Añadir los códigos de una lista separada por comas
+			void anadirLista(Galeria::Tipo tipo, const std::string& lista);
+			// Añadir las imágenes de las animaciones de un actor
+			void leerActor(const std::string& ruta, std::set<std::string>& leidos) throw (ArchivoEx, TarjetaEx);
+
+			Recursos _recursos;
+			Estado _estado;
+	};
+
+#endif
+
@@ -0,0 +1,176 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _MASCARA_H_
+#define _MASCARA_H_
+
+	#include <vector>
+	#include <gctypes.h>
+	#include "textura.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que representa la máscara de colisión de una imagen: un bit por píxel, que indica si es opaco.
+	 *
+	 * @details Las figuras de colisión de un actor (ver clase Figura) son rectángulos, círculos y puntos escritos a
+	 * mano, que en sprites de formas irregulares (un pato con las alas abiertas, por ejemplo) dejan huecos o sobran
+	 * por todas partes. La máscara de una imagen guarda, para cada píxel, si se ve o no al dibujarla, de forma que se
+	 * puede saber con exactitud si dos sprites se tocan. Un píxel se considera opaco si supera la comparación de alpha
+	 * con la que dibuja la clase Screen, es decir, si tiene el bit de opaco de RGB5A3 o algo de alpha; los píxeles
+	 * del color transparente (ver Imagen::alpha) son, por tanto, transparentes.
+	 *
+	 * La clase Imagen crea la máscara de una imagen cuando se le pide por primera vez (ver Imagen::mascara()), y la
+	 * clase Actor la pide al cargar las animaciones de los actores que la utilizan (ver clase Actor). Las
+	 * comprobaciones con máscaras sólo se hacen cuando las figuras de colisión ya se tocan, así que su coste queda
+	 * acotado por el número de colisiones, y no por el de actores.
+	 *
+	 * Igual que la clase Contadores, esta clase no depende de ninguna biblioteca de la consola y se compila tanto para
+	 * la Wii como para el PC.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Cada fila de la máscara se guarda en palabras de 32 bits (el tamaño de los registros del procesador de la
+	 * consola), con el píxel de la izquierda en el bit de mayor peso, más una palabra a cero al final, de forma que
+	 * se pueden leer 32 bits a partir de cualquier columna sin salirse de la fila. Se guarda además cada fila al
+	 * revés, para los cuadros que se dibujan invertidos: la máscara ocupa dos bits por píxel, y a cambio comprobar un
+	 * cuadro invertido cuesta lo mismo que uno normal.
+	 *
+	 * Para saber si dos cuadros se solapan, se calcula el rectángulo en el que coinciden en el escenario y, en cada
+	 * fila de ese rectángulo, se extraen de cada máscara los bits de esa fila desplazados a la misma columna, y se
+	 * comparan con un AND de 32 en 32 píxeles; en cuanto un AND no es cero, los cuadros se tocan.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // ¿Se tocan el cuadro 2 del pato (de 100x100 píxeles, en una imagen de una fila) y la mira?
+	 * const Mascara& pato = galeria->imagen("pato").mascara();
+	 * const Mascara& mira = galeria->imagen("mira").mascara();
+	 * Mascara::Cuadro a = { 200, 0, 100, 100, false, pato_x, pato_y };
+	 * Mascara::Cuadro b = { 0, 0, 30, 30, false, mira_x, mira_y };
+	 * if(pato.solapa(a, mira, b))
+	 *   ...
+	 * @endcode
+	 *
+	 */
+	class Mascara
+	{
+		public:
+
+			/**
+			 * @brief Cuadro de una máscara y posición en la que se encuentra en el escenario.
+			 */
+			typedef struct cuadro
+			{
+				u16 x;				/**< Columna del cuadro dentro de la máscara */
+				u16 y;				/**< Fila del cuadro dentro de la máscara */
+				u16 ancho;			/**< Ancho del cuadro */
+				u16 alto;			/**< Alto del cuadro */
+				bool invertido;		/**< Si el cuadro se dibuja invertido horizontalmente */
+				s32 posX;			/**< Posición horizontal de la esquina superior izquierda en el escenario */
+				s32 posY;			/**< Posición vertical de la esquina superior izquierda en el escenario */
+			} Cuadro;
+
+			/**
+			 * Constructor de la clase Mascara. Crea una máscara vacía, de cero píxeles.
+			 */
+			Mascara(void);
+
+			/**
+			 * Método que crea la máscara de un rectángulo de una textura de las que utiliza la clase Imagen.
+			 * @param texels Textura, organizada en bloques
+			 * @param formato Formato de la textura: RGB5A3, CI8 o CI4; con cualquier otro, la máscara es opaca
+			 * @param paleta Colores RGB5A3 de la paleta, en los formatos de índices; si es NULL, la máscara es opaca
+			 * @param ancho_textura Ancho en píxeles de la textura
+			 * @param x Columna de la esquina superior izquierda del rectángulo
+			 * @param y Fila de la esquina superior izquierda del rectángulo
+			 * @param ancho Ancho en píxeles del rectángulo, y de la máscara
+			 * @param alto Alto en píxeles del rectángulo, y de la máscara
+			 */
+			void crear(const void* texels, textura::Formato formato, const u16* paleta, u16 ancho_textura, u16 x,
+						u16 y, u16 ancho, u16 alto);
+
+			/**
+			 * Método consultor del ancho de la máscara.
+			 * @return Ancho en píxeles
+			 */
+			u16 ancho(void) const;
+
+			/**
+			 * Método consultor del alto de la máscara.
+			 * @return Alto en píxeles
+			 */
+			u16 alto(void) const;
+
+			/**
+			 * Método que indica si un píxel de la máscara es opaco.
+			 * @param x Columna del píxel
+			 * @param y Fila del píxel
+			 * @return Verdadero si el píxel es opaco, falso si es transparente o está fuera de la máscara
+			 */
+			bool opaco(u16 x, u16 y) const;
+
+			/**
+			 * Método que comprueba si un cuadro de esta máscara y un cuadro de otra tienen algún píxel opaco en la
+			 * misma posición del escenario.
+			 * @param propio Cuadro de esta máscara y su posición
+			 * @param otra Otra máscara (puede ser la misma)
+			 * @param ajeno Cuadro de la otra máscara y su posición
+			 * @return Verdadero si los cuadros se tocan, falso en caso contrario
+			 */
+			bool solapa(const Cuadro& propio, const Mascara& otra, const Cuadro& ajeno) const;
+
+			/**
+			 * Método que comprueba si un cuadro de esta máscara tiene algún píxel opaco dentro de un rectángulo del
+			 * escenario.
+			 * @param propio Cuadro de esta máscara y su posición
+			 * @param x0 Columna del escenario del borde izquierdo del rectángulo
+			 * @param y0 Fila del escenario del borde superior del rectángulo
+			 * @param x1 Columna del escenario del borde derecho del rectángulo (incluida)
+			 * @param y1 Fila del escenario del borde inferior del rectángulo (incluida)
+			 * @return Verdadero si hay algún píxel opaco dentro del rectángulo, falso en caso contrario
+			 */
+			bool contiene(const Cuadro& propio, s32 x0, s32 y0, s32 x1, s32 y1) const;
+
+			/**
+			 * Método que calcula la memoria que ocupa la máscara.
+			 * @return Tamaño en bytes de los bits de la máscara
+			 */
+			u32 bytes(void) const;
+
+		private:
+
+			// Máximo ancho en píxeles de una comprobación, el de la mayor textura de la GX
+			static const u32 MAX_ANCHO = 1024;
+
+			// Comprobar que un cuadro esté dentro de la máscara
+			bool valido(const Cuadro& c) const;
+			// Extraer los bits de una fila de un cuadro, a partir de una columna del cuadro, en palabras de 32 bits
+			void extraer(const Cuadro& c, u16 fila, u16 columna, u16 bits, u32* destino) const;
+			// Recortar un rectángulo del escenario al de un cuadro; falso si no coinciden
+			static bool recortar(const Cuadro& c, s32& x0, s32& y0, s32& x1, s32& y1);
+
+			u16 _ancho, _alto;
+			// Palabras de cada fila, incluida la palabra de relleno
+			u32 _palabras;
+			// Filas de la máscara y filas invertidas, una detrás de otra
+			std::vector<u32> _bits;
+			std::vector<u32> _invertidos;
+	};
+
+#endif
+
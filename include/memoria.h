@@ -0,0 +1,188 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _MEMORIA_H_
+#define _MEMORIA_H_
+
+	#include <cstdlib>
+	#include <cstring>
+	#include <malloc.h>
+	#include <string>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para reservar memoria alineada llevando la cuenta de cuánta utiliza cada subsistema.
+	 *
+	 * @details La Wii dispone de muy poca memoria (24 MB de MEM1 y 64 MB de MEM2), y cuando se agota no hay forma de
+	 * saber desde la consola quién la está ocupando. Toda la memoria que reserva la biblioteca (texturas, sonidos,
+	 * música, mapas de los niveles, actores, fuentes, documentos XML, archivos leídos de la tarjeta SD...) se pide a
+	 * través de estas funciones, indicando en cada reserva una etiqueta con el subsistema al que pertenece. Para cada
+	 * etiqueta se lleva la cuenta de los bytes y bloques vivos en cada momento, y del pico de bytes vivos alcanzado
+	 * (la marca de agua), de tal manera que se puede consultar en tiempo de ejecución cuánta memoria utiliza cada
+	 * parte del juego, y cuál es el máximo que ha llegado a necesitar (por ejemplo, durante la transición entre dos
+	 * niveles, cuando conviven los recursos de ambos). La función informe() vuelca todos los contadores en el log del
+	 * sistema.
+	 *
+	 * Igual que el códec ADPCM o LZ4, este código no depende de ninguna biblioteca de la consola y se compila también
+	 * para el PC (las herramientas del directorio tools lo utilizan a través de la clase Paquete). Fuera de la
+	 * consola, además, se mantiene una lista con todos los bloques vivos y, al terminar el programa, se muestra por la
+	 * salida de error un informe de fugas con los bloques que nadie ha liberado.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Cada bloque va precedido de una cabecera de TAM_CABECERA bytes, que guarda un número mágico, el tamaño pedido y
+	 * la etiqueta del bloque (y, fuera de la consola, los enlaces de la lista de bloques vivos). La cabecera ocupa un
+	 * múltiplo de 32 bytes, así que la memoria que se devuelve sigue alineada a 32 bytes, como la que devuelve
+	 * memalign(32, ...), y se puede utilizar para texturas, DMA de audio o el FIFO de GX. Al liberar un bloque, la
+	 * cabecera indica cuánto restar y de qué etiqueta, y el número mágico permite detectar (en la mayoría de los
+	 * casos) la liberación de memoria que no se ha reservado con reservar(), o que ya se había liberado, que se
+	 * ignora en lugar de descuadrar los contadores.
+	 *
+	 * Los contadores se actualizan con las interrupciones deshabilitadas en la consola (son unas pocas sumas, y así
+	 * se pueden utilizar desde cualquier hilo, incluido el hilo de carga de la clase Cargador), y con un mutex fuera
+	 * de ella.
+	 *
+	 * La clase Actor reserva sus instancias (y las de todas sus clases derivadas) con la etiqueta ACTORES, mediante
+	 * sus propios operadores new y delete.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * u8* datos = (u8*)memoria::reservar(1024, memoria::AUDIO);
+	 * // ...
+	 * memoria::liberar(datos);
+	 *
+	 * // Memoria que ocupan ahora mismo las texturas, y máximo que han llegado a ocupar
+	 * u32 vivos = memoria::vivos(memoria::TEXTURAS);
+	 * u32 pico = memoria::pico(memoria::TEXTURAS);
+	 *
+	 * // Volcar todos los contadores en el log
+	 * memoria::informe();
+	 * @endcode
+	 *
+	 */
+	namespace memoria
+	{
+		/**
+		 * Subsistemas a los que se puede asignar la memoria reservada.
+		 */
+		enum Etiqueta
+		{
+			TEXTURAS,	/**< Píxeles de las imágenes */
+			AUDIO,		/**< Efectos de sonido, pistas de música y memorias del mezclador */
+			NIVEL,		/**< Mapas de tiles de los niveles */
+			ACTORES,	/**< Instancias de la clase Actor y sus derivadas */
+			FUENTES,	/**< Archivos de fuentes que utiliza FreeType */
+			XML,		/**< Contenido de los archivos XML y TMX antes de analizarlos */
+			ARCHIVOS,	/**< Archivos leídos de la tarjeta SD y datos de los paquetes de recursos */
+			SISTEMA,	/**< FIFO de GX y memoria temporal de la propia biblioteca */
+			NUM_ETIQUETAS
+		};
+
+		/**
+		 * Tamaño en bytes de la cabecera que precede a cada bloque.
+		 */
+		static const u32 TAM_CABECERA = 32;
+
+		/**
+		 * Reserva un bloque de memoria alineado a 32 bytes, y lo anota en los contadores de una etiqueta.
+		 * @param tam Tamaño en bytes del bloque
+		 * @param etiqueta Subsistema al que pertenece el bloque
+		 * @return Dirección del bloque, o NULL si no hay memoria suficiente
+		 */
+		void* reservar(u32 tam, Etiqueta etiqueta);
+
+		/**
+		 * Libera un bloque reservado con reservar(), y lo descuenta de los contadores de su etiqueta. Si el puntero
+		 * es nulo, no hace nada.
+		 * @param bloque Dirección del bloque
+		 */
+		void liberar(void* bloque);
+
+		/**
+		 * Consulta el tamaño pedido al reservar un bloque.
+		 * @param bloque Dirección de un bloque reservado con reservar()
+		 * @return Tamaño en bytes del bloque, o cero si el puntero no corresponde a ningún bloque
+		 */
+		u32 tam(const void* bloque);
+
+		/**
+		 * Consulta los bytes reservados y todavía sin liberar de una etiqueta.
+		 * @param etiqueta Subsistema que se consulta
+		 * @return Bytes vivos de la etiqueta
+		 */
+		u32 vivos(Etiqueta etiqueta);
+
+		/**
+		 * Consulta el máximo de bytes vivos que ha llegado a tener una etiqueta.
+		 * @param etiqueta Subsistema que se consulta
+		 * @return Marca de agua de la etiqueta, en bytes
+		 */
+		u32 pico(Etiqueta etiqueta);
+
+		/**
+		 * Consulta el número de bloques reservados y todavía sin liberar de una etiqueta.
+		 * @param etiqueta Subsistema que se consulta
+		 * @return Bloques vivos de la etiqueta
+		 */
+		u32 bloques(Etiqueta etiqueta);
+
+		/**
+		 * Consulta los bytes vivos de todas las etiquetas juntas.
+		 * @return Bytes vivos en total
+		 */
+		u32 total(void);
+
+		/**
+		 * Consulta el máximo de bytes vivos, entre todas las etiquetas, que se ha llegado a alcanzar.
+		 * @return Marca de agua total, en bytes
+		 */
+		u32 picoTotal(void);
+
+		/**
+		 * Iguala la marca de agua de cada etiqueta (y la total) a sus bytes vivos en este momento, por ejemplo
+		 * para medir el pico de un nivel concreto.
+		 */
+		void reiniciarPicos(void);
+
+		/**
+		 * Devuelve el nombre de una etiqueta, para mostrarlo en los informes.
+		 * @param etiqueta Subsistema
+		 * @return Nombre del subsistema
+		 */
+		const char* nombre(Etiqueta etiqueta);
+
+		/**
+		 * Construye una línea de texto con los bytes vivos, el pico y los bloques vivos de una etiqueta.
+		 * @param etiqueta Subsistema
+		 * @return Línea con los contadores de la etiqueta
+		 */
+		std::string resumen(Etiqueta etiqueta);
+
+		#ifdef GEKKO
+		/**
+		 * Vuelca en el log del sistema (nivel INFO) los contadores de cada etiqueta, junto con el total y su pico.
+		 * Sólo está disponible en la consola.
+		 */
+		void informe(void);
+		#endif
+	}
+
+#endif
+
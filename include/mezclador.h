@@ -0,0 +1,248 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _MEZCLADOR_H_
+#define _MEZCLADOR_H_
+
+	#include <cstdlib>
+	#include <sstream>
+	#include <string>
+	#include <gctypes.h>
+	#include <gccore.h>
+	#include <malloc.h>
+	#include <asndlib.h>
+	#include <ogc/irq.h>
+	#include <ogc/lwp_watchdog.h>
+	#include "adpcm.h"
+	#include "logger.h"
+	#include "memoria.h"
+	#include "voces.h"
+
+	// Declaración anticipada
+	class Sonido;
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que reparte las voces de la libASND entre los efectos de sonido que se quieren reproducir.
+	 *
+	 * @details La libASND dispone de 16 voces, una de las cuales queda reservada para la pista de música (ver clase
+	 * Musica). Antes de existir esta clase, cada llamada a Sonido::play() tomaba la primera voz libre, y si no había
+	 * ninguna, el efecto simplemente no sonaba. Además, era muy habitual que un mismo efecto se disparase varias veces
+	 * en un mismo frame (por ejemplo, cuando la bola del Arkanoid golpea varios ladrillos a la vez), ocupando varias
+	 * voces con exactamente el mismo sonido y agotándolas en muy poco tiempo.
+	 *
+	 * El Mezclador resuelve ambos problemas. Cada efecto de sonido tiene una prioridad (un entero de 8 bits sin signo,
+	 * donde un valor mayor indica un efecto más importante) y un número máximo de instancias simultáneas (0 indica
+	 * que no hay límite). Cuando se solicita la reproducción de un efecto, se siguen estos pasos:
+	 *
+	 * 1. Si el mismo efecto ya comenzó a sonar dentro de la ventana de fusión (por defecto, la duración de un frame),
+	 * la petición se fusiona con la anterior y no se ocupa una voz nueva.
+	 * 2. Si el efecto ya tiene en reproducción su número máximo de instancias, se reutiliza la voz de la instancia más
+	 * antigua de ese mismo efecto.
+	 * 3. Si hay alguna voz libre, se utiliza.
+	 * 4. Si no hay voces libres, se roba la voz del efecto de menor prioridad (y, en caso de empate, el que lleve más
+	 * tiempo sonando), siempre que su prioridad no sea mayor que la del efecto que se quiere reproducir. En caso
+	 * contrario, la petición se descarta.
+	 *
+	 * Todas estas decisiones quedan reflejadas en unas estadísticas de uso de voces (peticiones, reproducciones,
+	 * fusiones, robos, descartes, voces ocupadas y máximo de voces ocupadas a la vez), que se pueden consultar en
+	 * cualquier momento o volcar en el log del sistema mediante el método informe().
+	 *
+	 * Funcionamiento interno
+	 *
+	 * El Mezclador implementa el patrón Singleton, y mantiene una tabla con el estado de cada voz de efectos: el
+	 * efecto que la ocupa, su prioridad y el instante en el que comenzó a sonar. Una voz se considera libre si la
+	 * libASND indica que no está reproduciendo nada, independientemente de lo que diga la tabla, de tal manera que no
+	 * hace falta ningún tipo de notificación cuando un efecto termina. El instante de cada reproducción se toma de la
+	 * base de tiempos de la consola en microsegundos.
+	 *
+	 * La política de reparto (los cuatro pasos anteriores y las estadísticas) no está en esta clase, sino en el grupo
+	 * de funciones voces, que no depende de la libASND: el Mezclador marca en la tabla las voces que han quedado
+	 * libres, pide a voces::elegir() la voz de cada petición, y sólo se encarga de detener e iniciar las voces. Así
+	 * la política se compila también para el PC, donde la herramienta comprobarvoces comprueba sus decisiones.
+	 *
+	 * Los efectos comprimidos en ADPCM (ver clase Sonido) no se pueden entregar tal cual a la libASND, así que el
+	 * Mezclador reserva para cada voz, la primera vez que la necesita, un búfer doble de muestras PCM. Al iniciar la
+	 * reproducción se decodifican los dos primeros bloques, uno en cada mitad del búfer, y se registra una función de
+	 * retorno en la voz. La libASND llama a esta función cuando empieza a reproducir la segunda mitad, momento en el
+	 * que se decodifica el siguiente bloque en la mitad que acaba de quedar libre y se encola con ASND_AddVoice(), hasta
+	 * agotar los bloques del efecto.
+	 *
+	 * No es necesario utilizar esta clase directamente, ya que Sonido::play() delega en ella, y Sonido::inicializar()
+	 * se encarga de inicializarla. La clase Juego ajusta la ventana de fusión a la duración de un frame según los FPS
+	 * indicados en el archivo de configuración.
+	 *
+	 * Ejemplo de uso
+	 *
+	 * @code
+	 * // Reproducir el mismo efecto tres veces en el mismo frame: sólo se ocupa una voz
+	 * galeria->sonido("golpe").play();
+	 * galeria->sonido("golpe").play();
+	 * galeria->sonido("golpe").play();
+	 * // Consultar cuántas peticiones se han fusionado hasta el momento
+	 * u32 fusiones = mezclador->estadisticas().fusiones;
+	 * // Volcar las estadísticas en el log
+	 * mezclador->informe();
+	 * @endcode
+	 *
+	 */
+	class Mezclador
+	{
+		public:
+
+			/**
+			 * Estadísticas de uso de las voces, acumuladas desde la inicialización del Mezclador (ver
+			 * voces::Estadisticas).
+			 */
+			typedef voces::Estadisticas Estadisticas;
+
+			/**
+			 * Primera voz de la libASND que se utiliza para efectos. La voz 0 queda para la pista de música.
+			 */
+			static const u8 PRIMERA_VOZ = 1;
+
+			/**
+			 * Número total de voces de la libASND.
+			 */
+			static const u8 NUM_VOCES = 16;
+
+			/**
+			 * Función estática que devuelve la instancia activa del mezclador. En el caso de no haber ninguna
+			 * instancia, se crea y se devuelve. Implementación del patrón Singleton.
+			 * @return Puntero a la instancia activa del mezclador
+			 */
+			static Mezclador* get_instance(void)
+			{
+				if(_instance == 0)
+				{
+					_instance = new Mezclador();
+					atexit(destroy);
+				}
+				return _instance;
+			}
+
+			/**
+			 * Función estática que destruye la instancia activa del mezclador, llamando a su destructor.
+			 */
+			static void destroy(void)
+			{
+				delete _instance;
+				_instance = 0;
+			}
+
+			/**
+			 * Método que deja todas las voces libres y pone a cero las estadísticas.
+			 */
+			void inicializar(void);
+
+			/**
+			 * Método que establece la ventana de fusión: dos peticiones del mismo efecto separadas por menos tiempo
+			 * que esta ventana se consideran una sola.
+			 * @param microsegundos Duración de la ventana de fusión, en microsegundos (0 desactiva la fusión)
+			 */
+			void setVentana(u32 microsegundos);
+
+			/**
+			 * Método que intenta reproducir un efecto de sonido según la política de reparto de voces.
+			 * @param s Efecto de sonido que se quiere reproducir
+			 * @return Verdadero si el efecto suena (o se ha fusionado con una reproducción anterior), falso si
+			 * se ha descartado.
+			 */
+			bool reproducir(const Sonido& s);
+
+			/**
+			 * Método que detiene todas las voces que estén reproduciendo un efecto concreto. Se llama desde el
+			 * destructor de Sonido para que ninguna voz quede apuntando a memoria liberada.
+			 * @param s Efecto de sonido que se quiere detener
+			 */
+			void detener(const Sonido& s);
+
+			/**
+			 * Método consultor de las estadísticas de uso de las voces.
+			 * @return Referencia constante a las estadísticas actuales
+			 */
+			const Estadisticas& estadisticas(void) const;
+
+			/**
+			 * Método que vuelca en el log del sistema (nivel INFO) las estadísticas de uso de las voces.
+			 */
+			void informe(void) const;
+
+		protected:
+
+			/**
+			 * Constructor de la clase Mezclador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Mezclador(void);
+
+			/**
+			 * Destructor de la clase Mezclador. Se encuentra en la zona protegida debido a la implementación
+			 * del patrón Singleton.
+			 */
+			~Mezclador(void);
+
+			/**
+			 * Constructor de copia de la clase Mezclador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Mezclador(const Mezclador& m);
+
+			/**
+			 * Operador de asignación de la clase Mezclador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Mezclador& operator=(const Mezclador& m);
+
+		private:
+
+			// Estado de la decodificación de un efecto comprimido en una voz
+			typedef struct decodificacion
+			{
+				u32 bloque;
+				u8 mitad;
+			} Decodificacion;
+
+			// Tamaño en bytes de cada mitad del búfer doble de decodificación de una voz
+			static const u32 TAM_MITAD = adpcm::MAX_MUESTRAS_BLOQUE * 2 * sizeof(s16);
+
+			// Instante actual en microsegundos
+			u64 ahora(void) const;
+			// Efecto que ocupa una voz según la tabla, o NULL si está libre
+			const Sonido* sonido(u8 v) const;
+			// Comenzar la reproducción de un efecto en una voz concreta
+			bool iniciar(u8 v, const Sonido& s, u64 instante);
+			// Detener la reproducción de una voz concreta
+			void parar(u8 v);
+			// Decodificar el siguiente bloque ADPCM de una voz en la mitad libre de su búfer, devolviendo su tamaño
+			u32 decodificar(u8 v, const Sonido& s);
+			// Función de retorno de la libASND, que encola el siguiente bloque de un efecto comprimido
+			static void alimentar(s32 v);
+
+			static Mezclador* _instance;
+			voces::Voz _voces[NUM_VOCES];
+			Decodificacion _decodificacion[NUM_VOCES];
+			s16* _buffers[NUM_VOCES];
+			u32 _ventana;
+			Estadisticas _estadisticas;
+	};
+
+	#define mezclador Mezclador::get_instance()
+
+#endif
+
@@ -18,7 +18,6 @@
 #ifndef _MUSICA_H_
 #define _MUSICA_H_
 
-	#include <fstream>
 	#include <gccore.h>
 	#include <malloc.h>
 	#include <mp3player.h>
@@ -70,10 +69,10 @@
 	 * abre el archivo que se recibe como parámetro mediante la ruta absoluta de éste en la tarjeta. Hay otro parámetro
 	 * opcional, un entero de 8 bits sin signo (u8), que representa el volumen de la pista de audio (siendo 0 el
 	 * volumen mínimo, y 255 el máximo), y que se puede modificar en tiempo de ejecución mediante el método modificador
-	 * setVolumen(). El archivo MP3 se abre mediante un flujo de entrada de bytes ifstream, y se lee en bloque sobre
-	 * una zona de memoria reservada previamente, de tipo puntero entero de 16 bits con signo (s16), alineada a 32
-	 * bytes, y convenientemente ajustada a un tamaño múltiplo de 32 bytes también. Si todo va bien, se cierra el flujo
-	 * de entrada, y queda lista la pista de sonido para ser reproducida.
+	 * setVolumen(). El archivo MP3 se lee de una sola vez mediante Sdcard::leer() (desde el paquete de recursos, si
+	 * hay alguno montado que lo contenga) sobre una zona de memoria de tipo puntero entero de 16 bits con signo (s16),
+	 * alineada a 32 bytes, y convenientemente ajustada a un tamaño múltiplo de 32 bytes también. Si todo va bien, queda
+	 * lista la pista de sonido para ser reproducida.
 	 *
 	 * Para iniciar la reproducción de la pista, basta con llamar al método play() de la instancia, indicando si se
 	 * quiere reproducir una vez, o de forma ininterrumpida (tal y como se ha explicado previamente). Este método se
@@ -155,6 +154,18 @@
 			 */
 			bool reproduciendo(void) const;
 
+			/**
+			 * Método que indica si esta pista concreta es la que está sonando en este momento.
+			 * @return Verdadero si la última pista que se ha comenzado a reproducir es ésta, y sigue sonando.
+			 */
+			bool activa(void) const;
+
+			/**
+			 * Método consultor de la memoria que ocupa la pista de música.
+			 * @return Número de bytes que ocupa la pista de música en memoria.
+			 */
+			u32 bytes(void) const;
+
 			/**
 			 * Función modificadora del volumen de la pista de música.
 			 * @param volumen Nuevo valor para el volumen de la pista de música (entre 0 y 255)
@@ -176,6 +187,8 @@
 			Musica& operator=(const Musica& m);
 
 		private:
+			// Última pista que se ha comenzado a reproducir
+			static const Musica* _activa;
 			bool _loop;
 			u8 _volumen;
 			s16* _musica;
@@ -25,9 +25,12 @@
 	#include "colision.h"
 	#include "excepcion.h"
 	#include "galeria.h"
+	#include "manifiesto.h"
 	#include "mando.h"
+	#include "memoria.h"
 	#include "parser.h"
 	#include "screen.h"
+	#include "tiled.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
@@ -71,6 +74,12 @@
 	 * para que sólo se evalúe la colisión con los tiles sobre los que se encuentre el actor, evitando cálculos
 	 * innecesarios.
 	 *
+	 * Cada tile ocupa 16 bits: su número identificador dentro del tileset y dos marcas, una para los tiles
+	 * invertidos y otra para los no atravesables (ver Tile). Los tiles de cada capa se guardan seguidos, fila a fila,
+	 * y los de todas las capas, en un único bloque de memoria que se reserva y se libera de una sola vez; la posición
+	 * de un tile en el escenario se calcula a partir de su fila y su columna, y el rectángulo de colisión de un tile
+	 * no atravesable se construye sólo cuando se comprueba una colisión con él.
+	 *
 	 * Se proporciona un método virtual puro actualizarEscenario() en el que se pueden implementar comportamientos para
 	 * el escenario (como por ejemplo, plataformas destructibles, o en movimiento, además de cambiar las coordenadas
 	 * del scroll de la pantalla), y un método que dibuja la ventana del nivel en la pantalla de la consola.
@@ -106,18 +115,31 @@
 	 * imagen_fondo (que es el código que debe tener la imagen de fondo del nivel en la Galeria de medias),
 	 * imagen_tileset (código que la imagen del tileset deberá tener asociado en la Galeria de medias del sistema) y
 	 * musica (código identificador de la pista de música en la Galeria de medias del sistema). Tras leer las
-	 * propiedades del mapa de tiles, se procede a leer las tres capas que debe contener el archivo TMX, que son las
-	 * siguientes:
+	 * propiedades del mapa de tiles, se procede a leer las capas del archivo TMX, que son las siguientes:
 	 *
-	 * 1. Capa ‘escenario’ (nombre obligatorio): capa de patrones del editor Tiled, debe contener los tiles
-	 * atravesables.
-	 * 2. Capa ‘plataformas’ (nombre obligatorio): capa de patrones del editor Tiled, que contiene los tiles no
-	 * atravesables (los que tendrán figura de colisión asociada)
-	 * 3. Capa ‘actores’ (nombre obligatorio): capa de objetos del editor Tiled. Cada objeto definido en esta capa debe
+	 * 1. Capas de patrones del editor Tiled, tantas como se quiera, que se dibujan en el orden en que aparecen en el
+	 * archivo (cada capa, por delante de las anteriores). Sus tiles son atravesables, salvo los de la capa llamada
+	 * ‘plataformas’ y los de las capas que tengan la propiedad solida con valor 1, que son no atravesables (tendrán
+	 * figura de colisión asociada). Los niveles habituales tienen una capa ‘escenario’ con los tiles atravesables y una
+	 * capa ‘plataformas’ con los no atravesables. De los volteos de tiles de Tiled, sólo se admite el horizontal: una
+	 * capa con algún tile volteado en vertical o en diagonal no se puede cargar. Los tiles de una capa pueden guardarse
+	 * con cualquiera de los formatos de capa de Tiled salvo la compresión gzip: XML, CSV o base64, sin comprimir o
+	 * comprimido con zlib. Los dos últimos ocupan mucho menos y se leen bastante más deprisa, ya que se decodifican
+	 * directamente sobre los tiles de la capa, sin crear un elemento XML por tile.
+	 * 2. Capa ‘actores’ (nombre obligatorio): capa de objetos del editor Tiled. Cada objeto definido en esta capa debe
 	 * tener la propiedad xml con la dirección absoluta en la tarjeta SD del archivo XML de descripción del actor como
 	 * valor. Si además, el actor es un actor jugador, se espera que tenga otra propiedad llamada jugador, y cuyo valor
 	 * debe ser el código identificador del jugador. También debe tener el identificador de su tipo en el campo Tipo.
 	 *
+	 * Además de las propiedades anteriores, el mapa puede tener las propiedades opcionales imagenes, musicas, sonidos
+	 * y fuentes, con una lista de códigos de la Galeria separados por comas, para indicar los recursos que el nivel
+	 * utiliza desde el código del juego. Con todas ellas, y con las imágenes de las animaciones de los actores (los de
+	 * la capa de objetos y los indicados en propiedades del mapa cuyo nombre empiece por 'xml'), el constructor
+	 * construye el Manifiesto del nivel, y retiene (y, por tanto, carga) todos sus recursos antes de que el nivel
+	 * comience. El destructor los libera y descarta de la Galeria los que nadie más utilice, así que la memoria
+	 * ocupada por los recursos es la del nivel en curso. Si el nivel se ha pedido antes al Cargador, el manifiesto y
+	 * sus recursos ya están preparados, y los que comparte con el nivel anterior no se descargan entre uno y otro.
+	 *
 	 * Hay que tener en cuenta otro detalle importante, y es que, al llamar al constructor, la información de los
 	 * actores se guardan en una estructura temporal. Por ese motivo, existe el método virtual puro cargarActores(),
 	 * que ha de ser implementado por el programador al derivar la clase Nivel, y que se debe encargar de recorrer esta
@@ -170,33 +192,35 @@
 		public:
 
 			/**
-			 * @brief Estructura que almacena los datos de un tile.
-			 * @details Se compone de una pareja de coordenadas (X,Y), que especifican la distancia del punto superior
-			 * izquierdo del tile respecto al origen de coordenadas (0,0) del nivel, un entero de 32 bits que indica
-			 * el número identificador del tile dentro del mapa de tiles generado con la aplicación Tiled, y un puntero
-			 * a un rectángulo de colisión asociado al tile (puede ser NULL).
+			 * Tile de una capa del escenario (ver tiled::Tile).
 			 */
-			typedef struct tile
-			{
-				u32 x;
-				u32 y;
-				u32 gid;
-				Rectangulo* colision;
-			} Tile;
+			typedef tiled::Tile Tile;
 
 			/**
-			 * Nombres de las distintas capas de Tiles que componen un escenario
+			 * Bits del número identificador de un tile (ver tiled::GID).
 			 */
-			typedef enum
-			{
-				PLATAFORMAS,
-				ESCENARIO
-			} Capa;
+			static const Tile GID = tiled::GID;
+
+			/**
+			 * Marca de un tile que se dibuja invertido horizontalmente (ver tiled::INVERTIDO).
+			 */
+			static const Tile INVERTIDO = tiled::INVERTIDO;
 
 			/**
-			 * Dicionario que almacena todos los tiles que componen un nivel.
+			 * Marca de un tile no atravesable (ver tiled::SOLIDO).
 			 */
-			typedef std::map<Capa, Tile**> Escenario;
+			static const Tile SOLIDO = tiled::SOLIDO;
+
+			/**
+			 * Capa de tiles del escenario, con su nombre, si es sólida y sus tiles ordenados por filas (ver
+			 * tiled::Capa).
+			 */
+			typedef tiled::Capa Capa;
+
+			/**
+			 * Vector que almacena todas las capas de tiles de un nivel, en el orden del archivo TMX.
+			 */
+			typedef std::vector<Capa> Escenario;
 
 			/**
 			 * Vector que almacena todos los actores no jugadores que participan en un nivel.
@@ -212,14 +236,18 @@
 			/**
 			 * Constructor de la clase Nivel. Carga un archivo TMX generado con el editor de mapas de tiles Tiled,
 			 * creando todas las estructuras necesarias del nivel, los actores no jugadores y los actores jugadores.
+			 * Todos los recursos del manifiesto del nivel quedan retenidos en la Galeria mientras exista el nivel.
 			 * @param ruta Ruta absoluta hasta el archivo TMX generado con Tiled que almacena la información del nivel
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir un archivo
+			 * @throw CodigoEx Se lanza si algún recurso del manifiesto no está registrado en la Galeria
+			 * @throw ImagenEx Se lanza si sucede un error al cargar el fondo o el tileset
 			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			Nivel(const std::string& ruta) throw (ArchivoEx, TarjetaEx);
+			Nivel(const std::string& ruta) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
 
 			/**
-			 * Destructor virtual de la clase. Destruye todos los tiles y actores.
+			 * Destructor virtual de la clase. Destruye todos los tiles y actores, libera los recursos retenidos en la
+			 * Galeria y descarta los que ya no retenga nadie.
 			 */
 			virtual ~Nivel(void);
 
@@ -341,26 +369,35 @@
 			typedef std::vector<ActorTemp> Temporal;
 
 			/**
-			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer todas las propiedades del nivel.
-			 * @param propiedades Elemento XML donde se almacenan las propiedades del nivel.
+			 * Método que carga el archivo TMX del nivel y lee todos sus datos: medidas, propiedades, capas de tiles y
+			 * actores (en la estructura temporal). Después, retiene en la Galeria los recursos del manifiesto del
+			 * nivel. Si lanza una excepción, el constructor libera lo que ya se hubiera retenido o reservado.
+			 * @param ruta Ruta absoluta hasta el archivo TMX generado con Tiled que almacena la información del nivel
+			 * @throw ArchivoEx Se lanza si hay algún error al abrir un archivo
+			 * @throw CodigoEx Se lanza si algún recurso del manifiesto no está registrado en la Galeria
+			 * @throw ImagenEx Se lanza si sucede un error al cargar el fondo o el tileset
+			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			void leerPropiedades(TiXmlElement* propiedades);
+			void cargarDatosIniciales(const std::string& ruta) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx);
 
 			/**
-			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer los tiles que componen el
-			 * escenario del nivel. Un tile forma parte del escenario si no tiene asociado ninguna caja de colisión,
-			 * es decir, si es un tile atravesable.
-			 * @param escenario Elemento XML donde se almacenan los tiles del escenario del nivel.
+			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer todas las propiedades del nivel.
+			 * @param propiedades Elemento XML donde se almacenan las propiedades del nivel.
 			 */
-			void leerEscenario(TiXmlElement* escenario);
+			void leerPropiedades(TiXmlElement* propiedades);
 
 			/**
-			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer los tiles que componen las
-			 * platformas del nivel. Un tile forma parte de las plataformas si tiene asociada una caja de colisión,
-			 * es decir, si es un tile no atravesable.
-			 * @param plataformas Elemento XML donde se almacenan los tiles de las plataformas del nivel.
+			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer los tiles de una capa del
+			 * escenario del nivel con tiled::leerCapa(). Si la capa es sólida, todos sus tiles son no atravesables, es
+			 * decir, tienen asociada una caja de colisión. Los tiles pueden estar guardados en formato XML (un
+			 * elemento por tile), csv, o base64, sin comprimir o comprimidos con zlib.
+			 * @param capa Elemento XML (etiqueta layer) donde se almacenan los tiles de la capa.
+			 * @param c Capa en la que se guardan los tiles.
+			 * @throw ArchivoEx Se lanza si la capa utiliza una compresión distinta de zlib, si sus datos en base64 no
+			 * son correctos, o si algún tile está volteado en vertical o en diagonal o tiene un identificador que no
+			 * cabe en los bits GID
 			 */
-			void leerPlataformas(TiXmlElement* plataformas);
+			void leerCapa(TiXmlElement* capa, Capa& c) throw (ArchivoEx);
 
 			/**
 			 * Método que, a partir de un elemento de un árbol XML, se encarga de leer todos los actores que 
@@ -395,6 +432,19 @@
 			 */
 			std::string _musica;
 
+			/**
+			 * Manejadores de la imagen de fondo, del tileset y de la pista de música del nivel, que se resuelven una
+			 * sola vez en el constructor para no buscar sus códigos en la Galeria en cada frame.
+			 */
+			Galeria::ManejadorImagen _fondo;
+			Galeria::ManejadorImagen _tileset;
+			Galeria::ManejadorMusica _pista;
+
+			/**
+			 * Recursos de la Galeria que utiliza el nivel, retenidos mientras exista.
+			 */
+			Manifiesto _manifiesto;
+
 			/**
 			 * Ancho en píxeles de un tile
 			 */
@@ -446,10 +496,16 @@
 			u16 _columnas_tileset;
 
 			/**
-			 * Estructura que almacena todos los tiles del nivel, tanto los atravesables como los no atravesables.
+			 * Estructura que almacena todas las capas de tiles del nivel, tanto las atravesables como las no
+			 * atravesables.
 			 */
 			Escenario _escenario;
 
+			/**
+			 * Memoria de los tiles de todas las capas del nivel, que se reserva y se libera de una sola vez.
+			 */
+			Tile* _tiles;
+
 			/**
 			 * Estructura que almacena todos los actores no jugadores del nivel.
 			 */
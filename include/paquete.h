@@ -0,0 +1,312 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _PAQUETE_H_
+#define _PAQUETE_H_
+
+	#include <cstdio>
+	#include <cstdlib>
+	#include <cstring>
+	#include <malloc.h>
+	#include <string>
+	#include <gctypes.h>
+	#ifdef GEKKO
+		#include <ogc/mutex.h>
+	#endif
+	#include "excepcion.h"
+	#include "fnv1a.h"
+	#include "lz4.h"
+	#include "memoria.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para leer y escribir el formato de los paquetes de recursos de libWiiEsp.
+	 *
+	 * @details Un paquete reúne en un único archivo todos los recursos de un juego (imágenes, sonidos, música,
+	 * fuentes y archivos XML), de tal manera que la consola abre un solo archivo de la tarjeta SD durante toda la
+	 * ejecución, en lugar de abrir (y, antes de abrir, comprobar la existencia de) un archivo por cada recurso. La
+	 * herramienta empaquetar (ver directorio tools) crea los paquetes, y la clase Paquete los lee.
+	 *
+	 * Un paquete comienza con una cabecera de 32 bytes (ver estructura Cabecera), seguida del índice, de la tabla de
+	 * nombres y de los contenidos de los archivos. El índice tiene una entrada de 32 bytes por archivo, con el hash
+	 * FNV-1a de su nombre (ver fnv1a::hash()), la posición del nombre en la tabla de nombres, la posición y el tamaño
+	 * de su contenido tal y como está almacenado, su tamaño original y el tipo de compresión (un byte); los 11 últimos
+	 * bytes de cada entrada están reservados y valen cero. Las entradas están ordenadas por hash (y, en caso de empate,
+	 * por nombre), así que un archivo se localiza con una búsqueda binaria que compara enteros. La tabla de nombres
+	 * contiene los nombres de los archivos, relativos al directorio del paquete y terminados en un carácter nulo. El
+	 * contenido de cada archivo comienza en una posición múltiplo de 32 bytes, y se rellena con ceros hasta el
+	 * siguiente múltiplo de 32 bytes.
+	 *
+	 * La herramienta empaquetar decide para cada archivo si se guarda comprimido con LZ4 (ver espacio de nombres
+	 * lz4), lo que sólo hace cuando el ahorro merece la pena (una imagen BMP o un mapa TMX ocupan mucho menos, pero un
+	 * MP3 ya está comprimido). Los paquetes de la versión 1, anteriores a la compresión, no tienen ningún archivo
+	 * comprimido, y se siguen pudiendo leer.
+	 *
+	 * Como en el resto de formatos binarios de la biblioteca, todos los campos se almacenan en big endian, que es el
+	 * orden nativo de la consola. Igual que el códec ADPCM, este código no depende de ninguna biblioteca de la consola
+	 * y se compila tanto para la Wii como para el PC.
+	 *
+	 */
+	namespace paquete
+	{
+		/**
+		 * Tamaño en bytes de la cabecera de un paquete.
+		 */
+		static const u32 TAM_CABECERA = 32;
+
+		/**
+		 * Tamaño en bytes de una entrada del índice.
+		 */
+		static const u32 TAM_ENTRADA = 32;
+
+		/**
+		 * Alineación en bytes del contenido de cada archivo dentro del paquete.
+		 */
+		static const u32 ALINEACION = 32;
+
+		/**
+		 * Versión de los paquetes que se escriben.
+		 */
+		static const u8 VERSION = 2;
+
+		/**
+		 * Tipos de compresión del contenido de un archivo del paquete.
+		 */
+		enum Compresion
+		{
+			NINGUNA = 0,
+			LZ4 = 1
+		};
+
+		/**
+		 * @brief Cabecera de un paquete, con sus campos ya convertidos al orden de bytes de la máquina.
+		 */
+		typedef struct cabecera
+		{
+			u8 version;
+			u32 entradas;
+			u32 nombres;
+			u32 tam_nombres;
+			u32 datos;
+		} Cabecera;
+
+		/**
+		 * @brief Entrada del índice de un paquete, con sus campos ya convertidos al orden de bytes de la máquina.
+		 */
+		typedef struct entrada
+		{
+			u32 hash;
+			u32 nombre;
+			u32 offset;
+			u32 tam;
+			u32 tam_original;
+			u8 compresion;
+		} Entrada;
+
+		/**
+		 * Lee la cabecera de un paquete desde memoria y comprueba que sea válida.
+		 * @param datos Dirección de memoria donde comienza el paquete
+		 * @param tam Tamaño en bytes de la zona de memoria
+		 * @param c Cabecera donde se guardarán los campos leídos
+		 * @return Verdadero si la cabecera es válida, falso en caso contrario
+		 */
+		bool leerCabecera(const u8* datos, u32 tam, Cabecera& c);
+
+		/**
+		 * Escribe la cabecera de un paquete en memoria.
+		 * @param c Cabecera que se quiere escribir
+		 * @param destino Zona de memoria de, al menos, TAM_CABECERA bytes
+		 */
+		void escribirCabecera(const Cabecera& c, u8* destino);
+
+		/**
+		 * Lee una entrada del índice. En las entradas sin comprimir, el tamaño original es igual al tamaño almacenado.
+		 * @param indice Dirección de memoria donde comienza el índice
+		 * @param i Posición de la entrada en el índice
+		 * @param e Entrada donde se guardarán los campos leídos
+		 */
+		void leerEntrada(const u8* indice, u32 i, Entrada& e);
+
+		/**
+		 * Escribe una entrada del índice en memoria, con sus bytes reservados a cero.
+		 * @param e Entrada que se quiere escribir
+		 * @param destino Zona de memoria de, al menos, TAM_ENTRADA bytes
+		 */
+		void escribirEntrada(const Entrada& e, u8* destino);
+
+		/**
+		 * Busca un archivo en el índice de un paquete.
+		 * @param indice Dirección de memoria donde comienza el índice
+		 * @param c Cabecera del paquete
+		 * @param nombres Dirección de memoria donde comienza la tabla de nombres
+		 * @param nombre Nombre del archivo, relativo al directorio del paquete
+		 * @param e Entrada donde se guardarán los datos del archivo, si se encuentra
+		 * @return Verdadero si el archivo está en el paquete, falso en caso contrario
+		 */
+		bool buscar(const u8* indice, const Cabecera& c, const char* nombres, const std::string& nombre, Entrada& e);
+	}
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que lee archivos contenidos en un paquete de recursos.
+	 *
+	 * @details Un Paquete abre el archivo del paquete una sola vez y carga en memoria su índice y su tabla de
+	 * nombres. A partir de ese momento, leer un archivo del paquete consiste en buscarlo en el índice y copiar su
+	 * contenido directamente en una zona de memoria alineada a 32 bytes, sin volver a abrir nada. Normalmente no es
+	 * necesario utilizar esta clase directamente, ya que la clase Sdcard la utiliza de forma transparente cuando se
+	 * monta un paquete (ver Sdcard::montarPaquete()).
+	 *
+	 * Funcionamiento interno
+	 *
+	 * En la consola, el archivo del paquete permanece abierto, y cada lectura se posiciona en el contenido y lo lee
+	 * de una sola vez. Si el archivo está comprimido, en cambio, se lee bloque a bloque en una pequeña memoria
+	 * intermedia de la clase (unos 64 KB), y cada bloque se descomprime directamente en su posición de la memoria de
+	 * destino, que es la que se entrega al que llama (y que, por ejemplo, la clase Imagen convierte en textura), así
+	 * que nunca hace falta una copia completa del archivo comprimido. Como el hilo de la clase Cargador y el hilo
+	 * principal pueden leer a la vez, cada lectura está protegida por un mutex. Fuera de la consola, el paquete
+	 * completo se proyecta en memoria con mmap(), de tal manera que las lecturas no hacen ninguna llamada al sistema,
+	 * y el método contenido() permite acceder a un archivo sin copiarlo.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * Paquete p;
+	 * p.abrir("sd:/apps/wiipang/datos.pak");
+	 * paquete::Entrada e;
+	 * if(p.buscar("xml/galeria.xml", e))
+	 * {
+	 *     u8* datos = p.leer(e);
+	 *     // ...
+	 *     memoria::liberar(datos);
+	 * }
+	 * @endcode
+	 *
+	 */
+	class Paquete
+	{
+		public:
+
+			/**
+			 * Constructor de la clase Paquete. El paquete queda cerrado.
+			 */
+			Paquete(void);
+
+			/**
+			 * Método que abre un paquete y carga su índice en memoria. Si ya había un paquete abierto, se cierra.
+			 * @param ruta Ruta completa hasta el archivo del paquete (en la consola, con la unidad como prefijo)
+			 * @throw ArchivoEx Se lanza si el archivo no existe o no es un paquete válido
+			 */
+			void abrir(const std::string& ruta) throw (ArchivoEx);
+
+			/**
+			 * Método que cierra el paquete, si está abierto.
+			 */
+			void cerrar(void);
+
+			/**
+			 * Método que indica si hay un paquete abierto.
+			 * @return Verdadero si hay un paquete abierto, falso en caso contrario
+			 */
+			bool abierto(void) const;
+
+			/**
+			 * Método consultor del número de archivos del paquete.
+			 * @return Número de archivos del paquete, 0 si no hay ninguno abierto
+			 */
+			u32 entradas(void) const;
+
+			/**
+			 * Método consultor de una entrada del índice, en el orden del índice.
+			 * @param i Posición de la entrada, menor que entradas()
+			 * @return Entrada del índice
+			 */
+			paquete::Entrada entrada(u32 i) const;
+
+			/**
+			 * Método consultor del nombre de un archivo del paquete.
+			 * @param e Entrada del archivo
+			 * @return Nombre del archivo, relativo al directorio del paquete
+			 */
+			std::string nombre(const paquete::Entrada& e) const;
+
+			/**
+			 * Método que busca un archivo en el índice del paquete.
+			 * @param nombre Nombre del archivo, relativo al directorio del paquete
+			 * @param e Entrada donde se guardarán los datos del archivo, si se encuentra
+			 * @return Verdadero si el archivo está en el paquete, falso en caso contrario
+			 */
+			bool buscar(const std::string& nombre, paquete::Entrada& e) const;
+
+			/**
+			 * Método que lee el contenido de un archivo del paquete (descomprimiéndolo si es necesario, de tal manera
+			 * que ocupa el tamaño original de la entrada) en una zona de memoria alineada a 32 bytes, con su tamaño
+			 * redondeado al siguiente múltiplo de 32 bytes y rellena con ceros (siempre queda, al menos, un
+			 * byte nulo tras el contenido). La memoria se reserva con memoria::reservar(), y quien llama debe
+			 * liberarla con memoria::liberar().
+			 * @param e Entrada del archivo, obtenida con buscar()
+			 * @param etiqueta Subsistema al que se asigna la memoria del contenido (ver memoria.h)
+			 * @return Contenido del archivo
+			 * @throw ArchivoEx Se lanza si no hay memoria suficiente o si falla la lectura
+			 */
+			u8* leer(const paquete::Entrada& e, memoria::Etiqueta etiqueta = memoria::ARCHIVOS) throw (ArchivoEx);
+
+			#ifndef GEKKO
+			/**
+			 * Método que devuelve el contenido de un archivo del paquete directamente desde la proyección en memoria,
+			 * sin copiarlo, tal y como está almacenado (es decir, comprimido, si la entrada lo está). Sólo está
+			 * disponible fuera de la consola.
+			 * @param e Entrada del archivo, obtenida con buscar()
+			 * @return Puntero al contenido del archivo, válido mientras el paquete siga abierto
+			 */
+			const u8* contenido(const paquete::Entrada& e) const;
+			#endif
+
+			/**
+			 * Destructor de la clase Paquete, que lo cierra.
+			 */
+			~Paquete(void);
+
+		private:
+
+			// Un paquete abierto no se puede copiar
+			Paquete(const Paquete& p);
+			Paquete& operator=(const Paquete& p);
+
+			#ifdef GEKKO
+			// Lee del archivo abierto y descomprime una entrada comprimida, bloque a bloque
+			bool descomprimir(const paquete::Entrada& e, u8* destino);
+			#endif
+
+			std::string _ruta;
+			paquete::Cabecera _cabecera;
+			const u8* _indice;
+			const char* _nombres;
+
+			#ifdef GEKKO
+			FILE* _archivo;
+			u8* _memoria;
+			u8* _bloque;
+			mutex_t _mutex;
+			#else
+			u8* _mapa;
+			size_t _tam_mapa;
+			#endif
+	};
+
+#endif
+
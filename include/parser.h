@@ -19,6 +19,7 @@
 #define _PARSER_H_
 
 	#include <gctypes.h>
+	#include <map>
 	#include <string>
 	#include <tinyxml.h>
 	#include "excepcion.h"
@@ -146,6 +147,15 @@
 			 */
 			void cargar(const std::string& ruta) throw (ArchivoEx, TarjetaEx);
 
+			/**
+			 * Método que entrega al parser un documento XML ya leído y analizado (normalmente por el hilo de la
+			 * clase Cargador). La siguiente llamada a cargar() con la misma ruta utiliza este documento en lugar de
+			 * volver a leer el archivo de la tarjeta SD. El parser pasa a ser el propietario del documento.
+			 * @param ruta Ruta absoluta hasta el archivo XML, tal y como se pasará después a cargar()
+			 * @param doc Documento XML ya cargado
+			 */
+			void precargar(const std::string& ruta, TiXmlDocument* doc);
+
 			/**
 			 * Método que devuelve el elemento raíz del árbol XML del archivo que esté cargado en memoria.
 			 * @return Elemento raíz del árbol XML del archivo que está actualmente cargado
@@ -220,7 +230,7 @@
 			 * Destructor de la clase Parser. Se encuentra en la zona protegida debido a la implementación 
 			 * del patrón Singleton.
 			 */			
-			~Parser(void) { };
+			~Parser(void);
 
 			/**
 			 * Constructor de copia de la clase Parser. Se encuentra en la zona protegida debido a la
@@ -241,6 +251,7 @@
 
 			static Parser* _instance;
 			TiXmlDocument _doc;
+			std::map<std::string, TiXmlDocument*> _precargados;
 
 	};
 
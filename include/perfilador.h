@@ -0,0 +1,269 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _PERFILADOR_H_
+#define _PERFILADOR_H_
+
+	#include <cstdlib>
+	#include <string>
+	#include <gctypes.h>
+	#include "excepcion.h"
+	#include "ritmo.h"
+	#include "screen.h"
+	#include "sdcard.h"
+	#include "util.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que mide cuánto tiempo ocupa cada parte de un frame, y lo muestra en pantalla o lo exporta a la SD.
+	 *
+	 * @details Cuando un juego no llega a su ritmo de frames, hay que saber en qué se va el tiempo: en leer los mandos,
+	 * en la lógica del juego (Juego::frame()), en dibujar el nivel, en esperar a que el procesador gráfico termine
+	 * (GX_DrawDone) o en esperar la sincronización vertical. El perfilador divide cada frame en zonas con nombre: un
+	 * objeto de la clase Perfilador::Zona anota el instante en que se crea y el instante en que se destruye, así que
+	 * basta con declararlo al principio del bloque que se quiere medir. La biblioteca ya mide las fases del bucle
+	 * principal (ver Juego::run()), Screen::flip(), Nivel::dibujar(), la carga de recursos de la galería y los
+	 * trabajos del hilo de carga de la clase Cargador; el juego puede añadir las zonas que necesite.
+	 *
+	 * Las medidas se pueden ver de dos formas:
+	 *
+	 * - En la propia pantalla, con setVisible(): en la parte superior se dibuja una barra por cada nivel de anidamiento
+	 * con las zonas del último frame completo, cada una de un color, y debajo, la duración de los últimos frames como
+	 * un gráfico de barras verticales. Las dos escalas abarcan dos frames, con una línea blanca en la duración
+	 * prevista de un frame (ver clase Ritmo): lo que pasa de la línea no cabe en el frame.
+	 * - En el PC, con exportar(): se escriben en la tarjeta SD todas las zonas que conserva el perfilador (los
+	 * últimos frames) en el formato JSON de eventos de traza de Chrome, que se abre con chrome://tracing o con
+	 * Perfetto. Cada hilo aparece en su propia fila, y cada frame se marca con un evento propio.
+	 *
+	 * El perfilador está desactivado hasta que se llama a setActivo(); mientras lo está, una zona sólo cuesta una
+	 * comprobación. La clase Juego lo activa, y muestra su gráfica, según la etiqueta opcional perfil de su
+	 * archivo de configuración.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Cada zona se guarda al terminar, como un evento con su nombre (un puntero a una cadena constante, que no se
+	 * copia), su instante de inicio y de fin (con la resolución completa del reloj, ver Ritmo::ahora()), su hilo y su
+	 * nivel de anidamiento. Los eventos se escriben en un buffer circular de MAX_EVENTOS posiciones: cada escritor
+	 * obtiene su posición con un incremento atómico del contador de eventos, así que el hilo principal y el hilo de
+	 * carga pueden registrar zonas a la vez sin ningún mutex, y los eventos más antiguos se sobrescriben sin más. Al
+	 * comienzo de cada frame (nuevoFrame(), que llama Juego::run()) se anota su instante en otro buffer circular de
+	 * MAX_FRAMES posiciones. La gráfica en pantalla toma del buffer las zonas del hilo principal que comenzaron
+	 * durante el último frame completo; el nivel de anidamiento sólo se lleva en el hilo principal.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * perfilador->setActivo(true);
+	 * perfilador->setVisible(true);
+	 *
+	 * void MiJuego::actualizarEnemigos(void)
+	 * {
+	 *   Perfilador::Zona zona("enemigos");
+	 *   // ...
+	 * }
+	 *
+	 * // Guardar una captura de los últimos frames al pulsar un botón
+	 * if(mando->pulsado("menos"))
+	 *   perfilador->exportar("/apps/wiipang/perfil.json");
+	 * @endcode
+	 *
+	 */
+	class Perfilador
+	{
+		public:
+
+			/**
+			 * @brief Zona del perfilador: mide el tiempo que pasa desde que se crea hasta que se destruye.
+			 */
+			class Zona
+			{
+				public:
+
+					/**
+					 * Constructor de la clase Zona. Anota el instante de inicio, si el perfilador está activo.
+					 * @param nombre Nombre de la zona; debe ser una cadena constante, ya que no se copia
+					 */
+					Zona(const char* nombre);
+
+					/**
+					 * Destructor de la clase Zona. Registra la zona en el perfilador.
+					 */
+					~Zona(void);
+
+				private:
+
+					Zona(const Zona& z);
+					Zona& operator=(const Zona& z);
+
+					const char* _nombre;
+					u64 _inicio;
+					u32 _hilo;
+					u8 _profundidad;
+			};
+
+			/**
+			 * Número de zonas que conserva el perfilador (potencia de 2).
+			 */
+			static const u32 MAX_EVENTOS = 4096;
+
+			/**
+			 * Número de frames que conserva el perfilador (potencia de 2), que son los que muestra la gráfica.
+			 */
+			static const u32 MAX_FRAMES = 64;
+
+			/**
+			 * Función estática que devuelve la instancia activa del perfilador en el sistema. En el caso
+			 * de no haber ninguna instancia, se crea y se devuelve. Implementación del patrón Singleton.
+			 * @return Puntero a la instancia activa del perfilador en el sistema
+			 */
+			static Perfilador* get_instance(void)
+			{
+				if(_instance == 0)
+				{
+					_instance = new Perfilador();
+					atexit(destroy);
+				}
+				return _instance;
+			}
+
+			/**
+			 * Función estática que destruye la instancia activa del perfilador, llamando a su destructor.
+			 */
+			static void destroy(void)
+			{
+				delete _instance;
+			}
+
+			/**
+			 * Método que activa o desactiva la medida de zonas. El hilo que lo activa se toma como hilo principal.
+			 * @param activo Verdadero para medir las zonas, falso para ignorarlas
+			 */
+			void setActivo(bool activo);
+
+			/**
+			 * Método consultor del estado del perfilador.
+			 * @return Verdadero si se están midiendo las zonas
+			 */
+			bool activo(void) const;
+
+			/**
+			 * Método que muestra u oculta la gráfica del perfilador en la pantalla.
+			 * @param visible Verdadero para mostrar la gráfica en cada frame
+			 */
+			void setVisible(bool visible);
+
+			/**
+			 * Método consultor de la visibilidad de la gráfica del perfilador.
+			 * @return Verdadero si la gráfica se muestra en cada frame
+			 */
+			bool visible(void) const;
+
+			/**
+			 * Método que marca el comienzo de un nuevo frame. Lo llama Juego::run() al comienzo de cada iteración
+			 * del bucle principal.
+			 */
+			void nuevoFrame(void);
+
+			/**
+			 * Método que registra una zona ya medida. Normalmente no se llama directamente, sino a través de un
+			 * objeto de la clase Zona. Se puede llamar desde cualquier hilo.
+			 * @param nombre Nombre de la zona; debe ser una cadena constante, ya que no se copia
+			 * @param inicio Instante de inicio de la zona, en nanosegundos (ver Ritmo::ahora())
+			 * @param fin Instante de fin de la zona, en nanosegundos
+			 * @param hilo Identificador del hilo que ha ejecutado la zona
+			 * @param profundidad Nivel de anidamiento de la zona en el hilo principal
+			 */
+			void registrar(const char* nombre, u64 inicio, u64 fin, u32 hilo, u8 profundidad);
+
+			/**
+			 * Método que dibuja la gráfica del perfilador, si está visible. Se debe llamar después de dibujar el
+			 * frame, para que la gráfica quede por encima; Juego::run() ya lo hace.
+			 */
+			void dibujar(void) const;
+
+			/**
+			 * Método que escribe en la tarjeta SD todas las zonas que conserva el perfilador, en formato JSON de
+			 * eventos de traza de Chrome.
+			 * @param ruta Ruta absoluta del archivo en la tarjeta SD
+			 * @throw ArchivoEx Se lanza si no se puede escribir el archivo
+			 * @throw TarjetaEx Se lanza si la tarjeta SD no está montada
+			 */
+			void exportar(const std::string& ruta) const throw (ArchivoEx, TarjetaEx);
+
+			/**
+			 * Función que obtiene el identificador del hilo que la llama.
+			 * @return Identificador del hilo
+			 */
+			static u32 hilo(void);
+
+		protected:
+
+			/**
+			 * Constructor de la clase Perfilador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Perfilador(void);
+
+			/**
+			 * Destructor de la clase Perfilador. Se encuentra en la zona protegida debido a la implementación
+			 * del patrón Singleton.
+			 */
+			~Perfilador(void);
+
+			/**
+			 * Constructor de copia de la clase Perfilador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Perfilador(const Perfilador& p);
+
+			/**
+			 * Operador de asignación de la clase Perfilador. Se encuentra en la zona protegida debido a la
+			 * implementación del patrón Singleton.
+			 */
+			Perfilador& operator=(const Perfilador& p);
+
+		private:
+
+			typedef struct evento
+			{
+				const char* nombre;
+				u64 inicio;
+				u64 fin;
+				u32 hilo;
+				u8 profundidad;
+			} Evento;
+
+			// Color de una zona en la gráfica, a partir de su nombre
+			static u32 color(const char* nombre);
+
+			static Perfilador* _instance;
+			Evento _eventos[MAX_EVENTOS];
+			u64 _frames[MAX_FRAMES];
+			// Número total de eventos y de frames registrados; las posiciones se obtienen con su resto
+			volatile u32 _escritos;
+			u32 _frame;
+			u32 _principal;
+			u8 _profundidad;
+			bool _activo;
+			bool _visible;
+	};
+
+	#define perfilador Perfilador::get_instance()
+
+#endif
+
@@ -0,0 +1,141 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _PNGDEC_H_
+#define _PNGDEC_H_
+
+	#include <cstring>
+	#include <gctypes.h>
+	#include "bmp.h"
+	#include "inflador.h"
+	#include "memoria.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para decodificar imágenes PNG directamente en texturas RGB5A3 de la consola.
+	 *
+	 * @details Un archivo PNG ocupa entre tres y diez veces menos que el mismo bitmap sin comprimir, y leer de la
+	 * tarjeta SD es la parte más lenta de la carga de una imagen. Estas funciones, igual que las del espacio de nombres
+	 * bmp, decodifican una imagen ya leída en memoria fila a fila, escribiendo cada grupo de 4 píxeles directamente en
+	 * la fila de su tile de 4x4 (ver clase Screen), sin tener nunca en memoria la imagen descomprimida completa: los
+	 * datos comprimidos se descomprimen con la clase Inflador a medida que se necesita cada fila.
+	 *
+	 * Se admiten todos los tipos de color del estándar (gris, RGB, paleta, gris con alpha y RGBA) con todas sus
+	 * profundidades (de 1 a 16 bits por componente), siempre que la imagen no sea entrelazada (Adam7) y que sus
+	 * medidas sean múltiplo de 4. Las imágenes con canal alpha, o con transparencia indicada en un bloque tRNS, se
+	 * codifican con su transparencia real: los píxeles opacos en el modo de 5 bits por componente de RGB5A3, y los
+	 * semitransparentes en el de 4 bits por componente y 3 de alpha. Sólo a las imágenes que no tienen ninguna
+	 * información de transparencia se les aplica el color transparente (ver Imagen::alpha), igual que a los bitmaps.
+	 * Las componentes de 16 bits se reducen a 8 tomando su byte de mayor peso.
+	 *
+	 * Igual que el códec ADPCM o LZ4, este código no depende de ninguna biblioteca de la consola y se compila tanto
+	 * para la Wii como para el PC.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * leerCabecera() recorre los bloques (chunks) del archivo, comprobando que todos estén completos, y guarda la
+	 * posición de la paleta (PLTE), de la transparencia (tRNS) y del primer bloque de datos (IDAT). Las sumas CRC de
+	 * los bloques no se comprueban, pero sí la suma Adler-32 del flujo zlib, que cubre todos los píxeles.
+	 *
+	 * decodificar() entrega al Inflador, uno tras otro, el contenido de los bloques IDAT consecutivos, y le pide cada
+	 * vez una fila completa (el byte de filtro y los píxeles). Sólo se guardan en memoria dos filas, la actual y la
+	 * anterior, que es lo que necesitan los filtros de PNG para reconstruir la actual. Una vez reconstruida, un
+	 * núcleo de conversión específico del tipo de color la convierte a RGB5A3 en grupos de 4 píxeles, igual que en
+	 * bmp::decodificar(): las imágenes con paleta y las de gris de hasta 8 bits convierten primero todos sus colores
+	 * posibles a una tabla de 256 colores RGB5A3 (con la transparencia ya aplicada), y cada píxel es una consulta a
+	 * esa tabla.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * png::Info info;
+	 * if(png::leerCabecera(datos, tam, info))
+	 * {
+	 *     u16* texels = (u16*)memoria::reservar(png::tamTextura(info), memoria::TEXTURAS);
+	 *     if(not png::decodificar(datos, info, 0xFF00FFFF, texels))
+	 *         // ... datos comprimidos corruptos ...
+	 * }
+	 * @endcode
+	 *
+	 */
+	namespace png
+	{
+		/**
+		 * Tipos de color de una imagen PNG.
+		 */
+		enum Color { GRIS = 0, RGB = 2, PALETA = 3, GRIS_ALPHA = 4, RGBA = 6 };
+
+		/**
+		 * @brief Información de una imagen PNG, obtenida de sus bloques.
+		 */
+		typedef struct info
+		{
+			u16 ancho;				/**< Ancho en píxeles */
+			u16 alto;				/**< Alto en píxeles */
+			u8 profundidad;			/**< Bits por componente (o por índice, con paleta): 1, 2, 4, 8 o 16 */
+			u8 color;				/**< Tipo de color (ver png::Color) */
+			bool alpha;				/**< Verdadero si la imagen tiene canal alpha o bloque tRNS */
+			u32 paso;				/**< Bytes que ocupa cada fila descomprimida, sin contar el byte de filtro */
+			u32 datos;				/**< Posición del primer bloque IDAT en el archivo */
+			u32 paleta;				/**< Posición del contenido del bloque PLTE, o 0 si no hay */
+			u32 colores;			/**< Número de colores de la paleta */
+			u32 transparencia;		/**< Posición del contenido del bloque tRNS, o 0 si no hay */
+			u32 tam_transparencia;	/**< Tamaño en bytes del contenido del bloque tRNS */
+		} Info;
+
+		/**
+		 * Comprueba la firma de un archivo PNG.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param tam Tamaño en bytes del archivo
+		 * @return Verdadero si el archivo comienza con la firma de PNG, falso en caso contrario
+		 */
+		bool esPng(const u8* datos, u32 tam);
+
+		/**
+		 * Lee los bloques de una imagen PNG que se encuentra en memoria y comprueba que sea un formato admitido, que
+		 * sus medidas sean múltiplo de 4 y que todos sus bloques estén completos.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param tam Tamaño en bytes del archivo
+		 * @param info Información donde se guardarán los datos leídos
+		 * @return Verdadero si la imagen es válida y se puede decodificar, falso en caso contrario
+		 */
+		bool leerCabecera(const u8* datos, u32 tam, Info& info);
+
+		/**
+		 * Calcula el tamaño en bytes de la textura RGB5A3 de una imagen PNG.
+		 * @param info Información de la imagen
+		 * @return Tamaño en bytes de la textura
+		 */
+		u32 tamTextura(const Info& info);
+
+		/**
+		 * Descomprime y decodifica los píxeles de una imagen PNG en una textura RGB5A3 organizada en tiles de 4x4
+		 * píxeles, lista para el procesador gráfico.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param info Información de la imagen, obtenida con leerCabecera()
+		 * @param transparente Color que se considera transparente, en formato 0xRRGGBBAA (se ignora el alpha); sólo
+		 * se aplica si la imagen no tiene información de transparencia propia
+		 * @param destino Zona de memoria de tamTextura() bytes donde se escribe la textura
+		 * @return Verdadero si la imagen se ha decodificado completa, falso si los datos comprimidos son incorrectos
+		 * o no hay memoria para las filas
+		 */
+		bool decodificar(const u8* datos, const Info& info, u32 transparente, u16* destino);
+	}
+
+#endif
+
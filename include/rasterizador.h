@@ -0,0 +1,298 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _RASTERIZADOR_H_
+#define _RASTERIZADOR_H_
+
+	#include <cmath>
+	#include <cstring>
+	#include <vector>
+	#include <gctypes.h>
+	#include "contadores.h"
+	#include "textura.h"
+	#include "trigonometria.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que dibuja en memoria, sin procesador gráfico, las mismas primitivas que la clase Screen.
+	 *
+	 * @details Para comprobar un cambio en la forma de dibujar (el orden de los dibujos, las páginas de un atlas, el
+	 * número de bloques de vértices) no siempre se tiene una consola a mano, y aunque se tenga, comparar a ojo dos
+	 * capturas de pantalla no es una forma fiable de saber si algo ha cambiado. El Rasterizador tiene los mismos
+	 * métodos de dibujo que Screen (dibujarTextura(), dibujarCuadro(), dibujarPunto(), dibujarLinea(),
+	 * dibujarRectangulo() y dibujarCirculo()), con los mismos parámetros, pero en lugar de enviar vértices al
+	 * procesador gráfico, rellena un buffer de color y un buffer de profundidad en la memoria del PC. Como la clase
+	 * Contadores, no depende de ninguna biblioteca de la consola y se compila tanto para la Wii como para el PC; la
+	 * herramienta rasterizar (ver directorio tools) dibuja con ella escenas descritas en un archivo de texto, las
+	 * compara con una imagen de referencia y mide su velocidad.
+	 *
+	 * El Rasterizador reproduce la configuración que Screen::inicializar() hace de la GX:
+	 *
+	 * - La misma proyección ortográfica, incluido el margen vertical que se aplica en los modos de hasta 480 líneas,
+	 * así que cada vértice cae en el mismo píxel que en la consola.
+	 * - La comparación de alpha (sólo se dibujan los fragmentos con alpha mayor o igual que 8) y la mezcla con el
+	 * alpha del fragmento (GX_BL_SRCALPHA y GX_BL_INVSRCALPHA).
+	 * - La prueba de profundidad GX_LEQUAL con escritura, después de texturizar (un fragmento descartado por su
+	 * alpha no escribe su profundidad), con la coordenada Z dividida entre el plano lejano de 1000.
+	 * - Las texturas RGB5A3, CI8 y CI4 organizadas en bloques, como las prepara la clase Imagen, con el filtro
+	 * bilineal y el modo GX_CLAMP de Screen::crearTextura().
+	 * - El mismo lote de figuras de color que Screen: los puntos, líneas, rectángulos y círculos se acumulan, con
+	 * los mismos vértices, y se dibujan antes del siguiente dibujo de textura, al cerrar el frame o cuando cambia el
+	 * tipo de primitiva, en el orden en el que se pidieron. Por eso no aparecen en el buffer de color hasta entonces.
+	 * - Los mismos bloques de vértices que envía Screen, contados igual (ver clase Contadores), incluidas las cargas
+	 * de textura y paleta y las reconfiguraciones que Screen evita al repetir textura o color.
+	 *
+	 * El resultado no es idéntico bit a bit al de la consola (la precisión interna del procesador gráfico, la copia
+	 * al frame buffer externo y su filtro no se reproducen), pero sí es siempre el mismo para la misma escena, que es
+	 * lo que se necesita para comparar dos versiones del código que dibuja.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Todas las primitivas se descomponen en triángulos, igual que hace el procesador gráfico con los cuadriláteros.
+	 * Cada triángulo se recorre dentro de su caja, en coordenadas de pantalla, con las tres funciones de arista
+	 * evaluadas en el centro de cada píxel; la regla de arista superior izquierda decide a qué triángulo pertenecen
+	 * los píxeles de un lado compartido, para que las dos mitades de un cuadrilátero no se solapen ni dejen huecos.
+	 * Las coordenadas de textura se interpolan linealmente (en una proyección ortográfica no hace falta corregir la
+	 * perspectiva), y el color de un dibujo de color plano es el de su primer vértice, ya que Screen da el mismo
+	 * color a todos. El buffer de color guarda los píxeles en formato 0xRRGGBBAA, como los colores de Screen.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * Rasterizador r(640, 480);
+	 * Rasterizador::Textura t = { texels, 64, 64, textura::RGB5A3, NULL };
+	 * r.limpiar(0x000000FF);
+	 * r.dibujarTextura(t, 100, 100, 10, 64, 64);
+	 * r.dibujarCirculo(320, 240, 5, 60.0f, 0xFF0000FF);
+	 * r.cerrarFrame();
+	 * u32 centro = r.pixel(320, 240);
+	 * @endcode
+	 *
+	 */
+	class Rasterizador
+	{
+		public:
+
+			/**
+			 * @brief Textura que se puede dibujar con el Rasterizador, con los mismos datos que un GXTexObj.
+			 */
+			typedef struct datos_textura
+			{
+				const void* texels;			/**< Texels en bloques; los RGB5A3, en el orden de la máquina */
+				u16 ancho;					/**< Ancho en píxeles */
+				u16 alto;					/**< Alto en píxeles */
+				textura::Formato formato;	/**< Formato: RGB5A3, CI8 o CI4 */
+				const u16* paleta;			/**< Paleta RGB5A3 de los formatos CI8 y CI4, o NULL */
+			} Textura;
+
+			/**
+			 * Plano lejano de la proyección, igual que en Screen::inicializar(). Los dibujos con una coordenada Z
+			 * mayor quedan fuera de la escena.
+			 */
+			static const s16 LEJANO = 1000;
+
+			/**
+			 * Constructor de la clase Rasterizador. Crea los buffers de color y profundidad, limpios.
+			 * @param ancho Ancho de la pantalla en píxeles
+			 * @param alto Alto de la pantalla en píxeles
+			 */
+			Rasterizador(u16 ancho = 640, u16 alto = 480);
+
+			/**
+			 * Método que limpia el buffer de color y el de profundidad, igual que la copia al frame buffer externo.
+			 * @param color Color de fondo, en formato 0xRRGGBBAA
+			 */
+			void limpiar(u32 color = 0x000000FF);
+
+			/**
+			 * Método que da por terminado un frame: dibuja lo que quede en el lote de figuras y cierra los contadores.
+			 */
+			void cerrarFrame(void);
+
+			/**
+			 * Método que dibuja una textura completa, igual que Screen::dibujarTextura().
+			 * @param t Textura
+			 * @param x Coordenada X de la esquina superior izquierda
+			 * @param y Coordenada Y de la esquina superior izquierda
+			 * @param z Coordenada Z (profundidad)
+			 * @param ancho Ancho en píxeles con el que se dibuja
+			 * @param alto Alto en píxeles con el que se dibuja
+			 */
+			void dibujarTextura(const Textura& t, s16 x, s16 y, s16 z, u16 ancho, u16 alto);
+
+			/**
+			 * Método que dibuja una parte de una textura, igual que Screen::dibujarCuadro().
+			 * @param t Textura
+			 * @param x Coordenada X de la esquina superior izquierda
+			 * @param y Coordenada Y de la esquina superior izquierda
+			 * @param z Coordenada Z (profundidad)
+			 * @param cuadroX Coordenada X del cuadro dentro de la textura
+			 * @param cuadroY Coordenada Y del cuadro dentro de la textura
+			 * @param cuadroAncho Ancho del cuadro
+			 * @param cuadroAlto Alto del cuadro
+			 * @param invertido Si es verdadero, el cuadro se dibuja invertido sobre el eje vertical
+			 */
+			void dibujarCuadro(const Textura& t, s16 x, s16 y, s16 z, s16 cuadroX, s16 cuadroY, u16 cuadroAncho,
+								u16 cuadroAlto, bool invertido = false);
+
+			/**
+			 * Método que dibuja un punto, igual que Screen::dibujarPunto().
+			 * @param x Coordenada X
+			 * @param y Coordenada Y
+			 * @param z Coordenada Z (profundidad)
+			 * @param color Color en formato 0xRRGGBBAA
+			 */
+			void dibujarPunto(s16 x, s16 y, s16 z, u32 color);
+
+			/**
+			 * Método que dibuja una línea con ancho, igual que Screen::dibujarLinea().
+			 * @param x1 Coordenada X del primer extremo
+			 * @param y1 Coordenada Y del primer extremo
+			 * @param x2 Coordenada X del segundo extremo
+			 * @param y2 Coordenada Y del segundo extremo
+			 * @param z Coordenada Z (profundidad)
+			 * @param ancho Ancho de la línea en píxeles
+			 * @param color Color en formato 0xRRGGBBAA
+			 */
+			void dibujarLinea(s16 x1, s16 y1, s16 x2, s16 y2, s16 z, u16 ancho, u32 color);
+
+			/**
+			 * Método que dibuja un cuadrilátero relleno, igual que Screen::dibujarRectangulo(). Los vértices se
+			 * indican en el orden izquierda-arriba, derecha-arriba, derecha-abajo e izquierda-abajo.
+			 * @param x1 Coordenada X del primer vértice
+			 * @param y1 Coordenada Y del primer vértice
+			 * @param x2 Coordenada X del segundo vértice
+			 * @param y2 Coordenada Y del segundo vértice
+			 * @param x3 Coordenada X del tercer vértice
+			 * @param y3 Coordenada Y del tercer vértice
+			 * @param x4 Coordenada X del cuarto vértice
+			 * @param y4 Coordenada Y del cuarto vértice
+			 * @param z Coordenada Z (profundidad)
+			 * @param color Color en formato 0xRRGGBBAA
+			 */
+			void dibujarRectangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 x4, s16 y4, s16 z, u32 color);
+
+			/**
+			 * Método que dibuja un círculo relleno, igual que Screen::dibujarCirculo().
+			 * @param x Coordenada X del centro
+			 * @param y Coordenada Y del centro
+			 * @param z Coordenada Z (profundidad)
+			 * @param r Diámetro del círculo
+			 * @param color Color en formato 0xRRGGBBAA
+			 */
+			void dibujarCirculo(s16 x, s16 y, s16 z, f32 r, u32 color);
+
+			/**
+			 * Método observador del ancho de la pantalla.
+			 * @return Ancho en píxeles
+			 */
+			u16 ancho(void) const;
+
+			/**
+			 * Método observador del alto de la pantalla.
+			 * @return Alto en píxeles
+			 */
+			u16 alto(void) const;
+
+			/**
+			 * Método observador de un píxel del buffer de color.
+			 * @param x Coordenada X del píxel
+			 * @param y Coordenada Y del píxel
+			 * @return Color del píxel, en formato 0xRRGGBBAA, o cero si está fuera de la pantalla
+			 */
+			u32 pixel(u16 x, u16 y) const;
+
+			/**
+			 * Método observador del buffer de color completo.
+			 * @return Píxeles en formato 0xRRGGBBAA, fila a fila de arriba a abajo
+			 */
+			const u32* pixeles(void) const;
+
+			/**
+			 * Método observador de los contadores de trabajo, contados igual que en Screen.
+			 * @return Contadores del rasterizador
+			 */
+			const Contadores& contadores(void) const;
+
+			/**
+			 * Método observador del número de fragmentos procesados desde la creación del rasterizador, hayan pasado
+			 * o no las pruebas de alpha y profundidad.
+			 * @return Número de fragmentos
+			 */
+			u64 fragmentos(void) const;
+
+		private:
+
+			// Vértice ya transformado a coordenadas de pantalla, con su profundidad y sus coordenadas de textura
+			typedef struct vertice
+			{
+				f32 x;
+				f32 y;
+				u32 z;
+				f32 s;
+				f32 t;
+				u32 color;
+			} Vertice;
+
+			// Capacidad del lote de figuras, la misma que en Screen
+			static const u32 MAX_VERTICES_LOTE = 3 * 1024;
+			static const u32 MAX_PUNTOS_LOTE = 4096;
+
+			// Transformar un vértice con la proyección de Screen
+			Vertice transformar(s16 x, s16 y, s16 z, f32 s = 0, f32 t = 0) const;
+			// Dibujar un triángulo de color plano, o texturizado si se indica una textura
+			void triangulo(const Vertice& a, const Vertice& b, const Vertice& c, u32 color, const Textura* tex);
+			// Dibujar un cuadrilátero como dos triángulos, igual que GX_QUADS
+			void cuadrilatero(const Vertice* v, u32 color, const Textura* tex);
+			// Aplicar a un fragmento las pruebas de alpha y profundidad, y mezclarlo con el buffer de color
+			void fragmento(u32 indice, u32 z, u32 color);
+			// Color de un texel, en formato 0xRRGGBBAA
+			static u32 texel(const Textura& t, s32 x, s32 y);
+			// Color filtrado de unas coordenadas de textura normalizadas
+			static u32 muestrear(const Textura& t, f32 s, f32 ty);
+			// Contar las cargas y reconfiguraciones que haría Screen::configurarTextura() y configurarColor()
+			void configurarTextura(const Textura& t, u8 escala);
+			void configurarColor(void);
+			// Contar un bloque de vértices, como Screen::comenzar()
+			void comenzar(u16 vertices);
+			// Añadir un triángulo de color al lote, y dibujar el lote entero, como en Screen
+			void anadirTriangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 z, u32 color);
+			void vaciarLote(void);
+
+			u16 _ancho;
+			u16 _alto;
+			// Escala y desplazamiento vertical de la proyección
+			f32 _escala_x;
+			f32 _escala_y;
+			f32 _arriba;
+			std::vector<u32> _color;
+			std::vector<u32> _profundidad;
+			// Lote de figuras de color: vértices de triángulos (de tres en tres, con el color en el tercero) y puntos
+			std::vector<Vertice> _triangulos;
+			std::vector<Vertice> _puntos;
+			// Estado que recordaría Screen: escala de los descriptores (-1 si son de color), y última textura cargada
+			s16 _escala_cargada;
+			Textura _textura_cargada;
+			bool _textura_valida;
+			const u16* _paleta_cargada;
+			Contadores _contadores;
+			u64 _fragmentos;
+	};
+
+#endif
+
@@ -0,0 +1,179 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _RITMO_H_
+#define _RITMO_H_
+
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Clase que mantiene constante el número de frames por segundo y mide la duración de cada frame.
+	 *
+	 * @details El bucle principal de un juego debe presentar un frame nuevo a un ritmo fijo (el indicado en la
+	 * etiqueta fps del archivo de configuración, ver clase Juego), aunque unos frames cuesten más que otros. La
+	 * pantalla sólo cambia en la sincronización vertical (50 veces por segundo en PAL, 60 en NTSC), así que el ritmo
+	 * de frames tiene que contar con ella: un frame que espera de más y deja pasar la sincronización que le tocaba
+	 * no aparece hasta la siguiente, y el juego da un tirón. La clase Screen tiene un objeto de esta clase, que
+	 * decide en cada llamada a Screen::flip() cuánto hay que esperar antes de presentar el frame, y guarda las
+	 * estadísticas de duración de los frames (ver Screen::ritmo()).
+	 *
+	 * Si la frecuencia de refresco de la pantalla es múltiplo de los frames por segundo (por ejemplo, 30 fps en NTSC,
+	 * o 25 en PAL), cada frame dura un número exacto de sincronizaciones verticales, y el ritmo se lleva contándolas
+	 * (ver vblanks()): no hay nada que medir, y no se acumula ningún error. Si no lo es (25 fps en NTSC), el ritmo se
+	 * lleva con el reloj: cada frame tiene su instante previsto, que es el del frame anterior más la duración exacta
+	 * de un frame, de forma que el redondeo de un frame se compensa en los siguientes y la media es exacta. Antes de
+	 * presentar el frame, esperar() duerme sólo hasta la sincronización vertical anterior a ese instante, nunca más
+	 * allá, y la espera de la sincronización de Screen::flip() hace el resto. Si el juego se retrasa más de un frame
+	 * completo (por ejemplo, durante una carga), el ritmo vuelve a empezar a partir de ese momento, en lugar de
+	 * acelerar durante un rato para recuperar los frames perdidos.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * Los tiempos se miden en nanosegundos a partir del reloj de más resolución disponible: la base de tiempos del
+	 * procesador en la consola y CLOCK_MONOTONIC en el PC. Igual que el códec ADPCM o LZ4, este código no depende de
+	 * ninguna biblioteca gráfica y se compila tanto para la Wii como para el PC; la cuenta de las sincronizaciones
+	 * verticales la lleva la clase Screen, que es la que las espera.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // Sin la clase Screen, por ejemplo en el PC: 30 frames por segundo, sin sincronización vertical
+	 * Ritmo ritmo;
+	 * ritmo.configurar(30, 0);
+	 * while(jugando)
+	 * {
+	 *   actualizar();
+	 *   ritmo.esperar();
+	 *   presentar();
+	 *   ritmo.marcar();
+	 * }
+	 * printf("%u us de media, %u frames perdidos\n", ritmo.medio(), ritmo.perdidos());
+	 * @endcode
+	 *
+	 */
+	class Ritmo
+	{
+		public:
+
+			/**
+			 * Constructor de la clase Ritmo. Crea un ritmo sin límite de frames por segundo ni sincronización.
+			 */
+			Ritmo(void);
+
+			/**
+			 * Método que establece los frames por segundo y la frecuencia de la pantalla, y reinicia las estadísticas.
+			 * @param fps Frames por segundo que se quieren mantener (0 indica que no hay límite)
+			 * @param refresco Sincronizaciones verticales por segundo de la pantalla (0 si no se sincroniza)
+			 */
+			void configurar(u32 fps, u32 refresco);
+
+			/**
+			 * Método consultor del número de sincronizaciones verticales que dura cada frame cuando la frecuencia de
+			 * la pantalla es múltiplo de los frames por segundo.
+			 * @return Sincronizaciones verticales por frame, o cero si el ritmo se lleva con el reloj
+			 */
+			u32 vblanks(void) const;
+
+			/**
+			 * Método consultor de la duración prevista de cada frame.
+			 * @return Duración en microsegundos, o cero si no hay límite de frames por segundo ni sincronización
+			 */
+			u32 periodo(void) const;
+
+			/**
+			 * Método que, si el ritmo se lleva con el reloj, duerme hasta la sincronización vertical anterior al
+			 * instante previsto para presentar el frame (o hasta ese instante, si no hay sincronización). Se debe
+			 * llamar justo antes de esperar la sincronización vertical y presentar el frame.
+			 */
+			void esperar(void);
+
+			/**
+			 * Método que anota que se acaba de presentar un frame, y actualiza las estadísticas.
+			 */
+			void marcar(void);
+
+			/**
+			 * Método que reinicia las estadísticas de duración de los frames.
+			 */
+			void reiniciar(void);
+
+			/**
+			 * Método consultor del número de frames presentados desde que se reiniciaron las estadísticas.
+			 * @return Número de frames
+			 */
+			u32 frames(void) const;
+
+			/**
+			 * Método consultor de la duración del último frame.
+			 * @return Duración en microsegundos
+			 */
+			u32 ultimo(void) const;
+
+			/**
+			 * Método consultor de la duración media de los frames.
+			 * @return Duración media en microsegundos, o cero si aún no hay ningún frame completo
+			 */
+			u32 medio(void) const;
+
+			/**
+			 * Método consultor de la duración del frame más corto.
+			 * @return Duración en microsegundos, o cero si aún no hay ningún frame completo
+			 */
+			u32 minimo(void) const;
+
+			/**
+			 * Método consultor de la duración del frame más largo.
+			 * @return Duración en microsegundos
+			 */
+			u32 maximo(void) const;
+
+			/**
+			 * Método consultor del número de frames que han durado más de lo previsto (al menos la mitad de un frame
+			 * más), es decir, que no se han presentado a tiempo.
+			 * @return Número de frames perdidos
+			 */
+			u32 perdidos(void) const;
+
+			/**
+			 * Función que obtiene el instante actual del reloj monótono de más resolución disponible.
+			 * @return Nanosegundos transcurridos desde un origen arbitrario
+			 */
+			static u64 ahora(void);
+
+		private:
+
+			// Duración prevista de un frame y de una sincronización vertical, en nanosegundos (0 si no hay)
+			u64 _periodo;
+			u64 _vblank;
+			// Sincronizaciones verticales por frame, o 0 si el ritmo se lleva con el reloj
+			u32 _intervalo;
+			// Instante previsto para presentar el siguiente frame, e instante en que se presentó el anterior
+			u64 _siguiente;
+			u64 _anterior;
+			// Estadísticas, en nanosegundos
+			u32 _frames;
+			u32 _perdidos;
+			u64 _suma;
+			u64 _ultimo;
+			u64 _minimo;
+			u64 _maximo;
+	};
+
+#endif
+
@@ -23,6 +23,10 @@
 	#include <cstring>
 	#include <gccore.h>
 	#include <malloc.h>
+	#include "contadores.h"
+	#include "memoria.h"
+	#include "ritmo.h"
+	#include "textura.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
@@ -107,13 +111,31 @@
 	 * framebuffer actual al FIFO y de enviarlo al chip gráfico de la consola), y dos métodos consultores para saber, en
 	 * todo momento, el ancho y alto de la pantalla en píxeles.
 	 *
+	 * flip() también mantiene el ritmo de frames por segundo indicado con setFps(): si la frecuencia de la pantalla
+	 * es múltiplo de los frames por segundo, espera el número de sincronizaciones verticales que dura cada frame,
+	 * contadas desde el frame anterior; si no, duerme hasta la sincronización anterior al instante previsto para el
+	 * frame (ver clase Ritmo). En ningún caso se duerme después de esperar la sincronización, así que un frame nunca
+	 * deja pasar la sincronización en la que debe aparecer. Las estadísticas de duración de los frames se consultan
+	 * con ritmo().
+	 *
+	 * Por defecto, flip() espera a que el procesador gráfico termine de dibujar el frame (GX_DrawDone) antes de
+	 * esperar la sincronización vertical, así que la CPU y el procesador gráfico nunca trabajan a la vez. Con
+	 * setLatencia(1), flip() copia el frame en un tercer frame buffer, deja en la cola del procesador gráfico una
+	 * marca de fin de dibujo (GX_SetDrawDone) y vuelve sin esperar. Cuando el procesador gráfico llega a la marca,
+	 * una interrupción anota el frame buffer como terminado, y otra, justo antes de la siguiente sincronización
+	 * vertical, lo envía a la pantalla. El flip() siguiente espera, si hace falta, a que termine el frame anterior
+	 * antes de enviar el suyo, así que la CPU nunca va más de un frame por delante. Los tres frame buffers se usan en
+	 * rotación, de forma que nunca se copia un frame en el que está en pantalla o en el que está esperando a
+	 * mostrarse. Mientras la CPU calcula un frame, el procesador gráfico puede estar leyendo aún las texturas del
+	 * anterior; por eso, antes de liberar una textura hay que llamar a sincronizar().
+	 *
 	 * El punto fuerte de la clase Screen tiene que ver con las texturas. Se proporciona una función, crearTextura(),
-	 * que a partir de una zona de memoria en la cual haya píxeles de 8 bits por color y en formato RGB, creará un
-	 * objeto de textura GXTexObj, con el formato que utiliza la GX, y preparado para trabajar con él. El formato de
-	 * imagen que utiliza la Wii es RGB5A3, de 16 bits. Se representa con 5 bits para cada color, y uno para el canal
-	 * alpha, pero se puede utilizar un píxel de cada color para determinar niveles de transparencia más complejos. Esta
-	 * función de creación de texturas modifica la zona de memoria que almacena la información de los píxeles,
-	 * convirtiéndola en tiles de 4×4.
+	 * que a partir de una zona de memoria en la cual haya píxeles en formato RGB5A3, creará un objeto de textura
+	 * GXTexObj, con el formato que utiliza la GX, y preparado para trabajar con él. El formato de imagen que utiliza
+	 * la Wii es RGB5A3, de 16 bits. Se representa con 5 bits para cada color, y uno para el canal alpha, pero se puede
+	 * utilizar un píxel de cada color para determinar niveles de transparencia más complejos. Esta función de
+	 * creación de texturas modifica la zona de memoria que almacena la información de los píxeles, convirtiéndola en
+	 * tiles de 4×4 (ver textura.h, que codifica y reorganiza texturas de cualquiera de los formatos de la GX).
 	 *
 	 * Una vez creada la textura, se puede dibujar tal cual en la pantalla utilizando la función dibujarTextura(),
 	 * indicando sus coordenadas y su ancho y alto. También se puede dibujar una parte de esa textura, utilizando la
@@ -122,6 +144,23 @@
 	 * del cuadro. Internamente, estas dos funciones de dibujo hacen uso de una función privada de la clase,
 	 * configurarTextura(), que se encarga de establecer los descriptores de la GX para dibujar texturas.
 	 *
+	 * Las texturas de índices de paleta (CI4 y CI8, ver crearTexturaIndexada()) no guardan colores, sino índices de
+	 * una paleta de 16 o 256 colores (TLUT). A las dos funciones de dibujo se les indica la paleta con la que se
+	 * quiere dibujar la textura, que se carga en la memoria de texturas justo antes; así, dibujar la misma textura
+	 * con otra paleta (por ejemplo, un ladrillo de otro color) no cuesta nada.
+	 *
+	 * Cargar un objeto de textura en el procesador gráfico tiene un coste, así que configurarTextura() recuerda la
+	 * última textura y la última paleta cargadas (se compara el contenido de los objetos, no su dirección, que se
+	 * puede reutilizar), y sólo carga las que cambian; tampoco vuelve a configurar los descriptores de vértices si
+	 * el dibujo anterior ya era de una textura con la misma escala. Por eso conviene dibujar seguidos los cuadros de
+	 * una misma textura, y agrupar las imágenes pequeñas de una escena en las páginas de un atlas (ver clase Atlas).
+	 *
+	 * Para saber cuánto trabajo le cuesta al procesador gráfico cada frame, Screen cuenta las llamadas a sus funciones
+	 * de dibujo, los bloques de vértices y los vértices que envía, las texturas y paletas que carga, y las veces que
+	 * reconfigura la TEV y los descriptores de vértices (ver clase Contadores). Los contadores se cierran en cada
+	 * flip(), guardan el historial de los últimos frames, y se consultan con contadores() o se vuelcan en el log del
+	 * sistema con informe().
+	 *
 	 * El tercer bloque de funciones de dibujo de la clase Screen son, básicamente, funciones que permiten dibujar
 	 * formas geométricas (como son un punto, una línea recta, un rectángulo y un círculo), en un color plano, y a
 	 * partir de las primitivas que se describieron anteriormente. Importante: al dibujar un rectángulo, el orden de los
@@ -130,6 +169,16 @@
 	 * uso de una función privada de la clase, configurarColor(), que se encarga de establecer los descriptores de la GX
 	 * para dibujar con color directo de relleno.
 	 *
+	 * Las figuras geométricas no se envían al procesador gráfico una a una, sino que se acumulan en un lote: cada
+	 * línea y cada rectángulo son dos triángulos, cada círculo es un abanico de triángulos alrededor de su centro (con
+	 * más segmentos cuanto mayor es, ver trigonometria.h), y los puntos se guardan aparte. El lote se dibuja entero
+	 * justo antes del siguiente dibujo de una textura, al final del frame (flip()), cuando se llena o cuando cambia el
+	 * tipo de primitiva (de triángulos a puntos o al revés), con una sola configuración de color y un único bloque de
+	 * vértices. Así, un texto (que la clase Fuente dibuja punto a punto), una capa de depuración o un efecto de
+	 * partículas cuestan un bloque en lugar de uno por figura. Las figuras se dibujan siempre en el orden en el que se
+	 * pidieron, también respecto a las texturas, así que dos figuras que se solapan en la misma Z se ven igual que si
+	 * se dibujasen de una en una.
+	 *
 	 * Para más información sobre los métodos de la clase Screen, consultar su descripción.
 	 *
 	 * Ejemplo de uso:
@@ -205,18 +254,94 @@
 			 */
 			void flip(void);
 
+			/**
+			 * Método que establece los frames por segundo que debe mantener flip(), y reinicia las estadísticas de
+			 * duración de los frames.
+			 * @param fps Frames por segundo (0 indica que cada frame dura hasta la siguiente sincronización vertical)
+			 */
+			void setFps(u8 fps);
+
+			/**
+			 * Método que establece cuántos frames puede ir la CPU por delante del procesador gráfico. Con latencia 0
+			 * (el valor por defecto), flip() espera a que el procesador gráfico termine el frame antes de mostrarlo.
+			 * Con latencia 1, flip() envía el frame y vuelve sin esperar, de forma que la CPU calcula el siguiente
+			 * frame mientras el procesador gráfico dibuja éste, a cambio de mostrarlo como mucho un frame más tarde y
+			 * de reservar un tercer frame buffer. Valores mayores que 1 se consideran 1.
+			 * @param frames Frames de latencia (0 o 1)
+			 */
+			void setLatencia(u8 frames);
+
+			/**
+			 * Método observador de la latencia establecida con setLatencia().
+			 * @return Frames de latencia (0 o 1)
+			 */
+			u8 latencia(void) const;
+
+			/**
+			 * Método que espera a que el procesador gráfico termine el último frame enviado. Con latencia 1, hay que
+			 * llamarlo antes de liberar o modificar la memoria de una textura que se haya dibujado en el frame
+			 * anterior (la galería lo hace al descargar una imagen); con latencia 0, no hace nada.
+			 */
+			void sincronizar(void);
+
+			/**
+			 * Método observador del ritmo de frames, con las estadísticas de duración de los frames presentados.
+			 * @return Ritmo de frames de la pantalla
+			 */
+			const Ritmo& ritmo(void) const;
+
+			/**
+			 * Método observador de la frecuencia de refresco de la pantalla.
+			 * @return Sincronizaciones verticales por segundo (50 en PAL, 60 en el resto de modos)
+			 */
+			u32 refresco(void) const;
+
+			/**
+			 * Método observador de los contadores de trabajo del procesador gráfico, con el historial de los últimos
+			 * frames.
+			 * @return Contadores de la pantalla
+			 */
+			const Contadores& contadores(void) const;
+
+			/**
+			 * Método que escribe en el log del sistema, como información, el resumen de los contadores de trabajo del
+			 * procesador gráfico en los últimos frames.
+			 */
+			void informe(void) const;
+
 			/**
 			 * Método que, a partir de una zona de memoria con información de píxeles, crea un objeto de textura
 			 * GXTexObj, con el cual puede trabajar la biblioteca de bajo nivel GX. El formato de la zona de memoria
-			 * debe ser una secuencia de píxeles, con 24 bits por píxel (ocho bits por color, primero rojo, seguido
-			 * de verde y finalmente azul). Las medidas de la imagen formada por la información de estos píxeles
-			 * debe tener medidas (alto y ancho) múltiplos de 8.
+			 * debe ser una secuencia de píxeles RGB5A3, de 16 bits por píxel, que se reorganiza en tiles de 4x4 con
+			 * textura::ordenar() (para otros formatos, ver textura.h). Las medidas de la imagen formada por la
+			 * información de estos píxeles debe tener medidas (alto y ancho) múltiplos de 8.
 			 * @param textura Dirección de memoria a un objeto GXTexObj recién creado.
 			 * @param pixeles Dirección a la zona de memoria donde se encuentra la información de la imagen.
 			 * @param ancho Ancho en píxeles que tiene la imagen que se convertirá en textura.
 			 * @param alto Alto en píxeles que tiene la imagen que se convertirá en textura.
+			 * @param ordenada Verdadero si los píxeles ya están organizados en tiles de 4x4 (por ejemplo, los que
+			 * decodifica bmp::decodificar()), en cuyo caso no se reorganizan.
+			 */
+			void crearTextura(GXTexObj* textura, void* pixeles, u16 ancho, u16 alto, bool ordenada = false);
+
+			/**
+			 * Método que crea un objeto de textura de índices de paleta (CI4 o CI8), ya codificada en bloques (ver
+			 * textura::codificarIndices()). La textura toma sus colores de la paleta que se indique al dibujarla.
+			 * @param textura Dirección de memoria a un objeto GXTexObj recién creado.
+			 * @param indices Dirección de la textura de índices, en memoria alineada a 32 bytes.
+			 * @param ancho Ancho en píxeles de la textura.
+			 * @param alto Alto en píxeles de la textura.
+			 * @param formato Formato de la textura: textura::CI4 o textura::CI8.
 			 */
-			void crearTextura(GXTexObj* textura, void* pixeles, u16 ancho, u16 alto);
+			void crearTexturaIndexada(GXTexObj* textura, void* indices, u16 ancho, u16 alto, textura::Formato formato);
+
+			/**
+			 * Método que crea un objeto de paleta (TLUT) a partir de una tabla de colores RGB5A3.
+			 * @param paleta Dirección de memoria a un objeto GXTlutObj.
+			 * @param colores Tabla de colores RGB5A3, en memoria alineada a 32 bytes.
+			 * @param num Número de colores de la tabla: 16 para texturas CI4, 256 para texturas CI8.
+			 */
+			void crearPaleta(GXTlutObj* paleta, void* colores, u16 num);
 
 			/**
 			 * Método que dibuja una textura en formato GXTexObj en unas coordenadas (x,y,z) de la pantalla. En
@@ -227,8 +352,9 @@
 			 * @param z Coordenada Z (capa) donde se comenzará a dibujar la textura. Entre 0 y 999.
 			 * @param ancho Ancho en píxeles de la textura a dibujar
 			 * @param alto Alto en píxeles de la textura a dibujar
+			 * @param paleta Paleta de colores, sólo para las texturas de índices (ver crearTexturaIndexada()).
 			 */
-			void dibujarTextura(GXTexObj* textura, s16 x, s16 y, s16 z, u16 ancho, u16 alto);
+			void dibujarTextura(GXTexObj* textura, s16 x, s16 y, s16 z, u16 ancho, u16 alto, GXTlutObj* paleta = NULL);
 
 			/**
 			 * Método que dibuja una parte de una textura en formato GXTexObj en unas coordenadas (x,y,z)
@@ -248,9 +374,11 @@
 			 * @param cuadroAncho Ancho en píxeles del cuadro de la textura que se va a dibujar.
 			 * @param cuadroAlto Alto en píxeles del cuadro de la textura que se va a dibujar.
 			 * @param invertido Verdadero si se quiere dibujar el cuadro de la textura invertido respecto al eje vert.
+			 * @param paleta Paleta de colores, sólo para las texturas de índices (ver crearTexturaIndexada()).
 			 */
 			void dibujarCuadro(GXTexObj* textura, u16 texAncho, u16 texAlto, s16 x, s16 y, s16 z,
-								s16 cuadroX, s16 cuadroY, u16 cuadroAncho, u16 cuadroAlto, bool invertido = false);
+								s16 cuadroX, s16 cuadroY, u16 cuadroAncho, u16 cuadroAlto, bool invertido = false,
+								GXTlutObj* paleta = NULL);
 
 			/**
 			 * Método que dibuja un punto de un color concreto en unas coordenadas (x,y,z).
@@ -335,8 +463,8 @@
 
 			// Puntero al modo de pantalla
 			GXRModeObj* _screenMode;
-			// Dos buffers de frame para el sistema de doble buffer
-			void* _frameBuffer[2];
+			// Dos buffers de frame para el sistema de doble buffer, y un tercero si hay latencia
+			void* _frameBuffer[3];
 			// Buffer para pasar la información de cada frame al procesador gráfico
 			void* _fifoBuffer;
 			// Tamaño del fifoBuffer
@@ -351,23 +479,54 @@
 			u16 _alto_pantalla;
 			// Ancho de la pantalla
 			u16 _ancho_pantalla;
-			// Indica el buffer actual (0 o 1)
+			// Indica el buffer actual (0 o 1, o de 0 a 2 con latencia)
 			u8 _frame_actual;
+			// Frame buffer enviado a la pantalla en último lugar
+			u8 _mostrado;
+			// Frames que la CPU puede ir por delante del procesador gráfico (0 o 1)
+			u8 _latencia;
 			// Indicador de si hace falta actualizar la pantalla o no
 			u8 _update_scr;
 			// Flag que indica si los gráficos se han actualizado en este frame
 			u8 _update_gfx;
+			// Escala de coordenadas de textura de los descriptores actuales, -2 si están preparados para color directo,
+			// o -1 si aún no se han preparado
+			s16 _escala_cargada;
+			// Copia de la última textura y de la última paleta cargadas, para no volver a cargarlas
+			GXTexObj _textura_cargada;
+			GXTlutObj _paleta_cargada;
+			bool _textura_valida;
+			bool _paleta_valida;
+			// Ritmo de frames, y número de sincronizaciones verticales en el momento de presentar el último frame
+			Ritmo _ritmo;
+			u32 _retrace;
+			// Contadores de trabajo del procesador gráfico
+			Contadores _contadores;
+			// Lote de dibujos de color: vértices de triángulos (de tres en tres) y puntos, aún sin enviar
+			typedef struct vertice_color
+			{
+				s16 x;
+				s16 y;
+				s16 z;
+				u32 color;
+			} VerticeColor;
+			static const u32 MAX_VERTICES_LOTE = 3 * 1024;
+			static const u32 MAX_PUNTOS_LOTE = 4096;
+			VerticeColor _triangulos[MAX_VERTICES_LOTE];
+			VerticeColor _puntos[MAX_PUNTOS_LOTE];
+			u32 _num_triangulos;
+			u32 _num_puntos;
 
-			// Método para crear tiles de 4x4 a partir de una memoria de pixeles
-			void tiling4x4(void* mem, u16 ancho, u16 alto);
-			// Método para calcular el seno de un ángulo respecto a 16384 (no respecto a 360º)
-			u32 seno(u32 ang);
-			// Método para calcular el coseno de un ángulo respecto a 16384 (no respecto a 360º)
-			u32 coseno(u32 ang);
+			// Método que añade al lote un triángulo de color
+			void anadirTriangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 z, u32 color);
+			// Método que dibuja todos los triángulos y puntos del lote, y lo vacía
+			void vaciarLote(void);
 			// Método que prepara el procesador gráfico para dibujar color directo (en formato u32)
 			void configurarColor(void);
 			// Método que prepara el procesador gráfico para dibujar una textura
-			void configurarTextura(GXTexObj* textura, u8 escala);
+			void configurarTextura(GXTexObj* textura, u8 escala, GXTlutObj* paleta);
+			// Método que comienza un bloque de vértices, sumándolo a los contadores
+			void comenzar(u8 primitiva, u16 vertices);
 	};
 
 	#define screen Screen::get_instance()
@@ -20,10 +20,15 @@
 
 	#include <cstdio>
 	#include <cstdlib>
+	#include <cstring>
 	#include <fat.h>
+	#include <malloc.h>
 	#include <sdcard/wiisd_io.h>
 	#include <string>
 	#include <unistd.h>
+	#include "excepcion.h"
+	#include "memoria.h"
+	#include "paquete.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
@@ -80,6 +85,18 @@
 	 * que Sdcard haya montado previamente la unidad FAT/FAT32 sobre la que se van a realizar las operaciones de entrada
 	 * y salida.
 	 *
+	 * Paquetes de recursos
+	 *
+	 * Cada recurso de un juego es un archivo distinto de la tarjeta SD, y abrir un archivo en una partición FAT es
+	 * una operación lenta. Para evitarlo, los recursos se pueden reunir en un paquete con la herramienta empaquetar
+	 * (ver clase Paquete y directorio tools). Una vez montado un paquete con montarPaquete(), los métodos existe() y
+	 * leer() buscan primero en el índice del paquete cualquier archivo cuya ruta esté dentro del directorio en el que
+	 * se encuentra el paquete, y sólo acceden a la tarjeta si el archivo no está en él. De esta forma, el resto de
+	 * clases de la biblioteca utilizan el paquete sin cambiar las rutas de los recursos. Por ejemplo, si se monta el
+	 * paquete '/apps/wiipang/datos.pak', una petición del archivo '/apps/wiipang/media/fondo.bmp' se atiende con la
+	 * entrada 'media/fondo.bmp' del paquete. Si la entrada está comprimida, leer() la descomprime directamente en la
+	 * memoria que devuelve, y el tamaño indicado es el del archivo original.
+	 *
 	 * Pequeño ejemplo de uso:
 	 *
 	 * @code
@@ -155,6 +172,34 @@
 			 */
 			bool existe(const std::string& archivo);
 
+			/**
+			 * Método que lee un archivo completo de la tarjeta SD (o del paquete montado) a una zona de memoria
+			 * alineada a 32 bytes, cuyo tamaño se redondea a un múltiplo de 32 bytes y se rellena con ceros, de tal
+			 * manera que siempre queda al menos un byte nulo tras el contenido. La memoria pasa a ser propiedad
+			 * de quien llama al método, que debe liberarla con memoria::liberar(). Se puede llamar desde cualquier
+			 * hilo.
+			 * @param archivo Ruta absoluta del archivo que se quiere leer, con el nombre de la unidad como prefijo.
+			 * @param tam Variable donde se guarda el tamaño real en bytes del archivo.
+			 * @param etiqueta Subsistema al que se asigna la memoria del contenido (ver memoria.h)
+			 * @return Puntero a la zona de memoria con el contenido del archivo.
+			 * @throw ArchivoEx Se lanza si la unidad no está montada o si hay algún error al leer el archivo
+			 */
+			u8* leer(const std::string& archivo, u32& tam, memoria::Etiqueta etiqueta = memoria::ARCHIVOS)
+				throw (ArchivoEx);
+
+			/**
+			 * Método que monta un paquete de recursos. Si ya había un paquete montado, se desmonta. A partir de este
+			 * momento, los archivos del directorio del paquete se leen desde el paquete.
+			 * @param ruta Ruta absoluta del paquete en la tarjeta SD, sin el nombre de la unidad como prefijo.
+			 * @throw ArchivoEx Se lanza si el paquete no existe o no es válido
+			 * @throw TarjetaEx Se lanza si la unidad no está montada
+			 */
+			void montarPaquete(const std::string& ruta) throw (ArchivoEx, TarjetaEx);
+
+			/**
+			 * Método que desmonta el paquete de recursos, si hay alguno montado.
+			 */
+			void desmontarPaquete(void);
 
 		protected:
 
@@ -185,8 +230,13 @@
 		private:
 
 			static Sdcard* _instance;
+			// Buscar en el paquete montado un archivo indicado con su ruta completa (unidad incluida)
+			bool enPaquete(const std::string& archivo, paquete::Entrada& e) const;
+
 			u16 _montada;
 			std::string _unidad;
+			Paquete _paquete;
+			std::string _raiz;
 	};
 
 	#define sdcard Sdcard::get_instance()
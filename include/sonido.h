@@ -19,11 +19,12 @@
 #define _SONIDO_H_
 
 	#include <asndlib.h>
-	#include <fstream>
 	#include <gccore.h>
 	#include <malloc.h>
 	#include <string>
+	#include "adpcm.h"
 	#include "excepcion.h"
+	#include "mezclador.h"
 	#include "sdcard.h"
 
 	/**
@@ -58,6 +59,17 @@
 	 * Una vez finalizada la conversión, basta con copiar el archivo output.pcm a la tarjeta SD, y trabajar con la
 	 * clase Sonido para tener el efecto disponible para su reproducción.
 	 *
+	 * Como el PCM de 16 bits ocupa mucha memoria, la clase también admite efectos comprimidos en IMA ADPCM de 4 bits
+	 * por muestra, que ocupan la cuarta parte. Estos archivos se obtienen a partir de los archivos PCM anteriores con
+	 * la herramienta pcm2adpcm, que se encuentra en el directorio tools de la biblioteca y se compila para el PC:
+	 *
+	 * @code
+	 * pcm2adpcm output.pcm output.adpcm
+	 * @endcode
+	 *
+	 * No hace falta indicar de ningún modo que un efecto está comprimido: al cargarlo, la clase reconoce la cabecera
+	 * del formato ADPCM (ver espacio de nombres adpcm), y en caso contrario, trata el archivo como PCM crudo.
+	 *
 	 * Existe un detalle importante a tener en cuenta, y es relativo al sistema de sonido de la Nintendo Wii. La libASND
 	 * puede mezclar 16 voces de sonido, una de las cuales está reservada para la pista de música. Esto es así porque la
 	 * cantidad de instrucciones a procesar para mezclar 16 voces con la diversidad de formatos expuesta antes es muy
@@ -68,12 +80,13 @@
 	 * procesador cuya única tarea es la de procesar los efectos de sonido. Con esto se consigue descongestionar al
 	 * procesador principal, y obtener una mayor potencia a la hora de trabajar con el audio.
 	 *
-	 * Cada vez que un sonido es reproducido, se busca una voz desocupada (que no esté reproduciendo nada en ese
-	 * momento), y se envía allí la secuencia de datos que componen el sonido. Evidentemente, esto quiere decir que sólo
-	 * se pueden reproducir, en un mismo momento, 15 efectos de sonido y una pista de música, cantidad más que
-	 * suficiente para el desarrollo de juegos en dos dimensiones. Si en algún momento, se intentaran reproducir más
-	 * sonidos de los que se permiten, no ocurriría ningún error, porque existe un mecanismo que evita que haya
-	 * conflictos: si no hay ninguna voz libre, el sonido no se intenta reproducir.
+	 * Cada vez que un sonido es reproducido, la clase Mezclador le asigna una voz, y se envía allí la secuencia de
+	 * datos que componen el sonido. Evidentemente, esto quiere decir que sólo se pueden reproducir, en un mismo
+	 * momento, 15 efectos de sonido y una pista de música. Para repartir estas voces, cada sonido tiene una prioridad
+	 * (de 0 a 255, mayor cuanto más importante sea el efecto) y un número máximo de instancias simultáneas (0 indica
+	 * que no hay límite). Si no hay ninguna voz libre, el Mezclador roba la voz del efecto menos prioritario, y si el
+	 * mismo sonido se reproduce varias veces en un mismo frame, las peticiones se fusionan en una sola. Consultar la
+	 * documentación de la clase Mezclador para conocer todos los detalles.
 	 *
 	 * Funcionamiento interno de la clase Sonido
 	 *
@@ -85,19 +98,25 @@
 	 * como tipo del puntero). En último lugar, se lee el propio archivo a la zona de memoria alineada, y se cierra el
 	 * flujo de bytes.
 	 *
+	 * Los efectos comprimidos se guardan en memoria tal y como están en el archivo, y nunca se descomprimen por
+	 * completo. Al reproducirlos, el Mezclador decodifica los bloques ADPCM de uno en uno, conforme la libASND los va
+	 * necesitando, en un pequeño búfer doble que tiene reservado para cada voz. Fuera de la reproducción, el único
+	 * coste del formato comprimido es el de la propia decodificación, que se realiza en la interrupción de audio.
+	 *
 	 * Un sonido dispondrá también de dos valores enteros de 8 bits sin signo, que representan el volumen de cada uno de
 	 * los dos canales de audio. Estos dos valores se le pueden pasar al constructor junto con la ruta absoluta del
 	 * archivo a cargar, y también se pueden modificar en tiempo de ejecución, de tal manera que, en ese sentido, la
-	 * clase es bastante flexible.
+	 * clase es bastante flexible. Igualmente, el constructor recibe la prioridad y el número máximo de instancias del
+	 * efecto, que se leen de los atributos 'prioridad' e 'instancias' de la etiqueta del sonido en la Galeria.
 	 *
-	 * Para escuchar un sonido, se busca la primera voz para efectos que esté libre, y se vuelca en ella la información
-	 * del sonido, comenzando la reproducción. Como esta clase está pensada para pequeños efectos de sonido, no se
+	 * Para escuchar un sonido, se solicita una voz al Mezclador, y se vuelca en ella la información del sonido,
+	 * comenzando la reproducción. Como esta clase está pensada para pequeños efectos de sonido, no se
 	 * proporciona un método de parada o pausa de la reproducción, ya que se sobreentiende que un efecto de sonido dura,
 	 * a lo sumo, cinco o seis segundos.
 	 *
 	 * Existe una función estática y pública, llamada Sonido::inicializar(), a la cual es necesario llamar antes de
-	 * trabajar con la clase. Dicha función también establece que, al salir del programa, se apague el subsistema de
-	 * audio de la consola.
+	 * trabajar con la clase. Dicha función inicializa el Mezclador, y también establece que, al salir del programa, se
+	 * apague el subsistema de audio de la consola.
 	 *
 	 * Por último, un pequeño fragmento de código para ilustrar el uso de la clase:
 	 *
@@ -121,10 +140,13 @@
 			 * @param ruta Ruta absoluta del fichero de sonido desde el que se cargará el efecto de sonido
 			 * @param volder Volumen del canal derecho
 			 * @param volizq Volumen del canal izquierdo
+			 * @param prioridad Prioridad del efecto a la hora de repartir las voces (mayor cuanto más importante)
+			 * @param instancias Número máximo de reproducciones simultáneas del efecto (0 indica que no hay límite)
 			 * @throw ArchivoEx Se lanza si hay algún error al abrir el archivo al que apunta la ruta aportada
 			 * @throw TarjetaEx Se lanza si ocurre un error relacionado con la tarjeta SD
 			 */
-			Sonido(const std::string& ruta, u8 volder = 255, u8 volizq = 255) throw (ArchivoEx, TarjetaEx);
+			Sonido(const std::string& ruta, u8 volder = 255, u8 volizq = 255, u8 prioridad = 128, u8 instancias = 0)
+				throw (ArchivoEx, TarjetaEx);
 
 			/**
 			 * Destructor de la clase Sonido.
@@ -133,12 +155,82 @@
 
 			/**
 			 * Método que reproduce un sonido una sola vez, con el volumen prefijado para cada canal.
-			 * Si el sonido pudiera reproducirse correctamente, se devuelve un valor True, en caso contrario,
-			 * el método devuelve un valor False.
+			 * Si el sonido pudiera reproducirse correctamente (o se ha fusionado con otra reproducción del mismo
+			 * sonido en este frame), se devuelve un valor True; si el Mezclador lo ha descartado, el método
+			 * devuelve un valor False.
 			 * @return Se devuelve verdadero si el sonido se reproduce correctamente, en caso contrario, falso.
 			 */
 			bool play(void) const;
 
+			/**
+			 * Método consultor de los datos del sonido, alineados a 32 bytes.
+			 * @return Puntero a las muestras del sonido (o al archivo ADPCM completo, si el sonido está comprimido)
+			 */
+			const s16* datos(void) const;
+
+			/**
+			 * Método consultor del tamaño en bytes de los datos del sonido.
+			 * @return Tamaño en bytes de las muestras del sonido (o del archivo ADPCM, si el sonido está comprimido)
+			 */
+			u32 tamano(void) const;
+
+			/**
+			 * Método que indica si el sonido está comprimido en formato ADPCM.
+			 * @return Verdadero si el sonido está comprimido, falso si se trata de PCM crudo
+			 */
+			bool comprimido(void) const;
+
+			/**
+			 * Método consultor del formato del sonido. Para un sonido PCM crudo, la cabecera indica 2 canales a
+			 * 48000 Hz y ningún bloque.
+			 * @return Referencia constante a la cabecera del sonido
+			 */
+			const adpcm::Cabecera& cabecera(void) const;
+
+			/**
+			 * Método que devuelve la dirección de un bloque ADPCM del sonido. Sólo tiene sentido para sonidos
+			 * comprimidos, y no se comprueba que el índice sea válido.
+			 * @param indice Índice del bloque, empezando por cero
+			 * @return Puntero al comienzo del bloque
+			 */
+			const u8* bloque(u32 indice) const;
+
+			/**
+			 * Método consultor de la duración del sonido.
+			 * @return Duración del sonido, en microsegundos
+			 */
+			u64 duracion(void) const;
+
+			/**
+			 * Método consultor de la memoria que ocupa el sonido.
+			 * @return Número de bytes que ocupa el sonido en memoria.
+			 */
+			u32 bytes(void) const;
+
+			/**
+			 * Método consultor del volumen del canal izquierdo.
+			 * @return Volumen del canal izquierdo (entre 0 y 255)
+			 */
+			u8 volumenIzquierdo(void) const;
+
+			/**
+			 * Método consultor del volumen del canal derecho.
+			 * @return Volumen del canal derecho (entre 0 y 255)
+			 */
+			u8 volumenDerecho(void) const;
+
+			/**
+			 * Método consultor de la prioridad del efecto.
+			 * @return Prioridad del efecto (entre 0 y 255, mayor cuanto más importante)
+			 */
+			u8 prioridad(void) const;
+
+			/**
+			 * Método consultor del número máximo de instancias simultáneas del efecto.
+			 * @return Número máximo de instancias (0 indica que no hay límite)
+			 */
+			u8 instancias(void) const;
+
 			/**
 			 * Función modificadora del volumen del canal izquierdo del sonido.
 			 * @param volumen Nuevo valor para el volumen del canal izquierdo (entre 0 y 255).
@@ -155,6 +247,7 @@
 			 * Método de clase para inicializar el sistema de sonido de la consola.
 			 */
 			static void inicializar(void) {
+				mezclador->inicializar();
 				ASND_Init();
 				ASND_Pause(0);
 				atexit(ASND_End);
@@ -175,9 +268,11 @@
 			Sonido& operator=(const Sonido& m);
 
 		private:
-			u8 _volder, _volizq;
-			s16* _sonido;
+			u8 _volder, _volizq, _prioridad, _instancias;
+			u8* _sonido;
 			u32 _size;
+			bool _comprimido;
+			adpcm::Cabecera _cabecera;
 	};
 
 #endif
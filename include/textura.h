@@ -0,0 +1,251 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _TEXTURA_H_
+#define _TEXTURA_H_
+
+	#include <cstring>
+	#include <gctypes.h>
+	#include "bmp.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones para codificar píxeles RGBA en cualquiera de los formatos de textura de la GX.
+	 *
+	 * @details El procesador gráfico de la Wii no lee las texturas fila a fila, sino por bloques: la imagen se divide
+	 * en bloques de 32 bytes (4x4 píxeles en los formatos de 16 bits, 8x4 en los de 8 bits y 8x8 en los de 4 bits), y
+	 * los bloques se almacenan de izquierda a derecha y de arriba a abajo. Cada formato tiene además su propia forma
+	 * de guardar los píxeles dentro del bloque: RGBA8 reparte cada bloque de 4x4 en dos mitades de 32 bytes (alpha y
+	 * rojo en la primera, verde y azul en la segunda), y CMPR (la compresión S3TC/DXT1 de la GX) agrupa cuatro
+	 * subbloques de 4x4 en cada bloque de 8x8.
+	 *
+	 * Estas funciones convierten una imagen lineal de píxeles RGBA (cuatro bytes por píxel: rojo, verde, azul y alpha)
+	 * en una textura de cualquiera de esos formatos, lista para GX_InitTexObj(), y reorganizan en bloques una imagen
+	 * lineal que ya esté en el formato de destino. Se escribe siempre byte a byte en big endian, que es el orden de
+	 * la consola, así que el resultado es idéntico en la Wii y en el PC: igual que el códec ADPCM o LZ4, este código
+	 * no depende de ninguna biblioteca de la consola, y las herramientas del directorio tools pueden preparar en el PC
+	 * texturas que la consola utiliza tal cual.
+	 *
+	 * Los formatos de índices (CI4 y CI8) no se obtienen a partir de colores, sino de una imagen de índices de paleta
+	 * (ver codificarIndices()). Si las medidas de la imagen no son múltiplo de las del bloque, los píxeles que sobran
+	 * en los bloques del borde se rellenan con ceros (transparentes).
+	 *
+	 * Funcionamiento interno
+	 *
+	 * La textura se recorre en el orden de sus bloques, que es el orden en el que se escribe: el destino se escribe
+	 * siempre de forma secuencial, y de la imagen de origen sólo se leen, para cada bloque, unos pocos bytes
+	 * consecutivos de 4 u 8 filas, que caben a la vez en la caché. Para cada formato hay un núcleo que codifica un
+	 * bloque completo a partir de su esquina superior izquierda; los bloques del borde que se salen de la imagen se
+	 * copian antes a un bloque temporal rellenado con ceros, de forma que los núcleos no tienen que comprobar nada.
+	 *
+	 * indexar() cuenta los colores de una textura RGB5A3 con una pequeña tabla hash de direccionamiento abierto, y
+	 * abandona en cuanto aparece el color número 257, así que el coste en imágenes con muchos colores es mínimo.
+	 *
+	 * El codificador de CMPR toma como extremos de cada subbloque las esquinas de la caja que contiene sus colores
+	 * opacos, y asigna a cada píxel el más cercano de los cuatro colores resultantes. Si el subbloque tiene algún
+	 * píxel con alpha menor que 128, utiliza el modo de tres colores de DXT1, en el que el cuarto es transparente.
+	 *
+	 * Texturas cocinadas
+	 *
+	 * La herramienta cocinar (ver directorio tools) hace en el PC todo el trabajo que la clase Imagen hace al cargar
+	 * una imagen BMP o PNG (decodificar, aplicar el color transparente, organizar en bloques y, si procede, convertir
+	 * a índices de paleta), y guarda el resultado en un archivo que la consola carga con una sola lectura. El archivo
+	 * comienza con una cabecera de 32 bytes (ver estructura Cabecera): la firma "WTEX", la versión (un byte), el
+	 * formato (un byte), el ancho, el alto y el número de colores de la paleta (16 bits cada uno), el tamaño de la
+	 * textura y la posición de la paleta (32 bits cada uno); el resto de bytes valen cero. La textura comienza justo
+	 * después de la cabecera, en la posición 32, y la paleta (sólo en los formatos CI4 y CI8, con 16 o 256 entradas
+	 * RGB5A3) en la siguiente posición múltiplo de 32. Como en el resto de formatos binarios de la biblioteca, todos
+	 * los campos se almacenan en big endian. Como el archivo se lee en una zona de memoria alineada a 32 bytes, la
+	 * textura y la paleta quedan alineadas, y se pasan tal cual a GX_InitTexObj() y GX_InitTlutObj().
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * u32 tam = textura::tam(textura::RGB565, ancho, alto);
+	 * u8* texels = (u8*)memoria::reservar(tam, memoria::TEXTURAS);
+	 * textura::codificar(rgba, ancho, alto, textura::RGB565, texels);
+	 * DCFlushRange(texels, tam);
+	 * GX_InitTexObj(&obj, texels, ancho, alto, textura::RGB565, GX_CLAMP, GX_CLAMP, GX_FALSE);
+	 * @endcode
+	 *
+	 */
+	namespace textura
+	{
+		/**
+		 * Formatos de textura de la GX. Los valores coinciden con las constantes GX_TF_* de libOgc, así que se
+		 * pueden pasar directamente a GX_InitTexObj().
+		 */
+		enum Formato
+		{
+			I4 = 0x0,		/**< Intensidad de 4 bits */
+			I8 = 0x1,		/**< Intensidad de 8 bits */
+			IA4 = 0x2,		/**< Intensidad y alpha de 4 bits */
+			IA8 = 0x3,		/**< Intensidad y alpha de 8 bits */
+			RGB565 = 0x4,	/**< Color de 16 bits, sin alpha */
+			RGB5A3 = 0x5,	/**< Color de 16 bits, opaco con 5 bits por componente o con 3 bits de alpha */
+			RGBA8 = 0x6,	/**< Color de 32 bits */
+			CI4 = 0x8,		/**< Índice de paleta de 4 bits */
+			CI8 = 0x9,		/**< Índice de paleta de 8 bits */
+			CMPR = 0xE		/**< Compresión S3TC (DXT1), 4 bits por píxel */
+		};
+
+		/**
+		 * Tamaño en bytes de la cabecera de una textura cocinada.
+		 */
+		static const u32 TAM_CABECERA = 32;
+
+		/**
+		 * Versión de las texturas cocinadas que se escriben.
+		 */
+		static const u8 VERSION = 1;
+
+		/**
+		 * @brief Cabecera de una textura cocinada, con sus campos ya convertidos al orden de bytes de la máquina.
+		 */
+		typedef struct cabecera
+		{
+			u8 version;
+			u8 formato;
+			u16 ancho;
+			u16 alto;
+			u16 colores;
+			u32 tam;
+			u32 paleta;
+		} Cabecera;
+
+		/**
+		 * Calcula el ancho en píxeles de los bloques de un formato.
+		 * @param formato Formato de la textura
+		 * @return Ancho de bloque: 4 u 8 píxeles
+		 */
+		u32 anchoBloque(Formato formato);
+
+		/**
+		 * Calcula el alto en píxeles de los bloques de un formato.
+		 * @param formato Formato de la textura
+		 * @return Alto de bloque: 4 u 8 píxeles
+		 */
+		u32 altoBloque(Formato formato);
+
+		/**
+		 * Calcula el número de bits que ocupa cada píxel en un formato.
+		 * @param formato Formato de la textura
+		 * @return Bits por píxel: 4, 8, 16 o 32
+		 */
+		u32 bitsPixel(Formato formato);
+
+		/**
+		 * Calcula el tamaño en bytes de una textura, con sus medidas redondeadas a bloques completos. Siempre es
+		 * múltiplo de 32 bytes.
+		 * @param formato Formato de la textura
+		 * @param ancho Ancho en píxeles
+		 * @param alto Alto en píxeles
+		 * @return Tamaño en bytes de la textura
+		 */
+		u32 tam(Formato formato, u16 ancho, u16 alto);
+
+		/**
+		 * Codifica una imagen lineal RGBA en una textura de la GX.
+		 * @param rgba Píxeles de la imagen, fila a fila, con cuatro bytes por píxel (rojo, verde, azul y alpha)
+		 * @param ancho Ancho en píxeles de la imagen
+		 * @param alto Alto en píxeles de la imagen
+		 * @param formato Formato de la textura; no puede ser un formato de índices
+		 * @param destino Zona de memoria de tam() bytes donde se escribe la textura
+		 * @return Verdadero si se ha codificado la textura, falso si el formato es CI4 o CI8
+		 */
+		bool codificar(const u8* rgba, u16 ancho, u16 alto, Formato formato, void* destino);
+
+		/**
+		 * Codifica una imagen lineal de índices de paleta en una textura CI4 o CI8.
+		 * @param indices Índices de la imagen, fila a fila, con un byte por píxel (en CI4, sólo valen de 0 a 15)
+		 * @param ancho Ancho en píxeles de la imagen
+		 * @param alto Alto en píxeles de la imagen
+		 * @param formato Formato de la textura: CI4 o CI8
+		 * @param destino Zona de memoria de tam() bytes donde se escribe la textura
+		 * @return Verdadero si se ha codificado la textura, falso si el formato no es de índices
+		 */
+		bool codificarIndices(const u8* indices, u16 ancho, u16 alto, Formato formato, void* destino);
+
+		/**
+		 * Reorganiza en bloques una imagen lineal cuyos píxeles ya están codificados en un formato de 8 o 16 bits
+		 * (por ejemplo, una imagen RGB5A3 almacenada fila a fila). El origen y el destino no pueden solaparse.
+		 * @param origen Píxeles de la imagen, fila a fila, con el mismo orden de bytes que tendrá la textura
+		 * @param ancho Ancho en píxeles de la imagen
+		 * @param alto Alto en píxeles de la imagen
+		 * @param formato Formato de los píxeles; sólo formatos de 8 o 16 bits
+		 * @param destino Zona de memoria de tam() bytes donde se escribe la textura
+		 * @return Verdadero si se ha reorganizado la textura, falso si el formato no es de 8 o 16 bits
+		 */
+		bool ordenar(const void* origen, u16 ancho, u16 alto, Formato formato, void* destino);
+
+		/**
+		 * Obtiene los índices de paleta de una textura RGB5A3 que tenga, como mucho, 256 colores distintos.
+		 * @param texels Textura RGB5A3 organizada en bloques de 4x4 píxeles
+		 * @param ancho Ancho en píxeles de la textura (múltiplo de 4)
+		 * @param alto Alto en píxeles de la textura (múltiplo de 4)
+		 * @param indices Zona de memoria de ancho * alto bytes donde se escriben los índices, en orden lineal
+		 * @param paleta Zona de memoria de 256 colores donde se escriben los colores RGB5A3, por orden de aparición
+		 * @return Número de colores de la paleta, o cero si la textura tiene más de 256 colores
+		 */
+		u32 indexar(const u16* texels, u16 ancho, u16 alto, u8* indices, u16* paleta);
+
+		/**
+		 * Calcula el número de entradas de la paleta de un formato de índices.
+		 * @param formato Formato de la textura
+		 * @return 16 para CI4, 256 para CI8 y cero para el resto de formatos
+		 */
+		u32 entradasPaleta(Formato formato);
+
+		/**
+		 * Lee la cabecera de una textura cocinada desde memoria y comprueba que sea válida y que el archivo esté
+		 * completo.
+		 * @param datos Dirección de memoria donde comienza el archivo
+		 * @param tam Tamaño en bytes del archivo
+		 * @param c Cabecera donde se guardarán los campos leídos
+		 * @return Verdadero si la cabecera es válida, falso en caso contrario
+		 */
+		bool leerCabecera(const u8* datos, u32 tam, Cabecera& c);
+
+		/**
+		 * Escribe la cabecera de una textura cocinada en memoria.
+		 * @param c Cabecera que se quiere escribir
+		 * @param destino Zona de memoria de, al menos, TAM_CABECERA bytes
+		 */
+		void escribirCabecera(const Cabecera& c, u8* destino);
+
+		/**
+		 * Convierte un color de 8 bits por componente a RGB565.
+		 * @param r Componente rojo
+		 * @param g Componente verde
+		 * @param b Componente azul
+		 * @return Color en formato RGB565
+		 */
+		u16 rgb565(u8 r, u8 g, u8 b);
+
+		/**
+		 * Calcula la intensidad (luminancia) de un color, tal y como se guarda en los formatos I4, I8, IA4 e IA8.
+		 * @param r Componente rojo
+		 * @param g Componente verde
+		 * @param b Componente azul
+		 * @return Intensidad entre 0 y 255
+		 */
+		u8 intensidad(u8 r, u8 g, u8 b);
+	}
+
+#endif
+
@@ -0,0 +1,111 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _TILED_H_
+#define _TILED_H_
+
+	#include <cstdlib>
+	#include <string>
+	#include <gctypes.h>
+	#include <tinyxml.h>
+	#include "excepcion.h"
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones que leen las capas de tiles de un mapa del editor Tiled (archivo TMX).
+	 *
+	 * @details La clase Nivel lee sus capas de tiles con estas funciones. Una capa de Tiled guarda un gid (número
+	 * identificador de 32 bits) por tile, en uno de estos formatos: XML, con un elemento por tile; CSV, con los gids
+	 * separados por comas; o base64, con cuatro bytes en little endian por gid, sin comprimir o comprimidos con zlib.
+	 * Los tres últimos se decodifican directamente sobre los tiles de la capa, sin crear un elemento XML por tile, y
+	 * el base64 se decodifica y se descomprime por trozos, sin copiar el texto completo (ver clase Inflador).
+	 *
+	 * Cada gid se convierte en un Tile de 16 bits: su número dentro del tileset y las marcas INVERTIDO y SOLIDO. De
+	 * los volteos que guarda Tiled en los bits altos del gid, sólo se admite el horizontal; un tile volteado en
+	 * vertical o en diagonal (rotado) no se puede dibujar con Screen, así que la capa que lo contiene no se carga.
+	 * Tampoco se carga una capa cuyos datos no tengan un gid por tile, comprimida con gzip, o con un tile cuyo número
+	 * no quepa en los bits GID.
+	 *
+	 * Como no dependen de ninguna biblioteca de la consola, estas funciones se compilan también para el PC, donde la
+	 * herramienta comprobartmx (ver directorio tools) las utiliza para comprobar que un mismo mapa guardado con los
+	 * distintos formatos de capa da exactamente los mismos tiles.
+	 *
+	 */
+	namespace tiled
+	{
+		/**
+		 * Tile de una capa. Los bits GID guardan el número identificador del tile dentro del tileset generado con
+		 * Tiled (0 si no hay tile), y el resto de bits son las marcas INVERTIDO y SOLIDO. La posición del tile se
+		 * deduce de su posición en la capa, así que no se guarda.
+		 */
+		typedef u16 Tile;
+
+		/**
+		 * Bits del número identificador de un tile. El tileset puede tener, como mucho, 16383 tiles; si una capa
+		 * utiliza un identificador mayor, la capa no se puede cargar.
+		 */
+		static const Tile GID = 0x3FFF;
+
+		/**
+		 * Marca de un tile que se dibuja invertido horizontalmente (en Tiled, volteado horizontalmente).
+		 */
+		static const Tile INVERTIDO = 0x4000;
+
+		/**
+		 * Marca de un tile no atravesable, que tiene un rectángulo de colisión de su mismo tamaño y posición.
+		 */
+		static const Tile SOLIDO = 0x8000;
+
+		/**
+		 * @brief Estructura que almacena una capa de tiles.
+		 * @details Se compone del nombre de la capa en el archivo TMX, de si sus tiles son no atravesables, y de
+		 * un puntero a sus tiles, ordenados por filas (el tile de la columna x y la fila y es tiles[y * ancho + x],
+		 * siendo ancho el número de tiles de ancho del mapa).
+		 */
+		typedef struct capa
+		{
+			std::string nombre;
+			bool solida;
+			Tile* tiles;
+		} Capa;
+
+		/**
+		 * Convierte el gid de Tiled de un tile en un Tile de una capa.
+		 * @param gid Gid del tile, con las marcas de volteo de Tiled en sus bits altos
+		 * @param c Capa a la que pertenece el tile, de la que se toma la marca SOLIDO
+		 * @return Tile correspondiente al gid (0 si no hay tile)
+		 * @throw ArchivoEx Se lanza si el tile está volteado en vertical o en diagonal, o si su número no cabe en los
+		 * bits GID
+		 */
+		Tile tile(u32 gid, const Capa& c) throw (ArchivoEx);
+
+		/**
+		 * Lee una capa de tiles de un archivo TMX: su nombre, si es sólida (la capa llamada 'plataformas', y las que
+		 * tengan la propiedad solida con valor distinto de cero) y sus tiles, en cualquiera de los formatos de Tiled
+		 * salvo la compresión gzip. Si la capa en XML o en CSV tiene menos tiles que los indicados, los que faltan no
+		 * se modifican.
+		 * @param capa Elemento XML (etiqueta layer) de la capa
+		 * @param c Capa donde se guardan el nombre y los tiles; c.tiles debe tener sitio para total tiles
+		 * @param total Número de tiles de la capa (ancho por alto del mapa)
+		 * @throw ArchivoEx Se lanza si la capa utiliza una compresión distinta de zlib, si sus datos en base64 no
+		 * son correctos, o si algún tile no se puede guardar (ver tile())
+		 */
+		void leerCapa(const TiXmlElement* capa, Capa& c, u32 total) throw (ArchivoEx);
+	}
+
+#endif
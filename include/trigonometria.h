@@ -0,0 +1,154 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _TRIGONOMETRIA_H_
+#define _TRIGONOMETRIA_H_
+
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones trigonométricas con tablas precalculadas, para dibujar figuras y mover actores.
+	 *
+	 * @details Las figuras curvas que dibuja la clase Screen (los círculos) necesitan el seno y el coseno de muchos
+	 * ángulos en cada frame, y no hace falta calcularlos con la precisión de sin() y cos(): basta con que el error
+	 * quede muy por debajo de un píxel. Estas funciones calculan el resultado a partir de una tabla de TAM_TABLA
+	 * valores que se rellena una sola vez, al arrancar el programa, y su error no supera ERROR_SENO partes de UNIDAD
+	 * (0,12 píxeles en un círculo de 1000 píxeles de radio). Como en el resto de la biblioteca, los ángulos no se miden
+	 * en grados ni en radianes, sino en unidades de una vuelta completa de VUELTA (16384) partes, y el resultado está
+	 * multiplicado por UNIDAD (16384), así que todo se calcula con enteros.
+	 *
+	 * Lo mismo ocurre con la dirección de un actor que se mueve en línea recta y rebota (la bola del Arkanoid, por
+	 * ejemplo): angulo() calcula la dirección de un vector de velocidad (el equivalente a atan2()), y rebotar()
+	 * calcula la dirección que lleva tras chocar con una superficie. Al medir los ángulos en partes de una vuelta,
+	 * sumarlos o restarlos nunca los saca de la vuelta, y no hace falta corregirlos con bucles ni comparar con pi.
+	 *
+	 * Igual que la clase Contadores, este código no depende de ninguna biblioteca de la consola y se compila tanto
+	 * para la Wii como para el PC, de forma que el Rasterizador de las herramientas dibuja los círculos exactamente
+	 * con los mismos vértices que Screen.
+	 *
+	 * Funcionamiento interno
+	 *
+	 * La tabla guarda, en enteros de 16 bits, el seno de TAM_TABLA ángulos repartidos a lo largo de la vuelta; el seno
+	 * de un ángulo se interpola linealmente entre los de los ángulos de la tabla inmediatamente anterior y siguiente, y
+	 * el coseno es el seno del ángulo un cuarto de vuelta mayor. Los ángulos de la tabla sólo tienen el error del
+	 * redondeo (media unidad), y la interpolación añade menos de una unidad más; la herramienta medirfijo recorre todos
+	 * los ángulos de la vuelta y falla si alguno se equivoca en más de ERROR_SENO unidades. Los ángulos se reducen a
+	 * una vuelta con una máscara de bits, así que los ángulos negativos convertidos a u32 también son válidos. Una
+	 * segunda tabla, de TAM_ARCOTANGENTE + 1 valores, guarda el arcotangente entre 0 y 1; angulo() reduce el vector al
+	 * primer octante, interpola entre los dos valores de la tabla más cercanos y coloca el resultado en su octante, con
+	 * un error muy por debajo de una unidad de ángulo.
+	 *
+	 * Ejemplo de uso
+	 * @code
+	 * // Vértices de un círculo de radio r, con los segmentos que necesita su tamaño
+	 * u32 n = trigonometria::segmentos(r);
+	 * for(u32 i = 0 ; i < n ; ++i)
+	 * {
+	 *     u32 ang = i * (trigonometria::VUELTA / n);
+	 *     s16 vx = x + (r * trigonometria::seno(ang)) / trigonometria::UNIDAD;
+	 *     s16 vy = y - (r * trigonometria::coseno(ang)) / trigonometria::UNIDAD;
+	 * }
+	 *
+	 * // Dirección de una bola que se mueve con velocidad (vx, vy), y rebote contra la pared de la derecha, cuya
+	 * // normal apunta hacia la izquierda
+	 * u32 dir = trigonometria::angulo(vx, vy);
+	 * dir = trigonometria::rebotar(dir, 3 * trigonometria::VUELTA / 4);
+	 * @endcode
+	 *
+	 */
+	namespace trigonometria
+	{
+		/**
+		 * Unidades de ángulo de una vuelta completa.
+		 */
+		static const u32 VUELTA = 16384;
+
+		/**
+		 * Valor que representa al 1 en el resultado del seno y del coseno.
+		 */
+		static const s32 UNIDAD = 16384;
+
+		/**
+		 * Número de ángulos de la tabla; divide a VUELTA.
+		 */
+		static const u32 TAM_TABLA = 1024;
+
+		/**
+		 * Cota del error de seno() y coseno(), en las mismas unidades que su resultado (partes de UNIDAD).
+		 */
+		static const s32 ERROR_SENO = 2;
+
+		/**
+		 * Número de intervalos de la tabla del arcotangente.
+		 */
+		static const u32 TAM_ARCOTANGENTE = 128;
+
+		/**
+		 * Número mínimo y máximo de segmentos con los que se dibuja un círculo.
+		 */
+		static const u32 MIN_SEGMENTOS = 8;
+		static const u32 MAX_SEGMENTOS = 128;
+
+		/**
+		 * Calcula el seno de un ángulo.
+		 * @param ang Ángulo, en unidades de VUELTA partes por vuelta
+		 * @return Seno del ángulo, multiplicado por UNIDAD
+		 */
+		s32 seno(u32 ang);
+
+		/**
+		 * Calcula el coseno de un ángulo.
+		 * @param ang Ángulo, en unidades de VUELTA partes por vuelta
+		 * @return Coseno del ángulo, multiplicado por UNIDAD
+		 */
+		s32 coseno(u32 ang);
+
+		/**
+		 * Calcula la dirección de un vector, con el mismo criterio que seno() y coseno(): el ángulo 0 es el eje Y
+		 * positivo, y el ángulo crece hacia el eje X positivo, de forma que el vector (seno(a), coseno(a)) tiene la
+		 * dirección a. Es el equivalente de atan2(x, y). Sólo importa la proporción entre x e y, así que pueden
+		 * estar en cualquier unidad (píxeles, píxeles multiplicados por UNIDAD, valores de la clase Fijo...).
+		 * @param x Componente horizontal del vector
+		 * @param y Componente vertical del vector
+		 * @return Ángulo del vector, entre 0 y VUELTA - 1; 0 si el vector es nulo
+		 */
+		u32 angulo(s32 x, s32 y);
+
+		/**
+		 * Calcula la dirección de un actor después de rebotar contra una superficie (su reflexión respecto a la
+		 * superficie).
+		 * @param direccion Dirección del actor antes del rebote
+		 * @param normal Dirección perpendicular a la superficie, hacia el lado desde el que llega el actor
+		 * @return Dirección del actor después del rebote, entre 0 y VUELTA - 1
+		 */
+		u32 rebotar(u32 direccion, u32 normal);
+
+		/**
+		 * Calcula cuántos segmentos necesita un círculo para que la distancia entre cada segmento y el arco que
+		 * sustituye no llegue a medio píxel. Es una potencia de 2 entre MIN_SEGMENTOS y MAX_SEGMENTOS, así que los
+		 * ángulos de los vértices caen siempre en ángulos de la tabla.
+		 * @param radio Radio del círculo en píxeles
+		 * @return Número de segmentos
+		 */
+		u32 segmentos(f32 radio);
+	}
+
+#endif
+
@@ -23,6 +23,8 @@
 	#include <ogc/lwp_watchdog.h>
 	#include <string>
 	#include <unistd.h>
+	#include "fnv1a.h"
+	#include "memoria.h"
 
 	/**
 	 * @author Ezequiel Vázquez de la Calle
@@ -59,36 +61,6 @@
 		}
 	}
 
-	/**
-	 * @author Ezequiel Vázquez de la Calle
-	 * @version 0.9.2
-	 * @brief Grupo de funciones para controlar el tiempo en una aplicación.
-	 * 
-	 * @details Con las funciones incluidas en este espacio de nombres, se pueden controlar fácilmente el tiempo
-	 * transcurrido entre dos puntos de la aplicación; aplicado a un videojuego, se puede retardar la ejecución del
-	 * programa el periodo necesario para mantener una tasa de fotogramas por segundo constante.
-	 * 
-	 */
-	namespace tiempo
-	{
-		/**
-		 * Variable para almacenar una medida de tiempo. Definirla a cero antes de entrar en el bucle principal
-		 */
-		static u32 tick;
-
-		/**
-		 * Función que retarda la ejecución del programa el tiempo necesario para mantener los fps constantes
-		 * @param fps Frames por segundo que se quieren mantener constantes
-		 */
-		void inline controlarFps(const u8 fps)
-		{
-			u32 nuevo = (gettick()/(u32)TB_TIMER_CLOCK);
-			if((nuevo - tick) < 1000/fps)
-				usleep((1000/fps - (nuevo - tick)) * 1000);
-			tick = nuevo;
-		}
-	}
-
 	/**
 	 * @author Ezequiel Vázquez de la Calle
 	 * @version 0.9.2
@@ -170,11 +142,11 @@
 		 */
 		std::wstring inline convertir(const std::string& cadena)
 		{
-			wchar_t *utf32 = (wchar_t*)memalign(32, (cadena.length() + 1) * sizeof(wchar_t));
+			wchar_t *utf32 = (wchar_t*)memoria::reservar((cadena.length() + 1) * sizeof(wchar_t), memoria::SISTEMA);
 			u32 length = mbstowcs(utf32, cadena.c_str(), cadena.length() + 1);
 			utf32[length] = L'\0';
 			std::wstring cadena_utf32(utf32);
-			free(utf32);
+			memoria::liberar(utf32);
 			return cadena_utf32;
 		}
 	}
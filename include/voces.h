@@ -0,0 +1,116 @@
+//
+// Licencia GPLv3
+//
+// Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+//
+// libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+// Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+// de la Licencia, o (a su elección) cualquier versión posterior.
+//
+// libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+// la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+// la Licencia Pública General GNU para obtener una información más detallada.
+//
+// Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+// contrario, consulte <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _VOCES_H_
+#define _VOCES_H_
+
+	#include <cstdlib>
+	#include <gctypes.h>
+
+	/**
+	 * @author Ezequiel Vázquez de la Calle
+	 * @version 0.9.2
+	 * @brief Grupo de funciones con la política de reparto de voces de sonido entre los efectos.
+	 *
+	 * @details La clase Mezclador decide con estas funciones qué voz de la libASND ocupa cada efecto que se quiere
+	 * reproducir: fusionar la petición con otra del mismo efecto dentro de la ventana de fusión, reutilizar la voz de
+	 * la instancia más antigua de un efecto que ya tiene sonando su número máximo de instancias, tomar una voz libre,
+	 * robar la voz del efecto de menor prioridad, o descartar la petición (ver clase Mezclador). Las funciones sólo
+	 * trabajan sobre una tabla con el estado de cada voz y no reproducen nada; el Mezclador marca como libres las
+	 * voces que la libASND ya no está reproduciendo, y después inicia el efecto en la voz elegida.
+	 *
+	 * Como no dependen de ninguna biblioteca de la consola, estas funciones se compilan también para el PC, donde la
+	 * herramienta comprobarvoces (ver directorio tools) simula una serie de peticiones y comprueba cada decisión.
+	 *
+	 */
+	namespace voces
+	{
+		/**
+		 * Valor devuelto por elegir() cuando la petición se fusiona con una reproducción anterior del mismo efecto.
+		 */
+		static const s16 FUSIONADA = -1;
+
+		/**
+		 * Valor devuelto por elegir() cuando la petición se descarta.
+		 */
+		static const s16 DESCARTADA = -2;
+
+		/**
+		 * @brief Estructura con las estadísticas de uso de las voces.
+		 * @details Todos los contadores son acumulados desde la última llamada a reiniciar(), salvo el número de
+		 * voces ocupadas, que refleja el estado en la última petición atendida. Las reproducciones las cuenta quien
+		 * inicia el efecto en la voz elegida, ya que la reproducción todavía puede fallar.
+		 */
+		typedef struct estadisticas
+		{
+			u32 peticiones;
+			u32 reproducciones;
+			u32 fusiones;
+			u32 robos;
+			u32 descartes;
+			u8 voces_ocupadas;
+			u8 pico_voces;
+		} Estadisticas;
+
+		/**
+		 * @brief Estructura con el estado de una voz.
+		 * @details El efecto que ocupa la voz sólo se utiliza para compararlo con el de otras peticiones (NULL si la
+		 * voz está libre); la prioridad es la del efecto, y el inicio, el instante en el que comenzó a sonar.
+		 */
+		typedef struct voz
+		{
+			const void* efecto;
+			u8 prioridad;
+			u64 inicio;
+		} Voz;
+
+		/**
+		 * @brief Estructura con una petición de reproducción.
+		 * @details Contiene el efecto que se quiere reproducir, su prioridad, su número máximo de instancias
+		 * simultáneas (0 si no hay límite) y el instante de la petición, en las mismas unidades que el inicio de
+		 * las voces.
+		 */
+		typedef struct peticion
+		{
+			const void* efecto;
+			u8 prioridad;
+			u8 instancias;
+			u64 instante;
+		} Peticion;
+
+		/**
+		 * Pone a cero todas las estadísticas.
+		 * @param e Estadísticas que se reinician
+		 */
+		void reiniciar(Estadisticas& e);
+
+		/**
+		 * Elige la voz que debe ocupar una petición, y actualiza las estadísticas (todas salvo las reproducciones).
+		 * La tabla de voces no se modifica: si se devuelve una voz, quien llama debe detener lo que esté sonando en
+		 * ella y anotar allí el nuevo efecto.
+		 * @param tabla Estado de las voces, con el efecto a NULL en las voces libres
+		 * @param primera Primera voz de la tabla que se puede utilizar
+		 * @param total Número de voces de la tabla
+		 * @param p Petición de reproducción
+		 * @param ventana Duración de la ventana de fusión, en las mismas unidades que los instantes (0 la desactiva)
+		 * @param e Estadísticas que se actualizan
+		 * @return Voz elegida, FUSIONADA o DESCARTADA
+		 */
+		s16 elegir(const Voz* tabla, u8 primera, u8 total, const Peticion& p, u32 ventana, Estadisticas& e);
+	}
+
+#endif
@@ -20,16 +20,19 @@
 #include "nivel.h"
 using namespace std;
 
-Actor::Actor(const std::string& ruta, const Nivel* nivel) throw (ArchivoEx, CodigoEx, TarjetaEx, XmlEx)
+Actor::Actor(const std::string& ruta, const Nivel* nivel) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx, XmlEx)
 : _nivel(nivel)
 {
 	_x = _y = _x_previo = _y_previo = 0;
 	_estado_previo = _estado_actual = "normal";
 	_invertida = false;
+	_mascara = false;
 	try {
 		cargarDatosIniciales(ruta);
-	} catch(const Excepcion& e) {
-		throw e;
+	} catch(...) {
+		// Si el actor no llega a construirse, no se ejecuta su destructor: liberar aquí las imágenes retenidas
+		liberarImagenes();
+		throw;
 	}
 }
 
@@ -39,6 +42,7 @@ Actor::~Actor(void)
 	for(Animaciones::iterator i = _map_animaciones.begin() ; i != _map_animaciones.end() ; ++i)
 		delete i->second;
 	_map_animaciones.clear();
+	liberarImagenes();
 
 	// Eliminar todas las cajas de colisión
 	for(Colisiones::iterator i = _map_colisiones.begin() ; i != _map_colisiones.end() ; ++i)
@@ -47,6 +51,19 @@ Actor::~Actor(void)
 	_map_colisiones.clear();
 }
 
+void* Actor::operator new(size_t tam) throw (std::bad_alloc)
+{
+	void* p = memoria::reservar(tam, memoria::ACTORES);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void Actor::operator delete(void* p) throw ()
+{
+	memoria::liberar(p);
+}
+
 // Métodos consultores
 
 u32 Actor::x(void) const
@@ -178,7 +195,21 @@ bool Actor::colision(const Actor& a)
 	for(CajasColision::iterator i = externo.begin() ; i != externo.end() ; ++i)
 		for(CajasColision::iterator j = interno.begin() ; j != interno.end() ; ++j)
 			if((*i)->hayColision(*j, a.x() + a.velX(), a.y() + a.velY(), _x + _vx, _y + _vy))
-				return true;
+			{
+				// Las máscaras sólo se comprueban cuando las figuras ya se tocan
+				if(not _mascara and not a._mascara)
+					return true;
+
+				// Si los dos actores tienen máscara, el resultado no depende de qué figuras se toquen
+				if(_mascara and a._mascara)
+					return animacionActual().imagen().mascara().solapa(cuadroMascara(),
+								a.animacionActual().imagen().mascara(), a.cuadroMascara());
+
+				// Si sólo uno la tiene, se comprueba con el rectángulo que contiene a la figura del otro
+				if(_mascara ? contieneFigura(**i, a.x() + a.velX(), a.y() + a.velY())
+							: a.contieneFigura(**j, _x + _vx, _y + _vy))
+					return true;
+			}
 
 	return false;
 }
@@ -201,7 +232,7 @@ void Actor::dibujar(s16 x, s16 y, s16 z)
 
 // Métodos protegidos
 
-void Actor::cargarDatosIniciales(const string& ruta) throw (ArchivoEx, TarjetaEx, CodigoEx, XmlEx)
+void Actor::cargarDatosIniciales(const string& ruta) throw (ArchivoEx, TarjetaEx, CodigoEx, ImagenEx, XmlEx)
 {
 	// Comprobar que la SD está montada
 	if(not sdcard->montada())
@@ -223,14 +254,10 @@ void Actor::cargarDatosIniciales(const string& ruta) throw (ArchivoEx, TarjetaEx
 
 	// Cargar las animaciones y las colisiones
 	leerColisiones(parser->buscar("colisiones"));
-	try {
-		leerAnimaciones(parser->buscar("animaciones"));
-	} catch(const Excepcion& e) {
-		throw e;
-	}
+	leerAnimaciones(parser->buscar("animaciones"));
 }
 
-void Actor::leerAnimaciones(TiXmlElement* nodo) throw (CodigoEx, XmlEx)
+void Actor::leerAnimaciones(TiXmlElement* nodo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx, XmlEx)
 {
 	// Recorrer los nodos animacion
 	for(TiXmlElement* hijo = nodo->FirstChildElement() ; hijo ; hijo = hijo->NextSiblingElement())
@@ -242,6 +269,7 @@ void Actor::leerAnimaciones(TiXmlElement* nodo) throw (CodigoEx, XmlEx)
 		u32 filas = parser->atributoU32("filas", hijo);
 		u32 columnas = parser->atributoU32("columnas", hijo);
 		u32 retardo = parser->atributoU32("retardo", hijo);
+		string paleta = parser->atributo("paleta", hijo);
 
 		if(estado == "" or codigo_imagen == "" or secuencia == "" or filas == 0 or columnas == 0)
 			throw XmlEx("Actor::leerAnimaciones - Error al leer un atributo");
@@ -250,14 +278,35 @@ void Actor::leerAnimaciones(TiXmlElement* nodo) throw (CodigoEx, XmlEx)
 		if(_map_animaciones.find(estado) != _map_animaciones.end())
 			throw CodigoEx("Actor::leerAnimaciones - Ya existe una animación para el estado '" + estado + "'");
 
+		// La animación guarda un puntero a la imagen, así que ésta debe quedar retenida en la galería
+		galeria->retener(Galeria::IMAGEN, codigo_imagen);
+		_imagenes.push_back(codigo_imagen);
+
 		// Crear la animacion y guardarla en el correspondiente estado
-		Animacion* a = new Animacion(galeria->imagen(codigo_imagen), secuencia, filas, columnas, retardo);
+		// Si se indican cambios de color, la animación utiliza una variante de la paleta de la imagen indexada
+		const Imagen& imagen = galeria->imagen(codigo_imagen);
+		Animacion* a = new Animacion(imagen, secuencia, filas, columnas, retardo, imagen.variante(paleta));
 		_map_animaciones.insert(make_pair(estado, a));
+
+		// La máscara de colisión se crea al cargar, y no en la primera colisión de la partida; se pide a la galería
+		// para que su memoria cuente en el presupuesto
+		if(_mascara)
+			galeria->mascara(codigo_imagen);
 	}
 }
 
+void Actor::liberarImagenes(void)
+{
+	for(vector<string>::iterator i = _imagenes.begin() ; i != _imagenes.end() ; ++i)
+		galeria->liberar(Galeria::IMAGEN, *i);
+	_imagenes.clear();
+}
+
 void Actor::leerColisiones(TiXmlElement* nodo)
 {
+	// Las colisiones se comprueban con las máscaras de las imágenes si así se indica
+	_mascara = (parser->atributoU32("mascara", nodo) != 0);
+
 	// Recorrer los nodos de colision
 	for(TiXmlElement* hijo = nodo->FirstChildElement() ; hijo ; hijo = hijo->NextSiblingElement())
 	{
@@ -285,3 +334,29 @@ void Actor::leerColisiones(TiXmlElement* nodo)
 	}
 }
 
+const Animacion& Actor::animacionActual(void) const
+{
+	Animaciones::const_iterator i = _map_animaciones.find(_estado_actual);
+
+	// Si no se ha encontrado una animación para el estado actual, se toma el estado normal
+	if(i == _map_animaciones.end())
+		return *_map_animaciones.find("normal")->second;
+	else
+		return *i->second;
+}
+
+Mascara::Cuadro Actor::cuadroMascara(void) const
+{
+	// El cuadro se coloca en la posición del actor tras el siguiente movimiento, igual que sus figuras
+	const Animacion& a = animacionActual();
+	Mascara::Cuadro c = { a.cuadroX(), a.cuadroY(), a.ancho(), a.alto(), _invertida,
+						  (s32)_x + _vx, (s32)_y + _vy };
+	return c;
+}
+
+bool Actor::contieneFigura(const Figura& f, s32 x, s32 y) const
+{
+	s32 x0, y0, x1, y1;
+	f.caja(x0, y0, x1, y1);
+	return animacionActual().imagen().mascara().contiene(cuadroMascara(), x0 + x, y0 + y, x1 + x, y1 + y);
+}
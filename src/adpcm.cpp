@@ -0,0 +1,220 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "adpcm.h"
+
+namespace
+{
+	// Tabla de tamaños de paso del estándar IMA ADPCM
+	const u16 PASOS[89] = {
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+		107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+		876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+		4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+		22385, 24623, 27086, 29794, 32767 };
+
+	// Variación del índice de paso según el valor (sin signo) de cada muestra codificada
+	const s8 INDICES[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+	// Cabecera: magia (4), versión (1), canales (1), muestras por bloque (2), frecuencia (4), muestras (4), bloques (4)
+	const u8 MAGIA[4] = { 'W', 'A', 'D', 'P' };
+
+	u16 leer16(const u8* p)
+	{
+		return (u16)((p[0] << 8) | p[1]);
+	}
+
+	u32 leer32(const u8* p)
+	{
+		return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+	}
+
+	void escribir16(u8* p, u16 v)
+	{
+		p[0] = (u8)(v >> 8);
+		p[1] = (u8)v;
+	}
+
+	void escribir32(u8* p, u32 v)
+	{
+		p[0] = (u8)(v >> 24);
+		p[1] = (u8)(v >> 16);
+		p[2] = (u8)(v >> 8);
+		p[3] = (u8)v;
+	}
+
+	// Aplicar una muestra codificada al estado de un canal, devolviendo la nueva predicción
+	s16 aplicar(adpcm::Estado& e, u8 codigo)
+	{
+		s32 paso = PASOS[e.indice];
+		s32 diferencia = paso >> 3;
+		if(codigo & 4)
+			diferencia += paso;
+		if(codigo & 2)
+			diferencia += paso >> 1;
+		if(codigo & 1)
+			diferencia += paso >> 2;
+
+		s32 prediccion = e.prediccion + ((codigo & 8) ? -diferencia : diferencia);
+		if(prediccion > 32767)
+			prediccion = 32767;
+		else if(prediccion < -32768)
+			prediccion = -32768;
+
+		s32 indice = e.indice + INDICES[codigo & 7];
+		if(indice < 0)
+			indice = 0;
+		else if(indice > 88)
+			indice = 88;
+
+		e.prediccion = (s16)prediccion;
+		e.indice = (u8)indice;
+		return e.prediccion;
+	}
+
+	// Codificar una muestra, actualizando el estado exactamente igual que lo hará el decodificador
+	u8 codificar(adpcm::Estado& e, s16 muestra)
+	{
+		s32 paso = PASOS[e.indice];
+		s32 diferencia = muestra - e.prediccion;
+		u8 codigo = 0;
+
+		if(diferencia < 0)
+		{
+			codigo = 8;
+			diferencia = -diferencia;
+		}
+		if(diferencia >= paso)
+		{
+			codigo |= 4;
+			diferencia -= paso;
+		}
+		paso >>= 1;
+		if(diferencia >= paso)
+		{
+			codigo |= 2;
+			diferencia -= paso;
+		}
+		paso >>= 1;
+		if(diferencia >= paso)
+			codigo |= 1;
+
+		aplicar(e, codigo);
+		return codigo;
+	}
+}
+
+bool adpcm::leerCabecera(const u8* datos, u32 tam, Cabecera& c)
+{
+	if(datos == NULL or tam < TAM_CABECERA or memcmp(datos, MAGIA, 4) != 0)
+		return false;
+
+	c.version = datos[4];
+	c.canales = datos[5];
+	c.muestras_bloque = leer16(datos + 6);
+	c.frecuencia = leer32(datos + 8);
+	c.muestras = leer32(datos + 12);
+	c.bloques = leer32(datos + 16);
+
+	if(c.version != 1 or (c.canales != 1 and c.canales != 2))
+		return false;
+	if(c.muestras_bloque == 0 or c.muestras_bloque > MAX_MUESTRAS_BLOQUE or c.muestras_bloque % 2 != 0)
+		return false;
+
+	// Las muestras deben ocupar exactamente los bloques anunciados: el último puede estar incompleto, pero no vacío.
+	// Si hubiera menos bloques, la cuenta de muestras restantes del Mezclador se saldría del rango de u32
+	u32 completos = c.muestras / c.muestras_bloque;
+	if(c.bloques != completos + (c.muestras % c.muestras_bloque != 0 ? 1 : 0))
+		return false;
+
+	// El archivo debe contener todos los bloques que anuncia la cabecera; se divide en lugar de multiplicar para
+	// que un número de bloques enorme no desborde el producto (tam >= TAM_CABECERA, y el bloque no está vacío)
+	return (c.bloques <= (tam - TAM_CABECERA) / tamBloque(c.canales, c.muestras_bloque));
+}
+
+void adpcm::escribirCabecera(const Cabecera& c, u8* destino)
+{
+	memset(destino, 0, TAM_CABECERA);
+	memcpy(destino, MAGIA, 4);
+	destino[4] = c.version;
+	destino[5] = c.canales;
+	escribir16(destino + 6, c.muestras_bloque);
+	escribir32(destino + 8, c.frecuencia);
+	escribir32(destino + 12, c.muestras);
+	escribir32(destino + 16, c.bloques);
+}
+
+u32 adpcm::tamBloque(u8 canales, u16 muestras_bloque)
+{
+	// Estado inicial de cada canal (4 bytes) y 4 bits por muestra
+	return 4 * canales + (muestras_bloque * canales) / 2;
+}
+
+void adpcm::codificarBloque(const s16* entrada, u8 canales, u16 muestras, Estado* estados, u8* bloque)
+{
+	// Estado inicial de cada canal
+	for(u8 c = 0 ; c < canales ; ++c)
+	{
+		escribir16(bloque, (u16)estados[c].prediccion);
+		bloque[2] = estados[c].indice;
+		bloque[3] = 0;
+		bloque += 4;
+	}
+
+	if(canales == 2)
+	{
+		// Una muestra de cada canal por byte, el izquierdo en los 4 bits de mayor peso
+		for(u16 i = 0 ; i < muestras ; ++i, entrada += 2)
+			*bloque++ = (codificar(estados[0], entrada[0]) << 4) | codificar(estados[1], entrada[1]);
+	}
+	else
+	{
+		// Dos muestras consecutivas por byte, la primera en los 4 bits de mayor peso
+		for(u16 i = 0 ; i < muestras ; i += 2, entrada += 2)
+			*bloque++ = (codificar(estados[0], entrada[0]) << 4) | codificar(estados[0], entrada[1]);
+	}
+}
+
+void adpcm::decodificarBloque(const u8* bloque, u8 canales, u16 muestras, s16* salida)
+{
+	Estado estados[2];
+	for(u8 c = 0 ; c < canales ; ++c)
+	{
+		estados[c].prediccion = (s16)leer16(bloque);
+		estados[c].indice = (bloque[2] > 88) ? 88 : bloque[2];
+		bloque += 4;
+	}
+
+	if(canales == 2)
+	{
+		for(u16 i = 0 ; i < muestras ; ++i, ++bloque)
+		{
+			*salida++ = aplicar(estados[0], *bloque >> 4);
+			*salida++ = aplicar(estados[1], *bloque & 0x0F);
+		}
+	}
+	else
+	{
+		for(u16 i = 0 ; i < muestras ; i += 2, ++bloque)
+		{
+			*salida++ = aplicar(estados[0], *bloque >> 4);
+			*salida++ = aplicar(estados[0], *bloque & 0x0F);
+		}
+	}
+}
+
@@ -19,8 +19,8 @@
 #include "animacion.h"
 using namespace std;
 
-Animacion::Animacion(const Imagen& i, const string& secuencia, u8 filas, u8 columnas, u8 retardo)
-: _imagen(&i), _filas(filas), _columnas(columnas), _paso(0), _retardo(retardo), _cont_retardo(0)
+Animacion::Animacion(const Imagen& i, const string& secuencia, u8 filas, u8 columnas, u8 retardo, u8 paleta)
+: _imagen(&i), _filas(filas), _columnas(columnas), _paso(0), _retardo(retardo), _cont_retardo(0), _paleta(paleta)
 {
 	_ancho_cuadro = _imagen->ancho() / _columnas;
 	_alto_cuadro = _imagen->alto() / _filas;
@@ -67,6 +67,16 @@ const Imagen& Animacion::imagen(void) const
 	return *(_imagen);
 }
 
+u16 Animacion::cuadroX(void) const
+{
+	return (_cuadros[_paso] % _columnas) * _ancho_cuadro;
+}
+
+u16 Animacion::cuadroY(void) const
+{
+	return (_cuadros[_paso] / _columnas) * _alto_cuadro;
+}
+
 void Animacion::avanzar(void)
 {
 	// Si ha pasado el número de frames '_retardo' desde el último cambio, se avanza un cuadro
@@ -89,13 +99,8 @@ void Animacion::reiniciar(void)
 
 void Animacion::dibujar(s16 x, s16 y, s16 z, bool invertir)
 {
-	// Punto superior izquierdo del cuadro en la rejilla
-	s16 origen_x = ((_cuadros[_paso] % _columnas) * (_ancho_cuadro));
-	s16 origen_y = ((_cuadros[_paso] / _columnas) * (_alto_cuadro));
-
-	// Dibujar el cuadro de la textura en las coordenadas que se reciben
-	screen->dibujarCuadro(_imagen->textura(), _imagen->ancho(), _imagen->alto(), x, y, z,
-							origen_x, origen_y, _ancho_cuadro, _alto_cuadro, invertir);
+	// Dibujar el cuadro de la imagen (que puede ser un recorte de un atlas) en las coordenadas que se reciben
+	_imagen->dibujarCuadro(x, y, z, cuadroX(), cuadroY(), _ancho_cuadro, _alto_cuadro, invertir, _paleta);
 
 	// Avanzar al siguiente cuadro de la animación
 	avanzar();
@@ -0,0 +1,163 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "atlas.h"
+using namespace std;
+
+namespace
+{
+	bool contenido(const Atlas::Rectangulo& a, const Atlas::Rectangulo& b)
+	{
+		return (a.x >= b.x and a.y >= b.y and a.x + a.ancho <= b.x + b.ancho and a.y + a.alto <= b.y + b.alto);
+	}
+
+	bool solapados(const Atlas::Rectangulo& a, const Atlas::Rectangulo& b)
+	{
+		return (a.x < b.x + b.ancho and b.x < a.x + a.ancho and a.y < b.y + b.alto and b.y < a.y + a.alto);
+	}
+
+	Atlas::Rectangulo nuevoRectangulo(u32 x, u32 y, u32 ancho, u32 alto)
+	{
+		Atlas::Rectangulo r;
+		r.x = x;
+		r.y = y;
+		r.ancho = ancho;
+		r.alto = alto;
+		return r;
+	}
+}
+
+Atlas::Atlas(u16 ancho, u16 alto, u16 margen): _ancho(ancho), _alto(alto), _margen(margen)
+{
+	vaciar();
+}
+
+bool Atlas::colocar(u16 ancho, u16 alto, Rectangulo& r)
+{
+	if(ancho == 0 or alto == 0)
+		return false;
+
+	// El margen se reserva junto al rectángulo, salvo donde éste toca el borde de la página
+	u32 ancho_margen = ancho + _margen;
+	u32 alto_margen = alto + _margen;
+
+	s32 elegido = -1;
+	u32 mejor_corto = 0, mejor_largo = 0;
+	for(u32 i = 0 ; i < _libres.size() ; ++i)
+	{
+		const Rectangulo& l = _libres[i];
+		u32 w = (l.x + ancho_margen > _ancho) ? ancho : ancho_margen;
+		u32 h = (l.y + alto_margen > _alto) ? alto : alto_margen;
+		if(w > l.ancho or h > l.alto)
+			continue;
+
+		u32 sobra_x = l.ancho - w;
+		u32 sobra_y = l.alto - h;
+		u32 corto = (sobra_x < sobra_y) ? sobra_x : sobra_y;
+		u32 largo = (sobra_x < sobra_y) ? sobra_y : sobra_x;
+		if(elegido < 0 or corto < mejor_corto or (corto == mejor_corto and largo < mejor_largo))
+		{
+			elegido = i;
+			mejor_corto = corto;
+			mejor_largo = largo;
+		}
+	}
+
+	if(elegido < 0)
+		return false;
+
+	const Rectangulo& l = _libres[elegido];
+	r = nuevoRectangulo(l.x, l.y, ancho, alto);
+	u32 w = (l.x + ancho_margen > _ancho) ? ancho : ancho_margen;
+	u32 h = (l.y + alto_margen > _alto) ? alto : alto_margen;
+	ocupar(nuevoRectangulo(r.x, r.y, w, h));
+	_ocupados += ancho * alto;
+	return true;
+}
+
+void Atlas::vaciar(void)
+{
+	_libres.clear();
+	_libres.push_back(nuevoRectangulo(0, 0, _ancho, _alto));
+	_ocupados = 0;
+}
+
+u32 Atlas::ocupados(void) const
+{
+	return _ocupados;
+}
+
+u16 Atlas::ancho(void) const
+{
+	return _ancho;
+}
+
+u16 Atlas::alto(void) const
+{
+	return _alto;
+}
+
+// Métodos privados
+void Atlas::ocupar(const Rectangulo& o)
+{
+	vector<Rectangulo> nuevos;
+	for(vector<Rectangulo>::iterator i = _libres.begin() ; i != _libres.end() ; )
+	{
+		if(not solapados(*i, o))
+		{
+			++i;
+			continue;
+		}
+
+		// Las partes del rectángulo libre que quedan fuera del ocupado siguen libres
+		Rectangulo l = *i;
+		if(o.x > l.x)
+			nuevos.push_back(nuevoRectangulo(l.x, l.y, o.x - l.x, l.alto));
+		if(o.x + o.ancho < l.x + l.ancho)
+			nuevos.push_back(nuevoRectangulo(o.x + o.ancho, l.y, l.x + l.ancho - o.x - o.ancho, l.alto));
+		if(o.y > l.y)
+			nuevos.push_back(nuevoRectangulo(l.x, l.y, l.ancho, o.y - l.y));
+		if(o.y + o.alto < l.y + l.alto)
+			nuevos.push_back(nuevoRectangulo(l.x, o.y + o.alto, l.ancho, l.y + l.alto - o.y - o.alto));
+
+		i = _libres.erase(i);
+	}
+
+	_libres.insert(_libres.end(), nuevos.begin(), nuevos.end());
+	podar();
+}
+
+void Atlas::podar(void)
+{
+	for(u32 i = 0 ; i < _libres.size() ; ++i)
+	{
+		for(u32 j = i + 1 ; j < _libres.size() ; )
+		{
+			if(contenido(_libres[j], _libres[i]))
+				_libres.erase(_libres.begin() + j);
+			else if(contenido(_libres[i], _libres[j]))
+			{
+				_libres.erase(_libres.begin() + i);
+				--i;
+				break;
+			}
+			else
+				++j;
+		}
+	}
+}
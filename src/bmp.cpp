@@ -0,0 +1,231 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "bmp.h"
+
+namespace
+{
+	// Tamaños de las cabeceras de archivo y de imagen (la más pequeña admitida, BITMAPINFOHEADER)
+	const u32 TAM_CABECERA_ARCHIVO = 14;
+	const u32 TAM_CABECERA_IMAGEN = 40;
+
+	// Tipos de compresión: sin comprimir, y sin comprimir con máscaras de bits
+	const u32 BI_RGB = 0;
+	const u32 BI_BITFIELDS = 3;
+
+	u16 leer16(const u8* p)
+	{
+		return (u16)p[0] | ((u16)p[1] << 8);
+	}
+
+	u32 leer32(const u8* p)
+	{
+		return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+	}
+
+	// Color BGR de 24 bits de un píxel, en la forma 0xRRGGBB
+	u32 bgr(const u8* p)
+	{
+		return ((u32)p[2] << 16) | ((u32)p[1] << 8) | (u32)p[0];
+	}
+
+	u16 opaco(u32 c)
+	{
+		return 0x8000 | ((c >> 9) & 0x7C00) | ((c >> 6) & 0x03E0) | ((c >> 3) & 0x001F);
+	}
+
+	// Los núcleos convierten una fila completa, en grupos de 4 píxeles; cada grupo ocupa una fila de un tile, y el
+	// grupo siguiente está 16 píxeles (un tile completo) más adelante en el destino
+	void fila8(const u8* p, u32 ancho, const u16* tabla, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, p += 4, d += 16)
+		{
+			d[0] = tabla[p[0]];
+			d[1] = tabla[p[1]];
+			d[2] = tabla[p[2]];
+			d[3] = tabla[p[3]];
+		}
+	}
+
+	void fila24(const u8* p, u32 ancho, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, p += 12, d += 16)
+		{
+			u32 c0 = bgr(p);
+			u32 c1 = bgr(p + 3);
+			u32 c2 = bgr(p + 6);
+			u32 c3 = bgr(p + 9);
+			d[0] = (c0 == clave) ? transparente : opaco(c0);
+			d[1] = (c1 == clave) ? transparente : opaco(c1);
+			d[2] = (c2 == clave) ? transparente : opaco(c2);
+			d[3] = (c3 == clave) ? transparente : opaco(c3);
+		}
+	}
+
+	void fila32(const u8* p, u32 ancho, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, p += 16, d += 16)
+		{
+			u32 c0 = bgr(p);
+			u32 c1 = bgr(p + 4);
+			u32 c2 = bgr(p + 8);
+			u32 c3 = bgr(p + 12);
+			d[0] = (c0 == clave) ? transparente : opaco(c0);
+			d[1] = (c1 == clave) ? transparente : opaco(c1);
+			d[2] = (c2 == clave) ? transparente : opaco(c2);
+			d[3] = (c3 == clave) ? transparente : opaco(c3);
+		}
+	}
+
+	void fila32Alpha(const u8* p, u32 ancho, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, p += 4)
+				d[i] = (bgr(p) == clave) ? transparente : bmp::rgb5a3(p[2], p[1], p[0], p[3]);
+		}
+	}
+}
+
+bool bmp::leerCabecera(const u8* datos, u32 tam, Info& info)
+{
+	if(datos == NULL or tam < TAM_CABECERA_ARCHIVO + TAM_CABECERA_IMAGEN or datos[0] != 'B' or datos[1] != 'M')
+		return false;
+
+	u32 tam_imagen = leer32(datos + 14);
+	s32 ancho = (s32)leer32(datos + 18);
+	s32 alto = (s32)leer32(datos + 22);
+	u32 compresion = leer32(datos + 30);
+	u32 colores = leer32(datos + 46);
+
+	if(tam_imagen < TAM_CABECERA_IMAGEN or TAM_CABECERA_ARCHIVO + tam_imagen > tam)
+		return false;
+
+	// Un alto negativo indica que las filas están almacenadas de arriba a abajo
+	info.invertida = (alto > 0);
+	if(alto < 0)
+		alto = -alto;
+	if(ancho <= 0 or alto <= 0 or ancho > 0xFFFF or alto > 0xFFFF or ancho % 4 != 0 or alto % 4 != 0)
+		return false;
+
+	info.ancho = (u16)ancho;
+	info.alto = (u16)alto;
+	info.bpp = leer16(datos + 28);
+	info.alpha = false;
+	info.inicio = leer32(datos + 10);
+	info.colores = 0;
+	info.paleta = 0;
+
+	switch(info.bpp)
+	{
+		case 8:
+			if(compresion != BI_RGB or colores > 256)
+				return false;
+			info.colores = (colores == 0) ? 256 : colores;
+			info.paleta = TAM_CABECERA_ARCHIVO + tam_imagen;
+			if(info.paleta + info.colores * 4 > tam)
+				return false;
+			break;
+		case 24:
+			if(compresion != BI_RGB)
+				return false;
+			break;
+		case 32:
+			if(compresion == BI_BITFIELDS)
+			{
+				// Las máscaras siguen a la cabecera de 40 bytes (o forman parte de una cabecera mayor); sólo se admite
+				// la disposición BGRA, y la máscara de alpha sólo existe en las cabeceras de 56 bytes o más
+				u32 mascaras = TAM_CABECERA_ARCHIVO + TAM_CABECERA_IMAGEN;
+				if(mascaras + 12 > tam or leer32(datos + mascaras) != 0x00FF0000
+					or leer32(datos + mascaras + 4) != 0x0000FF00 or leer32(datos + mascaras + 8) != 0x000000FF)
+					return false;
+				if(tam_imagen >= 56)
+				{
+					u32 mascara_alpha = leer32(datos + mascaras + 12);
+					if(mascara_alpha != 0 and mascara_alpha != 0xFF000000)
+						return false;
+					info.alpha = (mascara_alpha != 0);
+				}
+			}
+			else if(compresion != BI_RGB)
+				return false;
+			break;
+		default:
+			return false;
+	}
+
+	// Cada fila ocupa un múltiplo de 4 bytes, y el archivo debe contener todas las filas
+	info.paso = ((info.ancho * info.bpp + 31) / 32) * 4;
+	return (info.inicio <= tam and (tam - info.inicio) / info.paso >= info.alto);
+}
+
+u32 bmp::tamTextura(const Info& info)
+{
+	return (u32)info.ancho * info.alto * sizeof(u16);
+}
+
+void bmp::decodificar(const u8* datos, const Info& info, u32 transparente, u16* destino)
+{
+	// El color transparente, en la forma 0xRRGGBB, y su codificación en RGB5A3 con alpha a cero
+	u32 clave = transparente >> 8;
+	u16 invisible = rgb5a3((u8)(clave >> 16), (u8)(clave >> 8), (u8)clave, 0);
+
+	// Con paleta, cada color se convierte una sola vez
+	u16 tabla[256];
+	if(info.bpp == 8)
+	{
+		const u8* paleta = datos + info.paleta;
+		for(u32 i = 0 ; i < 256 ; ++i)
+		{
+			u32 c = (i < info.colores) ? bgr(paleta + i * 4) : 0;
+			tabla[i] = (c == clave) ? invisible : opaco(c);
+		}
+	}
+
+	for(u32 y = 0 ; y < info.alto ; ++y)
+	{
+		const u8* p = datos + info.inicio + (info.invertida ? info.alto - 1 - y : y) * info.paso;
+
+		// Primer grupo de la fila: la fila de tiles, y dentro de cada tile, la fila de píxeles
+		u16* d = destino + (y >> 2) * info.ancho * 4 + (y & 3) * 4;
+
+		switch(info.bpp)
+		{
+			case 8:
+				fila8(p, info.ancho, tabla, d);
+				break;
+			case 24:
+				fila24(p, info.ancho, clave, invisible, d);
+				break;
+			case 32:
+				if(info.alpha)
+					fila32Alpha(p, info.ancho, clave, invisible, d);
+				else
+					fila32(p, info.ancho, clave, invisible, d);
+				break;
+		}
+	}
+}
+
+u16 bmp::rgb5a3(u8 r, u8 g, u8 b, u8 a)
+{
+	// Opaco: 1 bit a uno y 5 bits por componente; si no, 1 bit a cero, 3 bits de alpha y 4 bits por componente
+	if(a >= 0xE0)
+		return 0x8000 | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+	return ((a >> 5) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+}
@@ -0,0 +1,438 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cargador.h"
+#include "perfilador.h"
+using namespace std;
+
+Cargador* Cargador::_instance = 0;
+
+// Métodos del Futuro
+bool Cargador::Futuro::listo(void) const
+{
+	return cargador->_trabajos.find(_id) == cargador->_trabajos.end();
+}
+
+bool Cargador::Futuro::fallido(void) const
+{
+	return cargador->_errores.find(_id) != cargador->_errores.end();
+}
+
+string Cargador::Futuro::error(void) const
+{
+	map<u32, string>::const_iterator i = cargador->_errores.find(_id);
+	if(i == cargador->_errores.end())
+		return string();
+	return i->second;
+}
+
+void Cargador::Futuro::esperar(void) const
+{
+	cargador->esperar(_id);
+}
+
+// Métodos públicos
+Cargador::Futuro Cargador::recurso(Galeria::Tipo tipo, const string& pedido) throw (CodigoEx)
+{
+	// Una imagen de un atlas no tiene archivo propio: se carga su página, y el recorte se crea al utilizarlo
+	string codigo = galeria->archivo(tipo, pedido);
+
+	// Si el recurso ya se ha pedido, se devuelve la petición existente
+	for(Trabajos::iterator i = _trabajos.begin() ; i != _trabajos.end() ; ++i)
+		if(not i->second->nivel and i->second->tipo == tipo and i->second->codigo == codigo)
+			return Futuro(i->first);
+
+	// Si el recurso ya está cargado, no hay nada que hacer y el Futuro nace terminado
+	Galeria::Entrada e;
+	if(not galeria->pedir(tipo, codigo, e))
+		return Futuro(++_ultimo);
+
+	Trabajo* t = new Trabajo;
+	t->nivel = false;
+	t->tipo = tipo;
+	t->codigo = codigo;
+	t->ruta = e.ruta;
+	t->volumen = e.volumen;
+	t->prioridad = e.prioridad;
+	t->instancias = e.instancias;
+	return encolar(t);
+}
+
+Cargador::Futuro Cargador::nivel(const string& ruta)
+{
+	for(Trabajos::iterator i = _trabajos.begin() ; i != _trabajos.end() ; ++i)
+		if(i->second->nivel and i->second->ruta == ruta)
+			return Futuro(i->first);
+
+	Trabajo* t = new Trabajo;
+	t->nivel = true;
+	t->tipo = Galeria::IMAGEN;
+	t->codigo = ruta;
+	t->ruta = ruta;
+	t->volumen = t->prioridad = t->instancias = 0;
+	return encolar(t);
+}
+
+bool Cargador::entregarManifiesto(const string& ruta, Manifiesto& m)
+{
+	for(Trabajos::iterator i = _trabajos.begin() ; i != _trabajos.end() ; ++i)
+		if(i->second->nivel and i->second->ruta == ruta)
+		{
+			esperar(i->first);
+			break;
+		}
+
+	Manifiestos::iterator i = _manifiestos.find(ruta);
+	if(i == _manifiestos.end())
+		return false;
+
+	m = *(i->second);
+	delete i->second;
+	_manifiestos.erase(i);
+	return true;
+}
+
+void Cargador::actualizar(void)
+{
+	if(_trabajos.empty())
+		return;
+
+	// Recoger de una vez todas las peticiones terminadas, para retener el mutex el menor tiempo posible
+	vector<Trabajo*> terminados;
+	LWP_MutexLock(_mutex);
+	terminados.swap(_terminados);
+	LWP_MutexUnlock(_mutex);
+
+	for(vector<Trabajo*>::iterator i = terminados.begin() ; i != terminados.end() ; ++i)
+		completar(*i);
+}
+
+void Cargador::esperar(void)
+{
+	while(not _trabajos.empty())
+	{
+		dormir();
+		actualizar();
+	}
+}
+
+bool Cargador::terminado(void) const
+{
+	return _trabajos.empty();
+}
+
+f32 Cargador::progreso(void) const
+{
+	if(_pedidos == 0)
+		return 1.0;
+	return (f32)_completados / _pedidos;
+}
+
+u32 Cargador::pendientes(void) const
+{
+	return _trabajos.size();
+}
+
+// Métodos protegidos
+Cargador::Cargador(void): _ultimo(0), _pedidos(0), _completados(0), _sincrono(false), _salir(false)
+{
+	_hilo = LWP_THREAD_NULL;
+	LWP_MutexInit(&_mutex, false);
+	LWP_CondInit(&_hay_trabajo);
+	LWP_CondInit(&_hay_terminados);
+}
+
+Cargador::~Cargador(void)
+{
+	// Pedir al hilo de carga que termine, y esperar a que lo haga; la petición en curso se termina igualmente
+	if(_hilo != LWP_THREAD_NULL)
+	{
+		LWP_MutexLock(_mutex);
+		_salir = true;
+		LWP_CondSignal(_hay_trabajo);
+		LWP_MutexUnlock(_mutex);
+		LWP_JoinThread(_hilo, NULL);
+	}
+
+	// Lo que no se haya entregado a la galería o al parser se libera aquí, sin tocar a ninguno de los dos
+	for(Trabajos::iterator i = _trabajos.begin() ; i != _trabajos.end() ; ++i)
+	{
+		descartar(i->second);
+		delete i->second;
+	}
+	_trabajos.clear();
+
+	// Los manifiestos no entregados tampoco deshacen sus reservas, ya que la galería puede no existir
+	for(Manifiestos::iterator i = _manifiestos.begin() ; i != _manifiestos.end() ; ++i)
+		delete i->second;
+	_manifiestos.clear();
+
+	LWP_CondDestroy(_hay_terminados);
+	LWP_CondDestroy(_hay_trabajo);
+	LWP_MutexDestroy(_mutex);
+}
+
+// Métodos privados
+Cargador::Futuro Cargador::encolar(Trabajo* t)
+{
+	// Si el Cargador había quedado sin trabajo, el progreso empieza de nuevo
+	if(_completados == _pedidos)
+		_pedidos = _completados = 0;
+	_pedidos++;
+
+	t->id = ++_ultimo;
+	t->estado = ESPERA;
+	t->recurso = NULL;
+	t->datos = NULL;
+	t->tam = 0;
+	t->doc = NULL;
+	t->manifiesto = NULL;
+	_trabajos[t->id] = t;
+
+	iniciar();
+
+	if(_sincrono)
+	{
+		// Sin hilo de carga, la petición se atiende ahora y se completa en la siguiente actualización
+		ejecutar(t);
+		_terminados.push_back(t);
+	}
+	else
+	{
+		LWP_MutexLock(_mutex);
+		_cola.push_back(t);
+		LWP_CondSignal(_hay_trabajo);
+		LWP_MutexUnlock(_mutex);
+	}
+
+	return Futuro(t->id);
+}
+
+void Cargador::iniciar(void)
+{
+	if(_hilo != LWP_THREAD_NULL or _sincrono)
+		return;
+
+	if(LWP_CreateThread(&_hilo, hilo, this, NULL, TAM_PILA, PRIORIDAD) < 0)
+	{
+		_hilo = LWP_THREAD_NULL;
+		_sincrono = true;
+		logger->aviso("Cargador - No se ha podido crear el hilo de carga, las peticiones se atenderán al momento");
+	}
+}
+
+void* Cargador::hilo(void* c)
+{
+	static_cast<Cargador*>(c)->trabajar();
+	return NULL;
+}
+
+void Cargador::trabajar(void)
+{
+	LWP_MutexLock(_mutex);
+
+	while(true)
+	{
+		// Dormir hasta que haya alguna petición en la cola, o hasta que haya que terminar
+		while(_cola.empty() and not _salir)
+		{
+			LWP_CondWait(_hay_trabajo, _mutex);
+		}
+		if(_salir)
+			break;
+
+		Trabajo* t = _cola.front();
+		_cola.pop_front();
+
+		// La petición se atiende sin retener el mutex, para que el hilo principal pueda seguir encolando
+		LWP_MutexUnlock(_mutex);
+		ejecutar(t);
+		LWP_MutexLock(_mutex);
+		_terminados.push_back(t);
+		LWP_CondBroadcast(_hay_terminados);
+	}
+
+	LWP_MutexUnlock(_mutex);
+}
+
+void Cargador::ejecutar(Trabajo* t)
+{
+	Perfilador::Zona zona("Cargador::ejecutar");
+	try {
+		if(t->nivel)
+		{
+			// Leer y analizar el TMX en un documento propio, independiente del que utiliza el Parser
+			string archivo = sdcard->unidad() + ":" + t->ruta;
+			u32 tam = 0;
+			u8* datos = sdcard->leer(archivo, tam, memoria::XML);
+			TiXmlDocument* doc = new TiXmlDocument(archivo);
+			doc->Parse((const char*)datos, NULL, TIXML_ENCODING_UTF8);
+			memoria::liberar(datos);
+			if(doc->Error())
+			{
+				string error = doc->ErrorDesc();
+				delete doc;
+				throw ArchivoEx("Cargador - Error al cargar el nivel '" + t->ruta + "': " + error);
+			}
+			t->doc = doc;
+
+			// El manifiesto lee los XML de los actores, pero no toca la galería
+			t->manifiesto = new Manifiesto;
+			t->manifiesto->leer(doc->RootElement());
+		}
+		else
+		{
+			switch(t->tipo)
+			{
+				case Galeria::IMAGEN:
+				{
+					// La textura se crea después, en el hilo principal
+					Imagen* i = new Imagen;
+					try {
+						i->decodificar(t->ruta);
+					} catch(...) {
+						delete i;
+						throw;
+					}
+					t->recurso = i;
+					break;
+				}
+				case Galeria::MUSICA:
+					t->recurso = new Musica(t->ruta, t->volumen);
+					break;
+				case Galeria::SONIDO:
+					t->recurso = new Sonido(t->ruta, t->volumen, t->volumen, t->prioridad, t->instancias);
+					break;
+				case Galeria::FUENTE:
+					// FreeType no es seguro entre hilos, así que aquí sólo se lee el archivo
+					t->datos = sdcard->leer(sdcard->unidad() + ":" + t->ruta, t->tam, memoria::FUENTES);
+					break;
+			}
+		}
+		t->estado = HECHO;
+	} catch(const exception& e) {
+		t->estado = FALLO;
+		t->error = e.what();
+	} catch(...) {
+		t->estado = FALLO;
+		t->error = "Cargador - Error desconocido al cargar '" + t->ruta + "'";
+	}
+}
+
+void Cargador::completar(Trabajo* t)
+{
+	if(t->estado == HECHO)
+	{
+		try {
+			if(t->nivel)
+			{
+				// Reservar los recursos del nivel, para que nada los descarte antes de que se construya el Nivel
+				Manifiesto* m = t->manifiesto;
+				m->reservar();
+				t->manifiesto = NULL;
+
+				// Un manifiesto anterior del mismo nivel que nadie ha recogido se sustituye por el nuevo
+				Manifiestos::iterator anterior = _manifiestos.find(t->ruta);
+				if(anterior != _manifiestos.end())
+				{
+					anterior->second->liberar();
+					delete anterior->second;
+				}
+				_manifiestos[t->ruta] = m;
+
+				parser->precargar(t->ruta, t->doc);
+				t->doc = NULL;
+
+				const Manifiesto::Recursos& recursos = m->recursos();
+				for(Manifiesto::Recursos::const_iterator i = recursos.begin() ; i != recursos.end() ; ++i)
+					recurso(i->first, i->second);
+			}
+			else
+			{
+				void* r = t->recurso;
+				if(t->tipo == Galeria::IMAGEN)
+					static_cast<Imagen*>(r)->crearTextura();
+				else if(t->tipo == Galeria::FUENTE)
+				{
+					// La fuente se queda con el contenido del archivo, incluso si falla su construcción
+					u8* datos = t->datos;
+					t->datos = NULL;
+					r = new Fuente(t->ruta, datos, t->tam);
+				}
+				t->recurso = NULL;
+				galeria->adoptar(t->tipo, t->codigo, r);
+			}
+		} catch(const exception& e) {
+			t->estado = FALLO;
+			t->error = e.what();
+		}
+	}
+
+	if(t->estado == FALLO)
+	{
+		logger->error(t->error);
+		_errores[t->id] = t->error;
+		if(not t->nivel)
+			galeria->cancelar(t->tipo, t->codigo);
+	}
+
+	descartar(t);
+	_trabajos.erase(t->id);
+	delete t;
+	_completados++;
+}
+
+void Cargador::descartar(Trabajo* t)
+{
+	if(t->recurso != NULL)
+		galeria->destruir(t->tipo, t->recurso);
+	memoria::liberar(t->datos);
+	delete t->doc;
+	delete t->manifiesto;
+	t->recurso = NULL;
+	t->datos = NULL;
+	t->doc = NULL;
+	t->manifiesto = NULL;
+}
+
+void Cargador::esperar(u32 id)
+{
+	while(_trabajos.find(id) != _trabajos.end())
+	{
+		dormir();
+		actualizar();
+	}
+}
+
+void Cargador::esperarRecurso(Galeria::Tipo tipo, const string& codigo)
+{
+	for(Trabajos::iterator i = _trabajos.begin() ; i != _trabajos.end() ; ++i)
+		if(not i->second->nivel and i->second->tipo == tipo and i->second->codigo == codigo)
+		{
+			esperar(i->first);
+			return;
+		}
+}
+
+void Cargador::dormir(void)
+{
+	LWP_MutexLock(_mutex);
+	while(_terminados.empty())
+		LWP_CondWait(_hay_terminados, _mutex);
+	LWP_MutexUnlock(_mutex);
+}
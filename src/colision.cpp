@@ -63,10 +63,11 @@ Figura* Figura::leerPunto(TiXmlElement* nodo)
 
 bool Punto::hayColision(Circulo* c, s16 dx1, s16 dy1, s16 dx2, s16 dy2)
 {
-	// Si la distancia entre el centro del ciculo y el punto es menor o igual al radio
-	f32 distancia_x = abs((c->centro().x() + dx2) - (_x + dx1));
-	f32 distancia_y = abs((c->centro().y() + dy2) - (_y + dy1));
-	if(sqrt(pow(distancia_x, 2) + pow(distancia_y, 2)) <= c->radio())
+	// Si la distancia entre el centro del ciculo y el punto es menor o igual al radio; se comparan los cuadrados
+	// para no calcular la raíz cuadrada
+	s32 distancia_x = (c->centro().x() + dx2) - (_x + dx1);
+	s32 distancia_y = (c->centro().y() + dy2) - (_y + dy1);
+	if(distancia_x * distancia_x + distancia_y * distancia_y <= c->radio() * c->radio())
 		return true;
 	return false;
 }
@@ -158,11 +159,21 @@ bool Rectangulo::hayColision(Punto* p, s16 dx1, s16 dy1, s16 dx2, s16 dy2)
 	return false;
 }
 
+void Rectangulo::caja(s32& x0, s32& y0, s32& x1, s32& y1) const
+{
+	// Mismos bordes que utilizan las comprobaciones de colisión del rectángulo
+	x0 = _p1.x();
+	y0 = _p1.y();
+	x1 = _p2.x();
+	y1 = _p4.y();
+}
+
 bool Circulo::hayColision(Circulo* c, s16 dx1, s16 dy1, s16 dx2, s16 dy2)
 {
-	f32 distancia_x = abs((_centro.x() + dx1) - (c->centro().x() + dx2));
-	f32 distancia_y = abs((_centro.y() + dy1) - (c->centro().y() + dy2));
-	if(pow(distancia_x, 2) + pow(distancia_y, 2) <= pow(_radio + c->radio(), 2))
+	s32 distancia_x = (_centro.x() + dx1) - (c->centro().x() + dx2);
+	s32 distancia_y = (_centro.y() + dy1) - (c->centro().y() + dy2);
+	f32 suma_radios = _radio + c->radio();
+	if(distancia_x * distancia_x + distancia_y * distancia_y <= suma_radios * suma_radios)
 		return true;
 	return false;
 }
@@ -183,10 +194,19 @@ bool Circulo::hayColision(Rectangulo* r, s16 dx1, s16 dy1, s16 dx2, s16 dy2)
 bool Circulo::hayColision(Punto* p, s16 dx1, s16 dy1, s16 dx2, s16 dy2)
 {
 	// Si la distancia entre el centro del ciculo y el punto es menor o igual al radio
-	f32 distancia_x = abs((_centro.x() + dx1) - (p->x() + dx2));
-	f32 distancia_y = abs((_centro.y() + dy1) - (p->y() + dy2));
-	if(pow(distancia_x, 2) + pow(distancia_y, 2) <= pow(_radio, 2))
+	s32 distancia_x = (_centro.x() + dx1) - (p->x() + dx2);
+	s32 distancia_y = (_centro.y() + dy1) - (p->y() + dy2);
+	if(distancia_x * distancia_x + distancia_y * distancia_y <= _radio * _radio)
 		return true;
 	return false;
 }
 
+void Circulo::caja(s32& x0, s32& y0, s32& x1, s32& y1) const
+{
+	s32 radio = (s32)ceil(_radio);
+	x0 = _centro.x() - radio;
+	y0 = _centro.y() - radio;
+	x1 = _centro.x() + radio;
+	y1 = _centro.y() + radio;
+}
+
@@ -0,0 +1,112 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "contadores.h"
+#include <sstream>
+using namespace std;
+
+namespace
+{
+	const char* NOMBRES[Contadores::NUM_CONTADORES] =
+	{
+		"dibujos", "bloques", "vertices", "texturas", "paletas", "configuraciones"
+	};
+}
+
+Contadores::Contadores(void)
+{
+	reiniciar();
+}
+
+void Contadores::cerrarFrame(void)
+{
+	memcpy(_historia[_frames % HISTORIA], _actual, sizeof(_actual));
+	memset(_actual, 0, sizeof(_actual));
+	_frames++;
+}
+
+void Contadores::reiniciar(void)
+{
+	memset(_actual, 0, sizeof(_actual));
+	memset(_historia, 0, sizeof(_historia));
+	_frames = 0;
+}
+
+u32 Contadores::actual(Contador c) const
+{
+	return _actual[c];
+}
+
+u32 Contadores::ultimo(Contador c) const
+{
+	return (_frames > 0) ? _historia[(_frames - 1) % HISTORIA][c] : 0;
+}
+
+u32 Contadores::minimo(Contador c) const
+{
+	u32 n = frames();
+	if(n == 0)
+		return 0;
+
+	u32 m = _historia[0][c];
+	for(u32 i = 1 ; i < n ; ++i)
+		if(_historia[i][c] < m)
+			m = _historia[i][c];
+	return m;
+}
+
+u32 Contadores::medio(Contador c) const
+{
+	u32 n = frames();
+	if(n == 0)
+		return 0;
+
+	u64 suma = 0;
+	for(u32 i = 0 ; i < n ; ++i)
+		suma += _historia[i][c];
+	return (u32)(suma / n);
+}
+
+u32 Contadores::maximo(Contador c) const
+{
+	u32 m = 0;
+	for(u32 i = 0 ; i < frames() ; ++i)
+		if(_historia[i][c] > m)
+			m = _historia[i][c];
+	return m;
+}
+
+u32 Contadores::frames(void) const
+{
+	return (_frames < HISTORIA) ? _frames : HISTORIA;
+}
+
+const char* Contadores::nombre(Contador c)
+{
+	return (c < NUM_CONTADORES) ? NOMBRES[c] : "";
+}
+
+string Contadores::informe(void) const
+{
+	stringstream texto;
+	texto << "Últimos " << frames() << " frames (último / mínimo / media / máximo):";
+	for(u32 c = 0 ; c < NUM_CONTADORES ; ++c)
+		texto << "\n  " << NOMBRES[c] << ": " << ultimo((Contador)c) << " / " << minimo((Contador)c) << " / "
+			<< medio((Contador)c) << " / " << maximo((Contador)c);
+	return texto.str();
+}
@@ -0,0 +1,153 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "fijo.h"
+#include <cmath>
+using namespace std;
+
+namespace
+{
+	// Número de ceros a la izquierda de un entero de 32 bits distinto de 0. Tanto devkitPPC como el compilador del
+	// PC son GCC, que lo traduce a una sola instrucción (cntlzw en la consola) en lugar de una cadena de saltos
+	u32 cerosIzquierda(u32 n)
+	{
+		return (u32)__builtin_clz(n);
+	}
+
+	// Raíz cuadrada entera, redondeada hacia abajo, calculada bit a bit desde el mayor bit de la raíz
+	u32 raizEntera(u64 n)
+	{
+		if(n == 0)
+			return 0;
+		u32 alto = (u32)(n >> 32);
+		u32 bits = alto ? 64 - cerosIzquierda(alto) : 32 - cerosIzquierda((u32)n);
+
+		u64 r = 0;
+		u64 bit = (u64)1 << ((bits - 1) & ~1u);
+		while(bit != 0)
+		{
+			if(n >= r + bit)
+			{
+				n -= r + bit;
+				r = (r >> 1) + bit;
+			}
+			else
+				r >>= 1;
+			bit >>= 2;
+		}
+		return (u32)r;
+	}
+
+	// Inverso de d entre 0,5 y 1, y raíz cuadrada inversa de d entre 0,25 y 1, con 30 bits de fracción, en pasos de
+	// 1/512 y de 1/256 respectivamente; ambas tablas incluyen el extremo superior, para interpolar en el último tramo
+	const u32 TAM_INVERSO = 256;
+	const u32 TAM_RAIZ = 192;
+	u32 tabla_inverso[TAM_INVERSO + 1];
+	u32 tabla_raiz[TAM_RAIZ + 1];
+
+	// Las tablas se rellenan al arrancar el programa, igual que las de trigonometria
+	struct Inicializador
+	{
+		Inicializador(void)
+		{
+			for(u32 i = 0 ; i <= TAM_INVERSO ; ++i)
+				tabla_inverso[i] = (u32)floor(1073741824.0 / (0.5 + 0.5 * i / TAM_INVERSO) + 0.5);
+			for(u32 i = 0 ; i <= TAM_RAIZ ; ++i)
+				tabla_raiz[i] = (u32)floor(1073741824.0 / sqrt((64.0 + i) / 256) + 0.5);
+		}
+	} inicializador;
+
+	// Valor de una tabla en la posición i más la fracción f (de 16 bits) del tramo siguiente; la tabla es decreciente
+	u32 interpolar(const u32* tabla, u32 i, u32 f)
+	{
+		return tabla[i] - (u32)(((u64)(tabla[i] - tabla[i + 1]) * f) >> 16);
+	}
+}
+
+Fijo Fijo::raiz(void) const
+{
+	if(_v <= 0)
+		return Fijo();
+
+	// Normalizar con un número par de ceros: d = v * 2^ceros / 2^32 está entre 0,25 y 1, y la raíz de x (la de
+	// v * 2^16 en valor bruto) es la raíz de d por 2^(24 - ceros / 2)
+	u32 ceros = cerosIzquierda((u32)_v) & ~1u;
+	u32 d = (u32)_v << ceros;
+
+	// Raíz inversa de d interpolada en la tabla (unos 14 bits correctos), y un paso de Newton-Raphson sobre la raíz
+	// s = d * y, s = s * (3 - s * y) / 2, que sólo multiplica y deja unos 28 bits correctos
+	u32 y = interpolar(tabla_raiz, (d >> 24) - 64, (d >> 8) & 0xFFFF);
+	u32 s = (u32)(((u64)d * y) >> 32);
+	u32 p = (u32)(((u64)s * y) >> 30);
+	s = (u32)(((u64)s * ((3u << 30) - p)) >> 31);
+
+	// Deshacer la normalización y corregir la última unidad, para que el resultado sea la raíz redondeada hacia abajo
+	u32 raiz = s >> (6 + ceros / 2);
+	u64 n = (u64)_v << BITS;
+	if((u64)raiz * raiz > n)
+		--raiz;
+	else if((u64)(raiz + 1) * (raiz + 1) <= n)
+		++raiz;
+	return desdeBruto((s32)raiz);
+}
+
+Fijo Fijo::inverso(void) const
+{
+	u32 a = (_v < 0) ? -(u32)_v : (u32)_v;
+	if(a == 0)
+		return desdeBruto(0x7FFFFFFF);
+
+	// Normalizar: d = a * 2^ceros / 2^32 está entre 0,5 y 1, y el inverso de x es 2^ceros / d en valor bruto
+	u32 ceros = cerosIzquierda(a);
+	u32 d = a << ceros;
+
+	// Inverso de d, entre 1 y 2, con 30 bits de fracción: interpolado en la tabla (unos 16 bits correctos), y un
+	// paso de Newton-Raphson, r = r * (2 - d * r), que sólo multiplica y deja unos 30 bits correctos
+	u32 r = interpolar(tabla_inverso, (d >> 23) & 0xFF, (d >> 7) & 0xFFFF);
+	u32 e = (u32)(((u64)d * r) >> 32);
+	r = (u32)(((u64)r * ((1u << 31) - e)) >> 30);
+
+	// Deshacer la normalización, redondeando, y saturar si el resultado no cabe. No se corrige la última unidad con
+	// otra multiplicación: cuando se dividen varios valores entre el mismo número, que es para lo que existe el
+	// inverso, esa corrección se come casi toda la ventaja sobre dividir (ver medirfijo)
+	s32 resultado = 0x7FFFFFFF;
+	if(ceros <= 30)
+	{
+		u32 desplazamiento = 30 - ceros;
+		u32 v = (desplazamiento > 0) ? (r + (1u << (desplazamiento - 1))) >> desplazamiento : r;
+		if(v <= 0x7FFFFFFF)
+			resultado = (s32)v;
+	}
+	return desdeBruto(_v < 0 ? -resultado : resultado);
+}
+
+Fijo VectorFijo::modulo(void) const
+{
+	s64 cx = x.bruto();
+	s64 cy = y.bruto();
+	return Fijo::desdeBruto((s32)raizEntera((u64)(cx * cx + cy * cy)));
+}
+
+VectorFijo VectorFijo::normalizar(void) const
+{
+	// Se divide en lugar de multiplicar por el inverso del módulo, que en los vectores largos pierde precisión
+	Fijo m = modulo();
+	if(m == Fijo())
+		return VectorFijo();
+	return VectorFijo(x / m, y / m);
+}
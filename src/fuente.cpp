@@ -29,15 +29,15 @@ Fuente::Fuente(const string& ruta) throw (ArchivoEx, TarjetaEx)
 	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
 	string ruta_completa = sdcard->unidad() + ":" + ruta;
 
-	// Comprobar la existencia del archivo
-	if(not sdcard->existe(ruta_completa))
-		throw ArchivoEx("Fuente - El archivo '" + ruta + "' no existe.");
+	// Leer el archivo completo de una sola vez (Sdcard::leer() comprueba su existencia); FreeType lo consultará desde memoria
+	_datos = sdcard->leer(ruta_completa, _tam, memoria::FUENTES);
+	iniciar(ruta);
+}
 
-	// Cargar la 'face' de la fuente desde el archivo, si da error, se lanza una excepción
-	u32 error = FT_New_Face(library, ruta_completa.c_str(), 0, &_face);
-	_kerning = FT_HAS_KERNING(_face);
-	if(error)
-		throw ArchivoEx("Fuente - Error al cargar la fuente '" + ruta + "'");
+Fuente::Fuente(const string& ruta, u8* datos, u32 tam) throw (ArchivoEx)
+	: _datos(datos), _tam(tam)
+{
+	iniciar(ruta);
 }
 
 void Fuente::escribir(const string& texto, u8 tam, s16 x, s16 y, s16 z, u32 color) const
@@ -81,12 +81,31 @@ void Fuente::escribir(const wstring& texto, u8 tam, s16 x, s16 y, s16 z, u32 col
 	}
 }
 
+u32 Fuente::bytes(void) const
+{
+	return _tam;
+}
+
 Fuente::~Fuente(void)
 {
 	FT_Done_Face(_face);
+	memoria::liberar(_datos);
 }
 
 // Métodos privados
+void Fuente::iniciar(const string& ruta) throw (ArchivoEx)
+{
+	// Cargar la 'face' de la fuente desde memoria, si da error, se libera el contenido y se lanza una excepción
+	u32 error = FT_New_Memory_Face(library, _datos, _tam, 0, &_face);
+	if(error)
+	{
+		memoria::liberar(_datos);
+		_datos = NULL;
+		throw ArchivoEx("Fuente - Error al cargar la fuente '" + ruta + "'");
+	}
+	_kerning = FT_HAS_KERNING(_face);
+}
+
 void Fuente::dibujarCaracter(FT_Bitmap *bitmap, s16 x, s16 y, s16 z, u32 color) const
 {
     s16 i, j, p, q;
@@ -17,36 +17,158 @@
  */
 
 #include "galeria.h"
+#include "cargador.h"
+#include "perfilador.h"
 using namespace std;
 
 Galeria* Galeria::_instance = 0;
 
-const Imagen& Galeria::imagen(const string& codigo) throw (CodigoEx)
+namespace
 {
-	if(_map_imagen.find(codigo) == _map_imagen.end())
-		throw CodigoEx("Galeria::imagen - Código erróneo (" + codigo + ")");
-	return *(_map_imagen[codigo]);
+	// Nombres de los tipos de recursos, para los mensajes de error y el log
+	const char* NOMBRES[Galeria::NUM_TIPOS] = { "imagen", "musica", "sonido", "fuente" };
 }
 
-const Musica& Galeria::musica(const string& codigo) throw (CodigoEx)
+const Imagen& Galeria::imagen(const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
 {
-	if(_map_musica.find(codigo) == _map_musica.end())
-		throw CodigoEx("Galeria::musica - Código erróneo (" + codigo + ")");
-	return *(_map_musica[codigo]);
+	return *static_cast<Imagen*>(acceder(IMAGEN, buscar(IMAGEN, codigo)).recurso);
 }
 
-const Sonido& Galeria::sonido(const string& codigo) throw (CodigoEx)
+const Imagen& Galeria::imagen(ManejadorImagen m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
 {
-	if(_map_sonido.find(codigo) == _map_sonido.end())
-		throw CodigoEx("Galeria::sonido - Código erróneo (" + codigo + ")");
-	return *(_map_sonido[codigo]);
+	return *static_cast<Imagen*>(acceder(IMAGEN, m._indice).recurso);
 }
 
-const Fuente& Galeria::fuente(const string& codigo) throw (CodigoEx)
+const Mascara& Galeria::mascara(const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
 {
-	if(_map_fuente.find(codigo) == _map_fuente.end())
-		throw CodigoEx("Galeria::fuente - Código erróneo (" + codigo + ")");
-	return *(_map_fuente[codigo]);
+	Entrada& e = acceder(IMAGEN, buscar(IMAGEN, codigo));
+	const Mascara& m = static_cast<Imagen*>(e.recurso)->mascara();
+
+	// Si la máscara se acaba de crear, la imagen ocupa más memoria que cuando se midió al cargarla
+	u32 bytes = medir(IMAGEN, e.recurso);
+	if(bytes != e.bytes)
+	{
+		_residentes[IMAGEN] += bytes - e.bytes;
+		e.bytes = bytes;
+		ajustar(&e);
+	}
+	return m;
+}
+
+const Musica& Galeria::musica(const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Musica*>(acceder(MUSICA, buscar(MUSICA, codigo)).recurso);
+}
+
+const Musica& Galeria::musica(ManejadorMusica m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Musica*>(acceder(MUSICA, m._indice).recurso);
+}
+
+const Sonido& Galeria::sonido(const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Sonido*>(acceder(SONIDO, buscar(SONIDO, codigo)).recurso);
+}
+
+const Sonido& Galeria::sonido(ManejadorSonido m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Sonido*>(acceder(SONIDO, m._indice).recurso);
+}
+
+const Fuente& Galeria::fuente(const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Fuente*>(acceder(FUENTE, buscar(FUENTE, codigo)).recurso);
+}
+
+const Fuente& Galeria::fuente(ManejadorFuente m) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	return *static_cast<Fuente*>(acceder(FUENTE, m._indice).recurso);
+}
+
+void Galeria::retener(Tipo tipo, const string& codigo) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	acceder(tipo, buscar(tipo, codigo)).referencias++;
+}
+
+void Galeria::liberar(Tipo tipo, const string& codigo)
+{
+	u32 indice;
+	if(localizar(tipo, codigo, indice))
+		soltar(tipo, indice);
+}
+
+void Galeria::reservar(Tipo tipo, const string& codigo) throw (CodigoEx)
+{
+	_entradas[tipo][buscar(tipo, codigo)].referencias++;
+}
+
+void Galeria::descartar(Tipo tipo, const string& codigo)
+{
+	u32 indice;
+	if(not localizar(tipo, codigo, indice))
+		return;
+
+	Entrada& e = _entradas[tipo][indice];
+	if(e.recurso == NULL or e.referencias > 0 or e.pendiente)
+		return;
+	if(tipo == MUSICA and static_cast<Musica*>(e.recurso)->activa())
+		return;
+
+	descargar(tipo, e);
+	logger->info("Galeria - Descartado el recurso '" + e.codigo + "' (" + NOMBRES[tipo] + ")");
+}
+
+void Galeria::setPresupuesto(u32 bytes)
+{
+	_presupuesto = bytes;
+	ajustar(NULL);
+}
+
+u32 Galeria::presupuesto(void) const
+{
+	return _presupuesto;
+}
+
+u32 Galeria::residentes(Tipo tipo) const
+{
+	return _residentes[tipo];
+}
+
+bool Galeria::cargado(Tipo tipo, const string& codigo) const
+{
+	u32 indice;
+	return (localizar(tipo, codigo, indice) and _entradas[tipo][indice].recurso != NULL);
+}
+
+void Galeria::informe(void) const
+{
+	u32 total = 0;
+	for(u8 t = 0 ; t < NUM_TIPOS ; ++t)
+	{
+		u32 cargados = 0;
+		u32 retenidos = 0;
+		for(Entradas::const_iterator i = _entradas[t].begin() ; i != _entradas[t].end() ; ++i)
+		{
+			if(i->recurso != NULL)
+				cargados++;
+			if(i->referencias > 0)
+				retenidos++;
+		}
+
+		stringstream texto;
+		texto << "Galeria - " << NOMBRES[t] << ": " << cargados << " de " << _entradas[t].size()
+			<< " cargados (" << retenidos << " retenidos), " << _residentes[t] << " bytes";
+		logger->info(texto.str());
+		total += _residentes[t];
+	}
+
+	stringstream texto;
+	texto << "Galeria - Total: " << total << " bytes, presupuesto: ";
+	if(_presupuesto == 0)
+		texto << "sin límite";
+	else
+		texto << _presupuesto << " bytes";
+	logger->info(texto.str());
 }
 
 void Galeria::inicializar(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx, XmlEx)
@@ -62,12 +184,15 @@ void Galeria::inicializar(const string& ruta) throw (ArchivoEx, ImagenEx, Tarjet
 		throw e;
 	}
 
+	// El presupuesto de memoria es opcional, y se indica en kilobytes
+	_presupuesto = parser->atributoU32("presupuesto", parser->raiz()) * 1024;
+
 	// Recorrer todos los nodos hijo de la raiz
 	for(TiXmlElement* media = parser->raiz()->FirstChildElement() ; media ; media = media->NextSiblingElement())
 	{
 		string tipo = media->ValueStr();
 
-		// Según el tipo de nodo, llamar a una función de carga o a otra
+		// Según el tipo de nodo, llamar a una función de lectura o a otra
 		try {
 			if(tipo == "imagen")
 				leerImagen(media);
@@ -81,113 +206,403 @@ void Galeria::inicializar(const string& ruta) throw (ArchivoEx, ImagenEx, Tarjet
 			throw e;
 		}
 	}
+
+	// La página de cada recorte debe ser una imagen de la galería con archivo propio
+	for(Entradas::const_iterator i = _entradas[IMAGEN].begin() ; i != _entradas[IMAGEN].end() ; ++i)
+	{
+		u32 pagina;
+		if(i->atlas != "" and (not localizar(IMAGEN, i->atlas, pagina) or _entradas[IMAGEN][pagina].atlas != ""))
+			throw XmlEx("Galeria::inicializar - La imagen '" + i->codigo + "' pertenece a una página de atlas"
+						" que no existe (" + i->atlas + ")");
+	}
 }
 
 // Métodos protegidos
+Galeria::Galeria(void): _presupuesto(0), _reloj(0)
+{
+	for(u8 t = 0 ; t < NUM_TIPOS ; ++t)
+		_residentes[t] = 0;
+}
+
 Galeria::~Galeria(void)
 {
-	for(map<string, Imagen*>::iterator i = _map_imagen.begin() ; i != _map_imagen.end() ; ++i)
-		delete i->second;
-	for(map<string, Musica*>::iterator i = _map_musica.begin() ; i != _map_musica.end() ; ++i)
-		delete i->second;
-	for(map<string, Sonido*>::iterator i = _map_sonido.begin() ; i != _map_sonido.end() ; ++i)
-		delete i->second;
-	for(map<string, Fuente*>::iterator i = _map_fuente.begin() ; i != _map_fuente.end() ; ++i)
-		delete i->second;
+	for(u8 t = 0 ; t < NUM_TIPOS ; ++t)
+		for(Entradas::iterator i = _entradas[t].begin() ; i != _entradas[t].end() ; ++i)
+			descargar((Tipo)t, *i);
 }
 
 // Métodos privados
-void Galeria::leerImagen(TiXmlElement* nodo) throw (ArchivoEx, ImagenEx, TarjetaEx, XmlEx)
+void Galeria::leerImagen(TiXmlElement* nodo) throw (ImagenEx, XmlEx)
 {
 	// Leer los atributos del tag XML
+	Entrada e;
 	string codigo = parser->atributo("codigo", nodo);
-	string ruta = parser->atributo("ruta", nodo);
-	string formato = parser->atributo("formato", nodo);
+	e.ruta = parser->atributo("ruta", nodo);
+	e.formato = parser->atributo("formato", nodo);
+	e.atlas = parser->atributo("atlas", nodo);
+	e.x = e.y = e.ancho = e.alto = 0;
 
-	if(codigo == "" or ruta == "" or formato == "")
+	if(codigo == "")
 		throw XmlEx("Galeria::leerImagen - Error al cargar un atributo");
 
-	// Cargar la imagen
-	Imagen* i = new Imagen;
-	if(formato == "bmp")
-		try {
-			i->cargarBmp(ruta);
-		} catch(const Excepcion& e) {
-			delete i;
-			throw e;
-		}
-	else
+	// Una imagen de un atlas es un recorte de otra imagen de la galería, su página, y no tiene archivo propio
+	if(e.atlas != "")
 	{
-		delete i;
-		throw ImagenEx("Galeria::leerImagen - Formato de imagen no soportado");
+		e.x = parser->atributoU32("x", nodo);
+		e.y = parser->atributoU32("y", nodo);
+		e.ancho = parser->atributoU32("ancho", nodo);
+		e.alto = parser->atributoU32("alto", nodo);
+		if(e.ancho == 0 or e.alto == 0)
+			throw XmlEx("Galeria::leerImagen - Error al cargar el recorte de la imagen '" + codigo + "'");
+		e.volumen = e.prioridad = e.instancias = 0;
+		registrar(IMAGEN, codigo, e);
+		return;
 	}
 
-	// Insertar la imagen en el diccionario
-	_map_imagen.insert(make_pair(codigo, i));
+	if(e.ruta == "" or e.formato == "")
+		throw XmlEx("Galeria::leerImagen - Error al cargar un atributo");
+
+	// El formato se comprueba ahora, aunque la imagen no se cargue hasta que se utilice
+	if(e.formato != "bmp" and e.formato != "png" and e.formato != "tex")
+		throw ImagenEx("Galeria::leerImagen - Formato de imagen no soportado");
+
+	// Registrar la imagen en el diccionario
+	e.volumen = e.prioridad = e.instancias = 0;
+	registrar(IMAGEN, codigo, e);
 }
 
-void Galeria::leerMusica(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx)
+void Galeria::leerMusica(TiXmlElement* nodo) throw (XmlEx)
 {
 	// Leer los atributos del tag XML
+	Entrada e;
 	string codigo = parser->atributo("codigo", nodo);
-	string ruta = parser->atributo("ruta", nodo);
-	u32 volumen = parser->atributoU32("volumen", nodo);
+	e.ruta = parser->atributo("ruta", nodo);
+	e.volumen = parser->atributoU32("volumen", nodo);
 
-	if(codigo == "" or ruta == "")
+	if(codigo == "" or e.ruta == "")
 		throw XmlEx("Galeria::leerMusica - Error al cargar un atributo");
 
-	// Cargar la pista de música
-	Musica* m;
-	try {
-		m = new Musica(ruta, volumen);
-	} catch(const Excepcion& e) {
-		throw e;
-	}
-
-	// Insertar la pista de música en el diccionario
-	_map_musica.insert(make_pair(codigo, m));
+	// Registrar la pista de música en el diccionario
+	e.prioridad = e.instancias = 0;
+	registrar(MUSICA, codigo, e);
 }
 
-void Galeria::leerSonido(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx)
+void Galeria::leerSonido(TiXmlElement* nodo) throw (XmlEx)
 {
 	// Leer los atributos del tag XML
+	Entrada e;
 	string codigo = parser->atributo("codigo", nodo);
-	string ruta = parser->atributo("ruta", nodo);
-	u32 volumen = parser->atributoU32("volumen", nodo);
+	e.ruta = parser->atributo("ruta", nodo);
+	e.volumen = parser->atributoU32("volumen", nodo);
 
-	if(codigo == "" or ruta == "")
+	if(codigo == "" or e.ruta == "")
 		throw XmlEx("Galeria::leerSonido - Error al cargar un atributo");
 
-	// Cargar el sonido
-	Sonido* s;
-	try {
-		s = new Sonido(ruta, volumen, volumen);
-	} catch(const Excepcion& e) {
-		throw e;
-	}
+	// La prioridad y el número de instancias son opcionales, y se guardan en 8 bits
+	u32 prioridad = 128;
+	if(parser->atributo("prioridad", nodo) != "")
+		prioridad = parser->atributoU32("prioridad", nodo);
+	u32 instancias = parser->atributoU32("instancias", nodo);
+	if(prioridad > 255 or instancias > 255)
+		throw XmlEx("Galeria::leerSonido - La prioridad y las instancias del sonido '" + codigo
+					+ "' deben estar entre 0 y 255");
+	e.prioridad = prioridad;
+	e.instancias = instancias;
 
-	// Insertar el sonido en el diccionario
-	_map_sonido.insert(make_pair(codigo, s));
+	// Registrar el sonido en el diccionario
+	registrar(SONIDO, codigo, e);
 }
 
-void Galeria::leerFuente(TiXmlElement* nodo) throw (ArchivoEx, TarjetaEx, XmlEx)
+void Galeria::leerFuente(TiXmlElement* nodo) throw (XmlEx)
 {
 	// Leer los atributos del tag XML
+	Entrada e;
 	string codigo = parser->atributo("codigo", nodo);
-	string ruta = parser->atributo("ruta", nodo);
+	e.ruta = parser->atributo("ruta", nodo);
 
-	if(codigo == "" or ruta == "")
+	if(codigo == "" or e.ruta == "")
 		throw XmlEx("Galeria::leerFuente - Error al cargar un atributo");
 
-	// Cargar la fuente
-	Fuente* f;
-	try {
-		f = new Fuente(ruta);
-	} catch(const Excepcion& e) {
-		throw e;
+	// Registrar la fuente en el diccionario
+	e.volumen = e.prioridad = e.instancias = 0;
+	registrar(FUENTE, codigo, e);
+}
+
+void Galeria::registrar(Tipo tipo, const string& codigo, Entrada& e) throw (XmlEx)
+{
+	u32 id = fnv1a::hash(codigo);
+	Indices::iterator i = _indices[tipo].find(id);
+	if(i != _indices[tipo].end())
+	{
+		// Un código repetido se ignora, pero dos códigos distintos no pueden compartir identificador
+		if(_entradas[tipo][i->second].codigo == codigo)
+			return;
+		throw XmlEx("Galeria - Los códigos '" + _entradas[tipo][i->second].codigo + "' y '" + codigo
+					+ "' (" + NOMBRES[tipo] + ") tienen el mismo identificador, hay que cambiar uno de ellos");
+	}
+
+	e.codigo = codigo;
+	e.recurso = NULL;
+	e.bytes = e.referencias = 0;
+	e.uso = 0;
+	e.pendiente = false;
+
+	_indices[tipo][id] = _entradas[tipo].size();
+	_entradas[tipo].push_back(e);
+}
+
+bool Galeria::localizar(Tipo tipo, const string& codigo, u32& indice) const
+{
+	// Se compara el código además del identificador, por si se pide un código no registrado con el mismo hash
+	Indices::const_iterator i = _indices[tipo].find(fnv1a::hash(codigo));
+	if(i == _indices[tipo].end() or _entradas[tipo][i->second].codigo != codigo)
+		return false;
+	indice = i->second;
+	return true;
+}
+
+u32 Galeria::buscar(Tipo tipo, const string& codigo) const throw (CodigoEx)
+{
+	u32 indice;
+	if(not localizar(tipo, codigo, indice))
+		throw CodigoEx("Galeria::" + string(NOMBRES[tipo]) + " - Código erróneo (" + codigo + ")");
+	return indice;
+}
+
+u32 Galeria::buscar(Tipo tipo, u32 id) const throw (CodigoEx)
+{
+	Indices::const_iterator i = _indices[tipo].find(id);
+	if(i == _indices[tipo].end())
+	{
+		stringstream texto;
+		texto << "Galeria::" << NOMBRES[tipo] << " - Identificador erróneo (0x" << hex << id << ")";
+		throw CodigoEx(texto.str());
+	}
+	return i->second;
+}
+
+Galeria::Entrada& Galeria::acceder(Tipo tipo, u32 indice) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	if(indice >= _entradas[tipo].size())
+		throw CodigoEx("Galeria::" + string(NOMBRES[tipo]) + " - Manejador no válido");
+
+	Entrada& e = _entradas[tipo][indice];
+
+	// Si el recurso se está cargando en segundo plano, se espera a que termine en lugar de leerlo dos veces
+	if(e.pendiente)
+		cargador->esperarRecurso(tipo, e.codigo);
+
+	e.uso = ++_reloj;
+
+	if(e.recurso == NULL)
+	{
+		Perfilador::Zona zona("Galeria::cargar");
+		cargar(tipo, e);
+		logger->info("Galeria - Cargado el recurso '" + e.codigo + "' (" + NOMBRES[tipo] + ")");
+
+		// El recurso recién cargado no se puede descargar para hacerle sitio a él mismo
+		ajustar(&e);
 	}
 
-	// Insertar la fuente en el diccionario
-	_map_fuente.insert(make_pair(codigo, f));
+	return e;
+}
+
+void Galeria::soltar(Tipo tipo, u32 indice)
+{
+	if(indice >= _entradas[tipo].size() or _entradas[tipo][indice].referencias == 0)
+		return;
+
+	// Si el recurso deja de estar retenido, puede que haya que descargar algo para cumplir el presupuesto
+	if(--_entradas[tipo][indice].referencias == 0)
+		ajustar(NULL);
+}
+
+void Galeria::cargar(Tipo tipo, Entrada& e) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	// Las excepciones de los constructores se propagan sin modificar, conservando su tipo
+	switch(tipo)
+	{
+		case IMAGEN:
+		{
+			// La página de un recorte se retiene mientras el recorte esté cargado
+			Entrada* pagina = NULL;
+			if(e.atlas != "")
+			{
+				pagina = &acceder(IMAGEN, buscar(IMAGEN, e.atlas));
+				pagina->referencias++;
+			}
+
+			Imagen* i = new Imagen;
+			try {
+				if(pagina != NULL)
+					i->recortar(*static_cast<Imagen*>(pagina->recurso), e.x, e.y, e.ancho, e.alto);
+				else
+					i->cargar(e.ruta);
+			} catch(...) {
+				delete i;
+				if(pagina != NULL)
+					pagina->referencias--;
+				throw;
+			}
+			e.recurso = i;
+			break;
+		}
+		case MUSICA:
+			e.recurso = new Musica(e.ruta, e.volumen);
+			break;
+		case SONIDO:
+			e.recurso = new Sonido(e.ruta, e.volumen, e.volumen, e.prioridad, e.instancias);
+			break;
+		case FUENTE:
+			e.recurso = new Fuente(e.ruta);
+			break;
+	}
+
+	e.bytes = medir(tipo, e.recurso);
+	_residentes[tipo] += e.bytes;
+}
+
+void Galeria::descargar(Tipo tipo, Entrada& e)
+{
+	if(e.recurso == NULL)
+		return;
+
+	destruir(tipo, e.recurso);
+
+	_residentes[tipo] -= e.bytes;
+	e.recurso = NULL;
+	e.bytes = 0;
+
+	// Quitar la retención de la página de un recorte; si queda libre, la descargará el propio ajuste en curso o el
+	// siguiente, así que no se ajusta desde aquí
+	u32 indice;
+	if(tipo == IMAGEN and e.atlas != "" and localizar(IMAGEN, e.atlas, indice)
+		and _entradas[IMAGEN][indice].referencias > 0)
+		_entradas[IMAGEN][indice].referencias--;
+}
+
+void Galeria::destruir(Tipo tipo, void* recurso)
+{
+	switch(tipo)
+	{
+		case IMAGEN:
+			// Con latencia, el procesador gráfico puede estar dibujando aún la textura en el frame anterior
+			screen->sincronizar();
+			delete static_cast<Imagen*>(recurso);
+			break;
+		case MUSICA:
+			delete static_cast<Musica*>(recurso);
+			break;
+		case SONIDO:
+			delete static_cast<Sonido*>(recurso);
+			break;
+		case FUENTE:
+			delete static_cast<Fuente*>(recurso);
+			break;
+	}
+}
+
+u32 Galeria::medir(Tipo tipo, const void* recurso) const
+{
+	switch(tipo)
+	{
+		case IMAGEN:
+			return static_cast<const Imagen*>(recurso)->bytes();
+		case MUSICA:
+			return static_cast<const Musica*>(recurso)->bytes();
+		case SONIDO:
+			return static_cast<const Sonido*>(recurso)->bytes();
+		case FUENTE:
+			return static_cast<const Fuente*>(recurso)->bytes();
+	}
+	return 0;
+}
+
+string Galeria::archivo(Tipo tipo, const string& codigo) const throw (CodigoEx)
+{
+	const Entrada& e = _entradas[tipo][buscar(tipo, codigo)];
+	return (tipo == IMAGEN and e.atlas != "") ? e.atlas : codigo;
+}
+
+bool Galeria::pedir(Tipo tipo, const string& codigo, Entrada& copia) throw (CodigoEx)
+{
+	Entrada& e = _entradas[tipo][buscar(tipo, codigo)];
+	if(e.recurso != NULL or e.pendiente)
+		return false;
+
+	e.pendiente = true;
+	copia = e;
+	return true;
+}
+
+void Galeria::adoptar(Tipo tipo, const string& codigo, void* recurso)
+{
+	// Si la entrada no existe o ya tiene recurso (no debería ocurrir), se descarta el recibido
+	u32 indice;
+	if(not localizar(tipo, codigo, indice) or _entradas[tipo][indice].recurso != NULL)
+	{
+		destruir(tipo, recurso);
+		return;
+	}
+
+	Entrada& e = _entradas[tipo][indice];
+	e.pendiente = false;
+	e.recurso = recurso;
+	e.bytes = medir(tipo, recurso);
+	e.uso = ++_reloj;
+	_residentes[tipo] += e.bytes;
+	logger->info("Galeria - Cargado en segundo plano el recurso '" + codigo + "' (" + NOMBRES[tipo] + ")");
+
+	ajustar(&e);
+}
+
+void Galeria::cancelar(Tipo tipo, const string& codigo)
+{
+	u32 indice;
+	if(localizar(tipo, codigo, indice))
+		_entradas[tipo][indice].pendiente = false;
+}
+
+void Galeria::ajustar(const Entrada* protegida)
+{
+	if(_presupuesto == 0)
+		return;
+
+	u32 total = 0;
+	for(u8 t = 0 ; t < NUM_TIPOS ; ++t)
+		total += _residentes[t];
+
+	while(total > _presupuesto)
+	{
+		// Buscar el recurso cargado y no retenido que lleve más tiempo sin utilizarse
+		Entrada* victima = NULL;
+		u8 tipo = 0;
+		for(u8 t = 0 ; t < NUM_TIPOS ; ++t)
+			for(Entradas::iterator i = _entradas[t].begin() ; i != _entradas[t].end() ; ++i)
+			{
+				Entrada& e = *i;
+				if(e.recurso == NULL or e.referencias > 0 or &e == protegida)
+					continue;
+				// La pista de música que está sonando no se descarga, aunque nadie la retenga
+				if(t == MUSICA and static_cast<Musica*>(e.recurso)->activa())
+					continue;
+				if(victima == NULL or e.uso < victima->uso)
+				{
+					victima = &e;
+					tipo = t;
+				}
+			}
+
+		// Si no queda nada que se pueda descargar, se sobrepasa el presupuesto
+		if(victima == NULL)
+		{
+			logger->aviso("Galeria - Presupuesto de memoria superado, todos los recursos cargados están en uso");
+			return;
+		}
+
+		total -= victima->bytes;
+		descargar((Tipo)tipo, *victima);
+		logger->info("Galeria - Descargado el recurso '" + victima->codigo + "' (" + NOMBRES[tipo] + ")");
+	}
 }
 
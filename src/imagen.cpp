@@ -20,92 +20,110 @@
 using namespace std;
 
 u32 Imagen::alpha = 0;
+bool Imagen::indexar = true;
 
 Imagen::Imagen(void)
 {
 	_imagen = NULL;
 	_pixelData = NULL;
+	_cocinada = NULL;
+	_pagina = NULL;
+	_mascara = NULL;
 	reset();
 }
 
-void Imagen::cargarBmp(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+void Imagen::cargar(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
 {
-	reset();
+	decodificar(ruta, CUALQUIERA);
+	crearTextura();
+}
 
-	if(not sdcard->montada())
-		throw TarjetaEx("Imagen::cargarBmp - La tarjeta SD no está montada.");
+void Imagen::decodificar(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	decodificar(ruta, CUALQUIERA);
+}
 
-	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
-	string ruta_completa = sdcard->unidad() + ":" + ruta;
+void Imagen::cargarBmp(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	decodificar(ruta, BMP);
+	crearTextura();
+}
 
-	// Comprobar la existencia del archivo
-	if(not sdcard->existe(ruta_completa))
-		throw ArchivoEx("Imagen::cargarBmp - El archivo '" + ruta + "' no existe.");
+void Imagen::decodificarBmp(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	decodificar(ruta, BMP);
+}
 
-	// Cargar el archivo en un flujo de fichero
-	ifstream archivo;
-	archivo.open(ruta_completa.c_str(), ios::binary);
+void Imagen::cargarPng(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	decodificar(ruta, PNG);
+	crearTextura();
+}
 
-	if(not archivo.good())
-		throw ArchivoEx("Imagen::cargarBmp - Error al abrir el archivo: " + ruta);
+void Imagen::decodificarPng(const string& ruta) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	decodificar(ruta, PNG);
+}
 
-	// Leer la cabecera del fichero
-	BitmapFileHeader bmfh;
-	archivo.rdbuf()->sgetn((char*)&bmfh, sizeof(BitmapFileHeader));
+void Imagen::crearTextura(void)
+{
+	if(_pixelData == NULL or _imagen != NULL)
+		return;
 
-	// Si el bfType no es este valor, entonces el archivo no contiene un BitMap
-	if(endian::swap16(bmfh.bfType) != 19778)
+	// Crear el objeto de textura y guardar en él la información de la imagen en píxeles
+	_imagen = new GXTexObj;
+	if(indexada())
 	{
-		archivo.close();
-		throw ImagenEx("Imagen::cargarBmp - El archivo no es un mapa de bits");
+		screen->crearTexturaIndexada(_imagen, _pixelData, _ancho, _alto, _formato);
+		screen->crearPaleta(&_paletas[0].tlut, _paletas[0].colores, tamPaleta());
 	}
+	else
+		screen->crearTextura(_imagen, _pixelData, _ancho, _alto, true);
 
-	// Leer la cabecera de información de la imagen
-	BitmapInfoHeader bmih;
-	archivo.rdbuf()->sgetn((char*)&bmih, sizeof(BitmapInfoHeader));
-	_ancho = (u16)endian::swap32(bmih.biWidth);
-	_alto = (u16)endian::swap32(bmih.biHeight);
-	u16 bpp = endian::swap16(bmih.biBitCount);
+	// Fijar en la zona de memoria alineada la información de la imagen, ya organizada en tiles, desde la cache
+	DCFlushRange(_pixelData, textura::tam(_formato, _ancho, _alto));
+}
 
-	if(_ancho % 8 != 0 or _alto % 8 != 0)
-	{
-		archivo.close();
-		throw ImagenEx("Imagen::cargarBmp - Las medidas de la imagen no son múltiplo de 8");
-	}
+void Imagen::recortar(const Imagen& pagina, u16 x, u16 y, u16 ancho, u16 alto) throw (ImagenEx)
+{
+	reset();
 
-	// Número de píxeles
-	u32 pixel_num = _alto * _ancho;
+	if(pagina._pagina != NULL)
+		throw ImagenEx("Imagen::recortar - No se puede recortar un recorte de otra página");
+	if(ancho == 0 or alto == 0 or x + ancho > pagina.ancho() or y + alto > pagina.alto())
+		throw ImagenEx("Imagen::recortar - El recorte se sale de la página");
 
-	// Fijar el padding a 32 bytes
-	u8 padding = (pixel_num * sizeof(s16)) % 32;
+	_pagina = &pagina;
+	_x = x;
+	_y = y;
+	_ancho = ancho;
+	_alto = alto;
+}
 
-	// Reservar la memoria necesaria para la imagen
-	// En el formato RGB5A3, cada pixel tendra 16 bits
-	_pixelData = (u16*)memalign(32, pixel_num * sizeof(u16) + padding);
+bool Imagen::dibujar(s16 x, s16 y, s16 z, u8 paleta) const
+{
+	if(_pagina != NULL)
+		return dibujarCuadro(x, y, z, 0, 0, _ancho, _alto, false, paleta);
 
-	// Si no es un BMP de 24 bits, lanzar excepción
-	if(bpp == 24)
-		cargarBmp24(archivo);
-	else
+	if(_imagen != NULL and _pixelData != NULL and z < 1000)
 	{
-		archivo.close();
-		reset();
-		throw ImagenEx("Imagen::cargarBmp - Formato de BMP no soportado (sólo 24 bits)");
+		screen->dibujarTextura(_imagen, x, y, z, _ancho, _alto, this->paleta(paleta));
+		return true;
 	}
-
-	// Fijar en la zona de memoria alineada la información de la imagen que se ha leído desde la cache
-	DCFlushRange(_pixelData, pixel_num * sizeof(u16) + padding);
-
-	// Crear el objeto de textura y guardar en él la información de la imagen en píxeles
-	_imagen = new GXTexObj;
-	screen->crearTextura(_imagen, _pixelData, _ancho, _alto);
+	return false;
 }
 
-bool Imagen::dibujar(s16 x, s16 y, s16 z) const
+bool Imagen::dibujarCuadro(s16 x, s16 y, s16 z, u16 cuadroX, u16 cuadroY, u16 cuadroAncho, u16 cuadroAlto,
+							bool invertido, u8 paleta) const
 {
+	// Un recorte dibuja el cuadro correspondiente de su página
+	if(_pagina != NULL)
+		return _pagina->dibujarCuadro(x, y, z, _x + cuadroX, _y + cuadroY, cuadroAncho, cuadroAlto, invertido, paleta);
+
 	if(_imagen != NULL and _pixelData != NULL and z < 1000)
 	{
-		screen->dibujarTextura(_imagen, x, y, z, _ancho, _alto);
+		screen->dibujarCuadro(_imagen, _ancho, _alto, x, y, z, cuadroX, cuadroY, cuadroAncho, cuadroAlto, invertido,
+								this->paleta(paleta));
 		return true;
 	}
 	return false;
@@ -123,73 +141,312 @@ u16 Imagen::alto(void) const
 
 GXTexObj* Imagen::textura(void) const
 {
+	if(_pagina != NULL)
+		return _pagina->textura();
 	return _imagen;
 }
 
-Imagen::~Imagen(void)
+bool Imagen::indexada(void) const
 {
-	reset();
+	if(_pagina != NULL)
+		return _pagina->indexada();
+	return (not _paletas.empty());
 }
 
-// Métodos privados
-void Imagen::cargarBmp24(ifstream & archivo)
+u16 Imagen::colores(void) const
 {
-	// Desplazamiento: una imagen BMP tendrá desplazamiento en cada fila de 
-	// píxeles si el tamaño de ésta no es múltiplo de 4 (en bytes)
-	u8 offset = _ancho % 4;
+	if(_pagina != NULL)
+		return _pagina->colores();
+	return _colores;
+}
 
-	// La posición de cada pixel se tiene que calcular antes de insertarlo en la memoria alineada,
-	// ya que un BMP hay que leerlo de abajo a arriba y de izquierda a derecha
-	u32 pixel_count = 0;
-	u32 pixel_num = _alto * _ancho;
-	u32 y = _alto - 1;
-	u32 x = 0;
+const Imagen* Imagen::pagina(void) const
+{
+	return _pagina;
+}
 
-	// Variables para almacenar los distintos componentes de color de cada pixel de la imagen
-	u8 b = 0;
-	u8 g = 0;
-	u8 r = 0;
+GXTlutObj* Imagen::paleta(u8 paleta) const
+{
+	if(_pagina != NULL)
+		return _pagina->paleta(paleta);
+	if(paleta >= _paletas.size())
+		return NULL;
+	return &_paletas[paleta].tlut;
+}
 
-	while(pixel_count < pixel_num)
+u8 Imagen::variante(const string& cambios) const throw (ImagenEx)
+{
+	// Las variantes de un recorte son las de su página
+	if(_pagina != NULL)
+		return _pagina->variante(cambios);
+
+	if(not indexada() or cambios == "")
+		return 0;
+
+	for(u32 i = 0 ; i < _paletas.size() ; ++i)
+		if(_paletas[i].cambios == cambios)
+			return i;
+
+	if(_paletas.size() > 255)
+		throw ImagenEx("Imagen::variante - No se pueden crear más variantes de la paleta");
+
+	// La variante parte de la paleta original
+	u32 tam = tamPaleta() * sizeof(u16);
+	u16* colores = (u16*)memoria::reservar(tam, memoria::TEXTURAS);
+	if(colores == NULL)
+		throw ImagenEx("Imagen::variante - No hay memoria para la paleta");
+	memcpy(colores, _paletas[0].colores, tam);
+
+	// Cada cambio tiene la forma RRGGBBAA:RRGGBBAA
+	string::size_type inicio = 0;
+	while(inicio < cambios.length())
 	{
-		// Leer la información de un pixel (un BMP tiene la ordenación de color
-		// BGR en lugar de lo común RGB)
-		archivo.rdbuf()->sgetn((char*)&b, sizeof(u8));
-		archivo.rdbuf()->sgetn((char*)&g, sizeof(u8));
-		archivo.rdbuf()->sgetn((char*)&r, sizeof(u8));
-
-		// Procesar el pixel y almacenarlo en la memoria alineada
-		// Si el pixel es del color alpha, se toman sólo los 4 bits de mayor peso de cada color, y se establecen
-		// 4 bits de alpha con valor 0 (invisible)
-		// Si el pixel no es del color alpha, se toman los 5 bits de mayor peso de cada color, y se establece un
-		// bit de alpha con valor 1 (visible)
-		if(r == pixel::rojo(Imagen::alpha) and g == pixel::verde(Imagen::alpha) and b == pixel::azul(Imagen::alpha))
-			_pixelData[_ancho * y + x] = (b>>4) | ((g>>4)<<4) | ((r>>4)<<8) | (0<<13);
-		else
-			_pixelData[_ancho * y + x] = (b>>3) | ((g>>3)<<5) | ((r>>3)<<10) | (1<<15);
-		pixel_count++;
-		x++;
-
-		// Al final de cada fila de pixeles (en el BMP), puede haber desplazamiento (ya que el número de bytes de una
-		// fila debe ser múltiplo de 4 bytes). Estas instrucciones son para saltar dicho desplazamiento.
-		if(pixel_count % _ancho == 0)
+		string::size_type fin = cambios.find(',', inicio);
+		if(fin == string::npos)
+			fin = cambios.length();
+		string cambio = cambios.substr(inicio, fin - inicio);
+		string::size_type separador = cambio.find(':');
+		if(separador == string::npos)
 		{
-			x = 0;
-			y--;
-			for(u8 j = 0 ; j < offset ; ++j)
-				if(archivo.rdbuf()->in_avail() > 0)
-					archivo.rdbuf()->sgetn(NULL, sizeof(u8));
+			memoria::liberar(colores);
+			throw ImagenEx("Imagen::variante - Cambio de color incorrecto: '" + cambio + "'");
 		}
+
+		u32 original = strtoul(cambio.substr(0, separador).c_str(), NULL, 16);
+		u32 nuevo = strtoul(cambio.substr(separador + 1).c_str(), NULL, 16);
+		u16 o = bmp::rgb5a3(original >> 24, original >> 16, original >> 8, original);
+		u16 n = bmp::rgb5a3(nuevo >> 24, nuevo >> 16, nuevo >> 8, nuevo);
+		for(u16 i = 0 ; i < _colores ; ++i)
+			if(_paletas[0].colores[i] == o)
+				colores[i] = n;
+
+		inicio = fin + 1;
 	}
+
+	Paleta p;
+	p.cambios = cambios;
+	p.colores = colores;
+	screen->crearPaleta(&p.tlut, colores, tamPaleta());
+	_paletas.push_back(p);
+	return _paletas.size() - 1;
+}
+
+const Mascara& Imagen::mascara(void) const
+{
+	if(_mascara == NULL)
+	{
+		_mascara = new Mascara;
+		if(_pagina != NULL)
+			_mascara->crear(_pagina->_pixelData, _pagina->_formato,
+							_pagina->indexada() ? _pagina->_paletas[0].colores : NULL, _pagina->_ancho, _x, _y, _ancho,
+							_alto);
+		else
+			_mascara->crear(_pixelData, _formato, indexada() ? _paletas[0].colores : NULL, _ancho, 0, 0, _ancho, _alto);
+	}
+	return *_mascara;
+}
+
+u32 Imagen::bytes(void) const
+{
+	u32 mascara = (_mascara != NULL) ? _mascara->bytes() : 0;
+	if(_pixelData == NULL)
+		return mascara;
+	return textura::tam(_formato, _ancho, _alto) + _paletas.size() * tamPaleta() * sizeof(u16) + sizeof(GXTexObj)
+			+ mascara;
 }
 
+Imagen::~Imagen(void)
+{
+	reset();
+}
+
+// Métodos privados
 void Imagen::reset(void)
 {
 	delete _imagen;
-	free(_pixelData);
+	delete _mascara;
+
+	// La textura y la paleta original de una textura cocinada forman parte del propio archivo
+	if(_cocinada != NULL)
+		memoria::liberar(_cocinada);
+	else
+		memoria::liberar(_pixelData);
+	for(u32 i = (_cocinada != NULL) ? 1 : 0 ; i < _paletas.size() ; ++i)
+		memoria::liberar(_paletas[i].colores);
+	_paletas.clear();
 	_imagen = NULL;
 	_pixelData = NULL;
+	_cocinada = NULL;
+	_pagina = NULL;
+	_mascara = NULL;
+	_x = 0;
+	_y = 0;
+	_formato = textura::RGB5A3;
+	_colores = 0;
 	_alto = 0;
 	_ancho = 0;
 }
 
+void Imagen::decodificar(const string& ruta, Fichero fichero) throw (ArchivoEx, ImagenEx, TarjetaEx)
+{
+	reset();
+
+	if(not sdcard->montada())
+		throw TarjetaEx("Imagen::decodificar - La tarjeta SD no está montada.");
+
+	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
+	string ruta_completa = sdcard->unidad() + ":" + ruta;
+
+	// Leer el archivo completo de una sola vez (del paquete montado, si lo contiene)
+	u32 tam = 0;
+	u8* datos = sdcard->leer(ruta_completa, tam, memoria::TEXTURAS);
+
+	try {
+		// El formato se reconoce por la firma del archivo
+		bool es_bmp = (tam >= 2 and datos[0] == 'B' and datos[1] == 'M');
+		bool es_png = png::esPng(datos, tam);
+		textura::Cabecera cabecera;
+		bool es_cocinada = (fichero == CUALQUIERA and textura::leerCabecera(datos, tam, cabecera));
+
+		if(es_cocinada)
+		{
+			// La textura cocinada se utiliza tal cual, sin copiarla ni liberar el archivo
+			usarCocinada(datos, cabecera);
+			return;
+		}
+		else if(es_bmp and fichero != PNG)
+			decodificarBmp(datos, tam);
+		else if(es_png and fichero != BMP)
+			decodificarPng(datos, tam);
+		else if(fichero == BMP)
+			throw ImagenEx("Imagen::cargarBmp - El archivo no es un mapa de bits");
+		else if(fichero == PNG)
+			throw ImagenEx("Imagen::cargarPng - El archivo no es una imagen PNG");
+		else
+			throw ImagenEx("Imagen::cargar - Formato de imagen no soportado: " + ruta);
+
+		if(Imagen::indexar)
+			convertirIndexada();
+	} catch(...) {
+		memoria::liberar(datos);
+		reset();
+		throw;
+	}
+
+	memoria::liberar(datos);
+}
+
+void Imagen::decodificarBmp(const u8* datos, u32 tam) throw (ImagenEx)
+{
+	// Leer las cabeceras del fichero y de la imagen
+	bmp::Info info;
+	if(not bmp::leerCabecera(datos, tam, info))
+		throw ImagenEx("Imagen::cargarBmp - Formato de BMP no soportado (sólo 8, 24 o 32 bits sin comprimir), "
+						"o archivo incompleto");
+
+	if(info.ancho % 8 != 0 or info.alto % 8 != 0)
+		throw ImagenEx("Imagen::cargarBmp - Las medidas de la imagen no son múltiplo de 8");
+
+	_ancho = info.ancho;
+	_alto = info.alto;
+
+	// Reservar la memoria necesaria para la imagen
+	// En el formato RGB5A3, cada pixel tendra 16 bits; al ser las medidas múltiplo de 8, el tamaño ya es
+	// múltiplo de 32 bytes
+	_pixelData = memoria::reservar(bmp::tamTextura(info), memoria::TEXTURAS);
+	if(_pixelData == NULL)
+		throw ImagenEx("Imagen::cargarBmp - No hay memoria para la imagen");
+
+	// Decodificar los píxeles directamente en tiles de 4x4
+	bmp::decodificar(datos, info, Imagen::alpha, (u16*)_pixelData);
+}
+
+void Imagen::decodificarPng(const u8* datos, u32 tam) throw (ImagenEx)
+{
+	png::Info info;
+	if(not png::leerCabecera(datos, tam, info))
+		throw ImagenEx("Imagen::cargarPng - Formato de PNG no soportado (entrelazado), o archivo incompleto");
+
+	if(info.ancho % 8 != 0 or info.alto % 8 != 0)
+		throw ImagenEx("Imagen::cargarPng - Las medidas de la imagen no son múltiplo de 8");
+
+	_ancho = info.ancho;
+	_alto = info.alto;
+
+	_pixelData = memoria::reservar(png::tamTextura(info), memoria::TEXTURAS);
+	if(_pixelData == NULL)
+		throw ImagenEx("Imagen::cargarPng - No hay memoria para la imagen");
+
+	// Descomprimir fila a fila, decodificando los píxeles directamente en tiles de 4x4
+	if(not png::decodificar(datos, info, Imagen::alpha, (u16*)_pixelData))
+		throw ImagenEx("Imagen::cargarPng - Los datos comprimidos de la imagen son incorrectos");
+}
+
+void Imagen::convertirIndexada(void)
+{
+	u8* indices = (u8*)memoria::reservar(_ancho * _alto, memoria::TEXTURAS);
+	if(indices == NULL)
+		return;
+
+	// Con más de 256 colores, la imagen se queda como está
+	u16 paleta[256];
+	u32 colores = textura::indexar((const u16*)_pixelData, _ancho, _alto, indices, paleta);
+	if(colores == 0)
+	{
+		memoria::liberar(indices);
+		return;
+	}
+
+	textura::Formato formato = (colores <= 16) ? textura::CI4 : textura::CI8;
+	u16 tam_paleta = textura::entradasPaleta(formato);
+	void* texels_indices = memoria::reservar(textura::tam(formato, _ancho, _alto), memoria::TEXTURAS);
+	u16* colores_paleta = (u16*)memoria::reservar(tam_paleta * sizeof(u16), memoria::TEXTURAS);
+	if(texels_indices == NULL or colores_paleta == NULL)
+	{
+		memoria::liberar(texels_indices);
+		memoria::liberar(colores_paleta);
+		memoria::liberar(indices);
+		return;
+	}
+
+	textura::codificarIndices(indices, _ancho, _alto, formato, texels_indices);
+	memoria::liberar(indices);
+	memset(colores_paleta, 0, tam_paleta * sizeof(u16));
+	memcpy(colores_paleta, paleta, colores * sizeof(u16));
+
+	// La textura RGB5A3 se sustituye por la de índices
+	memoria::liberar(_pixelData);
+	_pixelData = texels_indices;
+	_formato = formato;
+	_colores = colores;
+
+	Paleta p;
+	p.colores = colores_paleta;
+	_paletas.push_back(p);
+}
+
+void Imagen::usarCocinada(u8* datos, const textura::Cabecera& cabecera) throw (ImagenEx)
+{
+	if(cabecera.formato != textura::RGB5A3 and cabecera.formato != textura::CI4 and cabecera.formato != textura::CI8)
+		throw ImagenEx("Imagen::cargar - Formato de textura cocinada no soportado");
+
+	_cocinada = datos;
+	_pixelData = datos + textura::TAM_CABECERA;
+	_formato = (textura::Formato)cabecera.formato;
+	_ancho = cabecera.ancho;
+	_alto = cabecera.alto;
+
+	// La paleta está en big endian, que es el orden de la consola
+	if(cabecera.colores > 0)
+	{
+		Paleta p;
+		p.colores = (u16*)(datos + cabecera.paleta);
+		_paletas.push_back(p);
+		_colores = cabecera.colores;
+	}
+}
+
+u16 Imagen::tamPaleta(void) const
+{
+	return textura::entradasPaleta(_formato);
+}
@@ -0,0 +1,466 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "inflador.h"
+
+namespace
+{
+	const u32 TAM_VENTANA = 32768;
+	const u32 MASCARA_VENTANA = TAM_VENTANA - 1;
+
+	// Bytes que se pueden sumar antes de reducir módulo 65521 sin desbordar los 32 bits de la suma Adler-32
+	const u32 MODULO_ADLER = 65521;
+	const u32 MAX_SIN_REDUCIR = 5552;
+
+	// Longitudes y distancias base de los símbolos de copia, y sus bits extra
+	const u16 BASE_LONGITUD[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99,
+									115, 131, 163, 195, 227, 258 };
+	const u8 EXTRA_LONGITUD[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5,
+									0 };
+	const u16 BASE_DISTANCIA[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+									1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const u8 EXTRA_DISTANCIA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+									12, 12, 13, 13 };
+
+	// Orden en el que se transmiten las longitudes del código de longitudes
+	const u8 ORDEN_LONGITUDES[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+}
+
+Inflador::Inflador(const u8* datos, u32 tam, bool zlib, memoria::Etiqueta etiqueta):
+	_fuente(NULL), _contexto(NULL), _pos(datos), _fin(datos + tam)
+{
+	iniciar(zlib, etiqueta);
+}
+
+Inflador::Inflador(Fuente fuente, void* contexto, bool zlib, memoria::Etiqueta etiqueta):
+	_fuente(fuente), _contexto(contexto), _pos(NULL), _fin(NULL)
+{
+	iniciar(zlib, etiqueta);
+}
+
+Inflador::~Inflador(void)
+{
+	memoria::liberar(_ventana);
+}
+
+u32 Inflador::leer(u8* destino, u32 tam)
+{
+	u32 escritos = 0;
+
+	while(escritos < tam)
+	{
+		switch(_fase)
+		{
+			case CABECERA:
+				_fase = leerCabecera() ? BLOQUE : FALLO;
+				break;
+
+			case BLOQUE:
+				if(_ultimo)
+					_fase = COLA;
+				else if(not leerBloque())
+					_fase = FALLO;
+				break;
+
+			case ALMACENADO:
+			{
+				u8 b;
+				while(_pendiente > 0 and escritos < tam)
+				{
+					if(not byte(b))
+						return escritos;
+					emitir(b, destino, escritos);
+					--_pendiente;
+				}
+				if(_pendiente == 0)
+					_fase = BLOQUE;
+				break;
+			}
+
+			case COMPRIMIDO:
+			{
+				// Primero, lo que quedara de la última copia
+				for( ; _pendiente > 0 and escritos < tam ; --_pendiente)
+					emitir(_ventana[(_posicion - _distancia) & MASCARA_VENTANA], destino, escritos);
+				if(escritos == tam)
+					break;
+
+				s32 s = simbolo(_literales);
+				if(s < 0)
+					_fase = FALLO;
+				else if(s < 256)
+					emitir((u8)s, destino, escritos);
+				else if(s == 256)
+					_fase = BLOQUE;
+				else
+				{
+					s -= 257;
+					if(s >= 29)
+					{
+						_fase = FALLO;
+						break;
+					}
+					u32 longitud = BASE_LONGITUD[s] + bits(EXTRA_LONGITUD[s]);
+
+					s32 d = simbolo(_distancias);
+					if(d < 0 or d >= 30)
+					{
+						_fase = FALLO;
+						break;
+					}
+					u32 distancia = BASE_DISTANCIA[d] + bits(EXTRA_DISTANCIA[d]);
+
+					// La copia no puede empezar antes del comienzo de los datos
+					if(_fase == FALLO or distancia > _total or distancia > TAM_VENTANA)
+					{
+						_fase = FALLO;
+						break;
+					}
+					_pendiente = longitud;
+					_distancia = distancia;
+				}
+				break;
+			}
+
+			case COLA:
+				_fase = leerCola() ? FIN : FALLO;
+				break;
+
+			case FIN:
+			case FALLO:
+				return escritos;
+		}
+	}
+
+	return escritos;
+}
+
+bool Inflador::terminar(void)
+{
+	u8 b;
+	if(leer(&b, 1) != 0)
+		return false;
+	return terminado();
+}
+
+bool Inflador::terminado(void) const
+{
+	return (_fase == FIN);
+}
+
+bool Inflador::error(void) const
+{
+	return (_fase == FALLO);
+}
+
+// Métodos privados
+void Inflador::iniciar(bool zlib, memoria::Etiqueta etiqueta)
+{
+	_bits = 0;
+	_num_bits = 0;
+	_zlib = zlib;
+	_ultimo = false;
+	_pendiente = 0;
+	_distancia = 0;
+	_posicion = 0;
+	_total = 0;
+	_s1 = 1;
+	_s2 = 0;
+	_sin_reducir = 0;
+
+	_ventana = (u8*)memoria::reservar(TAM_VENTANA, etiqueta);
+	if(_ventana == NULL)
+		_fase = FALLO;
+	else
+		_fase = zlib ? CABECERA : BLOQUE;
+}
+
+bool Inflador::rellenar(u32 n)
+{
+	while(_num_bits < n)
+	{
+		// Al agotar un trozo, se pide el siguiente (que puede estar vacío)
+		while(_pos == _fin)
+		{
+			u32 tam = 0;
+			if(_fuente == NULL or not _fuente(_contexto, _pos, tam))
+			{
+				_pos = _fin = NULL;
+				return false;
+			}
+			_fin = _pos + tam;
+		}
+		_bits |= (u32)*_pos++ << _num_bits;
+		_num_bits += 8;
+	}
+	return true;
+}
+
+u32 Inflador::bits(u32 n)
+{
+	if(n == 0)
+		return 0;
+	if(not rellenar(n))
+	{
+		_fase = FALLO;
+		return 0;
+	}
+	u32 valor = _bits & ((1u << n) - 1);
+	_bits >>= n;
+	_num_bits -= n;
+	return valor;
+}
+
+bool Inflador::byte(u8& b)
+{
+	b = (u8)bits(8);
+	return (_fase != FALLO);
+}
+
+s32 Inflador::simbolo(const Huffman& h)
+{
+	// Camino rápido: el código cabe en la tabla, y hay bits suficientes para consultarla
+	rellenar(BITS_RAPIDA);
+	if(_num_bits >= BITS_RAPIDA)
+	{
+		u16 entrada = h.rapida[_bits & ((1 << BITS_RAPIDA) - 1)];
+		if(entrada != 0)
+		{
+			_bits >>= (entrada & 15);
+			_num_bits -= (entrada & 15);
+			return entrada >> 4;
+		}
+	}
+
+	// Camino lento: decodificación canónica, bit a bit
+	s32 codigo = 0;
+	s32 primero = 0;
+	s32 indice = 0;
+	for(u32 longitud = 1 ; longitud < 16 ; ++longitud)
+	{
+		if(not rellenar(1))
+			return -1;
+		codigo |= _bits & 1;
+		_bits >>= 1;
+		_num_bits--;
+
+		s32 cuenta = h.cuenta[longitud];
+		if(codigo - cuenta < primero)
+			return h.simbolos[indice + (codigo - primero)];
+		indice += cuenta;
+		primero += cuenta;
+		primero <<= 1;
+		codigo <<= 1;
+	}
+	return -1;
+}
+
+bool Inflador::construir(Huffman& h, const u8* longitudes, u32 n)
+{
+	memset(h.cuenta, 0, sizeof(h.cuenta));
+	memset(h.rapida, 0, sizeof(h.rapida));
+	for(u32 i = 0 ; i < n ; ++i)
+		h.cuenta[longitudes[i]]++;
+	h.cuenta[0] = 0;
+
+	// Un código con más combinaciones de las posibles no es válido
+	s32 libres = 1;
+	for(u32 l = 1 ; l < 16 ; ++l)
+	{
+		libres = (libres << 1) - h.cuenta[l];
+		if(libres < 0)
+			return false;
+	}
+
+	// Símbolos ordenados por longitud y, dentro de cada longitud, por valor; primer código de cada longitud
+	u16 posicion[16];
+	u16 codigo[16];
+	posicion[1] = 0;
+	codigo[1] = 0;
+	for(u32 l = 1 ; l < 15 ; ++l)
+	{
+		posicion[l + 1] = posicion[l] + h.cuenta[l];
+		codigo[l + 1] = (codigo[l] + h.cuenta[l]) << 1;
+	}
+
+	for(u32 s = 0 ; s < n ; ++s)
+	{
+		u32 l = longitudes[s];
+		if(l == 0)
+			continue;
+		h.simbolos[posicion[l]++] = s;
+
+		// Los códigos cortos ocupan todas las entradas de la tabla que comienzan por ellos (al revés, porque
+		// Deflate los transmite empezando por el bit de mayor peso)
+		u32 c = codigo[l]++;
+		if(l <= BITS_RAPIDA)
+		{
+			u32 invertido = 0;
+			for(u32 i = 0 ; i < l ; ++i)
+				invertido |= ((c >> i) & 1) << (l - 1 - i);
+			for(u32 j = invertido ; j < (1u << BITS_RAPIDA) ; j += (1u << l))
+				h.rapida[j] = (s << 4) | l;
+		}
+	}
+	return true;
+}
+
+bool Inflador::leerCabecera(void)
+{
+	// Método de compresión Deflate, ventana de hasta 32 KB, múltiplo de 31 y sin diccionario predefinido
+	u32 cmf = bits(8);
+	u32 flg = bits(8);
+	return (_fase != FALLO and (cmf & 0x0F) == 8 and (cmf >> 4) <= 7 and ((cmf << 8) | flg) % 31 == 0
+			and (flg & 0x20) == 0);
+}
+
+bool Inflador::leerBloque(void)
+{
+	_ultimo = (bits(1) == 1);
+	u32 tipo = bits(2);
+	if(_fase == FALLO)
+		return false;
+
+	switch(tipo)
+	{
+		case 0:
+		{
+			// Bloque sin comprimir: se descartan los bits hasta el siguiente byte, y después longitud y complemento
+			bits(_num_bits & 7);
+			u32 longitud = bits(16);
+			u32 complemento = bits(16);
+			if(_fase == FALLO or (longitud ^ 0xFFFF) != complemento)
+				return false;
+			_pendiente = longitud;
+			_fase = ALMACENADO;
+			return true;
+		}
+		case 1:
+		{
+			// Códigos fijos
+			u8 longitudes[288 + 30];
+			memset(longitudes, 8, 144);
+			memset(longitudes + 144, 9, 112);
+			memset(longitudes + 256, 7, 24);
+			memset(longitudes + 280, 8, 8);
+			memset(longitudes + 288, 5, 30);
+			construir(_literales, longitudes, 288);
+			construir(_distancias, longitudes + 288, 30);
+			_fase = COMPRIMIDO;
+			return true;
+		}
+		case 2:
+			if(not leerCodigos())
+				return false;
+			_fase = COMPRIMIDO;
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool Inflador::leerCodigos(void)
+{
+	u32 num_literales = bits(5) + 257;
+	u32 num_distancias = bits(5) + 1;
+	u32 num_longitudes = bits(4) + 4;
+	if(_fase == FALLO or num_literales > 286 or num_distancias > 30)
+		return false;
+
+	// Código de las longitudes
+	u8 longitudes[288 + 32];
+	memset(longitudes, 0, 19);
+	for(u32 i = 0 ; i < num_longitudes ; ++i)
+		longitudes[ORDEN_LONGITUDES[i]] = bits(3);
+	if(_fase == FALLO or not construir(_distancias, longitudes, 19))
+		return false;
+
+	// Longitudes de los códigos de literales y distancias, seguidas
+	u32 total = num_literales + num_distancias;
+	u32 i = 0;
+	while(i < total)
+	{
+		s32 s = simbolo(_distancias);
+		if(s < 0)
+			return false;
+		if(s < 16)
+		{
+			longitudes[i++] = s;
+			continue;
+		}
+
+		u8 valor = 0;
+		u32 repeticiones;
+		if(s == 16)
+		{
+			if(i == 0)
+				return false;
+			valor = longitudes[i - 1];
+			repeticiones = 3 + bits(2);
+		}
+		else if(s == 17)
+			repeticiones = 3 + bits(3);
+		else
+			repeticiones = 11 + bits(7);
+
+		if(_fase == FALLO or i + repeticiones > total)
+			return false;
+		while(repeticiones-- > 0)
+			longitudes[i++] = valor;
+	}
+
+	// El bloque tiene que poder terminar
+	if(longitudes[256] == 0)
+		return false;
+
+	return construir(_literales, longitudes, num_literales)
+			and construir(_distancias, longitudes + num_literales, num_distancias);
+}
+
+bool Inflador::leerCola(void)
+{
+	if(not _zlib)
+		return true;
+
+	// La suma Adler-32 comienza en el siguiente byte, en big endian
+	bits(_num_bits & 7);
+	u32 adler = 0;
+	for(u32 i = 0 ; i < 4 ; ++i)
+		adler = (adler << 8) | bits(8);
+
+	_s1 %= MODULO_ADLER;
+	_s2 %= MODULO_ADLER;
+	return (_fase != FALLO and adler == ((_s2 << 16) | _s1));
+}
+
+void Inflador::emitir(u8 b, u8* destino, u32& escritos)
+{
+	destino[escritos++] = b;
+	_ventana[_posicion++ & MASCARA_VENTANA] = b;
+	if(_total < TAM_VENTANA)
+		_total++;
+
+	_s1 += b;
+	_s2 += _s1;
+	if(++_sin_reducir == MAX_SIN_REDUCIR)
+	{
+		_s1 %= MODULO_ADLER;
+		_s2 %= MODULO_ADLER;
+		_sin_reducir = 0;
+	}
+}
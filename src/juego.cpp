@@ -58,6 +58,17 @@ Juego::Juego(const string& ruta)
 		stringstream convert(color_alpha);
 		convert >> std::hex >> Imagen::alpha;
 		_fps = parser->atributoU32("valor", parser->buscar("fps"));
+		screen->setFps(_fps);
+		screen->setLatencia(parser->atributoU32("latencia", parser->buscar("fps")));
+
+		// El perfilador de frames es opcional, y por defecto está desactivado
+		TiXmlElement* nodo_perfil = parser->buscar("perfil");
+		perfilador->setActivo(parser->atributoU32("activo", nodo_perfil) != 0);
+		perfilador->setVisible(parser->atributoU32("visible", nodo_perfil) != 0);
+
+		// Las peticiones de un mismo efecto de sonido dentro de un frame se fusionan en una sola
+		if(_fps > 0)
+			mezclador->setVentana(1000000 / _fps);
 
 		// Cargar los controles de los jugadores
 		TiXmlElement* nodo_jugadores = parser->buscar("jugadores");
@@ -79,6 +90,11 @@ Juego::Juego(const string& ruta)
 		string ruta_lang = parser->atributo("valor", nodo_lang);
 		wstring defecto_lang = utf32::convertir(parser->atributo("defecto", nodo_lang));
 
+		// Montar el paquete de recursos, si se ha indicado alguno; desde aquí, los recursos se leen de él
+		string ruta_paquete = parser->atributo("valor", parser->buscar("paquete"));
+		if(ruta_paquete != "")
+			sdcard->montarPaquete(ruta_paquete);
+
 		// Cargar la biblioteca de medias
 		galeria->inicializar(parser->atributo("valor", parser->buscar("galeria")));
 
@@ -96,6 +112,19 @@ Juego::~Juego(void)
 	for(Controles::iterator i = _mandos.begin() ; i != _mandos.end() ; ++i)
 		delete i->second;
 	_mandos.clear();
+
+	// Dejar en el log la memoria que sigue ocupada al salir, y el máximo que ha llegado a ocupar cada subsistema
+	memoria::informe();
+
+	// Y la duración de los frames, para saber si el juego ha mantenido el ritmo
+	const Ritmo& r = screen->ritmo();
+	stringstream texto;
+	texto << "Juego - " << r.frames() << " frames, duración media " << r.medio() << " us (mínima " << r.minimo()
+		<< " us, máxima " << r.maximo() << " us), " << r.perdidos() << " frames perdidos";
+	logger->info(texto.str());
+
+	// Y el trabajo que ha costado cada frame al procesador gráfico
+	screen->informe();
 	exit(0);
 }
 
@@ -107,24 +136,40 @@ void Juego::run(void)
 
 		// Variables para el control del bucle principal del juego
 		bool salir = false;
-		tiempo::tick = 0;
 
 		// Bucle principal del juego
 		while(not salir) 
 		{
+			perfilador->nuevoFrame();
+
 			// Leer la información de todos los mandos y actualizarlos
-			Mando::leerDatos();
-			for(Controles::iterator i = _mandos.begin() ; i != _mandos.end() ; ++i)
-				i->second->actualizar();
+			{
+				Perfilador::Zona zona("mandos");
+				Mando::leerDatos();
+				for(Controles::iterator i = _mandos.begin() ; i != _mandos.end() ; ++i)
+					i->second->actualizar();
+			}
+
+			// Completar las cargas que el hilo de carga haya terminado desde el frame anterior
+			{
+				Perfilador::Zona zona("cargador");
+				cargador->actualizar();
+			}
 
 			// Gestionar un frame
-			salir = frame();
-
-			// Esperar la sincronizacion de video
-			screen->flip();
-
-			// Control de tiempo: para mantener el framerate constante
-			tiempo::controlarFps(_fps);
+			{
+				Perfilador::Zona zona("frame");
+				salir = frame();
+			}
+
+			// La gráfica del perfilador, si está visible, queda por encima de todo lo demás
+			perfilador->dibujar();
+
+			// Esperar la sincronizacion de video, manteniendo el framerate constante
+			{
+				Perfilador::Zona zona("flip");
+				screen->flip();
+			}
 		}
 
 	} catch(const std::exception& e) {
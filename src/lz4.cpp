@@ -0,0 +1,280 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "lz4.h"
+using namespace std;
+
+namespace
+{
+	// Restricciones del formato de bloque de LZ4: una copia tiene al menos 4 bytes, los 5 últimos bytes de un bloque
+	// son siempre literales, y la última copia comienza al menos 12 bytes antes del final del bloque
+	const u32 LONGITUD_MINIMA = 4;
+	const u32 ULTIMOS_LITERALES = 5;
+	const u32 LIMITE_COPIA = 12;
+	const u32 DISTANCIA_MAXIMA = 65535;
+
+	// Tabla de posiciones del compresor, indexada por el hash de 4 bytes
+	const u32 BITS_HASH = 14;
+	const u32 NINGUNA = 0xFFFFFFFF;
+
+	u32 secuencia(const u8* p)
+	{
+		return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+	}
+
+	u32 hashSecuencia(u32 s)
+	{
+		return (s * 2654435761u) >> (32 - BITS_HASH);
+	}
+
+	void escribir32(vector<u8>& v, u32 x)
+	{
+		v.push_back((u8)(x >> 24));
+		v.push_back((u8)(x >> 16));
+		v.push_back((u8)(x >> 8));
+		v.push_back((u8)x);
+	}
+
+	void escribirLongitud(vector<u8>& v, u32 l)
+	{
+		for( ; l >= 255 ; l -= 255)
+			v.push_back(255);
+		v.push_back((u8)l);
+	}
+
+	bool leerLongitud(const u8*& p, const u8* fin, u32& l)
+	{
+		u8 b = 255;
+		while(b == 255)
+		{
+			if(p >= fin)
+				return false;
+			b = *p++;
+			l += b;
+		}
+		return true;
+	}
+
+	void escribirSecuencia(const u8* literales, u32 num_literales, u32 distancia, u32 longitud, vector<u8>& salida)
+	{
+		u32 posicion = salida.size();
+		salida.push_back(0);
+
+		u8 token = (num_literales >= 15 ? 15 : num_literales) << 4;
+		if(num_literales >= 15)
+			escribirLongitud(salida, num_literales - 15);
+		salida.insert(salida.end(), literales, literales + num_literales);
+
+		// La última secuencia de un bloque sólo tiene literales
+		if(longitud > 0)
+		{
+			salida.push_back((u8)distancia);
+			salida.push_back((u8)(distancia >> 8));
+			u32 resto = longitud - LONGITUD_MINIMA;
+			token |= (resto >= 15 ? 15 : resto);
+			if(resto >= 15)
+				escribirLongitud(salida, resto - 15);
+		}
+		salida[posicion] = token;
+	}
+
+	// Comprime los datos entre inicio y fin; la tabla conserva las posiciones de los bloques anteriores, así que las
+	// copias pueden hacer referencia a ellos
+	void comprimirBloque(const u8* datos, u32 inicio, u32 fin, vector<u32>& tabla, vector<u8>& salida)
+	{
+		u32 ancla = inicio;
+
+		if(fin - inicio > LIMITE_COPIA)
+		{
+			u32 limite = fin - LIMITE_COPIA;
+			u32 i = inicio;
+			u32 fallos = 0;
+
+			while(i < limite)
+			{
+				u32 s = secuencia(datos + i);
+				u32 h = hashSecuencia(s);
+				u32 candidato = tabla[h];
+				tabla[h] = i;
+
+				if(candidato == NINGUNA or i - candidato > DISTANCIA_MAXIMA or secuencia(datos + candidato) != s)
+				{
+					// En zonas que no se comprimen, se avanza cada vez más deprisa
+					i += 1 + (fallos++ >> 6);
+					continue;
+				}
+				fallos = 0;
+
+				// Alargar la copia hacia delante, respetando los últimos literales del bloque
+				u32 longitud = LONGITUD_MINIMA;
+				u32 maximo = fin - ULTIMOS_LITERALES - i;
+				while(longitud < maximo and datos[candidato + longitud] == datos[i + longitud])
+					++longitud;
+
+				// Y hacia atrás, mientras queden literales pendientes
+				while(i > ancla and candidato > 0 and datos[i - 1] == datos[candidato - 1])
+				{
+					--i;
+					--candidato;
+					++longitud;
+				}
+
+				escribirSecuencia(datos + ancla, i - ancla, i - candidato, longitud, salida);
+				i += longitud;
+				ancla = i;
+
+				// Registrar una posición dentro de la copia mejora la compresión a cambio de muy poco tiempo
+				if(i - 2 >= inicio and i + 2 <= fin)
+					tabla[hashSecuencia(secuencia(datos + i - 2))] = i - 2;
+			}
+		}
+
+		escribirSecuencia(datos + ancla, fin - ancla, 0, 0, salida);
+	}
+}
+
+u32 lz4::cotaBloque(u32 tam)
+{
+	return tam + tam / 255 + 16;
+}
+
+void lz4::comprimir(const u8* datos, u32 tam, vector<u8>& salida)
+{
+	vector<u32> tabla(1 << BITS_HASH, NINGUNA);
+	vector<u8> bloque;
+	bloque.reserve(cotaBloque(TAM_BLOQUE));
+
+	for(u32 inicio = 0 ; inicio < tam ; inicio += TAM_BLOQUE)
+	{
+		u32 fin = (tam - inicio > TAM_BLOQUE) ? inicio + TAM_BLOQUE : tam;
+		bloque.clear();
+		comprimirBloque(datos, inicio, fin, tabla, bloque);
+
+		// Si el bloque no se reduce, se guarda tal cual
+		if(bloque.size() >= fin - inicio)
+		{
+			escribir32(salida, (fin - inicio) | SIN_COMPRIMIR);
+			salida.insert(salida.end(), datos + inicio, datos + fin);
+		}
+		else
+		{
+			escribir32(salida, bloque.size());
+			salida.insert(salida.end(), bloque.begin(), bloque.end());
+		}
+	}
+}
+
+bool lz4::descomprimirBloque(const u8* bloque, u32 tam, const u8* inicio, u8* destino, u32 tam_destino)
+{
+	if(tam & SIN_COMPRIMIR)
+	{
+		if(bytesBloque(tam) != tam_destino)
+			return false;
+		memcpy(destino, bloque, tam_destino);
+		return true;
+	}
+
+	const u8* p = bloque;
+	const u8* fin = bloque + tam;
+	u8* q = destino;
+	u8* fin_destino = destino + tam_destino;
+
+	while(p < fin)
+	{
+		u8 token = *p++;
+
+		// Literales
+		u32 literales = token >> 4;
+		if(literales == 15 and not leerLongitud(p, fin, literales))
+			return false;
+		if(literales > (u32)(fin - p) or literales > (u32)(fin_destino - q))
+			return false;
+		memcpy(q, p, literales);
+		p += literales;
+		q += literales;
+
+		// La última secuencia del bloque no tiene copia
+		if(p == fin)
+			break;
+
+		// Copia de datos anteriores, que pueden pertenecer a bloques previos del mismo destino
+		if(fin - p < 2)
+			return false;
+		u32 distancia = (u32)p[0] | ((u32)p[1] << 8);
+		p += 2;
+		if(distancia == 0 or distancia > (u32)(q - inicio))
+			return false;
+
+		u32 longitud = token & 15;
+		if(longitud == 15 and not leerLongitud(p, fin, longitud))
+			return false;
+		longitud += LONGITUD_MINIMA;
+		if(longitud > (u32)(fin_destino - q))
+			return false;
+
+		const u8* origen = q - distancia;
+		if(distancia >= longitud)
+			memcpy(q, origen, longitud);
+		else
+		{
+			// Las copias solapadas repiten un patrón, así que hay que copiarlas byte a byte
+			for(u32 i = 0 ; i < longitud ; ++i)
+				q[i] = origen[i];
+		}
+		q += longitud;
+	}
+
+	return (q == fin_destino);
+}
+
+bool lz4::descomprimir(const u8* datos, u32 tam, u8* destino, u32 tam_destino)
+{
+	u32 leidos = 0;
+	u32 escritos = 0;
+
+	while(escritos < tam_destino)
+	{
+		if(tam - leidos < 4)
+			return false;
+		u32 tam_bloque = leerTamBloque(datos + leidos);
+		leidos += 4;
+
+		u32 bytes = bytesBloque(tam_bloque);
+		if(bytes > tam - leidos)
+			return false;
+
+		u32 salida = (tam_destino - escritos > TAM_BLOQUE) ? TAM_BLOQUE : tam_destino - escritos;
+		if(not descomprimirBloque(datos + leidos, tam_bloque, destino, destino + escritos, salida))
+			return false;
+
+		leidos += bytes;
+		escritos += salida;
+	}
+
+	return (leidos == tam);
+}
+
+u32 lz4::leerTamBloque(const u8* datos)
+{
+	return ((u32)datos[0] << 24) | ((u32)datos[1] << 16) | ((u32)datos[2] << 8) | (u32)datos[3];
+}
+
+u32 lz4::bytesBloque(u32 tam)
+{
+	return tam & ~SIN_COMPRIMIR;
+}
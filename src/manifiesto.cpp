@@ -0,0 +1,226 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "manifiesto.h"
+using namespace std;
+
+namespace
+{
+	// Valor de un atributo, o una cadena vacía si no existe
+	string atributo(const TiXmlElement* el, const char* nombre)
+	{
+		const char* valor = el ? el->Attribute(nombre) : NULL;
+		return valor ? string(valor) : string();
+	}
+}
+
+Manifiesto::Manifiesto(void): _estado(LIBRE)
+{
+
+}
+
+void Manifiesto::leer(const string& ruta) throw (ArchivoEx, TarjetaEx)
+{
+	TiXmlDocument doc;
+	cargarXml(ruta, doc);
+	leer(doc.RootElement());
+}
+
+void Manifiesto::leer(const TiXmlElement* mapa) throw (ArchivoEx, TarjetaEx)
+{
+	if(mapa == NULL)
+		return;
+
+	// Cada archivo XML de actor se lee una sola vez, aunque lo utilicen varios objetos
+	set<string> leidos;
+
+	// Propiedades del mapa
+	const TiXmlElement* propiedades = mapa->FirstChildElement("properties");
+	for(const TiXmlElement* p = propiedades ? propiedades->FirstChildElement("property") : NULL ; p ;
+		p = p->NextSiblingElement("property"))
+	{
+		string nombre = atributo(p, "name");
+		string valor = atributo(p, "value");
+		if(valor == "")
+			continue;
+
+		if(nombre == "imagen_fondo" or nombre == "imagen_tileset")
+			anadir(Galeria::IMAGEN, valor);
+		else if(nombre == "musica")
+			anadir(Galeria::MUSICA, valor);
+		else if(nombre == "imagenes")
+			anadirLista(Galeria::IMAGEN, valor);
+		else if(nombre == "musicas")
+			anadirLista(Galeria::MUSICA, valor);
+		else if(nombre == "sonidos")
+			anadirLista(Galeria::SONIDO, valor);
+		else if(nombre == "fuentes")
+			anadirLista(Galeria::FUENTE, valor);
+		else if(nombre.compare(0, 3, "xml") == 0)
+			leerActor(valor, leidos);
+	}
+
+	// Actores de las capas de objetos
+	for(const TiXmlElement* grupo = mapa->FirstChildElement("objectgroup") ; grupo ;
+		grupo = grupo->NextSiblingElement("objectgroup"))
+	{
+		for(const TiXmlElement* objeto = grupo->FirstChildElement("object") ; objeto ;
+			objeto = objeto->NextSiblingElement("object"))
+		{
+			const TiXmlElement* props = objeto->FirstChildElement("properties");
+			for(const TiXmlElement* p = props ? props->FirstChildElement("property") : NULL ; p ;
+				p = p->NextSiblingElement("property"))
+				if(atributo(p, "name") == "xml" and atributo(p, "value") != "")
+					leerActor(atributo(p, "value"), leidos);
+		}
+	}
+}
+
+void Manifiesto::anadir(Galeria::Tipo tipo, const string& codigo)
+{
+	if(codigo != "" and not contiene(tipo, codigo))
+		_recursos.push_back(make_pair(tipo, codigo));
+}
+
+bool Manifiesto::contiene(Galeria::Tipo tipo, const string& codigo) const
+{
+	for(Recursos::const_iterator i = _recursos.begin() ; i != _recursos.end() ; ++i)
+		if(i->first == tipo and i->second == codigo)
+			return true;
+	return false;
+}
+
+const Manifiesto::Recursos& Manifiesto::recursos(void) const
+{
+	return _recursos;
+}
+
+void Manifiesto::retener(void) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	if(_estado == RETENIDO)
+		return;
+
+	// Si falla la carga de un recurso, se deshacen las retenciones ya hechas y el manifiesto queda como estaba
+	u32 retenidos = 0;
+	try {
+		for( ; retenidos < _recursos.size() ; ++retenidos)
+			galeria->retener(_recursos[retenidos].first, _recursos[retenidos].second);
+	} catch(...) {
+		for(u32 i = 0 ; i < retenidos ; ++i)
+			galeria->liberar(_recursos[i].first, _recursos[i].second);
+		throw;
+	}
+
+	// Las reservas se sustituyen por las retenciones recién hechas
+	if(_estado == RESERVADO)
+		for(Recursos::iterator i = _recursos.begin() ; i != _recursos.end() ; ++i)
+			galeria->liberar(i->first, i->second);
+
+	_estado = RETENIDO;
+}
+
+void Manifiesto::reservar(void) throw (CodigoEx)
+{
+	if(_estado != LIBRE)
+		return;
+
+	u32 reservados = 0;
+	try {
+		for( ; reservados < _recursos.size() ; ++reservados)
+			galeria->reservar(_recursos[reservados].first, _recursos[reservados].second);
+	} catch(...) {
+		for(u32 i = 0 ; i < reservados ; ++i)
+			galeria->liberar(_recursos[i].first, _recursos[i].second);
+		throw;
+	}
+
+	_estado = RESERVADO;
+}
+
+void Manifiesto::liberar(void)
+{
+	if(_estado == LIBRE)
+		return;
+
+	for(Recursos::iterator i = _recursos.begin() ; i != _recursos.end() ; ++i)
+		galeria->liberar(i->first, i->second);
+
+	// Descartar lo que nadie más retenga; se hace después de liberar todo para no depender del orden
+	for(Recursos::iterator i = _recursos.begin() ; i != _recursos.end() ; ++i)
+		galeria->descartar(i->first, i->second);
+
+	_estado = LIBRE;
+}
+
+bool Manifiesto::retenido(void) const
+{
+	return (_estado != LIBRE);
+}
+
+// Métodos privados
+void Manifiesto::cargarXml(const string& ruta, TiXmlDocument& doc) throw (ArchivoEx, TarjetaEx)
+{
+	if(not sdcard->montada())
+		throw TarjetaEx("Manifiesto - La tarjeta SD no está montada");
+
+	string archivo = sdcard->unidad() + ":" + ruta;
+	u32 tam = 0;
+	u8* datos = sdcard->leer(archivo, tam, memoria::XML);
+
+	doc.SetValue(archivo);
+	doc.Parse((const char*)datos, NULL, TIXML_ENCODING_UTF8);
+	memoria::liberar(datos);
+
+	if(doc.Error())
+		throw ArchivoEx("Manifiesto - Error al cargar el archivo '" + archivo + "': " + doc.ErrorDesc());
+}
+
+void Manifiesto::anadirLista(Galeria::Tipo tipo, const string& lista)
+{
+	string::size_type inicio = 0;
+	while(inicio <= lista.length())
+	{
+		string::size_type fin = lista.find(',', inicio);
+		if(fin == string::npos)
+			fin = lista.length();
+
+		// Quitar los espacios de alrededor de cada código
+		string codigo = lista.substr(inicio, fin - inicio);
+		string::size_type a = codigo.find_first_not_of(" \t");
+		string::size_type b = codigo.find_last_not_of(" \t");
+		if(a != string::npos)
+			anadir(tipo, codigo.substr(a, b - a + 1));
+
+		inicio = fin + 1;
+	}
+}
+
+void Manifiesto::leerActor(const string& ruta, set<string>& leidos) throw (ArchivoEx, TarjetaEx)
+{
+	if(not leidos.insert(ruta).second)
+		return;
+
+	TiXmlDocument doc;
+	cargarXml(ruta, doc);
+
+	const TiXmlElement* raiz = doc.RootElement();
+	const TiXmlElement* animaciones = raiz ? raiz->FirstChildElement("animaciones") : NULL;
+	for(const TiXmlElement* a = animaciones ? animaciones->FirstChildElement() : NULL ; a ;
+		a = a->NextSiblingElement())
+		anadir(Galeria::IMAGEN, atributo(a, "img"));
+}
@@ -0,0 +1,188 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "mascara.h"
+using namespace std;
+
+namespace
+{
+	// Color RGB5A3 de un píxel de una textura organizada en bloques
+	u16 color(const void* texels, textura::Formato formato, const u16* paleta, u32 bloques_fila, u16 x, u16 y)
+	{
+		u32 ancho_bloque = textura::anchoBloque(formato);
+		u32 alto_bloque = textura::altoBloque(formato);
+		u32 bloque = (y / alto_bloque) * bloques_fila + x / ancho_bloque;
+		u32 dentro = (y % alto_bloque) * ancho_bloque + x % ancho_bloque;
+
+		if(formato == textura::RGB5A3)
+			return ((const u16*)texels)[bloque * 16 + dentro];
+		if(formato == textura::CI8)
+			return paleta[((const u8*)texels)[bloque * 32 + dentro]];
+		u8 pareja = ((const u8*)texels)[bloque * 32 + dentro / 2];
+		return paleta[(dentro & 1) ? pareja & 0x0F : pareja >> 4];
+	}
+}
+
+Mascara::Mascara(void): _ancho(0), _alto(0), _palabras(0)
+{
+
+}
+
+void Mascara::crear(const void* texels, textura::Formato formato, const u16* paleta, u16 ancho_textura, u16 x, u16 y,
+					u16 ancho, u16 alto)
+{
+	_ancho = ancho;
+	_alto = alto;
+	_palabras = (ancho + 31) / 32 + 1;
+	_bits.assign(_palabras * alto, 0);
+	_invertidos.assign(_palabras * alto, 0);
+
+	// Sin una textura que se pueda leer, la máscara es opaca y manda el resultado de las figuras de colisión
+	bool legible = (texels != NULL and (formato == textura::RGB5A3
+						or ((formato == textura::CI8 or formato == textura::CI4) and paleta != NULL)));
+	u32 ancho_bloque = textura::anchoBloque(formato);
+	u32 bloques_fila = (ancho_textura + ancho_bloque - 1) / ancho_bloque;
+
+	for(u16 fila = 0 ; fila < alto ; ++fila)
+	{
+		u32* bits = &_bits[fila * _palabras];
+		u32* invertidos = &_invertidos[fila * _palabras];
+		for(u16 columna = 0 ; columna < ancho ; ++columna)
+		{
+			// Opaco si pasa la comparación de alpha de Screen: bit de opaco, o algo de alpha
+			if(legible and (color(texels, formato, paleta, bloques_fila, x + columna, y + fila) & 0xF000) == 0)
+				continue;
+			bits[columna / 32] |= 0x80000000u >> (columna % 32);
+			u16 espejo = ancho - 1 - columna;
+			invertidos[espejo / 32] |= 0x80000000u >> (espejo % 32);
+		}
+	}
+}
+
+u16 Mascara::ancho(void) const
+{
+	return _ancho;
+}
+
+u16 Mascara::alto(void) const
+{
+	return _alto;
+}
+
+bool Mascara::opaco(u16 x, u16 y) const
+{
+	if(x >= _ancho or y >= _alto)
+		return false;
+	return (_bits[y * _palabras + x / 32] & (0x80000000u >> (x % 32))) != 0;
+}
+
+bool Mascara::solapa(const Cuadro& propio, const Mascara& otra, const Cuadro& ajeno) const
+{
+	// Un cuadro que no está dentro de su máscara (por ejemplo, de una máscara vacía) no descarta la colisión
+	if(not valido(propio) or not otra.valido(ajeno))
+		return true;
+
+	// Rectángulo del escenario en el que coinciden los dos cuadros
+	s32 x0 = ajeno.posX, y0 = ajeno.posY;
+	s32 x1 = ajeno.posX + ajeno.ancho - 1, y1 = ajeno.posY + ajeno.alto - 1;
+	if(not recortar(propio, x0, y0, x1, y1))
+		return false;
+
+	u16 bits = x1 - x0 + 1;
+	u32 palabras = (bits + 31) / 32;
+	u32 a[MAX_ANCHO / 32], b[MAX_ANCHO / 32];
+	for(s32 y = y0 ; y <= y1 ; ++y)
+	{
+		extraer(propio, y - propio.posY, x0 - propio.posX, bits, a);
+		otra.extraer(ajeno, y - ajeno.posY, x0 - ajeno.posX, bits, b);
+		for(u32 i = 0 ; i < palabras ; ++i)
+			if(a[i] & b[i])
+				return true;
+	}
+	return false;
+}
+
+bool Mascara::contiene(const Cuadro& propio, s32 x0, s32 y0, s32 x1, s32 y1) const
+{
+	if(not valido(propio))
+		return true;
+	if(not recortar(propio, x0, y0, x1, y1))
+		return false;
+
+	u16 bits = x1 - x0 + 1;
+	u32 palabras = (bits + 31) / 32;
+	u32 a[MAX_ANCHO / 32];
+	for(s32 y = y0 ; y <= y1 ; ++y)
+	{
+		extraer(propio, y - propio.posY, x0 - propio.posX, bits, a);
+		for(u32 i = 0 ; i < palabras ; ++i)
+			if(a[i])
+				return true;
+	}
+	return false;
+}
+
+u32 Mascara::bytes(void) const
+{
+	return (_bits.size() + _invertidos.size()) * sizeof(u32);
+}
+
+// Métodos privados
+
+bool Mascara::valido(const Cuadro& c) const
+{
+	return (c.ancho > 0 and c.alto > 0 and c.ancho <= MAX_ANCHO and c.x + c.ancho <= _ancho
+			and c.y + c.alto <= _alto);
+}
+
+void Mascara::extraer(const Cuadro& c, u16 fila, u16 columna, u16 bits, u32* destino) const
+{
+	// En un cuadro invertido, la columna del cuadro se cuenta desde la derecha en la fila normal, que es contar
+	// desde la izquierda en la fila invertida
+	u32 inicio = c.invertido ? (_ancho - c.x - c.ancho) + columna : c.x + columna;
+	const u32* origen = c.invertido ? &_invertidos[(c.y + fila) * _palabras] : &_bits[(c.y + fila) * _palabras];
+	origen += inicio / 32;
+	u32 desplazamiento = inicio % 32;
+
+	// La palabra de relleno del final de la fila permite leer siempre la palabra siguiente
+	u32 palabras = (bits + 31) / 32;
+	for(u32 i = 0 ; i < palabras ; ++i)
+	{
+		u32 v = origen[i] << desplazamiento;
+		if(desplazamiento != 0)
+			v |= origen[i + 1] >> (32 - desplazamiento);
+		destino[i] = v;
+	}
+
+	// Descartar los bits que sobran en la última palabra
+	if(bits % 32 != 0)
+		destino[palabras - 1] &= 0xFFFFFFFFu << (32 - bits % 32);
+}
+
+bool Mascara::recortar(const Cuadro& c, s32& x0, s32& y0, s32& x1, s32& y1)
+{
+	if(x0 < c.posX)
+		x0 = c.posX;
+	if(y0 < c.posY)
+		y0 = c.posY;
+	if(x1 > c.posX + c.ancho - 1)
+		x1 = c.posX + c.ancho - 1;
+	if(y1 > c.posY + c.alto - 1)
+		y1 = c.posY + c.alto - 1;
+	return (x0 <= x1 and y0 <= y1);
+}
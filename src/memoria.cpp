@@ -0,0 +1,242 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "memoria.h"
+#include <sstream>
+#ifdef GEKKO
+	#include <ogc/irq.h>
+	#include "logger.h"
+#else
+	#include <cstdio>
+	#include <pthread.h>
+#endif
+using namespace std;
+
+namespace
+{
+	const u32 MAGIA = 0x4D454D31;
+	const u32 LIBERADO = 0x4C494252;
+
+	const char* NOMBRES[memoria::NUM_ETIQUETAS] =
+		{ "Texturas", "Audio", "Nivel", "Actores", "Fuentes", "XML", "Archivos", "Sistema" };
+
+	struct Cabecera
+	{
+		u32 magia;
+		u32 tam;
+		u32 etiqueta;
+		#ifndef GEKKO
+		Cabecera* anterior;
+		Cabecera* siguiente;
+		#endif
+	};
+
+	// La cabecera no puede ocupar más de lo que se reserva para ella delante de cada bloque
+	typedef char ComprobarCabecera[sizeof(Cabecera) <= memoria::TAM_CABECERA ? 1 : -1];
+
+	struct Contador
+	{
+		u32 vivos;
+		u32 pico;
+		u32 bloques;
+	};
+
+	Contador contadores[memoria::NUM_ETIQUETAS];
+	u32 vivos_total = 0;
+	u32 pico_total = 0;
+
+	#ifdef GEKKO
+	// Sección crítica: unas pocas sumas, así que basta con deshabilitar las interrupciones
+	class Bloqueo
+	{
+		public:
+			Bloqueo(void) { _CPU_ISR_Disable(_nivel); }
+			~Bloqueo(void) { _CPU_ISR_Restore(_nivel); }
+		private:
+			u32 _nivel;
+	};
+	#else
+	pthread_mutex_t cerrojo = PTHREAD_MUTEX_INITIALIZER;
+
+	class Bloqueo
+	{
+		public:
+			Bloqueo(void) { pthread_mutex_lock(&cerrojo); }
+			~Bloqueo(void) { pthread_mutex_unlock(&cerrojo); }
+	};
+
+	// Lista de bloques vivos, para el informe de fugas
+	Cabecera* lista = NULL;
+
+	void informarFugas(void)
+	{
+		Bloqueo b;
+		u32 fugas = 0;
+		for(Cabecera* c = lista ; c != NULL ; c = c->siguiente)
+		{
+			fprintf(stderr, "memoria - Fuga: %u bytes (%s) en %p\n", c->tam, NOMBRES[c->etiqueta],
+					(void*)((u8*)c + memoria::TAM_CABECERA));
+			++fugas;
+		}
+		if(fugas > 0)
+			fprintf(stderr, "memoria - %u bloques sin liberar, %u bytes\n", fugas, vivos_total);
+	}
+
+	// El informe se registra antes de main(), así que se ejecuta después de cualquier otra función registrada con
+	// atexit() (por ejemplo, la destrucción de los singleton), y sólo muestra lo que de verdad se ha quedado sin liberar
+	struct Registro
+	{
+		Registro(void) { atexit(informarFugas); }
+	} registro;
+	#endif
+
+	Cabecera* cabecera(const void* bloque)
+	{
+		if(bloque == NULL)
+			return NULL;
+		Cabecera* c = (Cabecera*)((u8*)bloque - memoria::TAM_CABECERA);
+		return (c->magia == MAGIA) ? c : NULL;
+	}
+}
+
+void* memoria::reservar(u32 tam, Etiqueta etiqueta)
+{
+	if(etiqueta >= NUM_ETIQUETAS or tam > 0xFFFFFFFF - TAM_CABECERA)
+		return NULL;
+
+	u8* bloque = (u8*)memalign(32, TAM_CABECERA + tam);
+	if(bloque == NULL)
+		return NULL;
+
+	Cabecera* c = (Cabecera*)bloque;
+	c->magia = MAGIA;
+	c->tam = tam;
+	c->etiqueta = etiqueta;
+
+	Bloqueo b;
+	Contador& contador = contadores[etiqueta];
+	contador.vivos += tam;
+	contador.bloques++;
+	if(contador.vivos > contador.pico)
+		contador.pico = contador.vivos;
+	vivos_total += tam;
+	if(vivos_total > pico_total)
+		pico_total = vivos_total;
+
+	#ifndef GEKKO
+	c->anterior = NULL;
+	c->siguiente = lista;
+	if(lista != NULL)
+		lista->anterior = c;
+	lista = c;
+	#endif
+
+	return bloque + TAM_CABECERA;
+}
+
+void memoria::liberar(void* bloque)
+{
+	Cabecera* c = cabecera(bloque);
+	if(c == NULL)
+		return;
+
+	{
+		Bloqueo b;
+		Contador& contador = contadores[c->etiqueta];
+		contador.vivos -= c->tam;
+		contador.bloques--;
+		vivos_total -= c->tam;
+
+		#ifndef GEKKO
+		if(c->anterior != NULL)
+			c->anterior->siguiente = c->siguiente;
+		else
+			lista = c->siguiente;
+		if(c->siguiente != NULL)
+			c->siguiente->anterior = c->anterior;
+		#endif
+	}
+
+	// Una segunda liberación del mismo bloque ya no encontrará el número mágico
+	c->magia = LIBERADO;
+	free(c);
+}
+
+u32 memoria::tam(const void* bloque)
+{
+	Cabecera* c = cabecera(bloque);
+	return c ? c->tam : 0;
+}
+
+u32 memoria::vivos(Etiqueta etiqueta)
+{
+	return (etiqueta < NUM_ETIQUETAS) ? contadores[etiqueta].vivos : 0;
+}
+
+u32 memoria::pico(Etiqueta etiqueta)
+{
+	return (etiqueta < NUM_ETIQUETAS) ? contadores[etiqueta].pico : 0;
+}
+
+u32 memoria::bloques(Etiqueta etiqueta)
+{
+	return (etiqueta < NUM_ETIQUETAS) ? contadores[etiqueta].bloques : 0;
+}
+
+u32 memoria::total(void)
+{
+	return vivos_total;
+}
+
+u32 memoria::picoTotal(void)
+{
+	return pico_total;
+}
+
+void memoria::reiniciarPicos(void)
+{
+	Bloqueo b;
+	for(u32 i = 0 ; i < NUM_ETIQUETAS ; ++i)
+		contadores[i].pico = contadores[i].vivos;
+	pico_total = vivos_total;
+}
+
+const char* memoria::nombre(Etiqueta etiqueta)
+{
+	return (etiqueta < NUM_ETIQUETAS) ? NOMBRES[etiqueta] : "";
+}
+
+string memoria::resumen(Etiqueta etiqueta)
+{
+	stringstream texto;
+	texto << nombre(etiqueta) << ": " << vivos(etiqueta) << " bytes en " << bloques(etiqueta)
+		<< " bloques, pico de " << pico(etiqueta) << " bytes";
+	return texto.str();
+}
+
+#ifdef GEKKO
+void memoria::informe(void)
+{
+	for(u32 i = 0 ; i < NUM_ETIQUETAS ; ++i)
+		logger->info("Memoria - " + resumen((Etiqueta)i));
+
+	stringstream texto;
+	texto << "Memoria - Total: " << total() << " bytes, pico de " << picoTotal() << " bytes";
+	logger->info(texto.str());
+}
+#endif
@@ -0,0 +1,216 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "mezclador.h"
+#include "sonido.h"
+using namespace std;
+
+Mezclador* Mezclador::_instance = 0;
+
+void Mezclador::inicializar(void)
+{
+	for(u8 v = 0 ; v < NUM_VOCES ; ++v)
+	{
+		_voces[v].efecto = NULL;
+		_voces[v].prioridad = 0;
+		_voces[v].inicio = 0;
+		_decodificacion[v].bloque = 0;
+		_decodificacion[v].mitad = 0;
+	}
+	voces::reiniciar(_estadisticas);
+}
+
+void Mezclador::setVentana(u32 microsegundos)
+{
+	_ventana = microsegundos;
+}
+
+bool Mezclador::reproducir(const Sonido& s)
+{
+	u64 instante = ahora();
+
+	// Las voces que la libASND ya no está reproduciendo quedan libres en la tabla antes de elegir
+	for(u8 v = PRIMERA_VOZ ; v < NUM_VOCES ; ++v)
+		if(ASND_StatusVoice(v) == SND_UNUSED)
+			_voces[v].efecto = NULL;
+
+	voces::Peticion p = {&s, s.prioridad(), s.instancias(), instante};
+	s16 destino = voces::elegir(_voces, PRIMERA_VOZ, NUM_VOCES, p, _ventana, _estadisticas);
+	if(destino == voces::FUSIONADA)
+		return true;
+	if(destino == voces::DESCARTADA)
+		return false;
+
+	parar(destino);
+	if(not iniciar(destino, s, instante))
+	{
+		_estadisticas.descartes++;
+		return false;
+	}
+	_estadisticas.reproducciones++;
+	return true;
+}
+
+void Mezclador::detener(const Sonido& s)
+{
+	for(u8 v = PRIMERA_VOZ ; v < NUM_VOCES ; ++v)
+		if(sonido(v) == &s)
+			parar(v);
+}
+
+const Mezclador::Estadisticas& Mezclador::estadisticas(void) const
+{
+	return _estadisticas;
+}
+
+void Mezclador::informe(void) const
+{
+	stringstream texto;
+	texto << "Mezclador - peticiones: " << _estadisticas.peticiones
+		<< ", reproducciones: " << _estadisticas.reproducciones
+		<< ", fusiones: " << _estadisticas.fusiones
+		<< ", robos: " << _estadisticas.robos
+		<< ", descartes: " << _estadisticas.descartes
+		<< ", voces ocupadas: " << (u32)_estadisticas.voces_ocupadas
+		<< ", pico de voces: " << (u32)_estadisticas.pico_voces;
+	logger->info(texto.str());
+}
+
+// Métodos protegidos
+Mezclador::Mezclador(void): _ventana(0)
+{
+	for(u8 v = 0 ; v < NUM_VOCES ; ++v)
+		_buffers[v] = NULL;
+	inicializar();
+}
+
+Mezclador::~Mezclador(void)
+{
+	for(u8 v = PRIMERA_VOZ ; v < NUM_VOCES ; ++v)
+	{
+		parar(v);
+		memoria::liberar(_buffers[v]);
+	}
+}
+
+// Métodos privados
+u64 Mezclador::ahora(void) const
+{
+	return ticks_to_microsecs(gettime());
+}
+
+const Sonido* Mezclador::sonido(u8 v) const
+{
+	return static_cast<const Sonido*>(_voces[v].efecto);
+}
+
+bool Mezclador::iniciar(u8 v, const Sonido& s, u64 instante)
+{
+	// El estado de la voz se rellena antes de llamar a ASND_SetVoice(), ya que la función de retorno puede
+	// ejecutarse en cuanto la voz queda registrada, y necesita saber qué efecto tiene que seguir decodificando
+	_voces[v].efecto = &s;
+	_voces[v].prioridad = s.prioridad();
+	_voces[v].inicio = instante;
+	_decodificacion[v].bloque = 0;
+	_decodificacion[v].mitad = 0;
+
+	if(s.comprimido())
+	{
+		// El búfer doble de la voz se reserva la primera vez que reproduce un efecto comprimido
+		if(_buffers[v] == NULL)
+			_buffers[v] = (s16*)memoria::reservar(2 * TAM_MITAD, memoria::AUDIO);
+		if(_buffers[v] == NULL)
+		{
+			_voces[v].efecto = NULL;
+			return false;
+		}
+
+		// Decodificar los dos primeros bloques, uno en cada mitad del búfer, antes de registrar la voz
+		s32 formato = (s.cabecera().canales == 2) ? VOICE_STEREO_16BIT : VOICE_MONO_16BIT;
+		s16* primera = _buffers[v];
+		s16* segunda = _buffers[v] + TAM_MITAD / sizeof(s16);
+		u32 tam_primera = decodificar(v, s);
+		u32 tam_segunda = (_decodificacion[v].bloque < s.cabecera().bloques) ? decodificar(v, s) : 0;
+
+		// Registrar la voz y encolar el segundo bloque sin que la interrupción de audio pueda ejecutar la función
+		// de retorno entre ambas llamadas, ya que decodificaría un tercer bloque sobre la mitad que está sonando
+		u32 nivel;
+		_CPU_ISR_Disable(nivel);
+		s32 resultado = ASND_SetVoice(v, formato, s.cabecera().frecuencia, 0, primera, tam_primera,
+										s.volumenIzquierdo(), s.volumenDerecho(), alimentar);
+		if(resultado == SND_OK and tam_segunda > 0)
+			ASND_AddVoice(v, segunda, tam_segunda);
+		_CPU_ISR_Restore(nivel);
+
+		if(resultado != SND_OK)
+		{
+			_voces[v].efecto = NULL;
+			return false;
+		}
+	}
+	else if(ASND_SetVoice(v, VOICE_STEREO_16BIT, 48000, 0, (void*)s.datos(), s.tamano(),
+							s.volumenIzquierdo(), s.volumenDerecho(), NULL) != SND_OK)
+	{
+		_voces[v].efecto = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+void Mezclador::parar(u8 v)
+{
+	if(_voces[v].efecto != NULL)
+		ASND_StopVoice(v);
+	_voces[v].efecto = NULL;
+}
+
+u32 Mezclador::decodificar(u8 v, const Sonido& s)
+{
+	const adpcm::Cabecera& c = s.cabecera();
+	Decodificacion& d = _decodificacion[v];
+	s16* destino = _buffers[v] + d.mitad * (TAM_MITAD / sizeof(s16));
+
+	adpcm::decodificarBloque(s.bloque(d.bloque), c.canales, c.muestras_bloque, destino);
+
+	// El último bloque sólo contiene parte de sus muestras; el resto es relleno del codificador
+	u32 muestras = c.muestras_bloque;
+	u32 restantes = c.muestras - d.bloque * c.muestras_bloque;
+	if(restantes < muestras)
+		muestras = restantes;
+	u32 tam = (muestras * c.canales * sizeof(s16) + 31) & ~31;
+
+	DCFlushRange(destino, tam);
+
+	d.bloque++;
+	d.mitad ^= 1;
+	return tam;
+}
+
+void Mezclador::alimentar(s32 v)
+{
+	// Se ejecuta en la interrupción de audio, cuando la voz comienza a reproducir el último bloque encolado
+	const Sonido* s = _instance->sonido(v);
+	const Decodificacion& d = _instance->_decodificacion[v];
+	if(s == NULL or not s->comprimido() or d.bloque >= s->cabecera().bloques)
+		return;
+
+	s16* destino = _instance->_buffers[v] + d.mitad * (TAM_MITAD / sizeof(s16));
+	u32 tam = _instance->decodificar(v, *s);
+	ASND_AddVoice(v, destino, tam);
+}
@@ -19,6 +19,8 @@
 #include "musica.h"
 using namespace std;
 
+const Musica* Musica::_activa = NULL;
+
 Musica::Musica(const string& ruta, u8 volumen) throw (ArchivoEx, TarjetaEx):
 _volumen(volumen)
 {
@@ -28,40 +30,22 @@ _volumen(volumen)
 	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
 	string ruta_completa = sdcard->unidad() + ":" + ruta;
 
-	// Comprobar la existencia del archivo
-	if(not sdcard->existe(ruta_completa))
-		throw ArchivoEx("Musica - El archivo '" + ruta + "' no existe.");
-
-	// Cargar el archivo en un flujo de fichero
-	ifstream archivo;
-	archivo.open(ruta_completa.c_str(), ios::binary);
-
-	if(not archivo.good())
-		throw ArchivoEx("Musica - Error al abrir el archivo: " + ruta);
-
-	// Obtener el tamaño de la pista
-	archivo.seekg(0, ios::end);
-	_size = archivo.tellg();
-	archivo.seekg(0, ios::beg);
+	// Leer la pista completa de una sola vez (del paquete montado, si la contiene) en memoria alineada
+	_musica = (s16*)sdcard->leer(ruta_completa, _size, memoria::AUDIO);
 
-	// Fijar el padding a 32 bytes
-	u8 padding = (_size * sizeof(s16)) % 32;
-
-	// Reservar memoria alineada a 32 bytes para el sonido
-	_musica = (s16*)memalign(32, _size * sizeof(s16) + padding);
-	// Volcar el contenido del flujo en la memoria reservada
-	archivo.read((char*)_musica, _size);
 	// Fijar en la zona de memoria alineada la información de la pista de música que se ha leído desde la cache
-	DCFlushRange(_musica, _size * sizeof(s16) + padding);
-
-	// Una vez cargada la pista de música, se cierra el flujo de fichero
-	archivo.close();
+	DCFlushRange(_musica, (_size + 32) & ~31);
 }
 
 Musica::~Musica(void)
 {
-	stop();
-	free(_musica);
+	// Sólo se detiene la reproducción si es esta pista la que está sonando
+	if(_activa == this)
+	{
+		stop();
+		_activa = NULL;
+	}
+	memoria::liberar(_musica);
 }
 
 void Musica::play(void) const
@@ -69,6 +53,7 @@ void Musica::play(void) const
 	stop();
 	MP3Player_Volume(_volumen);
 	MP3Player_PlayBuffer(_musica, _size, NULL);
+	_activa = this;
 }
 
 void Musica::stop(void) const
@@ -80,7 +65,10 @@ void Musica::stop(void) const
 void Musica::loop(void) const
 {
 	if(not reproduciendo())
+	{
 		MP3Player_PlayBuffer(_musica, _size, NULL);
+		_activa = this;
+	}
 }
 
 bool Musica::reproduciendo(void) const
@@ -88,6 +76,16 @@ bool Musica::reproduciendo(void) const
 	return MP3Player_IsPlaying();
 }
 
+bool Musica::activa(void) const
+{
+	return (_activa == this and reproduciendo());
+}
+
+u32 Musica::bytes(void) const
+{
+	return _size;
+}
+
 void Musica::setVolumen(u8 volumen)
 {
 	_volumen = volumen;
@@ -17,71 +17,29 @@
  */
 
 #include "nivel.h"
+#include "cargador.h"
+#include "perfilador.h"
 using namespace std;
 
-Nivel::Nivel(const string& ruta) throw (ArchivoEx, TarjetaEx): _scroll_x(0), _scroll_y(0)
+Nivel::Nivel(const string& ruta) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+: _scroll_x(0), _scroll_y(0), _tiles(NULL)
 {
-	// Comprobar que la SD está montada
-	if(not sdcard->montada())
-		throw TarjetaEx("Nivel - La tarjeta SD no está montada");
-
-	// Abrir el archivo XML
 	try {
-		parser->cargar(ruta);
-	} catch(const Excepcion& e) {
-		throw e;
+		cargarDatosIniciales(ruta);
+	} catch(...) {
+		// Si el nivel no llega a construirse, no se ejecuta su destructor: liberar aquí sus tiles, y deshacer las
+		// reservas (o las retenciones) de sus recursos en la galería, incluidas las que entrega el Cargador
+		memoria::liberar(_tiles);
+		_tiles = NULL;
+		_manifiesto.liberar();
+		throw;
 	}
-
-	// Leer la información de la etiqueta 'map'
-	_ancho_tiles = parser->atributoU32("width", parser->raiz());
-	_alto_tiles = parser->atributoU32("height", parser->raiz());
-	_ancho_un_tile = parser->atributoU32("tilewidth", parser->raiz());
-	_alto_un_tile = parser->atributoU32("tileheight", parser->raiz());
-
-	// Calcular las medidas del escenario
-	_ancho_nivel = _ancho_tiles * _ancho_un_tile;
-	_alto_nivel = _alto_tiles * _alto_un_tile;
-
-	// Calcular el número de filas y columnas de la imagen del tileset
-	TiXmlElement* imagen_tileset = parser->buscar("image", parser->raiz());
-	_filas_tileset = parser->atributoU32("height", imagen_tileset) / _alto_un_tile;
-	_columnas_tileset = parser->atributoU32("width", imagen_tileset) / _ancho_un_tile;
-
-	// Leer las propiedades de 'map'
-	TiXmlElement* propiedades = parser->buscar("properties", parser->raiz());
-	leerPropiedades(propiedades);
-
-	// Reservar memoria para las matrices de tiles
-	_escenario[PLATAFORMAS] = (Tile**)memalign(32, _alto_tiles * sizeof(Tile*));
-	_escenario[ESCENARIO] = (Tile**)memalign(32, _alto_tiles * sizeof(Tile*));
-	for(u16 i = 0 ; i < _alto_tiles ; ++i)
-	{
-		_escenario[PLATAFORMAS][i] = (Tile*)memalign(32, _ancho_tiles * sizeof(Tile));
-		_escenario[ESCENARIO][i] = (Tile*)memalign(32, _ancho_tiles * sizeof(Tile));
-	}
-
-	// Leer el escenario (tiles atravesables), tile por tile
-	TiXmlElement* escenario = parser->buscar("layer", parser->raiz());
-	leerEscenario(escenario);
-
-	// Leer las plataformas (tiles no atravesables, con caja de colision), tile por tile
-	TiXmlElement* plataformas = parser->siguiente(escenario);
-	leerPlataformas(plataformas);
-
-	// Leer los actores y almacenarlos en la estructura temporal
-	TiXmlElement* actores = parser->buscar("objectgroup", parser->raiz());
-	leerActores(actores);
-
-	_scroll_x = 0;
-	_scroll_y = 0;
 }
 
 Nivel::~Nivel(void)
 {
-	// Destruir las figuras de colision de las plataformas
-	for(u16 i = 0 ; i < _filas_tileset ; ++i)
-		for(u16 j = 0 ; j < _columnas_tileset ; ++j)
-			delete _escenario[PLATAFORMAS][i][j].colision;
+	// Liberar los tiles de todas las capas
+	memoria::liberar(_tiles);
 	_escenario.clear();
 
 	// Destruir los actores no jugadores
@@ -91,6 +49,9 @@ Nivel::~Nivel(void)
 	// Destruir los actores jugadores
 	for(Jugadores::iterator i = _jugadores.begin() ; i != _jugadores.end() ; ++i)
 		delete i->second;
+
+	// Liberar los recursos del nivel retenidos en la galería, y descartar los que ya no utilice nadie
+	_manifiesto.liberar();
 }
 
 u32 Nivel::ancho(void) const
@@ -115,7 +76,7 @@ u32 Nivel::yScroll(void) const
 
 const Musica& Nivel::musica(void) const
 {
-	return galeria->musica(_musica);
+	return galeria->musica(_pista);
 }
 
 void Nivel::moverScroll(u32 x, u32 y)
@@ -131,36 +92,48 @@ void Nivel::moverScroll(u32 x, u32 y)
 
 void Nivel::dibujar(void)
 {
+	Perfilador::Zona zona("Nivel::dibujar");
 	u16 limite_x = screen->ancho();
 	u16 limite_y = screen->alto();
 
+	// Obtener las imágenes del nivel una sola vez por frame; están retenidas, así que no se descargan
+	const Imagen& fondo = galeria->imagen(_fondo);
+	const Imagen& tileset = galeria->imagen(_tileset);
+
 	// Dibujar el fondo de pantalla
-	screen->dibujarTextura(
-				galeria->imagen(_imagen_fondo).textura(),
-				0, 0, 900, 
-				galeria->imagen(_imagen_fondo).ancho(),
-				galeria->imagen(_imagen_fondo).alto());
-
-	// Dibujar los tiles que aparezcan en la pantalla
-	for(Escenario::const_iterator capa = _escenario.begin() ; capa != _escenario.end() ; ++capa)
-		for(u16 i = 0 ; i < _alto_tiles ; ++i)
-			for(u16 j = 0 ; j < _ancho_tiles ; ++j)
-				if((capa->second[i][j].x + _ancho_un_tile )>= _scroll_x and
-					capa->second[i][j].x <= _scroll_x + limite_x and
-					(capa->second[i][j].y + _alto_un_tile) >= _scroll_y and
-					capa->second[i][j].y <= _scroll_y + limite_y and
-					capa->second[i][j].gid != 0)
-				{
-					screen->dibujarCuadro(
-							galeria->imagen(_imagen_tileset).textura(),
-							galeria->imagen(_imagen_tileset).ancho(),
-							galeria->imagen(_imagen_tileset).alto(),
-							capa->second[i][j].x - _scroll_x, capa->second[i][j].y - _scroll_y, 800,
-							((capa->second[i][j].gid - 1) % _columnas_tileset) * (_ancho_un_tile),
-							((capa->second[i][j].gid - 1) / _columnas_tileset) * (_alto_un_tile),
+	fondo.dibujar(0, 0, 900);
+
+	// Dibujar los tiles que aparezcan en la pantalla, que se calculan a partir del scroll sin recorrer el resto
+	u32 columna0 = _scroll_x / _ancho_un_tile;
+	u32 columna1 = (_scroll_x + limite_x) / _ancho_un_tile;
+	u32 fila0 = _scroll_y / _alto_un_tile;
+	u32 fila1 = (_scroll_y + limite_y) / _alto_un_tile;
+	if(columna1 >= _ancho_tiles)
+		columna1 = _ancho_tiles - 1;
+	if(fila1 >= _alto_tiles)
+		fila1 = _alto_tiles - 1;
+
+	// Cada capa se dibuja por delante de las anteriores, y siempre por detrás de los actores
+	for(u32 c = 0 ; c < _escenario.size() ; ++c)
+	{
+		s16 z = 800 - (c < 99 ? c : 99);
+		for(u32 i = fila0 ; i <= fila1 and i < _alto_tiles ; ++i)
+		{
+			const Tile* fila = _escenario[c].tiles + i * _ancho_tiles;
+			for(u32 j = columna0 ; j <= columna1 and j < _ancho_tiles ; ++j)
+			{
+				u32 gid = fila[j] & GID;
+				if(gid != 0)
+					tileset.dibujarCuadro(
+							j * _ancho_un_tile - _scroll_x, i * _alto_un_tile - _scroll_y, z,
+							((gid - 1) % _columnas_tileset) * (_ancho_un_tile),
+							((gid - 1) / _columnas_tileset) * (_alto_un_tile),
 							_ancho_un_tile,
-							_alto_un_tile);
-				}
+							_alto_un_tile,
+							(fila[j] & INVERTIDO) != 0);
+			}
+		}
+	}
 
 	// Dibujar los actores no jugadores
 	for(Actores::const_iterator i = _actores.begin() ; i != _actores.end() ; ++i)
@@ -180,21 +153,38 @@ void Nivel::dibujar(void)
 
 bool Nivel::colision(const Actor* a)
 {
-	Tile** mapa = _escenario[PLATAFORMAS];
 	Actor::CajasColision actor = a->cajasColision();
 	u32 tiles_x0 = a->x() / _ancho_un_tile;
 	u32 tiles_x1 = (a->x() + a->ancho()) / _ancho_un_tile;
 	u32 tiles_y0 = a->y() / _alto_un_tile;
 	u32 tiles_y1 = (a->y() + a->alto()) / _alto_un_tile;
+	if(tiles_x1 >= _ancho_tiles)
+		tiles_x1 = _ancho_tiles - 1;
+	if(tiles_y1 >= _alto_tiles)
+		tiles_y1 = _alto_tiles - 1;
 
-	// Comprobar colisiones solo en la capa PLATAFORMAS, y solo en los tiles que toquen al actor
-	for(Actor::CajasColision::iterator i = actor.begin() ; i != actor.end() ; ++i)
-		for(u16 y = tiles_y0 ; y <= tiles_y1 ; ++y)
-			for(u16 x = tiles_x0 ; x <= tiles_x1 ; ++x)
-				if(mapa[y][x].colision != NULL)
+	// Comprobar colisiones solo en las capas sólidas, y solo en los tiles que toquen al actor
+	for(Escenario::const_iterator c = _escenario.begin() ; c != _escenario.end() ; ++c)
+	{
+		if(not c->solida)
+			continue;
+		for(u32 y = tiles_y0 ; y <= tiles_y1 ; ++y)
+			for(u32 x = tiles_x0 ; x <= tiles_x1 ; ++x)
+			{
+				if(not (c->tiles[y * _ancho_tiles + x] & SOLIDO))
+					continue;
+
+				// El rectángulo de colisión del tile se calcula a partir de su posición en la capa
+				Rectangulo tile(Punto(x * _ancho_un_tile, y * _alto_un_tile),
+								Punto((x+1) * _ancho_un_tile, y * _alto_un_tile),
+								Punto((x+1) * _ancho_un_tile, (y+1) * _alto_un_tile),
+								Punto(x * _ancho_un_tile, (y+1) * _alto_un_tile));
+				for(Actor::CajasColision::iterator i = actor.begin() ; i != actor.end() ; ++i)
 					// El actor tiene desplazamiento, pero el tile no
-					if(mapa[y][x].colision->hayColision(*i, 0, 0, a->x() + a->velX(), a->y() + a->velY()))
+					if(tile.hayColision(*i, 0, 0, a->x() + a->velX(), a->y() + a->velY()))
 						return true;
+			}
+	}
 
 	if(colisionBordes(a))
 		return true;
@@ -214,6 +204,92 @@ bool Nivel::colisionBordes(const Actor* a)
 }
 
 // Métodos protegidos
+void Nivel::cargarDatosIniciales(const string& ruta) throw (ArchivoEx, CodigoEx, ImagenEx, TarjetaEx)
+{
+	// Comprobar que la SD está montada
+	if(not sdcard->montada())
+		throw TarjetaEx("Nivel - La tarjeta SD no está montada");
+
+	// Si el nivel se ha pedido al Cargador, su documento y su manifiesto ya están preparados
+	bool preparado = cargador->entregarManifiesto(ruta, _manifiesto);
+
+	// Abrir el archivo XML
+	try {
+		parser->cargar(ruta);
+	} catch(const Excepcion& e) {
+		throw e;
+	}
+
+	if(not preparado)
+		_manifiesto.leer(parser->raiz());
+
+	// Leer la información de la etiqueta 'map'
+	_ancho_tiles = parser->atributoU32("width", parser->raiz());
+	_alto_tiles = parser->atributoU32("height", parser->raiz());
+	_ancho_un_tile = parser->atributoU32("tilewidth", parser->raiz());
+	_alto_un_tile = parser->atributoU32("tileheight", parser->raiz());
+
+	// Calcular las medidas del escenario
+	_ancho_nivel = _ancho_tiles * _ancho_un_tile;
+	_alto_nivel = _alto_tiles * _alto_un_tile;
+
+	// Calcular el número de filas y columnas de la imagen del tileset
+	TiXmlElement* imagen_tileset = parser->buscar("image", parser->raiz());
+	_filas_tileset = parser->atributoU32("height", imagen_tileset) / _alto_un_tile;
+	_columnas_tileset = parser->atributoU32("width", imagen_tileset) / _ancho_un_tile;
+
+	// Leer las propiedades de 'map'
+	TiXmlElement* propiedades = parser->buscar("properties", parser->raiz());
+	leerPropiedades(propiedades);
+
+	// Contar las capas de tiles, para reservar de una sola vez la memoria de todas ellas, a cero para que las
+	// capas incompletas queden sin tiles
+	if(_alto_tiles > 0 and _ancho_tiles > 0xFFFFFFFF / _alto_tiles)
+		throw ArchivoEx("Nivel - El mapa '" + ruta + "' tiene demasiados tiles");
+	u32 tiles_capa = _ancho_tiles * _alto_tiles;
+	u32 num_capas = 0;
+	TiXmlElement* primera = parser->buscar("layer", parser->raiz());
+	for(TiXmlElement* capa = primera ; capa and tiles_capa > 0 ; capa = parser->siguiente(capa))
+		++num_capas;
+	if(num_capas > 0)
+	{
+		// El tamaño de la memoria de los tiles, que se lee del archivo, no debe desbordar los 32 bits
+		if(tiles_capa > 0xFFFFFFFF / sizeof(Tile) / num_capas)
+			throw ArchivoEx("Nivel - El mapa '" + ruta + "' tiene demasiados tiles");
+		_tiles = (Tile*)memoria::reservar(num_capas * tiles_capa * sizeof(Tile), memoria::NIVEL);
+		if(_tiles == NULL)
+			throw ArchivoEx("Nivel - No hay memoria suficiente para los tiles del mapa '" + ruta + "'");
+		memset(_tiles, 0, num_capas * tiles_capa * sizeof(Tile));
+	}
+
+	// Leer las capas de tiles en el orden del archivo
+	_escenario.resize(num_capas);
+	TiXmlElement* capa = primera;
+	for(u32 i = 0 ; i < num_capas ; ++i, capa = parser->siguiente(capa))
+	{
+		_escenario[i].tiles = _tiles + i * tiles_capa;
+		leerCapa(capa, _escenario[i]);
+	}
+
+	// Leer los actores y almacenarlos en la estructura temporal
+	TiXmlElement* actores = parser->buscar("objectgroup", parser->raiz());
+	leerActores(actores);
+
+	_scroll_x = 0;
+	_scroll_y = 0;
+
+	// Cargar y retener todos los recursos del nivel antes de que comience
+	_manifiesto.retener();
+
+	// Resolver los recursos que se utilizan en cada frame
+	if(_imagen_fondo != "")
+		_fondo = galeria->resolver<Galeria::IMAGEN>(_imagen_fondo);
+	if(_imagen_tileset != "")
+		_tileset = galeria->resolver<Galeria::IMAGEN>(_imagen_tileset);
+	if(_musica != "")
+		_pista = galeria->resolver<Galeria::MUSICA>(_musica);
+}
+
 void Nivel::leerPropiedades(TiXmlElement* propiedades)
 {
 	for(TiXmlElement* prop = propiedades->FirstChildElement() ; prop ; prop = prop->NextSiblingElement())		
@@ -257,64 +333,7 @@ void Nivel::leerActores(TiXmlElement* actores)
 	}
 }
 
-void Nivel::leerEscenario(TiXmlElement* escenario)
+void Nivel::leerCapa(TiXmlElement* capa, Capa& c) throw (ArchivoEx)
 {
-	// Por si no hay capa de escenario
-	if(escenario == NULL)
-		return;
-
-	u32 x = 0;
-	u32 y = 0;
-	TiXmlElement* tiles = parser->buscar("data", escenario);
-	for(TiXmlElement* tile = tiles->FirstChildElement() ; tile ; tile = tile->NextSiblingElement())		
-	{
-		// Si el atributo gid es mayor que cero, entonces se trata de un tile
-		u32 gid = parser->atributoU32("gid", tile);
-		_escenario[ESCENARIO][y][x].x = x * _ancho_un_tile;
-		_escenario[ESCENARIO][y][x].y = y * _alto_un_tile;
-		_escenario[ESCENARIO][y][x].gid = gid;
-		_escenario[ESCENARIO][y][x].colision = NULL;
-
-		// Calcular cuando se llega al final de una fila de tiles
-		if(++x >= _ancho_tiles)
-		{
-			x = 0;
-			y++;
-		}
-	}
+	tiled::leerCapa(capa, c, _ancho_tiles * _alto_tiles);
 }
-
-void Nivel::leerPlataformas(TiXmlElement* plataformas)
-{
-	// Por si no hay capa de plataformas
-	if(plataformas == NULL)
-		return;
-
-	u32 x = 0;
-	u32 y = 0;
-	TiXmlElement* tiles = parser->buscar("data", plataformas);
-	for(TiXmlElement* tile = tiles->FirstChildElement() ; tile ; tile = tile->NextSiblingElement())		
-	{
-		// Si el atributo gid es mayor que cero, entonces se trata de un tile
-		u32 gid = parser->atributoU32("gid", tile);
-		_escenario[PLATAFORMAS][y][x].x = x * _ancho_un_tile;
-		_escenario[PLATAFORMAS][y][x].y = y * _alto_un_tile;
-		_escenario[PLATAFORMAS][y][x].gid = gid;
-		if(gid > 0)
-			_escenario[PLATAFORMAS][y][x].colision = new Rectangulo(
-					Punto(x * _ancho_un_tile, y * _alto_un_tile),
-					Punto((x+1) * _ancho_un_tile, y * _alto_un_tile),
-					Punto((x+1) * _ancho_un_tile, (y+1) * _alto_un_tile),
-					Punto(x * _ancho_un_tile, (y+1) * _alto_un_tile));
-		else
-			_escenario[PLATAFORMAS][y][x].colision = NULL;
-
-		// Calcular cuando se llega al final de una fila de tiles
-		if(++x >= _ancho_tiles)
-		{
-			x = 0;
-			y++;
-		}
-	}
-}
-
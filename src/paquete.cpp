@@ -0,0 +1,366 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "paquete.h"
+#ifndef GEKKO
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+using namespace std;
+
+namespace
+{
+	// Cabecera: magia (4), versión (1), relleno (3), entradas (4), nombres (4), tamaño de nombres (4), datos (4)
+	const u8 MAGIA[4] = { 'W', 'P', 'A', 'K' };
+
+	u32 leer32(const u8* p)
+	{
+		return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+	}
+
+	void escribir32(u8* p, u32 v)
+	{
+		p[0] = (u8)(v >> 24);
+		p[1] = (u8)(v >> 16);
+		p[2] = (u8)(v >> 8);
+		p[3] = (u8)v;
+	}
+
+	// Tamaño reservado para el contenido de un archivo: múltiplo de 32 bytes, con al menos un byte nulo al final
+	u32 reserva(u32 tam)
+	{
+		return (tam + paquete::ALINEACION) & ~(paquete::ALINEACION - 1);
+	}
+}
+
+bool paquete::leerCabecera(const u8* datos, u32 tam, Cabecera& c)
+{
+	if(datos == NULL or tam < TAM_CABECERA or memcmp(datos, MAGIA, 4) != 0)
+		return false;
+
+	c.version = datos[4];
+	c.entradas = leer32(datos + 8);
+	c.nombres = leer32(datos + 12);
+	c.tam_nombres = leer32(datos + 16);
+	c.datos = leer32(datos + 20);
+
+	if((c.version != 1 and c.version != VERSION) or c.datos % ALINEACION != 0)
+		return false;
+
+	// El índice, la tabla de nombres y los contenidos deben aparecer en ese orden, sin solaparse; se resta y se
+	// divide en lugar de sumar y multiplicar para que una cabecera con valores enormes no desborde las cuentas
+	return (c.nombres >= TAM_CABECERA and c.entradas <= (c.nombres - TAM_CABECERA) / TAM_ENTRADA
+			and c.datos >= c.nombres and c.tam_nombres <= c.datos - c.nombres);
+}
+
+void paquete::escribirCabecera(const Cabecera& c, u8* destino)
+{
+	memset(destino, 0, TAM_CABECERA);
+	memcpy(destino, MAGIA, 4);
+	destino[4] = c.version;
+	escribir32(destino + 8, c.entradas);
+	escribir32(destino + 12, c.nombres);
+	escribir32(destino + 16, c.tam_nombres);
+	escribir32(destino + 20, c.datos);
+}
+
+void paquete::leerEntrada(const u8* indice, u32 i, Entrada& e)
+{
+	const u8* p = indice + i * TAM_ENTRADA;
+	e.hash = leer32(p);
+	e.nombre = leer32(p + 4);
+	e.offset = leer32(p + 8);
+	e.tam = leer32(p + 12);
+	e.tam_original = leer32(p + 16);
+	e.compresion = p[20];
+
+	// Los bytes reservados valen cero en las entradas sin comprimir (y en todas las de la versión 1)
+	if(e.compresion == NINGUNA)
+		e.tam_original = e.tam;
+}
+
+void paquete::escribirEntrada(const Entrada& e, u8* destino)
+{
+	memset(destino, 0, TAM_ENTRADA);
+	escribir32(destino, e.hash);
+	escribir32(destino + 4, e.nombre);
+	escribir32(destino + 8, e.offset);
+	escribir32(destino + 12, e.tam);
+	if(e.compresion != NINGUNA)
+	{
+		escribir32(destino + 16, e.tam_original);
+		destino[20] = e.compresion;
+	}
+}
+
+bool paquete::buscar(const u8* indice, const Cabecera& c, const char* nombres, const string& nombre, Entrada& e)
+{
+	u32 h = fnv1a::hash(nombre);
+
+	// Búsqueda binaria de la primera entrada cuyo hash no sea menor que el buscado
+	u32 inicio = 0;
+	u32 fin = c.entradas;
+	while(inicio < fin)
+	{
+		u32 medio = (inicio + fin) / 2;
+		if(leer32(indice + medio * TAM_ENTRADA) < h)
+			inicio = medio + 1;
+		else
+			fin = medio;
+	}
+
+	// Entre las entradas con el mismo hash, buscar la que tenga el mismo nombre
+	for(u32 i = inicio ; i < c.entradas and leer32(indice + i * TAM_ENTRADA) == h ; ++i)
+	{
+		leerEntrada(indice, i, e);
+		if(e.nombre < c.tam_nombres and nombre == nombres + e.nombre)
+			return true;
+	}
+	return false;
+}
+
+Paquete::Paquete(void): _indice(NULL), _nombres(NULL)
+{
+	memset(&_cabecera, 0, sizeof(_cabecera));
+	#ifdef GEKKO
+	_archivo = NULL;
+	_memoria = NULL;
+	_bloque = NULL;
+	LWP_MutexInit(&_mutex, false);
+	#else
+	_mapa = NULL;
+	_tam_mapa = 0;
+	#endif
+}
+
+void Paquete::abrir(const string& ruta) throw (ArchivoEx)
+{
+	cerrar();
+
+	#ifdef GEKKO
+	_archivo = fopen(ruta.c_str(), "rb");
+	if(_archivo == NULL)
+		throw ArchivoEx("Paquete - El archivo '" + ruta + "' no existe.");
+
+	// Leer la cabecera, y después el índice y la tabla de nombres de una sola vez
+	u8 cabecera[paquete::TAM_CABECERA];
+	if(fread(cabecera, 1, paquete::TAM_CABECERA, _archivo) != paquete::TAM_CABECERA
+		or not paquete::leerCabecera(cabecera, paquete::TAM_CABECERA, _cabecera))
+	{
+		cerrar();
+		throw ArchivoEx("Paquete - El archivo '" + ruta + "' no es un paquete válido.");
+	}
+
+	u32 tam = _cabecera.nombres + _cabecera.tam_nombres - paquete::TAM_CABECERA;
+	_memoria = (u8*)memoria::reservar(reserva(tam), memoria::ARCHIVOS);
+	if(_memoria == NULL)
+	{
+		cerrar();
+		throw ArchivoEx("Paquete - No hay memoria para el índice de '" + ruta + "'");
+	}
+	memset(_memoria + tam, 0, reserva(tam) - tam);
+
+	if(fread(_memoria, 1, tam, _archivo) != tam)
+	{
+		cerrar();
+		throw ArchivoEx("Paquete - Error al leer el índice de '" + ruta + "'");
+	}
+
+	_indice = _memoria;
+	_nombres = (const char*)_memoria + (_cabecera.nombres - paquete::TAM_CABECERA);
+	#else
+	int fd = open(ruta.c_str(), O_RDONLY);
+	if(fd < 0)
+		throw ArchivoEx("Paquete - El archivo '" + ruta + "' no existe.");
+
+	// Proyectar el paquete completo en memoria; el descriptor ya no hace falta después
+	struct stat info;
+	if(fstat(fd, &info) == 0 and info.st_size > 0)
+	{
+		void* mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapa != MAP_FAILED)
+		{
+			_mapa = (u8*)mapa;
+			_tam_mapa = info.st_size;
+		}
+	}
+	close(fd);
+
+	if(_mapa == NULL or not paquete::leerCabecera(_mapa, _tam_mapa, _cabecera)
+		or _cabecera.datos > _tam_mapa)
+	{
+		cerrar();
+		throw ArchivoEx("Paquete - El archivo '" + ruta + "' no es un paquete válido.");
+	}
+
+	_indice = _mapa + paquete::TAM_CABECERA;
+	_nombres = (const char*)_mapa + _cabecera.nombres;
+	#endif
+
+	_ruta = ruta;
+}
+
+void Paquete::cerrar(void)
+{
+	#ifdef GEKKO
+	if(_archivo != NULL)
+		fclose(_archivo);
+	memoria::liberar(_memoria);
+	memoria::liberar(_bloque);
+	_archivo = NULL;
+	_memoria = NULL;
+	_bloque = NULL;
+	#else
+	if(_mapa != NULL)
+		munmap(_mapa, _tam_mapa);
+	_mapa = NULL;
+	_tam_mapa = 0;
+	#endif
+
+	_ruta.clear();
+	_indice = NULL;
+	_nombres = NULL;
+	memset(&_cabecera, 0, sizeof(_cabecera));
+}
+
+bool Paquete::abierto(void) const
+{
+	return (_indice != NULL);
+}
+
+u32 Paquete::entradas(void) const
+{
+	return _cabecera.entradas;
+}
+
+paquete::Entrada Paquete::entrada(u32 i) const
+{
+	paquete::Entrada e;
+	paquete::leerEntrada(_indice, i, e);
+	return e;
+}
+
+string Paquete::nombre(const paquete::Entrada& e) const
+{
+	if(e.nombre >= _cabecera.tam_nombres)
+		return string();
+	return string(_nombres + e.nombre);
+}
+
+bool Paquete::buscar(const string& nombre, paquete::Entrada& e) const
+{
+	if(not abierto())
+		return false;
+	return paquete::buscar(_indice, _cabecera, _nombres, nombre, e);
+}
+
+u8* Paquete::leer(const paquete::Entrada& e, memoria::Etiqueta etiqueta) throw (ArchivoEx)
+{
+	if(e.compresion != paquete::NINGUNA and e.compresion != paquete::LZ4)
+		throw ArchivoEx("Paquete - Compresión desconocida en '" + nombre(e) + "' de '" + _ruta + "'");
+
+	u8* datos = (u8*)memoria::reservar(reserva(e.tam_original), etiqueta);
+	if(datos == NULL)
+		throw ArchivoEx("Paquete - No hay memoria para un archivo de '" + _ruta + "'");
+	memset(datos + e.tam_original, 0, reserva(e.tam_original) - e.tam_original);
+
+	#ifdef GEKKO
+	// El hilo de carga y el hilo principal comparten el archivo abierto
+	LWP_MutexLock(_mutex);
+	bool correcto = (fseek(_archivo, e.offset, SEEK_SET) == 0);
+	if(e.compresion == paquete::NINGUNA)
+		correcto = correcto and fread(datos, 1, e.tam, _archivo) == e.tam;
+	else
+		correcto = correcto and descomprimir(e, datos);
+	LWP_MutexUnlock(_mutex);
+	#else
+	bool correcto = ((size_t)e.offset + e.tam <= _tam_mapa);
+	if(correcto and e.compresion == paquete::NINGUNA)
+		memcpy(datos, _mapa + e.offset, e.tam);
+	else if(correcto)
+		correcto = lz4::descomprimir(_mapa + e.offset, e.tam, datos, e.tam_original);
+	#endif
+
+	if(not correcto)
+	{
+		memoria::liberar(datos);
+		throw ArchivoEx("Paquete - Error al leer '" + nombre(e) + "' de '" + _ruta + "'");
+	}
+	return datos;
+}
+
+#ifndef GEKKO
+const u8* Paquete::contenido(const paquete::Entrada& e) const
+{
+	if((size_t)e.offset + e.tam > _tam_mapa)
+		return NULL;
+	return _mapa + e.offset;
+}
+#endif
+
+#ifdef GEKKO
+bool Paquete::descomprimir(const paquete::Entrada& e, u8* destino)
+{
+	// La memoria intermedia para un bloque comprimido se reserva la primera vez y se reutiliza en adelante
+	if(_bloque == NULL)
+		_bloque = (u8*)memoria::reservar(lz4::cotaBloque(lz4::TAM_BLOQUE), memoria::ARCHIVOS);
+	if(_bloque == NULL)
+		return false;
+
+	// Leer los bloques de uno en uno, y descomprimir cada uno directamente en su posición del destino
+	u32 leidos = 0;
+	u32 escritos = 0;
+	u8 cabecera[4];
+	while(escritos < e.tam_original)
+	{
+		if(e.tam - leidos < 4 or fread(cabecera, 1, 4, _archivo) != 4)
+			return false;
+		u32 tam = lz4::leerTamBloque(cabecera);
+		u32 bytes = lz4::bytesBloque(tam);
+		leidos += 4;
+
+		u32 salida = (e.tam_original - escritos > lz4::TAM_BLOQUE) ? lz4::TAM_BLOQUE : e.tam_original - escritos;
+		if(bytes > e.tam - leidos or bytes > lz4::cotaBloque(lz4::TAM_BLOQUE))
+			return false;
+
+		// Los bloques guardados sin comprimir se leen directamente en el destino
+		if(tam & lz4::SIN_COMPRIMIR)
+		{
+			if(bytes != salida or fread(destino + escritos, 1, bytes, _archivo) != bytes)
+				return false;
+		}
+		else if(fread(_bloque, 1, bytes, _archivo) != bytes
+				or not lz4::descomprimirBloque(_bloque, tam, destino, destino + escritos, salida))
+			return false;
+
+		leidos += bytes;
+		escritos += salida;
+	}
+	return (leidos == e.tam);
+}
+#endif
+
+Paquete::~Paquete(void)
+{
+	cerrar();
+	#ifdef GEKKO
+	LWP_MutexDestroy(_mutex);
+	#endif
+}
@@ -21,8 +21,25 @@ using namespace std;
 
 Parser* Parser::_instance = 0;
 
+Parser::~Parser(void)
+{
+	for(map<string, TiXmlDocument*>::iterator i = _precargados.begin() ; i != _precargados.end() ; ++i)
+		delete i->second;
+	_precargados.clear();
+}
+
 void Parser::cargar(const std::string& ruta) throw (ArchivoEx, TarjetaEx)
 {
+	// Si el documento ya se ha leído en segundo plano, utilizarlo sin volver a acceder a la tarjeta
+	map<string, TiXmlDocument*>::iterator i = _precargados.find(ruta);
+	if(i != _precargados.end())
+	{
+		_doc = *(i->second);
+		delete i->second;
+		_precargados.erase(i);
+		return;
+	}
+
 	// Comprobar que la SD está montada
 	if(not sdcard->montada())
 		throw TarjetaEx("Parser - La tarjeta SD no está montada");
@@ -30,18 +47,29 @@ void Parser::cargar(const std::string& ruta) throw (ArchivoEx, TarjetaEx)
 	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
 	string archivo = sdcard->unidad() + ":" + ruta;
 
-	// Comprobar la existencia del archivo
-	if(not sdcard->existe(archivo))
-		throw ArchivoEx("Parser::cargar - El archivo '" + archivo + "' no existe.");
+	// Leer el archivo completo de una sola vez (del paquete montado, si lo contiene); el contenido leído siempre
+	// termina en un carácter nulo, así que se puede analizar directamente
+	u32 tam = 0;
+	u8* datos = sdcard->leer(archivo, tam, memoria::XML);
 
 	_doc = TiXmlDocument(archivo);
+	_doc.Parse((const char*)datos, NULL, TIXML_ENCODING_UTF8);
+	memoria::liberar(datos);
 
-	try{
-		_doc.LoadFile(TIXML_ENCODING_UTF8);
-	}
-	catch(...) {
-		throw ArchivoEx("Parser - Error al cargar el archivo '" + archivo + "'");
+	if(_doc.Error())
+		throw ArchivoEx("Parser - Error al cargar el archivo '" + archivo + "': " + _doc.ErrorDesc());
+}
+
+void Parser::precargar(const std::string& ruta, TiXmlDocument* doc)
+{
+	map<string, TiXmlDocument*>::iterator i = _precargados.find(ruta);
+	if(i != _precargados.end())
+	{
+		delete i->second;
+		_precargados.erase(i);
 	}
+	if(doc != NULL)
+		_precargados[ruta] = doc;
 }
 
 TiXmlElement* Parser::raiz(void)
@@ -0,0 +1,275 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "perfilador.h"
+#include <cstdio>
+#include <fstream>
+#ifdef GEKKO
+	#include <ogc/lwp.h>
+#else
+	#include <pthread.h>
+#endif
+using namespace std;
+
+Perfilador* Perfilador::_instance = 0;
+
+namespace
+{
+	// Medidas de la gráfica en pantalla, en píxeles
+	const s16 MARGEN = 16;
+	const s16 ALTO_ZONA = 6;
+	const s16 ALTO_HISTORIA = 48;
+	const u32 MAX_NIVELES = 4;
+
+	// Colores de las zonas; cada nombre toma siempre el mismo
+	const u32 COLORES[] = { 0xE6194BC0, 0x3CB44BC0, 0xFFE119C0, 0x4363D8C0, 0xF58231C0, 0x911EB4C0, 0x46F0F0C0,
+							0xF032E6C0, 0xBCF60CC0, 0x008080C0 };
+	const u32 FONDO = 0x00000080;
+	const u32 LIMITE = 0xFFFFFFFF;
+
+	// Escribe un evento completo de traza de Chrome; los instantes se indican en nanosegundos y se escriben en
+	// microsegundos con tres decimales
+	void escribirEvento(ofstream& archivo, const char* nombre, u32 hilo, u64 inicio, u64 duracion)
+	{
+		char linea[256];
+		snprintf(linea, sizeof(linea), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03u,"
+				"\"dur\":%llu.%03u}", nombre, hilo, (unsigned long long)(inicio / 1000), (u32)(inicio % 1000),
+				(unsigned long long)(duracion / 1000), (u32)(duracion % 1000));
+		archivo << linea;
+	}
+}
+
+// Zona
+Perfilador::Zona::Zona(const char* nombre): _nombre(nombre), _inicio(0), _hilo(0), _profundidad(0)
+{
+	Perfilador* p = perfilador;
+	if(not p->_activo)
+		return;
+
+	_hilo = hilo();
+	if(_hilo == p->_principal)
+		_profundidad = p->_profundidad++;
+	_inicio = Ritmo::ahora();
+}
+
+Perfilador::Zona::~Zona(void)
+{
+	if(_inicio == 0)
+		return;
+
+	Perfilador* p = perfilador;
+	if(_hilo == p->_principal and p->_profundidad > 0)
+		p->_profundidad--;
+	p->registrar(_nombre, _inicio, Ritmo::ahora(), _hilo, _profundidad);
+}
+
+// Perfilador
+void Perfilador::setActivo(bool activo)
+{
+	_activo = activo;
+	_principal = hilo();
+	_profundidad = 0;
+}
+
+bool Perfilador::activo(void) const
+{
+	return _activo;
+}
+
+void Perfilador::setVisible(bool visible)
+{
+	_visible = visible;
+}
+
+bool Perfilador::visible(void) const
+{
+	return _visible;
+}
+
+void Perfilador::nuevoFrame(void)
+{
+	if(not _activo)
+		return;
+
+	_frames[_frame & (MAX_FRAMES - 1)] = Ritmo::ahora();
+	_frame++;
+}
+
+void Perfilador::registrar(const char* nombre, u64 inicio, u64 fin, u32 hilo, u8 profundidad)
+{
+	// La posición se reserva con un incremento atómico, así que varios hilos pueden registrar a la vez
+	u32 i = __sync_fetch_and_add(&_escritos, 1) & (MAX_EVENTOS - 1);
+	Evento& e = _eventos[i];
+	e.nombre = nombre;
+	e.inicio = inicio;
+	e.fin = fin;
+	e.hilo = hilo;
+	e.profundidad = profundidad;
+}
+
+void Perfilador::dibujar(void) const
+{
+	// Hacen falta al menos dos frames completos: el último y el anterior, para conocer su duración
+	if(not _visible or not _activo or _frame < 3)
+		return;
+
+	// La escala de las dos gráficas abarca dos frames
+	u32 periodo = screen->ritmo().periodo();
+	if(periodo == 0)
+		periodo = 16667;
+	s16 ancho = screen->ancho() - 2 * MARGEN;
+	f32 escala = (f32)ancho / (2000.0f * periodo);
+
+	s16 y_historia = MARGEN + MAX_NIVELES * ALTO_ZONA + 4;
+	screen->dibujarRectangulo(MARGEN, MARGEN, MARGEN + ancho, MARGEN, MARGEN + ancho, y_historia + ALTO_HISTORIA,
+								MARGEN, y_historia + ALTO_HISTORIA, 2, FONDO);
+
+	// Zonas del hilo principal que comenzaron durante el último frame completo
+	u64 inicio = _frames[(_frame - 2) & (MAX_FRAMES - 1)];
+	u64 fin = _frames[(_frame - 1) & (MAX_FRAMES - 1)];
+	u32 escritos = _escritos;
+	u32 total = (escritos < MAX_EVENTOS) ? escritos : MAX_EVENTOS;
+	for(u32 n = 1 ; n <= total ; ++n)
+	{
+		const Evento& e = _eventos[(escritos - n) & (MAX_EVENTOS - 1)];
+		if(e.hilo != _principal)
+			continue;
+		// Las zonas del hilo principal se registran en orden de fin, así que a partir de aquí son más antiguas
+		if(e.fin < inicio)
+			break;
+		if(e.inicio < inicio or e.inicio >= fin or e.profundidad >= MAX_NIVELES)
+			continue;
+
+		s16 x1 = MARGEN + (s16)((e.inicio - inicio) * escala);
+		s16 x2 = MARGEN + (s16)((e.fin - inicio) * escala);
+		if(x1 > MARGEN + ancho)
+			continue;
+		if(x2 > MARGEN + ancho)
+			x2 = MARGEN + ancho;
+		if(x2 <= x1)
+			x2 = x1 + 1;
+		s16 y1 = MARGEN + e.profundidad * ALTO_ZONA;
+		s16 y2 = y1 + ALTO_ZONA - 1;
+		screen->dibujarRectangulo(x1, y1, x2, y1, x2, y2, x1, y2, 1, color(e.nombre));
+	}
+
+	// Duración de los últimos frames, uno por barra
+	u32 frames = (_frame - 1 < MAX_FRAMES) ? _frame - 1 : MAX_FRAMES - 1;
+	s16 ancho_barra = ancho / (MAX_FRAMES - 1);
+	f32 escala_historia = (f32)ALTO_HISTORIA / (2000.0f * periodo);
+	for(u32 n = 0 ; n < frames ; ++n)
+	{
+		u32 f = _frame - 1 - frames + n;
+		u64 duracion = _frames[(f + 1) & (MAX_FRAMES - 1)] - _frames[f & (MAX_FRAMES - 1)];
+		s16 alto = (s16)(duracion * escala_historia);
+		if(alto > ALTO_HISTORIA)
+			alto = ALTO_HISTORIA;
+		if(alto < 1)
+			alto = 1;
+		s16 x1 = MARGEN + n * ancho_barra;
+		s16 x2 = x1 + ancho_barra - 1;
+		s16 y2 = y_historia + ALTO_HISTORIA;
+		u32 c = (duracion > 1500ull * periodo) ? COLORES[0] : COLORES[1];
+		screen->dibujarRectangulo(x1, y2 - alto, x2, y2 - alto, x2, y2, x1, y2, 1, c);
+	}
+
+	// Duración prevista de un frame, en la mitad de las dos escalas
+	s16 x = MARGEN + ancho / 2;
+	screen->dibujarLinea(x, MARGEN, x, MARGEN + MAX_NIVELES * ALTO_ZONA, 0, 1, LIMITE);
+	s16 y = y_historia + ALTO_HISTORIA / 2;
+	screen->dibujarLinea(MARGEN, y, MARGEN + ancho, y, 0, 1, LIMITE);
+}
+
+void Perfilador::exportar(const string& ruta) const throw (ArchivoEx, TarjetaEx)
+{
+	if(not sdcard->montada())
+		throw TarjetaEx("Perfilador::exportar - La tarjeta SD no está montada");
+
+	string ruta_completa = sdcard->unidad() + ":" + ruta;
+	ofstream archivo(ruta_completa.c_str());
+	if(not archivo.good())
+		throw ArchivoEx("Perfilador::exportar - Error al abrir el archivo: " + ruta);
+
+	// Los instantes se escriben en microsegundos, relativos al evento más antiguo
+	u32 escritos = _escritos;
+	u32 total = (escritos < MAX_EVENTOS) ? escritos : MAX_EVENTOS;
+	u64 origen = 0;
+	for(u32 n = 0 ; n < total ; ++n)
+	{
+		const Evento& e = _eventos[(escritos - total + n) & (MAX_EVENTOS - 1)];
+		if(origen == 0 or e.inicio < origen)
+			origen = e.inicio;
+	}
+
+	archivo << "{\"traceEvents\":[\n";
+	archivo << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"libWiiEsp\"}}";
+
+	for(u32 n = 0 ; n < total ; ++n)
+	{
+		const Evento& e = _eventos[(escritos - total + n) & (MAX_EVENTOS - 1)];
+		if(e.nombre == NULL or e.fin < e.inicio)
+			continue;
+		escribirEvento(archivo, e.nombre, e.hilo, e.inicio - origen, e.fin - e.inicio);
+	}
+
+	// Cada frame, como un evento propio en una fila aparte (hilo 0)
+	u32 frames = (_frame < MAX_FRAMES) ? _frame : MAX_FRAMES;
+	for(u32 n = 0 ; n + 1 < frames ; ++n)
+	{
+		u32 f = _frame - frames + n;
+		u64 inicio = _frames[f & (MAX_FRAMES - 1)];
+		u64 fin = _frames[(f + 1) & (MAX_FRAMES - 1)];
+		if(inicio < origen)
+			continue;
+		char nombre[32];
+		snprintf(nombre, sizeof(nombre), "frame %u", f);
+		escribirEvento(archivo, nombre, 0, inicio - origen, fin - inicio);
+	}
+
+	archivo << "\n]}\n";
+	if(not archivo.good())
+		throw ArchivoEx("Perfilador::exportar - Error al escribir el archivo: " + ruta);
+}
+
+u32 Perfilador::hilo(void)
+{
+	#ifdef GEKKO
+	return (u32)LWP_GetSelf();
+	#else
+	return (u32)(size_t)pthread_self();
+	#endif
+}
+
+// Métodos protegidos
+Perfilador::Perfilador(void): _escritos(0), _frame(0), _principal(0), _profundidad(0), _activo(false),
+	_visible(false)
+{
+	memset(_eventos, 0, sizeof(_eventos));
+	memset(_frames, 0, sizeof(_frames));
+}
+
+Perfilador::~Perfilador(void)
+{
+
+}
+
+// Métodos privados
+u32 Perfilador::color(const char* nombre)
+{
+	return COLORES[fnv1a::hash(nombre) % (sizeof(COLORES) / sizeof(COLORES[0]))];
+}
@@ -0,0 +1,454 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pngdec.h"
+
+namespace
+{
+	const u8 FIRMA[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+	// Cada bloque tiene 4 bytes de longitud, 4 de tipo, el contenido y 4 de CRC
+	const u32 TAM_FIRMA = 8;
+	const u32 TAM_BLOQUE = 12;
+	const u32 TAM_IHDR = 13;
+
+	u32 leer32(const u8* p)
+	{
+		return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+	}
+
+	u16 leer16(const u8* p)
+	{
+		return ((u16)p[0] << 8) | (u16)p[1];
+	}
+
+	bool esTipo(const u8* bloque, const char* tipo)
+	{
+		return (memcmp(bloque + 4, tipo, 4) == 0);
+	}
+
+	u32 canales(u8 color)
+	{
+		switch(color)
+		{
+			case png::GRIS:
+			case png::PALETA:
+				return 1;
+			case png::GRIS_ALPHA:
+				return 2;
+			case png::RGB:
+				return 3;
+			case png::RGBA:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	bool profundidadValida(u8 color, u8 profundidad)
+	{
+		switch(color)
+		{
+			case png::GRIS:
+				return (profundidad == 1 or profundidad == 2 or profundidad == 4 or profundidad == 8
+						or profundidad == 16);
+			case png::PALETA:
+				return (profundidad == 1 or profundidad == 2 or profundidad == 4 or profundidad == 8);
+			case png::RGB:
+			case png::GRIS_ALPHA:
+			case png::RGBA:
+				return (profundidad == 8 or profundidad == 16);
+			default:
+				return false;
+		}
+	}
+
+	u16 opaco(u32 c)
+	{
+		return 0x8000 | ((c >> 9) & 0x7C00) | ((c >> 6) & 0x03E0) | ((c >> 3) & 0x001F);
+	}
+
+	// Recorre los bloques IDAT consecutivos, entregando su contenido al Inflador; la posición apunta siempre al
+	// comienzo del siguiente bloque, y leerCabecera() ya ha comprobado que todos están completos
+	bool siguienteIdat(void* contexto, const u8*& datos, u32& tam)
+	{
+		const u8*& bloque = *(const u8**)contexto;
+		if(not esTipo(bloque, "IDAT"))
+			return false;
+		tam = leer32(bloque);
+		datos = bloque + 8;
+		bloque += TAM_BLOQUE + tam;
+		return true;
+	}
+
+	u8 paeth(u8 a, u8 b, u8 c)
+	{
+		s32 p = (s32)a + b - c;
+		s32 pa = p > a ? p - a : a - p;
+		s32 pb = p > b ? p - b : b - p;
+		s32 pc = p > c ? p - c : c - p;
+		if(pa <= pb and pa <= pc)
+			return a;
+		return (pb <= pc) ? b : c;
+	}
+
+	// Deshace el filtro de una fila; la anterior ya está reconstruida (o a cero, si es la primera)
+	bool defiltrar(u8 filtro, u8* fila, const u8* anterior, u32 paso, u32 bpp)
+	{
+		switch(filtro)
+		{
+			case 0:
+				return true;
+			case 1:
+				for(u32 i = bpp ; i < paso ; ++i)
+					fila[i] += fila[i - bpp];
+				return true;
+			case 2:
+				for(u32 i = 0 ; i < paso ; ++i)
+					fila[i] += anterior[i];
+				return true;
+			case 3:
+				for(u32 i = 0 ; i < bpp ; ++i)
+					fila[i] += anterior[i] >> 1;
+				for(u32 i = bpp ; i < paso ; ++i)
+					fila[i] += ((u32)fila[i - bpp] + anterior[i]) >> 1;
+				return true;
+			case 4:
+				for(u32 i = 0 ; i < bpp ; ++i)
+					fila[i] += anterior[i];
+				for(u32 i = bpp ; i < paso ; ++i)
+					fila[i] += paeth(fila[i - bpp], anterior[i], anterior[i - bpp]);
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	// Los núcleos convierten una fila completa, en grupos de 4 píxeles; cada grupo ocupa una fila de un tile, y el
+	// grupo siguiente está 16 píxeles (un tile completo) más adelante en el destino
+	void filaTabla8(const u8* p, u32 ancho, const u16* tabla, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, p += 4, d += 16)
+		{
+			d[0] = tabla[p[0]];
+			d[1] = tabla[p[1]];
+			d[2] = tabla[p[2]];
+			d[3] = tabla[p[3]];
+		}
+	}
+
+	// Índices de 1, 2 o 4 bits, empezando por los bits de mayor peso de cada byte
+	void filaTablaBits(const u8* p, u32 ancho, u32 profundidad, const u16* tabla, u16* d)
+	{
+		u32 mascara = (1 << profundidad) - 1;
+		u32 bit = 0;
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, bit += profundidad)
+				d[i] = tabla[(p[bit >> 3] >> (8 - profundidad - (bit & 7))) & mascara];
+		}
+	}
+
+	void filaRgb(const u8* p, u32 ancho, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, p += 12, d += 16)
+		{
+			u32 c0 = ((u32)p[0] << 16) | ((u32)p[1] << 8) | p[2];
+			u32 c1 = ((u32)p[3] << 16) | ((u32)p[4] << 8) | p[5];
+			u32 c2 = ((u32)p[6] << 16) | ((u32)p[7] << 8) | p[8];
+			u32 c3 = ((u32)p[9] << 16) | ((u32)p[10] << 8) | p[11];
+			d[0] = (c0 == clave) ? transparente : opaco(c0);
+			d[1] = (c1 == clave) ? transparente : opaco(c1);
+			d[2] = (c2 == clave) ? transparente : opaco(c2);
+			d[3] = (c3 == clave) ? transparente : opaco(c3);
+		}
+	}
+
+	// Con 16 bits, el bloque tRNS indica el color exacto de 48 bits; si no hay, se compara el color reducido a 24
+	void filaRgb16(const u8* p, u32 ancho, const u8* trns, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, p += 6)
+			{
+				u32 c = ((u32)p[0] << 16) | ((u32)p[2] << 8) | p[4];
+				bool invisible = trns ? memcmp(p, trns, 6) == 0 : c == clave;
+				d[i] = invisible ? transparente : opaco(c);
+			}
+		}
+	}
+
+	void filaGris16(const u8* p, u32 ancho, const u8* trns, u32 clave, u16 transparente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, p += 2)
+			{
+				u32 c = p[0] * 0x010101;
+				bool invisible = trns ? memcmp(p, trns, 2) == 0 : c == clave;
+				d[i] = invisible ? transparente : opaco(c);
+			}
+		}
+	}
+
+	// Píxeles con alpha; en 16 bits, cada componente ocupa dos bytes y se toma el de mayor peso
+	void filaGrisAlpha(const u8* p, u32 ancho, u32 componente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, p += 2 * componente)
+				d[i] = bmp::rgb5a3(p[0], p[0], p[0], p[componente]);
+		}
+	}
+
+	void filaRgba(const u8* p, u32 ancho, u32 componente, u16* d)
+	{
+		for(u32 x = 0 ; x < ancho ; x += 4, d += 16)
+		{
+			for(u32 i = 0 ; i < 4 ; ++i, p += 4 * componente)
+				d[i] = bmp::rgb5a3(p[0], p[componente], p[2 * componente], p[3 * componente]);
+		}
+	}
+
+	// Tabla de colores RGB5A3 de una imagen con paleta, o de gris de hasta 8 bits
+	void construirTabla(const u8* datos, const png::Info& info, u32 clave, u16 invisible, u16* tabla)
+	{
+		const u8* trns = info.transparencia ? datos + info.transparencia : NULL;
+
+		if(info.color == png::PALETA)
+		{
+			const u8* paleta = datos + info.paleta;
+			for(u32 i = 0 ; i < 256 ; ++i)
+			{
+				u32 c = 0;
+				if(i < info.colores)
+					c = ((u32)paleta[i * 3] << 16) | ((u32)paleta[i * 3 + 1] << 8) | paleta[i * 3 + 2];
+
+				// Con bloque tRNS, cada color tiene su alpha (opaco si el bloque no llega hasta él)
+				if(trns)
+				{
+					u8 a = (i < info.tam_transparencia) ? trns[i] : 255;
+					tabla[i] = bmp::rgb5a3((u8)(c >> 16), (u8)(c >> 8), (u8)c, a);
+				}
+				else
+					tabla[i] = (c == clave) ? invisible : opaco(c);
+			}
+			return;
+		}
+
+		// Gris: cada valor se escala a 8 bits, y el bloque tRNS indica el valor invisible
+		u32 maximo = (1 << info.profundidad) - 1;
+		for(u32 v = 0 ; v <= maximo ; ++v)
+		{
+			u32 c = (v * 255 / maximo) * 0x010101;
+			bool transparente = trns ? v == leer16(trns) : c == clave;
+			tabla[v] = transparente ? invisible : opaco(c);
+		}
+		for(u32 v = maximo + 1 ; v < 256 ; ++v)
+			tabla[v] = 0;
+	}
+}
+
+bool png::esPng(const u8* datos, u32 tam)
+{
+	return (datos != NULL and tam >= TAM_FIRMA and memcmp(datos, FIRMA, TAM_FIRMA) == 0);
+}
+
+bool png::leerCabecera(const u8* datos, u32 tam, Info& info)
+{
+	if(not esPng(datos, tam) or tam < TAM_FIRMA + TAM_BLOQUE + TAM_IHDR)
+		return false;
+
+	// El primer bloque es siempre la cabecera
+	const u8* ihdr = datos + TAM_FIRMA;
+	if(leer32(ihdr) != TAM_IHDR or not esTipo(ihdr, "IHDR"))
+		return false;
+
+	u32 ancho = leer32(ihdr + 8);
+	u32 alto = leer32(ihdr + 12);
+	info.profundidad = ihdr[16];
+	info.color = ihdr[17];
+
+	// Compresión Deflate, filtros estándar y sin entrelazado
+	if(ihdr[18] != 0 or ihdr[19] != 0 or ihdr[20] != 0)
+		return false;
+	if(ancho == 0 or alto == 0 or ancho > 0xFFFF or alto > 0xFFFF or ancho % 4 != 0 or alto % 4 != 0)
+		return false;
+	if(not profundidadValida(info.color, info.profundidad))
+		return false;
+
+	info.ancho = (u16)ancho;
+	info.alto = (u16)alto;
+	info.paso = (ancho * canales(info.color) * info.profundidad + 7) / 8;
+	info.datos = 0;
+	info.paleta = 0;
+	info.colores = 0;
+	info.transparencia = 0;
+	info.tam_transparencia = 0;
+
+	// Recorrer el resto de bloques hasta el final de la imagen
+	bool fin_datos = false;
+	u32 pos = TAM_FIRMA + TAM_BLOQUE + TAM_IHDR;
+	while(true)
+	{
+		if(tam - pos < TAM_BLOQUE)
+			return false;
+		const u8* bloque = datos + pos;
+		u32 longitud = leer32(bloque);
+		if(longitud > tam - pos - TAM_BLOQUE)
+			return false;
+
+		if(esTipo(bloque, "IEND"))
+			break;
+
+		if(esTipo(bloque, "IDAT"))
+		{
+			// Los bloques de datos tienen que ser consecutivos
+			if(fin_datos)
+				return false;
+			if(info.datos == 0)
+				info.datos = pos;
+		}
+		else if(info.datos != 0)
+			fin_datos = true;
+
+		if(esTipo(bloque, "PLTE"))
+		{
+			if(longitud % 3 != 0 or longitud / 3 > 256 or info.datos != 0)
+				return false;
+			info.paleta = pos + 8;
+			info.colores = longitud / 3;
+		}
+		else if(esTipo(bloque, "tRNS"))
+		{
+			// Gris: un valor de 16 bits; RGB: tres; paleta: un alpha por color, como mucho
+			if((info.color == GRIS and longitud != 2) or (info.color == RGB and longitud != 6)
+				or (info.color == PALETA and longitud > 256))
+				return false;
+			if(info.color != GRIS_ALPHA and info.color != RGBA)
+			{
+				info.transparencia = pos + 8;
+				info.tam_transparencia = longitud;
+			}
+		}
+
+		pos += TAM_BLOQUE + longitud;
+	}
+
+	if(info.datos == 0 or (info.color == PALETA and info.paleta == 0))
+		return false;
+
+	info.alpha = (info.color == GRIS_ALPHA or info.color == RGBA or info.transparencia != 0);
+	return true;
+}
+
+u32 png::tamTextura(const Info& info)
+{
+	return (u32)info.ancho * info.alto * sizeof(u16);
+}
+
+bool png::decodificar(const u8* datos, const Info& info, u32 transparente, u16* destino)
+{
+	// El color transparente, en la forma 0xRRGGBB, y su codificación en RGB5A3 con alpha a cero; con información
+	// de transparencia propia, el color clave no se utiliza
+	u32 clave = transparente >> 8;
+	u16 invisible = bmp::rgb5a3((u8)(clave >> 16), (u8)(clave >> 8), (u8)clave, 0);
+	const u8* trns = info.transparencia ? datos + info.transparencia : NULL;
+	if(trns)
+	{
+		clave = 0xFFFFFFFF;
+		invisible = 0;
+		if(info.color == RGB and info.profundidad == 8)
+		{
+			// El color invisible de tRNS se puede tratar como un color clave más
+			clave = ((u32)trns[1] << 16) | ((u32)trns[3] << 8) | trns[5];
+			invisible = bmp::rgb5a3(trns[1], trns[3], trns[5], 0);
+		}
+	}
+
+	u16 tabla[256];
+	bool con_tabla = (info.color == PALETA or (info.color == GRIS and info.profundidad <= 8));
+	if(con_tabla)
+		construirTabla(datos, info, clave, invisible, tabla);
+
+	// Dos filas, cada una precedida de su byte de filtro; la anterior a la primera es todo ceros
+	u32 bpp = (canales(info.color) * info.profundidad + 7) / 8;
+	u8* filas = (u8*)memoria::reservar(2 * (info.paso + 1), memoria::TEXTURAS);
+	if(filas == NULL)
+		return false;
+	memset(filas, 0, 2 * (info.paso + 1));
+	u8* anterior = filas;
+	u8* actual = filas + info.paso + 1;
+
+	const u8* bloque = datos + info.datos;
+	Inflador z(siguienteIdat, &bloque, true, memoria::TEXTURAS);
+
+	bool correcto = true;
+	for(u32 y = 0 ; y < info.alto and correcto ; ++y)
+	{
+		if(z.leer(actual, info.paso + 1) != info.paso + 1
+			or not defiltrar(actual[0], actual + 1, anterior + 1, info.paso, bpp))
+		{
+			correcto = false;
+			break;
+		}
+
+		// Primer grupo de la fila: la fila de tiles, y dentro de cada tile, la fila de píxeles
+		const u8* p = actual + 1;
+		u16* d = destino + (y >> 2) * info.ancho * 4 + (y & 3) * 4;
+
+		if(con_tabla)
+		{
+			if(info.profundidad == 8)
+				filaTabla8(p, info.ancho, tabla, d);
+			else
+				filaTablaBits(p, info.ancho, info.profundidad, tabla, d);
+		}
+		else
+		{
+			u32 componente = info.profundidad / 8;
+			switch(info.color)
+			{
+				case GRIS:
+					filaGris16(p, info.ancho, trns, clave, invisible, d);
+					break;
+				case RGB:
+					if(componente == 1)
+						filaRgb(p, info.ancho, clave, invisible, d);
+					else
+						filaRgb16(p, info.ancho, trns, clave, invisible, d);
+					break;
+				case GRIS_ALPHA:
+					filaGrisAlpha(p, info.ancho, componente, d);
+					break;
+				case RGBA:
+					filaRgba(p, info.ancho, componente, d);
+					break;
+			}
+		}
+
+		u8* t = anterior;
+		anterior = actual;
+		actual = t;
+	}
+
+	memoria::liberar(filas);
+
+	// El flujo tiene que terminar justo después de la última fila, con su suma Adler-32 correcta
+	return (correcto and z.terminar());
+}
@@ -0,0 +1,499 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "rasterizador.h"
+using namespace std;
+
+namespace
+{
+	// Profundidad máxima del buffer de 24 bits; los fragmentos más lejanos quedan fuera de la escena
+	const u32 PROFUNDIDAD_MAXIMA = 0x00FFFFFF;
+
+	// Valor de _escala_cargada cuando los descriptores están preparados para dibujar color directo, como en Screen
+	const s16 DESCRIPTORES_COLOR = -2;
+
+	// Expansión de un color RGB5A3 a 8 bits por componente, como la hace el procesador gráfico
+	u32 rgba(u16 c)
+	{
+		u32 r, g, b, a;
+		if(c & 0x8000)
+		{
+			r = (c >> 10) & 0x1F;
+			g = (c >> 5) & 0x1F;
+			b = c & 0x1F;
+			r = (r << 3) | (r >> 2);
+			g = (g << 3) | (g >> 2);
+			b = (b << 3) | (b >> 2);
+			a = 0xFF;
+		}
+		else
+		{
+			a = (c >> 12) & 0x07;
+			a = (a << 5) | (a << 2) | (a >> 1);
+			r = ((c >> 8) & 0x0F) * 0x11;
+			g = ((c >> 4) & 0x0F) * 0x11;
+			b = (c & 0x0F) * 0x11;
+		}
+		return (r << 24) | (g << 16) | (b << 8) | a;
+	}
+
+	// Mezcla de dos colores componente a componente, con un peso de 0 a 256 para el segundo
+	u32 mezclar(u32 c0, u32 c1, u32 peso)
+	{
+		u32 resultado = 0;
+		for(u32 desp = 0 ; desp < 32 ; desp += 8)
+		{
+			u32 a = (c0 >> desp) & 0xFF;
+			u32 b = (c1 >> desp) & 0xFF;
+			resultado |= (((a * (256 - peso) + b * peso) >> 8) & 0xFF) << desp;
+		}
+		return resultado;
+	}
+
+	// Función de arista: positiva si p queda a la derecha del lado p0-p1 (con la Y hacia abajo)
+	f32 arista(f32 x0, f32 y0, f32 x1, f32 y1, f32 x, f32 y)
+	{
+		return (x1 - x0) * (y - y0) - (y1 - y0) * (x - x0);
+	}
+
+	// Regla de arista superior izquierda, para triángulos en el sentido de las agujas del reloj
+	bool superiorIzquierda(f32 x0, f32 y0, f32 x1, f32 y1)
+	{
+		return (y1 < y0) or (y1 == y0 and x1 > x0);
+	}
+}
+
+Rasterizador::Rasterizador(u16 ancho, u16 alto): _ancho(ancho), _alto(alto), _escala_cargada(-1),
+	_textura_valida(false), _paleta_cargada(NULL), _fragmentos(0)
+{
+	// La misma proyección ortográfica que Screen::inicializar(), con su margen vertical hasta 480 líneas
+	f32 abajo = (alto <= 480) ? alto + 16 : alto;
+	_arriba = (alto <= 480) ? -12.0f : 0.0f;
+	_escala_x = (ancho > 1) ? (f32)ancho / (f32)(ancho - 1) : 1.0f;
+	_escala_y = (f32)alto / (abajo - _arriba);
+
+	_color.resize(ancho * alto);
+	_profundidad.resize(ancho * alto);
+	_triangulos.reserve(MAX_VERTICES_LOTE);
+	_puntos.reserve(MAX_PUNTOS_LOTE);
+	memset(&_textura_cargada, 0, sizeof(Textura));
+	limpiar();
+}
+
+void Rasterizador::limpiar(u32 color)
+{
+	_color.assign(_color.size(), color);
+	_profundidad.assign(_profundidad.size(), PROFUNDIDAD_MAXIMA);
+}
+
+void Rasterizador::cerrarFrame(void)
+{
+	vaciarLote();
+	_contadores.cerrarFrame();
+}
+
+void Rasterizador::dibujarTextura(const Textura& t, s16 x, s16 y, s16 z, u16 ancho, u16 alto)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+	configurarTextura(t, 0);
+	comenzar(4);
+
+	Vertice v[4] = {
+		transformar(x, y, z, 0, 0),
+		transformar(x + ancho, y, z, 1, 0),
+		transformar(x + ancho, y + alto, z, 1, 1),
+		transformar(x, y + alto, z, 0, 1)
+	};
+	cuadrilatero(v, 0xFFFFFFFF, &t);
+}
+
+void Rasterizador::dibujarCuadro(const Textura& t, s16 x, s16 y, s16 z, s16 cuadroX, s16 cuadroY, u16 cuadroAncho,
+									u16 cuadroAlto, bool invertido)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+	configurarTextura(t, 10);
+	comenzar(4);
+
+	// Las mismas coordenadas de textura que calcula Screen::dibujarCuadro(), con escala 10 (1024 es la unidad)
+	s16 w = (1023 * cuadroAncho) / t.ancho * (invertido ? -1 : 1);
+	s16 h = (1023 * cuadroAlto) / t.alto;
+	s16 tx = (1023 * (cuadroX + (invertido ? cuadroAncho : 0))) / t.ancho;
+	s16 ty = (1023 * cuadroY) / t.alto;
+
+	Vertice v[4] = {
+		transformar(x, y, z, tx / 1024.0f, ty / 1024.0f),
+		transformar(x + cuadroAncho, y, z, (s16)(tx + w) / 1024.0f, ty / 1024.0f),
+		transformar(x + cuadroAncho, y + cuadroAlto, z, (s16)(tx + w) / 1024.0f, (s16)(ty + h) / 1024.0f),
+		transformar(x, y + cuadroAlto, z, tx / 1024.0f, (s16)(ty + h) / 1024.0f)
+	};
+	cuadrilatero(v, 0xFFFFFFFF, &t);
+}
+
+void Rasterizador::dibujarPunto(s16 x, s16 y, s16 z, u32 color)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+
+	if(_puntos.size() == MAX_PUNTOS_LOTE or not _triangulos.empty())
+		vaciarLote();
+	_puntos.push_back(transformar(x, y, z));
+	_puntos.back().color = color;
+}
+
+void Rasterizador::dibujarLinea(s16 x1, s16 y1, s16 x2, s16 y2, s16 z, u16 ancho, u32 color)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+
+	// Los mismos cuatro vértices que calcula Screen::dibujarLinea()
+	if(x2 < x1)
+	{
+		s16 aux = x2;
+		x2 = x1;
+		x1 = aux;
+		aux = y2;
+		y2 = y1;
+		y1 = aux;
+	}
+	s16 diff_x = ((x2 - x1 < 0) ? x1 - x2 : x2 - x1) + 1;
+	s16 diff_y = ((y2 - y1 < 0) ? y1 - y2 : y2 - y1) + 1;
+
+	s16 x3 = x1;
+	s16 y3 = y1;
+	s16 x4 = x2;
+	s16 y4 = y2;
+	if((y1 == y2 and x1 != x2) or (diff_x > diff_y))
+	{
+		y3 += ancho;
+		y4 += ancho;
+	}
+	else
+	{
+		x3 += ancho;
+		x4 += ancho;
+	}
+
+	anadirTriangulo(x1, y1, x2, y2, x3, y3, z, color);
+	anadirTriangulo(x2, y2, x3, y3, x4, y4, z, color);
+}
+
+void Rasterizador::dibujarRectangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 x4, s16 y4, s16 z,
+										u32 color)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+
+	anadirTriangulo(x1, y1, x2, y2, x3, y3, z, color);
+	anadirTriangulo(x1, y1, x3, y3, x4, y4, z, color);
+}
+
+void Rasterizador::dibujarCirculo(s16 x, s16 y, s16 z, f32 r, u32 color)
+{
+	if(z < 0)
+		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
+	r = r / 2;
+
+	// El mismo abanico de triángulos que Screen::dibujarCirculo()
+	u32 paso = trigonometria::VUELTA / trigonometria::segmentos(r);
+	s16 xa = x;
+	s16 ya = y - (s16)r;
+	for(u32 ang = paso ; ang <= trigonometria::VUELTA ; ang += paso)
+	{
+		s16 xb = x + (s16)(r * trigonometria::seno(ang) / trigonometria::UNIDAD);
+		s16 yb = y - (s16)(r * trigonometria::coseno(ang) / trigonometria::UNIDAD);
+		anadirTriangulo(xa, ya, xb, yb, x, y, z, color);
+		xa = xb;
+		ya = yb;
+	}
+}
+
+u16 Rasterizador::ancho(void) const
+{
+	return _ancho;
+}
+
+u16 Rasterizador::alto(void) const
+{
+	return _alto;
+}
+
+u32 Rasterizador::pixel(u16 x, u16 y) const
+{
+	return (x < _ancho and y < _alto) ? _color[y * _ancho + x] : 0;
+}
+
+const u32* Rasterizador::pixeles(void) const
+{
+	return _color.empty() ? NULL : &_color[0];
+}
+
+const Contadores& Rasterizador::contadores(void) const
+{
+	return _contadores;
+}
+
+u64 Rasterizador::fragmentos(void) const
+{
+	return _fragmentos;
+}
+
+// Métodos privados
+
+Rasterizador::Vertice Rasterizador::transformar(s16 x, s16 y, s16 z, f32 s, f32 t) const
+{
+	Vertice v;
+	v.x = x * _escala_x;
+	v.y = (y - _arriba) * _escala_y;
+	v.z = (u32)(((u64)z * PROFUNDIDAD_MAXIMA) / LEJANO);
+	v.s = s;
+	v.t = t;
+	v.color = 0xFFFFFFFF;
+	return v;
+}
+
+void Rasterizador::triangulo(const Vertice& a, const Vertice& b, const Vertice& c, u32 color, const Textura* tex)
+{
+	// Los tres vértices de una primitiva de Screen tienen siempre la misma profundidad
+	if(a.z > PROFUNDIDAD_MAXIMA)
+		return;
+
+	// Sin eliminación de caras (GX_CULL_NONE): los triángulos en sentido contrario se recorren al revés
+	const Vertice* v0 = &a;
+	const Vertice* v1 = &b;
+	const Vertice* v2 = &c;
+	f32 area = arista(a.x, a.y, b.x, b.y, c.x, c.y);
+	if(area == 0)
+		return;
+	if(area < 0)
+	{
+		v1 = &c;
+		v2 = &b;
+		area = -area;
+	}
+
+	// Caja del triángulo, recortada a la pantalla
+	s32 xmin = (s32)floor(min(v0->x, min(v1->x, v2->x)));
+	s32 xmax = (s32)ceil(max(v0->x, max(v1->x, v2->x)));
+	s32 ymin = (s32)floor(min(v0->y, min(v1->y, v2->y)));
+	s32 ymax = (s32)ceil(max(v0->y, max(v1->y, v2->y)));
+	xmin = max(xmin, (s32)0);
+	ymin = max(ymin, (s32)0);
+	xmax = min(xmax, (s32)(_ancho - 1));
+	ymax = min(ymax, (s32)(_alto - 1));
+	if(xmin > xmax or ymin > ymax)
+		return;
+
+	// Qué lados se quedan con los píxeles cuyo centro cae justo sobre ellos
+	bool propio0 = superiorIzquierda(v1->x, v1->y, v2->x, v2->y);
+	bool propio1 = superiorIzquierda(v2->x, v2->y, v0->x, v0->y);
+	bool propio2 = superiorIzquierda(v0->x, v0->y, v1->x, v1->y);
+
+	// Incrementos de las funciones de arista al avanzar un píxel hacia la derecha
+	f32 paso0 = -(v2->y - v1->y);
+	f32 paso1 = -(v0->y - v2->y);
+	f32 paso2 = -(v1->y - v0->y);
+
+	for(s32 y = ymin ; y <= ymax ; ++y)
+	{
+		f32 cx = xmin + 0.5f;
+		f32 cy = y + 0.5f;
+		f32 w0 = arista(v1->x, v1->y, v2->x, v2->y, cx, cy);
+		f32 w1 = arista(v2->x, v2->y, v0->x, v0->y, cx, cy);
+		f32 w2 = arista(v0->x, v0->y, v1->x, v1->y, cx, cy);
+		u32 indice = y * _ancho + xmin;
+
+		for(s32 x = xmin ; x <= xmax ; ++x, ++indice, w0 += paso0, w1 += paso1, w2 += paso2)
+		{
+			if((w0 < 0 or (w0 == 0 and not propio0)) or (w1 < 0 or (w1 == 0 and not propio1))
+				or (w2 < 0 or (w2 == 0 and not propio2)))
+				continue;
+
+			if(tex == NULL)
+				fragmento(indice, v0->z, color);
+			else
+			{
+				// En una proyección ortográfica, las coordenadas de textura se interpolan linealmente
+				f32 s = (w0 * v0->s + w1 * v1->s + w2 * v2->s) / area;
+				f32 t = (w0 * v0->t + w1 * v1->t + w2 * v2->t) / area;
+				fragmento(indice, v0->z, muestrear(*tex, s, t));
+			}
+		}
+	}
+}
+
+void Rasterizador::cuadrilatero(const Vertice* v, u32 color, const Textura* tex)
+{
+	triangulo(v[0], v[1], v[2], color, tex);
+	triangulo(v[0], v[2], v[3], color, tex);
+}
+
+void Rasterizador::fragmento(u32 indice, u32 z, u32 color)
+{
+	++_fragmentos;
+
+	// GX_SetAlphaCompare(GX_GEQUAL, 8, ...): los fragmentos casi transparentes no llegan ni a la prueba de Z
+	u32 alpha = color & 0xFF;
+	if(alpha < 8)
+		return;
+
+	// GX_SetZMode(GX_TRUE, GX_LEQUAL, GX_TRUE)
+	if(z > _profundidad[indice])
+		return;
+	_profundidad[indice] = z;
+
+	// GX_BL_SRCALPHA y GX_BL_INVSRCALPHA; el frame buffer (GX_PF_RGB8_Z24) no guarda alpha
+	u32 destino = _color[indice];
+	u32 resultado = 0xFF;
+	for(u32 desp = 8 ; desp < 32 ; desp += 8)
+	{
+		u32 s = (color >> desp) & 0xFF;
+		u32 d = (destino >> desp) & 0xFF;
+		resultado |= ((s * alpha + d * (255 - alpha) + 127) / 255) << desp;
+	}
+	_color[indice] = resultado;
+}
+
+u32 Rasterizador::texel(const Textura& t, s32 x, s32 y)
+{
+	// GX_CLAMP: fuera de la textura se repiten los texels del borde
+	x = (x < 0) ? 0 : ((x >= t.ancho) ? t.ancho - 1 : x);
+	y = (y < 0) ? 0 : ((y >= t.alto) ? t.alto - 1 : y);
+
+	// Bloque que contiene el texel, y posición del texel dentro del bloque
+	u32 ancho_bloque = textura::anchoBloque(t.formato);
+	u32 alto_bloque = textura::altoBloque(t.formato);
+	u32 bloque = (y / alto_bloque) * ((t.ancho + ancho_bloque - 1) / ancho_bloque) + x / ancho_bloque;
+	u32 dentro = (y % alto_bloque) * ancho_bloque + x % ancho_bloque;
+
+	switch(t.formato)
+	{
+		case textura::RGB5A3:
+			return rgba(((const u16*)t.texels)[bloque * 16 + dentro]);
+		case textura::CI8:
+			return t.paleta ? rgba(t.paleta[((const u8*)t.texels)[bloque * 32 + dentro]]) : 0;
+		case textura::CI4:
+		{
+			u8 pareja = ((const u8*)t.texels)[bloque * 32 + dentro / 2];
+			return t.paleta ? rgba(t.paleta[(dentro & 1) ? pareja & 0x0F : pareja >> 4]) : 0;
+		}
+		default:
+			// El resto de formatos no los utiliza la clase Imagen
+			return 0;
+	}
+}
+
+u32 Rasterizador::muestrear(const Textura& t, f32 s, f32 ty)
+{
+	// GX_LINEAR: mezcla de los cuatro texels más cercanos, con los centros de los texels en la mitad
+	f32 u = s * t.ancho - 0.5f;
+	f32 v = ty * t.alto - 0.5f;
+	s32 x0 = (s32)floor(u);
+	s32 y0 = (s32)floor(v);
+	u32 fx = (u32)((u - x0) * 256);
+	u32 fy = (u32)((v - y0) * 256);
+
+	u32 arriba = mezclar(texel(t, x0, y0), texel(t, x0 + 1, y0), fx);
+	u32 abajo = mezclar(texel(t, x0, y0 + 1), texel(t, x0 + 1, y0 + 1), fx);
+	return mezclar(arriba, abajo, fy);
+}
+
+void Rasterizador::configurarTextura(const Textura& t, u8 escala)
+{
+	// Las mismas comparaciones que Screen::configurarTextura(), para contar las mismas cargas
+	vaciarLote();
+	bool indexada = (t.formato == textura::CI4 or t.formato == textura::CI8);
+	if(indexada and t.paleta != _paleta_cargada)
+	{
+		_contadores.sumar(Contadores::PALETAS);
+		_paleta_cargada = t.paleta;
+	}
+	if(not _textura_valida or t.texels != _textura_cargada.texels or t.ancho != _textura_cargada.ancho
+		or t.alto != _textura_cargada.alto or t.formato != _textura_cargada.formato)
+	{
+		_contadores.sumar(Contadores::TEXTURAS);
+		_textura_cargada = t;
+		_textura_valida = true;
+	}
+	if(_escala_cargada != escala)
+	{
+		_contadores.sumar(Contadores::CONFIGURACIONES);
+		_escala_cargada = escala;
+	}
+}
+
+void Rasterizador::configurarColor(void)
+{
+	if(_escala_cargada == DESCRIPTORES_COLOR)
+		return;
+	_contadores.sumar(Contadores::CONFIGURACIONES);
+	_escala_cargada = DESCRIPTORES_COLOR;
+}
+
+void Rasterizador::comenzar(u16 vertices)
+{
+	_contadores.sumar(Contadores::BLOQUES);
+	_contadores.sumar(Contadores::VERTICES, vertices);
+}
+
+void Rasterizador::anadirTriangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 z, u32 color)
+{
+	if(_triangulos.size() + 3 > MAX_VERTICES_LOTE or not _puntos.empty())
+		vaciarLote();
+	_triangulos.push_back(transformar(x1, y1, z));
+	_triangulos.push_back(transformar(x2, y2, z));
+	_triangulos.push_back(transformar(x3, y3, z));
+	_triangulos.back().color = color;
+}
+
+void Rasterizador::vaciarLote(void)
+{
+	if(_triangulos.empty() and _puntos.empty())
+		return;
+
+	// Igual que Screen::vaciarLote(): el lote contiene sólo triángulos o sólo puntos
+	configurarColor();
+	if(not _triangulos.empty())
+	{
+		comenzar(_triangulos.size());
+		for(u32 i = 0 ; i < _triangulos.size() ; i += 3)
+			triangulo(_triangulos[i], _triangulos[i + 1], _triangulos[i + 2], _triangulos[i + 2].color, NULL);
+	}
+	if(not _puntos.empty())
+	{
+		comenzar(_puntos.size());
+		for(vector<Vertice>::iterator v = _puntos.begin() ; v != _puntos.end() ; ++v)
+		{
+			// Un punto de un píxel cubre el píxel cuyo centro está más cerca de su posición
+			s32 px = (s32)floor(v->x);
+			s32 py = (s32)floor(v->y);
+			if(px >= 0 and py >= 0 and px < _ancho and py < _alto and v->z <= PROFUNDIDAD_MAXIMA)
+				fragmento(py * _ancho + px, v->z, v->color);
+		}
+	}
+
+	_triangulos.clear();
+	_puntos.clear();
+}
@@ -0,0 +1,149 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ritmo.h"
+#include <unistd.h>
+#ifdef GEKKO
+	#include <ogc/lwp_watchdog.h>
+#else
+	#include <ctime>
+#endif
+
+namespace
+{
+	const u64 SEGUNDO = 1000000000ull;
+}
+
+Ritmo::Ritmo(void)
+{
+	configurar(0, 0);
+}
+
+void Ritmo::configurar(u32 fps, u32 refresco)
+{
+	_vblank = (refresco > 0) ? SEGUNDO / refresco : 0;
+	_periodo = (fps > 0) ? SEGUNDO / fps : _vblank;
+
+	// Sin límite de frames por segundo, cada frame dura lo que tarde en llegar la siguiente sincronización
+	_intervalo = 0;
+	if(refresco > 0 and fps == 0)
+		_intervalo = 1;
+	else if(refresco > 0 and fps <= refresco and refresco % fps == 0)
+		_intervalo = refresco / fps;
+
+	_siguiente = 0;
+	reiniciar();
+}
+
+u32 Ritmo::vblanks(void) const
+{
+	return _intervalo;
+}
+
+u32 Ritmo::periodo(void) const
+{
+	return _periodo / 1000;
+}
+
+void Ritmo::esperar(void)
+{
+	if(_intervalo > 0 or _periodo == 0)
+		return;
+
+	u64 t = ahora();
+
+	// En el primer frame, o si el juego se ha retrasado más de un frame completo, el ritmo empieza de nuevo
+	if(_siguiente == 0 or t > _siguiente + _periodo)
+		_siguiente = t;
+	else
+	{
+		// Despertar en la última sincronización vertical anterior al instante previsto, para no perderla
+		u64 objetivo = (_siguiente > _vblank) ? _siguiente - _vblank : 0;
+		if(t < objetivo)
+			usleep((objetivo - t) / 1000);
+	}
+
+	// El siguiente instante se calcula a partir del previsto, y no del real, para no acumular el error
+	_siguiente += _periodo;
+}
+
+void Ritmo::marcar(void)
+{
+	u64 t = ahora();
+	if(_anterior != 0)
+	{
+		_ultimo = t - _anterior;
+		_suma += _ultimo;
+		if(_frames == 0 or _ultimo < _minimo)
+			_minimo = _ultimo;
+		if(_ultimo > _maximo)
+			_maximo = _ultimo;
+		if(_periodo > 0 and _ultimo > _periodo + _periodo / 2)
+			++_perdidos;
+		++_frames;
+	}
+	_anterior = t;
+}
+
+void Ritmo::reiniciar(void)
+{
+	_anterior = 0;
+	_frames = _perdidos = 0;
+	_suma = _ultimo = _minimo = _maximo = 0;
+}
+
+u32 Ritmo::frames(void) const
+{
+	return _frames;
+}
+
+u32 Ritmo::ultimo(void) const
+{
+	return _ultimo / 1000;
+}
+
+u32 Ritmo::medio(void) const
+{
+	return (_frames > 0) ? _suma / _frames / 1000 : 0;
+}
+
+u32 Ritmo::minimo(void) const
+{
+	return _minimo / 1000;
+}
+
+u32 Ritmo::maximo(void) const
+{
+	return _maximo / 1000;
+}
+
+u32 Ritmo::perdidos(void) const
+{
+	return _perdidos;
+}
+
+u64 Ritmo::ahora(void)
+{
+	#ifdef GEKKO
+	return ticks_to_nanosecs(gettime());
+	#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u64)t.tv_sec * SEGUNDO + t.tv_nsec;
+	#endif
+}
@@ -17,10 +17,44 @@
  */
 
 #include "screen.h"
+#include "logger.h"
+#include "perfilador.h"
+#include "trigonometria.h"
 using namespace std;
 
 Screen* Screen::_instance = 0;
 
+namespace
+{
+	// Valor de _escala_cargada cuando los descriptores están preparados para dibujar color directo
+	const s16 DESCRIPTORES_COLOR = -2;
+
+	// Frame buffer del último frame enviado con latencia, frame buffer ya terminado por el procesador gráfico que se
+	// mostrará en la siguiente sincronización vertical, e indicador de que aún no ha llegado el fin de dibujo del
+	// último frame enviado. Los modifican las interrupciones del procesador gráfico y del sistema de vídeo
+	void* volatile enviado = NULL;
+	void* volatile terminado = NULL;
+	volatile bool pendiente = false;
+
+	// Interrupción de fin de dibujo: el frame enviado ya está completo en su frame buffer
+	void finDibujo(void)
+	{
+		terminado = enviado;
+		pendiente = false;
+	}
+
+	// Interrupción anterior a cada sincronización vertical: mostrar el último frame terminado
+	void antesSincronizacion(u32 retrace)
+	{
+		if(terminado != NULL)
+		{
+			VIDEO_SetNextFramebuffer(terminado);
+			VIDEO_Flush();
+			terminado = NULL;
+		}
+	}
+}
+
 void Screen::inicializar(void)
 {
 	_fifoBuffer = NULL;
@@ -28,15 +62,27 @@ void Screen::inicializar(void)
 	_update_gfx = 0;
 	_update_scr = 0;
 	_backgroundColor = {0, 0x20*0, 0x40*0, 255};
+	_escala_cargada = -1;
+	_num_triangulos = 0;
+	_num_puntos = 0;
+	_textura_valida = false;
+	_paleta_valida = false;
+	_retrace = 0;
+	_latencia = 0;
+	_mostrado = 0;
 
 	// Inicialización básica del sistema de vídeo de la consola.
 	VIDEO_Init();
 
 	// Obtener el modo de pantalla que tenga la consola.
 	_screenMode = VIDEO_GetPreferredMode(NULL);
+	// Hasta que se indiquen los frames por segundo, cada frame dura una sincronización vertical
+	_ritmo.configurar(0, refresco());
 	// Inicializar el sistema de doble buffer a partir del modo de pantalla que tenga la consola.
 	_frameBuffer[0] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(_screenMode));
 	_frameBuffer[1] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(_screenMode));
+	// El tercero sólo se reserva si se activa la latencia (ver setLatencia())
+	_frameBuffer[2] = NULL;
 
 	// Aplicar el modo de pantalla al chip gráfico
 	VIDEO_Configure(_screenMode);
@@ -50,7 +96,7 @@ void Screen::inicializar(void)
 		VIDEO_WaitVSync();
 
 	// Asigna la memoria para el FIFO, el "bus" que envía los datos al procesador gráfico en cada frame.
-	_fifoBuffer = MEM_K0_TO_K1(memalign(32, FIFO_SIZE));
+	_fifoBuffer = MEM_K0_TO_K1(memoria::reservar(FIFO_SIZE, memoria::SISTEMA));
 	memset(_fifoBuffer, 0, FIFO_SIZE);
 
 	// Inicializar el procesador gráfico (y la librería gráfica de bajo nivel GX)
@@ -146,9 +192,28 @@ u16 Screen::alto(void) const
 
 void Screen::flip(void)
 {
+	// Los dibujos de color que queden en el lote forman parte de este frame
+	vaciarLote();
+
 	// Si se ha marcado que hay que actualizar los gráficos, dar por finalizado el frame actual
-	if(_update_gfx)
+	if(_update_gfx and _latencia > 0)
+	{
+		// Con latencia, no se espera a que el procesador gráfico termine este frame, sino el anterior (que casi
+		// siempre habrá terminado ya); éste se copia en un frame buffer libre, y se mostrará en cuanto termine
+		sincronizar();
+		GX_CopyDisp(_frameBuffer[_frame_actual], GX_TRUE);
+		enviado = _frameBuffer[_frame_actual];
+		pendiente = true;
+		GX_SetDrawDone();
+		GX_Flush();
+		_mostrado = _frame_actual;
+		_frame_actual = (_frame_actual + 1) % 3;
+		_update_gfx = 0;
+		_update_scr = 0;
+	}
+	else if(_update_gfx)
 	{
+		Perfilador::Zona zona("GX_DrawDone");
 		GX_DrawDone();
 		_update_scr = 1;
 	}
@@ -156,8 +221,20 @@ void Screen::flip(void)
 		// Si no se ha marcado la actualización de gráficos, no hay que actualizar la pantalla
 		_update_scr = 0;
 
-	// Esperar la sincronización vertical
-	VIDEO_WaitVSync();
+	// Mantener el ritmo de frames: si cada frame dura un número exacto de sincronizaciones verticales, se esperan las
+	// que falten desde el frame anterior menos la última; si no, se duerme hasta la anterior al instante previsto
+	{
+		Perfilador::Zona zona("vsync");
+		u32 vblanks = _ritmo.vblanks();
+		if(vblanks > 1)
+			while((s32)(_retrace + vblanks - VIDEO_GetRetraceCount()) > 1)
+				VIDEO_WaitVSync();
+		_ritmo.esperar();
+
+		// Esperar la sincronización vertical
+		VIDEO_WaitVSync();
+		_retrace = VIDEO_GetRetraceCount();
+	}
 	// Si hay que actualizar los gráficos y la pantalla
 	if(_update_gfx and _update_scr)
 	{
@@ -169,6 +246,7 @@ void Screen::flip(void)
 		GX_Flush();
 		// Establecer el nuevo "siguiente frame buffer"
 		VIDEO_SetNextFramebuffer(_frameBuffer[_frame_actual]);
+		_mostrado = _frame_actual;
 		// Calcular el nuevo "actual frame buffer"
 		_frame_actual ^= 1;
 		// Fijar los datos en el sistema de vídeo
@@ -180,14 +258,99 @@ void Screen::flip(void)
 	// Limpiar la caché de vértices y texturas para dejarla lista para el siguiente frame
 	GX_InvVtxCache();
 	GX_InvalidateTexAll();
+
+	_ritmo.marcar();
+	_contadores.cerrarFrame();
+}
+
+void Screen::setFps(u8 fps)
+{
+	_ritmo.configurar(fps, refresco());
+}
+
+void Screen::setLatencia(u8 frames)
+{
+	frames = (frames > 0) ? 1 : 0;
+	if(frames == _latencia)
+		return;
+
+	// Esperar a que el último frame enviado esté en pantalla, para saber qué frame buffers quedan libres
+	sincronizar();
+	VIDEO_WaitVSync();
+
+	if(frames > 0)
+	{
+		if(_frameBuffer[2] == NULL)
+			_frameBuffer[2] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(_screenMode));
+		GX_SetDrawDoneCallback(finDibujo);
+		VIDEO_SetPreRetraceCallback(antesSincronizacion);
+		// Los frame buffers se recorren en orden; el que está en pantalla es el último en volver a utilizarse
+		_frame_actual = (_mostrado + 1) % 3;
+	}
+	else
+	{
+		GX_SetDrawDoneCallback(NULL);
+		VIDEO_SetPreRetraceCallback(NULL);
+		// Sin latencia sólo se alternan los dos primeros frame buffers, sin tocar el que está en pantalla
+		_frame_actual = (_mostrado == 0) ? 1 : 0;
+	}
+	_latencia = frames;
+}
+
+u8 Screen::latencia(void) const
+{
+	return _latencia;
+}
+
+void Screen::sincronizar(void)
+{
+	if(pendiente)
+	{
+		Perfilador::Zona zona("GX_WaitDrawDone");
+		GX_WaitDrawDone();
+	}
+}
+
+const Ritmo& Screen::ritmo(void) const
+{
+	return _ritmo;
+}
+
+u32 Screen::refresco(void) const
+{
+	return (VIDEO_GetCurrentTvMode() == VI_PAL) ? 50 : 60;
+}
+
+const Contadores& Screen::contadores(void) const
+{
+	return _contadores;
+}
+
+void Screen::informe(void) const
+{
+	logger->info("Screen - " + _contadores.informe());
 }
 
 // Operaciones con texturas
 
-void Screen::crearTextura(GXTexObj* textura, void* pixeles, u16 ancho, u16 alto)
+void Screen::crearTextura(GXTexObj* textura, void* pixeles, u16 ancho, u16 alto, bool ordenada)
 {
-	// Organizar los pixeles en tiles de 4x4 para formato TILE_RGB5A3
-	tiling4x4(pixeles, ancho, alto);
+	// Organizar los pixeles en tiles de 4x4 para formato TILE_RGB5A3, si no lo están ya; los bloques se escriben
+	// sobre la propia memoria, a partir de una copia lineal temporal
+	if(not ordenada)
+	{
+		u32 tam = textura::tam(textura::RGB5A3, ancho, alto);
+		void* lineal = memoria::reservar(tam, memoria::SISTEMA);
+		if(lineal != NULL)
+		{
+			memcpy(lineal, pixeles, tam);
+			textura::ordenar(lineal, ancho, alto, textura::RGB5A3, pixeles);
+			memoria::liberar(lineal);
+		}
+		DCFlushRange(pixeles, tam);
+	}
+	// Una textura nueva puede ocupar la memoria de otra ya destruida, así que la caché de carga deja de ser fiable
+	_textura_valida = false;
 	// Preparar la creación de la textura
 	GX_TexModeSync();
 	// Inicializar el objeto de textura GXTexObj
@@ -196,17 +359,34 @@ void Screen::crearTextura(GXTexObj* textura, void* pixeles, u16 ancho, u16 alto)
 	GX_InitTexObjLOD(textura, GX_LINEAR, GX_LINEAR, 0, 0, 0, 0, 0, GX_ANISO_1);
 }
 
-void Screen::dibujarTextura(GXTexObj *textura, s16 x, s16 y, s16 z, u16 ancho, u16 alto)
+void Screen::crearTexturaIndexada(GXTexObj* textura, void* indices, u16 ancho, u16 alto, textura::Formato formato)
+{
+	_textura_valida = false;
+	GX_TexModeSync();
+	// Los colores se buscan en la paleta que esté cargada en GX_TLUT0 al dibujar
+	GX_InitTexObjCI(textura, indices, ancho, alto, formato, GX_CLAMP, GX_CLAMP, GX_FALSE, GX_TLUT0);
+	GX_InitTexObjLOD(textura, GX_LINEAR, GX_LINEAR, 0, 0, 0, 0, 0, GX_ANISO_1);
+}
+
+void Screen::crearPaleta(GXTlutObj* paleta, void* colores, u16 num)
+{
+	_paleta_valida = false;
+	DCFlushRange(colores, num * sizeof(u16));
+	GX_InitTlutObj(paleta, colores, GX_TL_RGB5A3, num);
+}
+
+void Screen::dibujarTextura(GXTexObj *textura, s16 x, s16 y, s16 z, u16 ancho, u16 alto, GXTlutObj* paleta)
 {
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
 
 	// Preparar el procesador gráfico para dibujar una textura
-	configurarTextura(textura, 0);
+	configurarTextura(textura, 0, paleta);
 
 	// Dibujar un cuadrado relleno con la textura (con escalado 1:1, es decir, tal cual)
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	comenzar(GX_QUADS, 4);
 
 	// Primer vértice (superior izquierdo)
 	GX_Position3s16(x, y, -z);
@@ -232,14 +412,16 @@ void Screen::dibujarTextura(GXTexObj *textura, s16 x, s16 y, s16 z, u16 ancho, u
 }
 
 void Screen::dibujarCuadro(GXTexObj* textura, u16 texAncho, u16 texAlto, s16 x, s16 y, s16 z,
-							s16 cuadroX, s16 cuadroY, u16 cuadroAncho, u16 cuadroAlto, bool invertido)
+							s16 cuadroX, s16 cuadroY, u16 cuadroAncho, u16 cuadroAlto, bool invertido,
+							GXTlutObj* paleta)
 {
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
 
 	// Preparar el procesador gráfico para dibujar una textura
-	configurarTextura(textura, 10);
+	configurarTextura(textura, 10, paleta);
 
 	// Calcular el ancho y el alto del cuadro de la textura que se quiere dibujar, aplicando una escala de 10
 	// Si se quiere dibujar el cuadro invertido, se desplaza el primer punto (izquierda arriba) horizontalmente
@@ -252,7 +434,7 @@ void Screen::dibujarCuadro(GXTexObj* textura, u16 texAncho, u16 texAlto, s16 x,
 	s16 ty = (1023 * cuadroY) / texAlto;
 
 	// Dibujando la parte de la textura que se quiere dibujar
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	comenzar(GX_QUADS, 4);
 		 
 	GX_Position3s16(x, y, -z); 
 	GX_Color1u32(0xFFFFFFFF);
@@ -280,18 +462,17 @@ void Screen::dibujarPunto(s16 x, s16 y, s16 z, u32 color)
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
-
-	// Preparar el procesador gráfico para dibujar color directo
-	configurarColor();
-
-	// Dibujar un punto de color
-	GX_Begin(GX_POINTS, GX_VTXFMT0, 1);	
-	// Establecer la posición con las coordenadas
-	GX_Position3s16(x, y, -z);
-	// Pintar con el color deseado el punto con las coordenadas indicadas en la instrucción anterior
-	GX_Color1u32(color);
-	// Fin del dibujo de un punto de color
-	GX_End();
+	_contadores.sumar(Contadores::DIBUJOS);
+
+	// Los puntos se acumulan en el lote, y se dibujan todos juntos en un solo bloque; si el lote tiene triángulos, se
+	// dibujan antes, para que las figuras que se solapan en la misma Z aparezcan en el orden en que se pidieron
+	if(_num_puntos == MAX_PUNTOS_LOTE or _num_triangulos > 0)
+		vaciarLote();
+	VerticeColor& v = _puntos[_num_puntos++];
+	v.x = x;
+	v.y = y;
+	v.z = z;
+	v.color = color;
 }
 
 void Screen::dibujarLinea(s16 x1, s16 y1, s16 x2, s16 y2, s16 z, u16 ancho, u32 color)
@@ -299,9 +480,7 @@ void Screen::dibujarLinea(s16 x1, s16 y1, s16 x2, s16 y2, s16 z, u16 ancho, u32
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
-
-	// Preparar el procesador gráfico para dibujar color directo
-	configurarColor();
+	_contadores.sumar(Contadores::DIBUJOS);
 
 	// Como la línea podrá tener más de un píxel de ancho, realmente se va a dibujar un rectángulo
 	s16 x3, y3, x4, y4;
@@ -343,31 +522,10 @@ void Screen::dibujarLinea(s16 x1, s16 y1, s16 x2, s16 y2, s16 z, u16 ancho, u32
 		y4 = y2;
 	}
 
-	// Dibujar los vértices, utilizando dos triángulos con un lado común para dibujar el rectángulo
-	// que compondrá la línea con ancho
-	GX_Begin(GX_TRIANGLES, GX_VTXFMT0, 6);
-
-	// Primer triángulo
-	GX_Position3s16(x1, y1, -z);
-	GX_Color1u32(color);
-
-	GX_Position3s16(x2, y2, -z);
-	GX_Color1u32(color);
-
-	GX_Position3s16(x3, y3, -z);
-	GX_Color1u32(color);
-
-	// Segundo triángulo: comparten los vértices 2 y 3
-	GX_Position3s16(x2, y2, -z);
-	GX_Color1u32(color);
-
-	GX_Position3s16(x3, y3, -z);
-	GX_Color1u32(color);
-	
-	GX_Position3s16(x4, y4, -z);
-	GX_Color1u32(color);
-
-	GX_End();
+	// Añadir al lote los vértices, utilizando dos triángulos con un lado común para dibujar el rectángulo que
+	// compondrá la línea con ancho
+	anadirTriangulo(x1, y1, x2, y2, x3, y3, z, color);
+	anadirTriangulo(x2, y2, x3, y3, x4, y4, z, color);
 }
 
 void Screen::dibujarRectangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 x4, s16 y4, s16 z, u32 color)
@@ -375,26 +533,11 @@ void Screen::dibujarRectangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
 
-	// Preparar el procesador gráfico para dibujar color directo
-	configurarColor();
-
-	// Dibujar un rectangulo (4 vertices) relleno de color
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
-
-	GX_Position3s16(x1, y1, -z); 
-	GX_Color1u32(color);
-
-	GX_Position3s16(x2, y2, -z); 
-	GX_Color1u32(color);
-
-	GX_Position3s16(x3, y3, -z); 
-	GX_Color1u32(color);
-
-	GX_Position3s16(x4, y4, -z); 
-	GX_Color1u32(color);
-
-	GX_End();
+	// Añadir al lote el rectángulo como dos triángulos, igual que los dibuja el procesador gráfico con GX_QUADS
+	anadirTriangulo(x1, y1, x2, y2, x3, y3, z, color);
+	anadirTriangulo(x1, y1, x3, y3, x4, y4, z, color);
 }
 
 void Screen::dibujarCirculo(s16 x, s16 y, s16 z, f32 r, u32 color)
@@ -402,32 +545,23 @@ void Screen::dibujarCirculo(s16 x, s16 y, s16 z, f32 r, u32 color)
 	// Si la coordenada Z es negativa (por error del usuario), se le cambia el signo
 	if(z < 0)
 		z = -z;
+	_contadores.sumar(Contadores::DIBUJOS);
 
 	// Para dibujar el tamaño correcto
 	r = r/2;
 
-	// Preparar el procesador gráfico para dibujar color directo
-	configurarColor();
-
-	for(u32 n = 0 ; n < 16384 ; n += 512)
+	// Un abanico de triángulos alrededor del centro, con más segmentos cuanto mayor es el círculo; cada vértice del
+	// borde se calcula una sola vez, y el seno y el coseno salen de la tabla precalculada
+	u32 paso = trigonometria::VUELTA / trigonometria::segmentos(r);
+	s16 xa = x;
+	s16 ya = y - (s16)r;
+	for(u32 ang = paso ; ang <= trigonometria::VUELTA ; ang += paso)
 	{
-		u32 na = 512;
-		if((n + 512) > 16384)
-			na = 16384 - n;
-
-		GX_Begin(GX_TRIANGLES, GX_VTXFMT0, 3);
-
-		GX_Position3s16(x + (s16)(r * seno(n)/16384), y - (s16)(r * coseno(n)/16384), -z); 
-		GX_Color1u32(color);
-
-		GX_Position3s16(x + (s16)(r * seno(n + na)/16384), y - (s16)(r * coseno(n+na)/16384), -z); 
-		GX_Color1u32(color);
-
-		GX_Position3s16(x, y, -z); 
-		GX_Color1u32(color);
-
-		GX_End();
-
+		s16 xb = x + (s16)(r * trigonometria::seno(ang) / trigonometria::UNIDAD);
+		s16 yb = y - (s16)(r * trigonometria::coseno(ang) / trigonometria::UNIDAD);
+		anadirTriangulo(xa, ya, xb, yb, x, y, z, color);
+		xa = xb;
+		ya = yb;
 	}
 }
 
@@ -436,63 +570,21 @@ void Screen::dibujarCirculo(s16 x, s16 y, s16 z, f32 r, u32 color)
 Screen::~Screen(void)
 {
 	flip();
+	setLatencia(0);
 }
 
 // Métodos privados
 
-void Screen::tiling4x4(void* mem, u16 ancho, u16 alto)
+void Screen::configurarColor(void)
 {
-	u16 mem_tile[1024*8];
-	u16* p1 = (u16*) mem;
-    u16* p2 = (u16*) &mem_tile[0];
-
-    for(u16 n = 0 ; n < alto ; n += 4)
+	// Si los descriptores ya están preparados para dibujar color, no hay nada que hacer
+	if(_escala_cargada == DESCRIPTORES_COLOR)
 	{
-		for(u16 l = 0 ; l < 4 ; l++)
-		{
-			for(u16 m = 0 ; m < ancho ; m += 4)
-			{
-				p2[((l+m)<<2)] = p1[(n+l)*ancho+m];
-				p2[((l+m)<<2)+1] = p1[(n+l)*ancho+m+1];
-				p2[((l+m)<<2)+2] = p1[(n+l)*ancho+m+2];
-				p2[((l+m)<<2)+3] = p1[(n+l)*ancho+m+3];
-			}
-		}
-		for(u16 l = 0 ; l < 4 ; l++)
-		{
-			for(u16 m = 0 ; m < ancho ; m++)
-				p1[(n+l)*ancho+m] = p2[(l)*ancho+m];
-		}
+		_update_gfx = 1;
+		return;
 	}
-	DCFlushRange(mem, ancho * alto * 2);
-}
-
-u32 Screen::seno(u32 ang)
-{
-	f32 PID = 6.283185307179586476925286766559;
-	u32 n = ang;
-
-	if(n < 0)
-		n = 16384 - n;
-	n &= 16383;
-
-	return (u32)((f32) 16384 * sin((PID * (f32)n)/16384.0));
-}
-
-u32 Screen::coseno(u32 ang)
-{
-	f32 PID = 6.283185307179586476925286766559;
-	u32 n = ang;
-
-	if(n < 0)
-		n = 16384 - n;
-	n &= 16383;
-
-	return (u32)((f32) 16384 * cos((PID * (f32)n)/16384.0));
-}
+	_contadores.sumar(Contadores::CONFIGURACIONES);
 
-void Screen::configurarColor(void)
-{
 	// Preparar las GX para dibujar un color (textura nula)
 	GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 	GX_SetAlphaCompare(GX_GEQUAL, 8, GX_AOP_AND, GX_ALWAYS, 0);
@@ -508,16 +600,48 @@ void Screen::configurarColor(void)
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, GX_POS_XYZ, GX_S16, 0);		// formato de posicion S16 para X, Y ,Z
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);	// color RGBA8 para color0
 
+	// El siguiente dibujo de una textura tiene que volver a configurar los descriptores
+	_escala_cargada = DESCRIPTORES_COLOR;
+
 	// Marcar el flag de actualización de gráficos
 	_update_gfx = 1;
 }
 
-void Screen::configurarTextura(GXTexObj* textura, u8 escala)
+void Screen::configurarTextura(GXTexObj* textura, u8 escala, GXTlutObj* paleta)
 {
+	// Los dibujos de color anteriores a la textura se dibujan antes que ella, para respetar el orden
+	vaciarLote();
+
+	// Las texturas de índices leen sus colores de la paleta cargada en GX_TLUT0. Sólo se carga una paleta o una
+	// textura si es distinta de la última cargada, así que dibujar seguidos varios cuadros de la misma textura (un
+	// tileset, o una página de un atlas) no cuesta ninguna carga
+	if(paleta != NULL and (not _paleta_valida or memcmp(paleta, &_paleta_cargada, sizeof(GXTlutObj)) != 0))
+	{
+		GX_LoadTlut(paleta, GX_TLUT0);
+		_contadores.sumar(Contadores::PALETAS);
+		_paleta_cargada = *paleta;
+		_paleta_valida = true;
+	}
+	if(not _textura_valida or memcmp(textura, &_textura_cargada, sizeof(GXTexObj)) != 0)
+	{
+		GX_LoadTexObj(textura, GX_TEXMAP0);
+		_contadores.sumar(Contadores::TEXTURAS);
+		_textura_cargada = *textura;
+		_textura_valida = true;
+	}
+
+	// Si los descriptores ya están preparados para dibujar texturas con la misma escala, no hay nada más que hacer
+	if(_escala_cargada == escala)
+	{
+		_update_gfx = 1;
+		return;
+	}
+	_escala_cargada = escala;
+	_contadores.sumar(Contadores::CONFIGURACIONES);
+
 	// Preparar las GX para dibujar una textura
 	GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA,GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 	GX_SetAlphaCompare(GX_GEQUAL, 8, GX_AOP_AND, GX_ALWAYS, 0);
-    GX_LoadTexObj(textura, GX_TEXMAP0);
 	GX_SetNumTevStages(1);
 	GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORD0, GX_TEXMAP0, GX_COLOR0A0);
 	GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
@@ -538,3 +662,65 @@ void Screen::configurarTextura(GXTexObj* textura, u8 escala)
 	_update_gfx = 1;
 }
 
+
+void Screen::comenzar(u8 primitiva, u16 vertices)
+{
+	_contadores.sumar(Contadores::BLOQUES);
+	_contadores.sumar(Contadores::VERTICES, vertices);
+	GX_Begin(primitiva, GX_VTXFMT0, vertices);
+}
+
+void Screen::anadirTriangulo(s16 x1, s16 y1, s16 x2, s16 y2, s16 x3, s16 y3, s16 z, u32 color)
+{
+	// Igual que en dibujarPunto(), un lote sólo contiene un tipo de primitiva
+	if(_num_triangulos + 3 > MAX_VERTICES_LOTE or _num_puntos > 0)
+		vaciarLote();
+
+	VerticeColor* v = &_triangulos[_num_triangulos];
+	v[0].x = x1;
+	v[0].y = y1;
+	v[1].x = x2;
+	v[1].y = y2;
+	v[2].x = x3;
+	v[2].y = y3;
+	for(u32 i = 0 ; i < 3 ; ++i)
+	{
+		v[i].z = z;
+		v[i].color = color;
+	}
+	_num_triangulos += 3;
+}
+
+void Screen::vaciarLote(void)
+{
+	if(_num_triangulos == 0 and _num_puntos == 0)
+		return;
+
+	// Preparar el procesador gráfico para dibujar color directo, una sola vez para todo el lote
+	configurarColor();
+
+	// El lote contiene sólo triángulos o sólo puntos, que se dibujan en un único bloque
+	if(_num_triangulos > 0)
+	{
+		comenzar(GX_TRIANGLES, _num_triangulos);
+		for(u32 i = 0 ; i < _num_triangulos ; ++i)
+		{
+			GX_Position3s16(_triangulos[i].x, _triangulos[i].y, -_triangulos[i].z);
+			GX_Color1u32(_triangulos[i].color);
+		}
+		GX_End();
+	}
+	if(_num_puntos > 0)
+	{
+		comenzar(GX_POINTS, _num_puntos);
+		for(u32 i = 0 ; i < _num_puntos ; ++i)
+		{
+			GX_Position3s16(_puntos[i].x, _puntos[i].y, -_puntos[i].z);
+			GX_Color1u32(_puntos[i].color);
+		}
+		GX_End();
+	}
+
+	_num_triangulos = 0;
+	_num_puntos = 0;
+}
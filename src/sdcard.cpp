@@ -63,6 +63,9 @@ bool Sdcard::montada(void) const
 
 void Sdcard::desmontar(void)
 {
+	// El paquete se cierra antes de desmontar la unidad en la que se encuentra
+	desmontarPaquete();
+
 	if(montada())
 	{
 		fatUnmount(_unidad.c_str());
@@ -76,6 +79,10 @@ bool Sdcard::existe(const string& archivo)
 	if(_montada == 0)
 		return false;
 
+	paquete::Entrada e;
+	if(enPaquete(archivo, e))
+		return true;
+
     FILE* fp = NULL;
 
     fp = fopen(archivo.c_str(), "rb");
@@ -87,9 +94,84 @@ bool Sdcard::existe(const string& archivo)
     return false;
 }
 
+u8* Sdcard::leer(const string& archivo, u32& tam, memoria::Etiqueta etiqueta) throw (ArchivoEx)
+{
+	if(_montada == 0)
+		throw ArchivoEx("Sdcard::leer - La tarjeta SD no está montada");
+
+	// Si el archivo está en el paquete montado, se lee de él sin abrir ningún archivo
+	paquete::Entrada e;
+	if(enPaquete(archivo, e))
+	{
+		tam = e.tam_original;
+		return _paquete.leer(e, etiqueta);
+	}
+
+	FILE* fp = fopen(archivo.c_str(), "rb");
+	if(fp == NULL)
+		throw ArchivoEx("Sdcard::leer - El archivo '" + archivo + "' no existe.");
+
+	// Obtener el tamaño del archivo
+	fseek(fp, 0, SEEK_END);
+	tam = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	// Reservar memoria alineada, con el tamaño redondeado a 32 bytes y al menos un byte nulo al final, y leer el
+	// archivo de una sola vez
+	u32 reserva = (tam + 32) & ~31;
+	u8* datos = (u8*)memoria::reservar(reserva, etiqueta);
+	if(datos == NULL)
+	{
+		fclose(fp);
+		throw ArchivoEx("Sdcard::leer - No hay memoria para el archivo '" + archivo + "'");
+	}
+	memset(datos + tam, 0, reserva - tam);
+
+	if(fread(datos, 1, tam, fp) != tam)
+	{
+		fclose(fp);
+		memoria::liberar(datos);
+		throw ArchivoEx("Sdcard::leer - Error al leer el archivo '" + archivo + "'");
+	}
+
+	fclose(fp);
+	return datos;
+}
+
+void Sdcard::montarPaquete(const string& ruta) throw (ArchivoEx, TarjetaEx)
+{
+	if(_montada == 0)
+		throw TarjetaEx("Sdcard::montarPaquete - La tarjeta SD no está montada");
+
+	desmontarPaquete();
+	_paquete.abrir(_unidad + ":" + ruta);
+
+	// Los nombres del paquete son relativos al directorio en el que se encuentra
+	_raiz = ruta.substr(0, ruta.rfind('/') + 1);
+}
+
+void Sdcard::desmontarPaquete(void)
+{
+	_paquete.cerrar();
+	_raiz.clear();
+}
+
 Sdcard::~Sdcard(void)
 {
 	// Desmontar la unidad al destruir la instancia del Singleton
 	desmontar();
 }
 
+// Métodos privados
+bool Sdcard::enPaquete(const string& archivo, paquete::Entrada& e) const
+{
+	if(not _paquete.abierto())
+		return false;
+
+	// Quitar el nombre de la unidad, y comprobar que la ruta está dentro del directorio del paquete
+	string ruta = archivo.substr(archivo.find(':') + 1);
+	if(ruta.compare(0, _raiz.length(), _raiz) != 0)
+		return false;
+
+	return _paquete.buscar(ruta.substr(_raiz.length()), e);
+}
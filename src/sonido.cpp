@@ -19,8 +19,8 @@
 #include "sonido.h"
 using namespace std;
 
-Sonido::Sonido(const string& ruta, u8 volder, u8 volizq) throw (ArchivoEx, TarjetaEx):
-_volder(volder), _volizq(volizq)
+Sonido::Sonido(const string& ruta, u8 volder, u8 volizq, u8 prioridad, u8 instancias) throw (ArchivoEx, TarjetaEx):
+_volder(volder), _volizq(volizq), _prioridad(prioridad), _instancias(instancias)
 {
 	if(not sdcard->montada())
 		throw TarjetaEx("Sonido - La tarjeta SD no está montada.");
@@ -28,46 +28,92 @@ _volder(volder), _volizq(volizq)
 	// Añadir a la ruta la unidad que esté montada en la clase sdcard como prefijo
 	string ruta_completa = sdcard->unidad() + ":" + ruta;
 
-	// Comprobar la existencia del archivo
-	if(not sdcard->existe(ruta_completa))
-		throw ArchivoEx("Sonido - El archivo '" + ruta + "' no existe.");
+	// Leer el sonido completo de una sola vez (del paquete montado, si lo contiene) en memoria alineada, con el
+	// tamaño redondeado a un múltiplo de 32 bytes y relleno con ceros
+	_sonido = sdcard->leer(ruta_completa, _size, memoria::AUDIO);
+	u32 reserva = (_size + 32) & ~31;
 
-	// Cargar el archivo en un flujo de fichero
-	ifstream archivo;
-	archivo.open(ruta_completa.c_str(), ios::binary);
+	// Si el archivo comienza con una cabecera ADPCM, las muestras se decodificarán por bloques al reproducirlo
+	_comprimido = adpcm::leerCabecera(_sonido, _size, _cabecera);
+	if(not _comprimido)
+	{
+		_cabecera.version = 0;
+		_cabecera.canales = 2;
+		_cabecera.muestras_bloque = 0;
+		_cabecera.frecuencia = 48000;
+		_cabecera.muestras = _size / 4;
+		_cabecera.bloques = 0;
+	}
 
-	if(not archivo.good())
-		throw ArchivoEx("Sonido - Error al abrir el archivo: " + ruta);
+	// Fijar en la zona de memoria alineada la información del sonido que se ha leído desde la cache
+	DCFlushRange(_sonido, reserva);
+}
 
-	// Obtener el tamaño del sonido
-	archivo.seekg(0, ios::end);
-	_size = archivo.tellg();
-	archivo.seekg(0, ios::beg);
+Sonido::~Sonido(void)
+{
+	// Ninguna voz debe quedar reproduciendo la memoria que se va a liberar
+	mezclador->detener(*this);
+	memoria::liberar(_sonido);
+}
 
-	// Fijar el padding a 32 bytes
-	u8 padding = (_size * sizeof(s16)) % 32;
+bool Sonido::play(void) const
+{
+	return mezclador->reproducir(*this);
+}
 
-	// Reservar memoria alineada a 32 bytes para el sonido
-	_sonido = (s16*)memalign(32, _size * sizeof(s16) + padding);
-	// Volcar el contenido del flujo en la memoria reservada
-	archivo.read((char*)_sonido, _size);
-	// Fijar en la zona de memoria alineada la información del sonido que se ha leído desde la cache
-	DCFlushRange(_sonido, _size * sizeof(s16) + padding);
+const s16* Sonido::datos(void) const
+{
+	return (const s16*)_sonido;
+}
 
-	// Una vez cargado el sonido, se cierra el flujo de fichero
-	archivo.close();
+u32 Sonido::tamano(void) const
+{
+	return _size;
 }
 
-Sonido::~Sonido(void)
+bool Sonido::comprimido(void) const
 {
-	free(_sonido);
+	return _comprimido;
 }
 
-bool Sonido::play(void) const
+const adpcm::Cabecera& Sonido::cabecera(void) const
+{
+	return _cabecera;
+}
+
+const u8* Sonido::bloque(u32 indice) const
+{
+	return _sonido + adpcm::TAM_CABECERA + indice * adpcm::tamBloque(_cabecera.canales, _cabecera.muestras_bloque);
+}
+
+u64 Sonido::duracion(void) const
+{
+	return ((u64)_cabecera.muestras * 1000000) / _cabecera.frecuencia;
+}
+
+u32 Sonido::bytes(void) const
+{
+	return (_size + 32) & ~31;
+}
+
+u8 Sonido::volumenIzquierdo(void) const
+{
+	return _volizq;
+}
+
+u8 Sonido::volumenDerecho(void) const
+{
+	return _volder;
+}
+
+u8 Sonido::prioridad(void) const
+{
+	return _prioridad;
+}
+
+u8 Sonido::instancias(void) const
 {
-	if(ASND_SetVoice(ASND_GetFirstUnusedVoice(), VOICE_STEREO_16BIT, 48000, 0, _sonido, _size, _volizq, _volder, NULL) == SND_OK)
-		return true;
-	return false;
+	return _instancias;
 }
 
 void Sonido::setVolumenIzquierdo(u8 volumen)
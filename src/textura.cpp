@@ -0,0 +1,483 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "textura.h"
+
+namespace
+{
+	// Núcleo que codifica un bloque completo a partir de su esquina superior izquierda
+	typedef void (*Nucleo)(const u8* p, u32 paso, u8* d);
+
+	// Todos los bloques ocupan 32 bytes, salvo los de RGBA8, que ocupan dos veces 32
+	const u32 TAM_BLOQUE = 32;
+
+	// Firma de las texturas cocinadas
+	const char MAGIA[4] = { 'W', 'T', 'E', 'X' };
+
+	// Tabla hash de colores que se utiliza para contar los colores de una textura
+	const u32 TAM_HASH = 1024;
+
+	u32 hashColor(u16 c)
+	{
+		return ((c * 40503u) >> 6) & (TAM_HASH - 1);
+	}
+
+	u16 leer16(const u8* p)
+	{
+		return ((u16)p[0] << 8) | (u16)p[1];
+	}
+
+	u32 leer32(const u8* p)
+	{
+		return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+	}
+
+	void escribir32(u8* d, u32 v)
+	{
+		d[0] = (u8)(v >> 24);
+		d[1] = (u8)(v >> 16);
+		d[2] = (u8)(v >> 8);
+		d[3] = (u8)v;
+	}
+
+	void escribir16(u8* d, u16 v)
+	{
+		d[0] = (u8)(v >> 8);
+		d[1] = (u8)v;
+	}
+
+	// Color de 16 bits expandido a 8 bits por componente, repitiendo los bits altos en los bajos
+	void expandir565(u16 c, u8* rgb)
+	{
+		u8 r = (c >> 11) & 0x1F;
+		u8 g = (c >> 5) & 0x3F;
+		u8 b = c & 0x1F;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	u32 distancia(const u8* a, const u8* b)
+	{
+		s32 r = (s32)a[0] - b[0];
+		s32 g = (s32)a[1] - b[1];
+		s32 bl = (s32)a[2] - b[2];
+		return r * r + g * g + bl * bl;
+	}
+
+	u8 intensidadPixel(const u8* p)
+	{
+		return textura::intensidad(p[0], p[1], p[2]);
+	}
+
+	void bloqueI4(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 8 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 8 ; x += 2)
+				*d++ = (intensidadPixel(p + x * 4) & 0xF0) | (intensidadPixel(p + x * 4 + 4) >> 4);
+	}
+
+	void bloqueI8(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 8 ; ++x)
+				*d++ = intensidadPixel(p + x * 4);
+	}
+
+	void bloqueIA4(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 8 ; ++x)
+				*d++ = (p[x * 4 + 3] & 0xF0) | (intensidadPixel(p + x * 4) >> 4);
+	}
+
+	void bloqueIA8(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+		{
+			for(u32 x = 0 ; x < 4 ; ++x)
+			{
+				*d++ = p[x * 4 + 3];
+				*d++ = intensidadPixel(p + x * 4);
+			}
+		}
+	}
+
+	void bloqueRGB565(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 4 ; ++x, d += 2)
+				escribir16(d, textura::rgb565(p[x * 4], p[x * 4 + 1], p[x * 4 + 2]));
+	}
+
+	void bloqueRGB5A3(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 4 ; ++x, d += 2)
+				escribir16(d, bmp::rgb5a3(p[x * 4], p[x * 4 + 1], p[x * 4 + 2], p[x * 4 + 3]));
+	}
+
+	// Alpha y rojo en los primeros 32 bytes del bloque, verde y azul en los 32 siguientes
+	void bloqueRGBA8(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso)
+		{
+			for(u32 x = 0 ; x < 4 ; ++x, d += 2)
+			{
+				d[0] = p[x * 4 + 3];
+				d[1] = p[x * 4];
+				d[TAM_BLOQUE] = p[x * 4 + 1];
+				d[TAM_BLOQUE + 1] = p[x * 4 + 2];
+			}
+		}
+	}
+
+	// Subbloque DXT1 de 4x4: dos colores RGB565 y un índice de 2 bits por píxel, empezando por los bits altos
+	void subbloqueCMPR(const u8* p, u32 paso, u8* d)
+	{
+		u8 minimo[3] = { 255, 255, 255 };
+		u8 maximo[3] = { 0, 0, 0 };
+		bool transparente = false;
+
+		for(u32 y = 0 ; y < 4 ; ++y)
+		{
+			for(u32 x = 0 ; x < 4 ; ++x)
+			{
+				const u8* c = p + y * paso + x * 4;
+				if(c[3] < 128)
+				{
+					transparente = true;
+					continue;
+				}
+				for(u32 i = 0 ; i < 3 ; ++i)
+				{
+					if(c[i] < minimo[i])
+						minimo[i] = c[i];
+					if(c[i] > maximo[i])
+						maximo[i] = c[i];
+				}
+			}
+		}
+
+		u16 c0 = textura::rgb565(maximo[0], maximo[1], maximo[2]);
+		u16 c1 = textura::rgb565(minimo[0], minimo[1], minimo[2]);
+		if(minimo[0] > maximo[0])
+			c0 = c1 = 0;
+
+		// Con algún píxel transparente, c0 <= c1 selecciona el modo de tres colores; si no, c0 > c1 el de cuatro
+		if((transparente and c0 > c1) or (not transparente and c0 < c1))
+		{
+			u16 t = c0;
+			c0 = c1;
+			c1 = t;
+		}
+		bool cuatro = (c0 > c1);
+
+		u8 paleta[4][3];
+		expandir565(c0, paleta[0]);
+		expandir565(c1, paleta[1]);
+		for(u32 i = 0 ; i < 3 ; ++i)
+		{
+			if(cuatro)
+			{
+				paleta[2][i] = (2 * paleta[0][i] + paleta[1][i]) / 3;
+				paleta[3][i] = (paleta[0][i] + 2 * paleta[1][i]) / 3;
+			}
+			else
+				paleta[2][i] = paleta[3][i] = (paleta[0][i] + paleta[1][i]) / 2;
+		}
+
+		escribir16(d, c0);
+		escribir16(d + 2, c1);
+		for(u32 y = 0 ; y < 4 ; ++y)
+		{
+			u8 fila = 0;
+			for(u32 x = 0 ; x < 4 ; ++x)
+			{
+				const u8* c = p + y * paso + x * 4;
+				u32 indice = 3;
+				if(c[3] >= 128)
+				{
+					indice = 0;
+					u32 mejor = distancia(c, paleta[0]);
+					for(u32 i = 1 ; i < (cuatro ? 4u : 3u) ; ++i)
+					{
+						u32 dist = distancia(c, paleta[i]);
+						if(dist < mejor)
+						{
+							mejor = dist;
+							indice = i;
+						}
+					}
+				}
+				fila |= indice << (6 - 2 * x);
+			}
+			d[4 + y] = fila;
+		}
+	}
+
+	// Cuatro subbloques de 4x4, de izquierda a derecha y de arriba a abajo
+	void bloqueCMPR(const u8* p, u32 paso, u8* d)
+	{
+		subbloqueCMPR(p, paso, d);
+		subbloqueCMPR(p + 16, paso, d + 8);
+		subbloqueCMPR(p + 4 * paso, paso, d + 16);
+		subbloqueCMPR(p + 4 * paso + 16, paso, d + 24);
+	}
+
+	// Índices de 4 bits: el primer píxel de cada pareja en los bits altos
+	void bloqueCI4(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 8 ; ++y, p += paso)
+			for(u32 x = 0 ; x < 8 ; x += 2)
+				*d++ = ((p[x] & 0x0F) << 4) | (p[x + 1] & 0x0F);
+	}
+
+	// Bloques de 8 bytes por fila y 4 filas: los de 8 bits (8x4) y los de 16 (4x4) se copian igual
+	void copiarFilas(const u8* p, u32 paso, u8* d)
+	{
+		for(u32 y = 0 ; y < 4 ; ++y, p += paso, d += 8)
+			memcpy(d, p, 8);
+	}
+
+	// Recorre la imagen en el orden de sus bloques, codificando cada uno con el núcleo indicado
+	void recorrer(const u8* origen, u32 bytes_pixel, u16 ancho, u16 alto, textura::Formato formato, Nucleo nucleo,
+					u8* destino)
+	{
+		u32 ancho_bloque = textura::anchoBloque(formato);
+		u32 alto_bloque = textura::altoBloque(formato);
+		u32 tam_bloque = ancho_bloque * alto_bloque * textura::bitsPixel(formato) / 8;
+		u32 paso = ancho * bytes_pixel;
+
+		// Bloque del borde, completado con ceros; el mayor es el de 8x8 píxeles RGBA
+		u8 temporal[8 * 8 * 4];
+
+		for(u32 by = 0 ; by < alto ; by += alto_bloque)
+		{
+			for(u32 bx = 0 ; bx < ancho ; bx += ancho_bloque, destino += tam_bloque)
+			{
+				const u8* p = origen + by * paso + bx * bytes_pixel;
+				if(bx + ancho_bloque <= ancho and by + alto_bloque <= alto)
+				{
+					nucleo(p, paso, destino);
+					continue;
+				}
+
+				u32 columnas = (ancho - bx < ancho_bloque) ? ancho - bx : ancho_bloque;
+				u32 filas = (alto - by < alto_bloque) ? alto - by : alto_bloque;
+				u32 paso_temporal = ancho_bloque * bytes_pixel;
+				memset(temporal, 0, sizeof(temporal));
+				for(u32 y = 0 ; y < filas ; ++y)
+					memcpy(temporal + y * paso_temporal, p + y * paso, columnas * bytes_pixel);
+				nucleo(temporal, paso_temporal, destino);
+			}
+		}
+	}
+}
+
+u32 textura::anchoBloque(Formato formato)
+{
+	return (bitsPixel(formato) >= 16) ? 4 : 8;
+}
+
+u32 textura::altoBloque(Formato formato)
+{
+	return (bitsPixel(formato) == 4) ? 8 : 4;
+}
+
+u32 textura::bitsPixel(Formato formato)
+{
+	switch(formato)
+	{
+		case I4:
+		case CI4:
+		case CMPR:
+			return 4;
+		case I8:
+		case IA4:
+		case CI8:
+			return 8;
+		case IA8:
+		case RGB565:
+		case RGB5A3:
+			return 16;
+		case RGBA8:
+			return 32;
+	}
+	return 0;
+}
+
+u32 textura::tam(Formato formato, u16 ancho, u16 alto)
+{
+	u32 ancho_bloque = anchoBloque(formato);
+	u32 alto_bloque = altoBloque(formato);
+	u32 bloques = ((ancho + ancho_bloque - 1) / ancho_bloque) * ((alto + alto_bloque - 1) / alto_bloque);
+	return bloques * ancho_bloque * alto_bloque * bitsPixel(formato) / 8;
+}
+
+bool textura::codificar(const u8* rgba, u16 ancho, u16 alto, Formato formato, void* destino)
+{
+	Nucleo nucleo = NULL;
+	switch(formato)
+	{
+		case I4:
+			nucleo = bloqueI4;
+			break;
+		case I8:
+			nucleo = bloqueI8;
+			break;
+		case IA4:
+			nucleo = bloqueIA4;
+			break;
+		case IA8:
+			nucleo = bloqueIA8;
+			break;
+		case RGB565:
+			nucleo = bloqueRGB565;
+			break;
+		case RGB5A3:
+			nucleo = bloqueRGB5A3;
+			break;
+		case RGBA8:
+			nucleo = bloqueRGBA8;
+			break;
+		case CMPR:
+			nucleo = bloqueCMPR;
+			break;
+		case CI4:
+		case CI8:
+			return false;
+	}
+
+	recorrer(rgba, 4, ancho, alto, formato, nucleo, (u8*)destino);
+	return true;
+}
+
+bool textura::codificarIndices(const u8* indices, u16 ancho, u16 alto, Formato formato, void* destino)
+{
+	if(formato == CI4)
+		recorrer(indices, 1, ancho, alto, formato, bloqueCI4, (u8*)destino);
+	else if(formato == CI8)
+		recorrer(indices, 1, ancho, alto, formato, copiarFilas, (u8*)destino);
+	else
+		return false;
+	return true;
+}
+
+bool textura::ordenar(const void* origen, u16 ancho, u16 alto, Formato formato, void* destino)
+{
+	u32 bits = bitsPixel(formato);
+	if(bits != 8 and bits != 16)
+		return false;
+	recorrer((const u8*)origen, bits / 8, ancho, alto, formato, copiarFilas, (u8*)destino);
+	return true;
+}
+
+u32 textura::indexar(const u16* texels, u16 ancho, u16 alto, u8* indices, u16* paleta)
+{
+	// Colores ya vistos y su índice en la paleta
+	u16 claves[TAM_HASH];
+	s16 valores[TAM_HASH];
+	memset(valores, -1, sizeof(valores));
+	u32 colores = 0;
+
+	// Se recorre la textura en su orden, bloque a bloque, y los índices se guardan en orden lineal
+	for(u32 by = 0 ; by < alto ; by += 4)
+	{
+		for(u32 bx = 0 ; bx < ancho ; bx += 4)
+		{
+			for(u32 y = by ; y < by + 4 ; ++y)
+			{
+				for(u32 x = bx ; x < bx + 4 ; ++x)
+				{
+					u16 c = *texels++;
+					u32 h = hashColor(c);
+					while(valores[h] >= 0 and claves[h] != c)
+						h = (h + 1) & (TAM_HASH - 1);
+
+					if(valores[h] < 0)
+					{
+						if(colores == 256)
+							return 0;
+						claves[h] = c;
+						valores[h] = colores;
+						paleta[colores++] = c;
+					}
+					indices[y * ancho + x] = (u8)valores[h];
+				}
+			}
+		}
+	}
+	return colores;
+}
+
+u32 textura::entradasPaleta(Formato formato)
+{
+	if(formato == CI4)
+		return 16;
+	if(formato == CI8)
+		return 256;
+	return 0;
+}
+
+bool textura::leerCabecera(const u8* datos, u32 tam, Cabecera& c)
+{
+	if(datos == NULL or tam < TAM_CABECERA or memcmp(datos, MAGIA, 4) != 0)
+		return false;
+
+	c.version = datos[4];
+	c.formato = datos[5];
+	c.ancho = leer16(datos + 6);
+	c.alto = leer16(datos + 8);
+	c.colores = leer16(datos + 10);
+	c.tam = leer32(datos + 12);
+	c.paleta = leer32(datos + 16);
+
+	// La textura debe ocupar exactamente lo que corresponde a su formato y medidas, y la paleta caber en el archivo
+	if(c.version != VERSION or c.formato > CMPR or bitsPixel((Formato)c.formato) == 0 or c.ancho == 0 or c.alto == 0
+		or c.tam != textura::tam((Formato)c.formato, c.ancho, c.alto) or c.tam > tam - TAM_CABECERA)
+		return false;
+	u32 entradas = entradasPaleta((Formato)c.formato);
+	if(entradas == 0)
+		return (c.colores == 0 and c.paleta == 0);
+	return (c.colores > 0 and c.colores <= entradas and c.paleta % TAM_BLOQUE == 0
+			and c.paleta >= TAM_CABECERA + c.tam and c.paleta <= tam and entradas * 2 <= tam - c.paleta);
+}
+
+void textura::escribirCabecera(const Cabecera& c, u8* destino)
+{
+	memset(destino, 0, TAM_CABECERA);
+	memcpy(destino, MAGIA, 4);
+	destino[4] = c.version;
+	destino[5] = c.formato;
+	escribir16(destino + 6, c.ancho);
+	escribir16(destino + 8, c.alto);
+	escribir16(destino + 10, c.colores);
+	escribir32(destino + 12, c.tam);
+	escribir32(destino + 16, c.paleta);
+}
+
+u16 textura::rgb565(u8 r, u8 g, u8 b)
+{
+	return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+u8 textura::intensidad(u8 r, u8 g, u8 b)
+{
+	return (u8)((r * 77 + g * 150 + b * 29 + 128) >> 8);
+}
@@ -0,0 +1,229 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la 
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3 
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera 
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso 
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tiled.h"
+#include "inflador.h"
+using namespace std;
+
+namespace
+{
+	// Marcas de volteo que Tiled guarda en los bits altos del gid de un tile
+	const u32 TILED_HORIZONTAL = 0x80000000;
+	const u32 TILED_VERTICAL = 0x40000000;
+	const u32 TILED_DIAGONAL = 0x20000000;
+	const u32 TILED_MARCAS = TILED_HORIZONTAL | TILED_VERTICAL | TILED_DIAGONAL;
+
+	// Valor de un atributo de un elemento XML, o una cadena vacía si no lo tiene (igual que Parser::atributo())
+	string atributo(const TiXmlElement* el, const char* nombre)
+	{
+		string valor;
+		if(el == NULL or el->QueryStringAttribute(nombre, &valor) != TIXML_SUCCESS)
+			return string();
+		return valor;
+	}
+
+	// Capa con codificación csv: los gids, separados por comas, se guardan a medida que se leen
+	void leerCsv(const char* texto, tiled::Capa& c, u32 total) throw (ArchivoEx)
+	{
+		u32 n = 0;
+		u32 gid = 0;
+		bool numero = false;
+		for(const char* p = texto ; p and *p and n < total ; ++p)
+		{
+			if(*p >= '0' and *p <= '9')
+			{
+				// Un número de más de 32 bits se satura, en lugar de dar la vuelta y parecer un gid válido, para que
+				// tiled::tile() lo rechace
+				if(gid > (0xFFFFFFFF - (*p - '0')) / 10)
+					gid = 0xFFFFFFFF;
+				else
+					gid = gid * 10 + (*p - '0');
+				numero = true;
+			}
+			else if(*p == ',')
+			{
+				c.tiles[n++] = tiled::tile(gid, c);
+				gid = 0;
+				numero = false;
+			}
+		}
+		if(numero and n < total)
+			c.tiles[n] = tiled::tile(gid, c);
+	}
+
+	// Los datos en base64 se decodifican por trozos, sin copiar el texto completo; el tamaño del trozo es múltiplo
+	// de 3 (cada 4 caracteres son 3 bytes) y de 4 (cada gid son 4 bytes), así que ningún gid queda partido
+	const u32 TAM_TROZO = 768;
+
+	struct Base64
+	{
+		const char* pos;
+		u8 trozo[TAM_TROZO];
+	};
+
+	// Valor de un carácter de base64, o -1 si no lo es (espacios, saltos de línea y relleno)
+	s32 valorBase64(char c)
+	{
+		if(c >= 'A' and c <= 'Z')
+			return c - 'A';
+		if(c >= 'a' and c <= 'z')
+			return c - 'a' + 26;
+		if(c >= '0' and c <= '9')
+			return c - '0' + 52;
+		if(c == '+')
+			return 62;
+		if(c == '/')
+			return 63;
+		return -1;
+	}
+
+	// Entrega el siguiente trozo de datos decodificados (ver Inflador::Fuente); todos los trozos salvo el último
+	// ocupan TAM_TROZO bytes
+	bool siguienteBase64(void* contexto, const u8*& datos, u32& tam)
+	{
+		Base64* b = (Base64*)contexto;
+		u32 grupo = 0;
+		u32 caracteres = 0;
+		tam = 0;
+		while(tam < TAM_TROZO and b->pos and *b->pos)
+		{
+			s32 valor = valorBase64(*b->pos++);
+			if(valor < 0)
+				continue;
+			grupo = (grupo << 6) | valor;
+			if(++caracteres == 4)
+			{
+				b->trozo[tam++] = (u8)(grupo >> 16);
+				b->trozo[tam++] = (u8)(grupo >> 8);
+				b->trozo[tam++] = (u8)grupo;
+				grupo = 0;
+				caracteres = 0;
+			}
+		}
+
+		// Último grupo incompleto, cuando el texto termina con relleno
+		if(caracteres == 2)
+			b->trozo[tam++] = (u8)(grupo >> 4);
+		else if(caracteres == 3)
+		{
+			b->trozo[tam++] = (u8)(grupo >> 10);
+			b->trozo[tam++] = (u8)(grupo >> 2);
+		}
+
+		datos = b->trozo;
+		return (tam > 0);
+	}
+
+	// Guarda los gids de un trozo de datos (4 bytes por gid, en little endian) en los siguientes tiles de una capa
+	void guardarGids(const u8* datos, u32 tam, tiled::Capa& c, u32& n) throw (ArchivoEx)
+	{
+		for(u32 i = 0 ; i + 4 <= tam ; i += 4)
+			c.tiles[n++] = tiled::tile((u32)datos[i] | ((u32)datos[i + 1] << 8) | ((u32)datos[i + 2] << 16)
+										| ((u32)datos[i + 3] << 24), c);
+	}
+
+	// Capa con codificación base64, comprimida con zlib o no; los datos tienen que contener exactamente un gid por
+	// tile de la capa
+	bool leerBase64(const char* texto, bool zlib, tiled::Capa& c, u32 total) throw (ArchivoEx)
+	{
+		Base64 b;
+		b.pos = texto;
+		u32 n = 0;
+
+		if(not zlib)
+		{
+			const u8* datos = NULL;
+			u32 tam = 0;
+			while(siguienteBase64(&b, datos, tam))
+			{
+				if(tam % 4 != 0 or tam / 4 > total - n)
+					return false;
+				guardarGids(datos, tam, c, n);
+			}
+			return (n == total);
+		}
+
+		// Los datos se descomprimen a medida que se decodifican, de trozo en trozo
+		Inflador z(siguienteBase64, &b, true, memoria::NIVEL);
+		u8 trozo[TAM_TROZO];
+		while(n < total)
+		{
+			u32 pedidos = (total - n) * 4 < TAM_TROZO ? (total - n) * 4 : TAM_TROZO;
+			if(z.leer(trozo, pedidos) != pedidos)
+				return false;
+			guardarGids(trozo, pedidos, c, n);
+		}
+		return z.terminar();
+	}
+}
+
+tiled::Tile tiled::tile(u32 gid, const Capa& c) throw (ArchivoEx)
+{
+	// Screen sólo sabe dibujar los tiles invertidos horizontalmente; un tile volteado en vertical o rotado se
+	// dibujaría mal sin que nada lo indicase, así que la capa no se acepta
+	if(gid & (TILED_VERTICAL | TILED_DIAGONAL))
+		throw ArchivoEx("Tiled - La capa '" + c.nombre + "' utiliza un tile volteado en vertical o en diagonal");
+
+	// Un gid que no cabe en los bits GID del tile no se puede guardar, así que la capa no es válida
+	u32 id = gid & ~TILED_MARCAS;
+	if(id > GID)
+		throw ArchivoEx("Tiled - La capa '" + c.nombre + "' utiliza un tile cuyo identificador es mayor que 16383");
+	Tile t = (Tile)id;
+	if(t == 0)
+		return 0;
+	if(gid & TILED_HORIZONTAL)
+		t |= INVERTIDO;
+	if(c.solida)
+		t |= SOLIDO;
+	return t;
+}
+
+void tiled::leerCapa(const TiXmlElement* capa, Capa& c, u32 total) throw (ArchivoEx)
+{
+	// La capa de plataformas, y las que tengan la propiedad solida, tienen tiles no atravesables
+	c.nombre = atributo(capa, "name");
+	c.solida = (c.nombre == "plataformas");
+	const TiXmlElement* propiedades = capa->FirstChildElement("properties");
+	for(const TiXmlElement* p = propiedades ? propiedades->FirstChildElement() : NULL ; p ;
+		p = p->NextSiblingElement())
+		if(atributo(p, "name") == "solida")
+			c.solida = (strtoul(atributo(p, "value").c_str(), NULL, 10) != 0);
+
+	const TiXmlElement* tiles = capa->FirstChildElement("data");
+	string codificacion = atributo(tiles, "encoding");
+	string compresion = atributo(tiles, "compression");
+
+	// Los formatos csv y base64 se decodifican directamente sobre los tiles de la capa
+	if(codificacion == "csv")
+		leerCsv(tiles->GetText(), c, total);
+	else if(codificacion == "base64")
+	{
+		if(compresion != "" and compresion != "zlib")
+			throw ArchivoEx("Tiled - La capa '" + c.nombre + "' utiliza una compresión no soportada: " + compresion);
+		if(not leerBase64(tiles->GetText(), compresion == "zlib", c, total))
+			throw ArchivoEx("Tiled - Los datos de la capa '" + c.nombre + "' no son correctos");
+	}
+	else
+	{
+		// Formato XML, con un elemento por tile
+		u32 n = 0;
+		for(const TiXmlElement* tile = tiles ? tiles->FirstChildElement() : NULL ; tile and n < total ;
+			tile = tile->NextSiblingElement())
+			c.tiles[n++] = tiled::tile(strtoul(atributo(tile, "gid").c_str(), NULL, 10), c);
+	}
+}
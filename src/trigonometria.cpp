@@ -0,0 +1,120 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trigonometria.h"
+#include <cmath>
+using namespace std;
+
+namespace
+{
+	s16 tabla[trigonometria::TAM_TABLA];
+	// El arcotangente se guarda con 4 bits más de precisión que una unidad de ángulo, para redondear sólo al final
+	const u32 PRECISION_ARCOTANGENTE = 16;
+	u16 arcotangente[trigonometria::TAM_ARCOTANGENTE + 1];
+
+	// La tabla se rellena al arrancar el programa, antes de que nadie pueda dibujar
+	struct Inicializador
+	{
+		Inicializador(void)
+		{
+			for(u32 i = 0 ; i < trigonometria::TAM_TABLA ; ++i)
+				tabla[i] = (s16)floor(trigonometria::UNIDAD * sin(6.283185307179586 * i / trigonometria::TAM_TABLA)
+										+ 0.5);
+			for(u32 i = 0 ; i <= trigonometria::TAM_ARCOTANGENTE ; ++i)
+				arcotangente[i] = (u16)floor(PRECISION_ARCOTANGENTE * trigonometria::VUELTA
+												* atan((f64)i / trigonometria::TAM_ARCOTANGENTE) / 6.283185307179586
+												+ 0.5);
+		}
+	} inicializador;
+}
+
+s32 trigonometria::seno(u32 ang)
+{
+	// Interpolación lineal entre el ángulo de la tabla inmediatamente anterior y el siguiente
+	const u32 paso = VUELTA / TAM_TABLA;
+	u32 a = ang & (VUELTA - 1);
+	u32 i = a / paso;
+	s32 anterior = tabla[i];
+	s32 siguiente = tabla[(i + 1) & (TAM_TABLA - 1)];
+	return anterior + (siguiente - anterior) * (s32)(a % paso) / (s32)paso;
+}
+
+s32 trigonometria::coseno(u32 ang)
+{
+	return seno(ang + VUELTA / 4);
+}
+
+u32 trigonometria::angulo(s32 x, s32 y)
+{
+	u32 ax = (x < 0) ? -(u32)x : (u32)x;
+	u32 ay = (y < 0) ? -(u32)y : (u32)y;
+	if(ax == 0 and ay == 0)
+		return 0;
+
+	// Ángulo respecto al eje más cercano, a partir de la proporción entre la componente menor y la mayor (de 0 a 1,
+	// con 16 bits de fracción), interpolando entre los dos valores más cercanos de la tabla. Las componentes se
+	// reducen a 16 bits para que la división sea de 32 bits
+	u32 menor = (ax < ay) ? ax : ay;
+	u32 mayor = (ax < ay) ? ay : ax;
+	for(u32 desplazamiento = 8 ; desplazamiento > 0 ; desplazamiento /= 2)
+	{
+		if(mayor >= (65536u << desplazamiento))
+		{
+			menor >>= desplazamiento;
+			mayor >>= desplazamiento;
+		}
+	}
+	if(mayor >= 65536)
+	{
+		menor >>= 1;
+		mayor >>= 1;
+	}
+	u32 proporcion = (menor << 16) / mayor;
+	u32 i = proporcion / (65536 / TAM_ARCOTANGENTE);
+	u32 fraccion = proporcion % (65536 / TAM_ARCOTANGENTE);
+	u32 a = arcotangente[i];
+	if(i < TAM_ARCOTANGENTE)
+		a += ((arcotangente[i + 1] - a) * fraccion) / (65536 / TAM_ARCOTANGENTE);
+	a = (a + PRECISION_ARCOTANGENTE / 2) / PRECISION_ARCOTANGENTE;
+
+	// Colocar el ángulo en su octante
+	if(ax > ay)
+		a = VUELTA / 4 - a;
+	if(y < 0)
+		a = VUELTA / 2 - a;
+	if(x < 0)
+		a = VUELTA - a;
+	return a & (VUELTA - 1);
+}
+
+u32 trigonometria::rebotar(u32 direccion, u32 normal)
+{
+	// La reflexión de la dirección respecto a la superficie es la simétrica de la dirección contraria respecto a la
+	// normal
+	return (2 * normal + VUELTA / 2 - direccion) & (VUELTA - 1);
+}
+
+u32 trigonometria::segmentos(f32 radio)
+{
+	// La distancia de un segmento a su arco es r * (1 - cos(pi / n)), aproximadamente r * pi² / (2 * n²); para que
+	// no llegue a medio píxel, n² debe ser al menos pi² * r
+	u32 n = MIN_SEGMENTOS;
+	while(n < MAX_SEGMENTOS and n * n < 9.87f * radio)
+		n *= 2;
+	return n;
+}
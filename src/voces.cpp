@@ -0,0 +1,106 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la 
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3 
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera 
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso 
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "voces.h"
+using namespace std;
+
+void voces::reiniciar(Estadisticas& e)
+{
+	e.peticiones = 0;
+	e.reproducciones = 0;
+	e.fusiones = 0;
+	e.robos = 0;
+	e.descartes = 0;
+	e.voces_ocupadas = 0;
+	e.pico_voces = 0;
+}
+
+s16 voces::elegir(const Voz* tabla, u8 primera, u8 total, const Peticion& p, u32 ventana, Estadisticas& e)
+{
+	e.peticiones++;
+
+	// Recorrer las voces una sola vez para conocer las voces libres, las instancias del efecto y la candidata a robo
+	s16 libre = -1;
+	s16 mas_antigua = -1;
+	s16 victima = -1;
+	u8 instancias = 0;
+	u8 ocupadas = 0;
+
+	for(u8 v = primera ; v < total ; ++v)
+	{
+		if(tabla[v].efecto == NULL)
+		{
+			if(libre < 0)
+				libre = v;
+			continue;
+		}
+
+		ocupadas++;
+
+		if(tabla[v].efecto == p.efecto)
+		{
+			// Si el mismo efecto ha comenzado dentro de la ventana de fusión, no se vuelve a reproducir
+			if(p.instante - tabla[v].inicio < ventana)
+			{
+				e.fusiones++;
+				return FUSIONADA;
+			}
+			instancias++;
+			if(mas_antigua < 0 or tabla[v].inicio < tabla[mas_antigua].inicio)
+				mas_antigua = v;
+		}
+
+		// La víctima de un robo es la voz de menor prioridad, y en caso de empate, la más antigua
+		if(victima < 0 or tabla[v].prioridad < tabla[victima].prioridad or
+			(tabla[v].prioridad == tabla[victima].prioridad and tabla[v].inicio < tabla[victima].inicio))
+			victima = v;
+	}
+
+	e.voces_ocupadas = ocupadas;
+
+	s16 destino = -1;
+
+	// Si el efecto ya tiene todas sus instancias sonando, se reutiliza la voz de la más antigua
+	if(p.instancias > 0 and instancias >= p.instancias)
+	{
+		destino = mas_antigua;
+		e.robos++;
+	}
+	// Si hay una voz libre, se utiliza
+	else if(libre >= 0)
+	{
+		destino = libre;
+		e.voces_ocupadas++;
+	}
+	// Si no hay voces libres, se roba la de menor prioridad, siempre que no sea más importante que el efecto nuevo
+	else if(victima >= 0 and tabla[victima].prioridad <= p.prioridad)
+	{
+		destino = victima;
+		e.robos++;
+	}
+	else
+	{
+		e.descartes++;
+		return DESCARTADA;
+	}
+
+	if(e.voces_ocupadas > e.pico_voces)
+		e.pico_voces = e.voces_ocupadas;
+
+	return destino;
+}
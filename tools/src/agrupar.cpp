@@ -0,0 +1,494 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * agrupar: agrupa las imágenes pequeñas de la galería de una aplicación en unas pocas texturas grandes, llamadas
+ * páginas, para que la consola pueda dibujar una escena casi sin cambiar de textura. Cada imagen BMP o PNG del
+ * archivo de la galería cuyas medidas no superen el límite indicado se decodifica con el mismo código que la clase
+ * Imagen, y se coloca en una página con la clase Atlas, de mayor a menor. Cada página se guarda como una textura
+ * cocinada (ver textura.h, y la herramienta cocinar), convertida en textura de índices si entre todas sus imágenes
+ * no suman más de 256 colores, y recortada a la parte ocupada. Después, escribe una copia del archivo de la galería
+ * en la que cada imagen agrupada es un recorte de su página (atributos atlas, x, y, ancho y alto; ver clase Galeria)
+ * y las páginas son imágenes nuevas, con los códigos prefijo0, prefijo1, etc. Los códigos de las imágenes no
+ * cambian, así que no hay que modificar ningún otro archivo del juego.
+ *
+ * El margen entre imágenes se rellena repitiendo la última columna y la última fila de cada una, para que el
+ * filtrado de la textura no mezcle sus bordes con los de la imagen vecina.
+ *
+ * Las páginas se guardan junto a la primera imagen que contienen. Las rutas de la galería se buscan en el
+ * directorio de la aplicación igual que en la herramienta cocinar.
+ *
+ * Uso: agrupar [-a color] [-t tam] [-m margen] [-l limite] [-p prefijo] [-n] directorio_app galeria.xml salida.xml
+ *   -a  Color transparente en hexadecimal, con la forma RRGGBBAA (por defecto, FF00FFFF); debe ser el mismo que
+ *       el del archivo de configuración del juego
+ *   -t  Ancho y alto máximos de cada página, múltiplo de 8 (por defecto, 512)
+ *   -m  Píxeles de margen entre imágenes (por defecto, 2)
+ *   -l  Ancho o alto máximo de una imagen para agruparla (por defecto, 128)
+ *   -p  Prefijo de los códigos y de los archivos de las páginas (por defecto, atlas)
+ *   -n  No convierte ninguna página en textura de índices (equivale a Imagen::indexar = false)
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "atlas.h"
+#include "bmp.h"
+#include "pngdec.h"
+#include "textura.h"
+using namespace std;
+
+namespace
+{
+	// Imagen de la galería que se agrupa en una página
+	struct Pieza
+	{
+		string codigo;
+		string ruta;
+		string origen;
+		string::size_type inicio, fin;
+		u16 ancho, alto;
+		vector<u16> pixeles;
+		u32 pagina;
+		Atlas::Rectangulo r;
+	};
+
+	// Página del atlas y lo que se sabe de ella al terminar
+	struct Pagina
+	{
+		Atlas atlas;
+		string codigo;
+		string ruta;
+		string destino;
+		textura::Cabecera cabecera;
+
+		Pagina(u16 tam, u16 margen): atlas(tam, tam, margen) { }
+	};
+
+	u32 alpha = 0xFF00FFFF;
+
+	void uso(void)
+	{
+		cerr << "Uso: agrupar [-a color] [-t tam] [-m margen] [-l limite] [-p prefijo] [-n] directorio_app galeria.xml"
+				" salida.xml" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	bool existe(const string& ruta)
+	{
+		struct stat info;
+		return (stat(ruta.c_str(), &info) == 0 and S_ISREG(info.st_mode));
+	}
+
+	// Busca el valor de un atributo dentro de una etiqueta, igual que la herramienta cocinar
+	bool atributo(const string& texto, string::size_type inicio, string::size_type fin, const string& nombre,
+					string& valor)
+	{
+		for(string::size_type p = texto.find(nombre, inicio) ; p != string::npos and p < fin ;
+			p = texto.find(nombre, p + 1))
+		{
+			if(p == 0 or not isspace(texto[p - 1]))
+				continue;
+			string::size_type q = texto.find_first_not_of(" \t\r\n", p + nombre.length());
+			if(q == string::npos or q >= fin or texto[q] != '=')
+				continue;
+			q = texto.find_first_not_of(" \t\r\n", q + 1);
+			if(q == string::npos or q >= fin or (texto[q] != '"' and texto[q] != '\''))
+				continue;
+			string::size_type cierre = texto.find(texto[q], q + 1);
+			if(cierre == string::npos or cierre >= fin)
+				return false;
+			valor = texto.substr(q + 1, cierre - q - 1);
+			return true;
+		}
+		return false;
+	}
+
+	bool localizar(const string& app, const string& ruta, string& local)
+	{
+		for(string::size_type p = 0 ; p != string::npos ; p = ruta.find('/', p + 1))
+		{
+			string resto = ruta.substr(p);
+			if(not resto.empty() and resto[0] == '/')
+				resto.erase(0, 1);
+			if(not resto.empty() and existe(app + "/" + resto))
+			{
+				local = app + "/" + resto;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	string directorio(const string& ruta)
+	{
+		string::size_type barra = ruta.rfind('/');
+		return (barra == string::npos) ? string() : ruta.substr(0, barra + 1);
+	}
+
+	void escribir16(vector<u8>& v, u32 posicion, u16 x)
+	{
+		v[posicion] = (u8)(x >> 8);
+		v[posicion + 1] = (u8)x;
+	}
+
+	// Decodifica una imagen con el mismo código que la consola, y la deja en orden lineal
+	bool decodificar(Pieza& p, string& error)
+	{
+		vector<u8> datos;
+		if(not leerArchivo(p.origen, datos) or datos.empty())
+		{
+			error = "no se puede leer el archivo";
+			return false;
+		}
+
+		vector<u16> texels;
+		bmp::Info info_bmp;
+		png::Info info_png;
+		if(bmp::leerCabecera(&datos[0], datos.size(), info_bmp))
+		{
+			p.ancho = info_bmp.ancho;
+			p.alto = info_bmp.alto;
+			texels.resize(bmp::tamTextura(info_bmp) / sizeof(u16));
+			bmp::decodificar(&datos[0], info_bmp, alpha, &texels[0]);
+		}
+		else if(png::esPng(&datos[0], datos.size()) and png::leerCabecera(&datos[0], datos.size(), info_png))
+		{
+			p.ancho = info_png.ancho;
+			p.alto = info_png.alto;
+			texels.resize(png::tamTextura(info_png) / sizeof(u16));
+			if(not png::decodificar(&datos[0], info_png, alpha, &texels[0]))
+				texels.clear();
+		}
+		if(texels.empty())
+		{
+			error = "formato de imagen no soportado";
+			return false;
+		}
+
+		// Deshacer los bloques de 4x4 de la textura RGB5A3
+		u32 bloques = (p.ancho + 3) / 4;
+		p.pixeles.resize(p.ancho * p.alto);
+		for(u32 y = 0 ; y < p.alto ; ++y)
+			for(u32 x = 0 ; x < p.ancho ; ++x)
+				p.pixeles[y * p.ancho + x] = texels[((y / 4) * bloques + x / 4) * 16 + (y % 4) * 4 + x % 4];
+		return true;
+	}
+
+	bool mayor(const Pieza* a, const Pieza* b)
+	{
+		u32 area_a = a->ancho * a->alto;
+		u32 area_b = b->ancho * b->alto;
+		if(area_a != area_b)
+			return area_a > area_b;
+		return a->codigo < b->codigo;
+	}
+
+	// Compone una página con sus piezas y la guarda como textura cocinada
+	bool guardarPagina(Pagina& pagina, const vector<Pieza*>& piezas, u32 indice, u16 margen, bool indexar)
+	{
+		// La página se recorta a la parte ocupada, redondeada a un múltiplo de 8
+		u32 ancho = 0, alto = 0;
+		for(vector<Pieza*>::const_iterator i = piezas.begin() ; i != piezas.end() ; ++i)
+			if((*i)->pagina == indice)
+			{
+				ancho = max(ancho, (u32)(*i)->r.x + (*i)->r.ancho);
+				alto = max(alto, (u32)(*i)->r.y + (*i)->r.alto);
+			}
+		ancho = (ancho + 7) & ~7;
+		alto = (alto + 7) & ~7;
+
+		// Copiar cada pieza, repitiendo su borde derecho e inferior en el margen
+		vector<u16> lineal(ancho * alto, 0);
+		for(vector<Pieza*>::const_iterator i = piezas.begin() ; i != piezas.end() ; ++i)
+		{
+			const Pieza& p = **i;
+			if(p.pagina != indice)
+				continue;
+			u32 fin_x = min((u32)p.r.x + p.ancho + margen, ancho);
+			u32 fin_y = min((u32)p.r.y + p.alto + margen, alto);
+			for(u32 y = p.r.y ; y < fin_y ; ++y)
+				for(u32 x = p.r.x ; x < fin_x ; ++x)
+				{
+					u32 px = min(x - p.r.x, (u32)p.ancho - 1);
+					u32 py = min(y - p.r.y, (u32)p.alto - 1);
+					lineal[y * ancho + x] = p.pixeles[py * p.ancho + px];
+				}
+		}
+
+		// Organizar en bloques de 4x4, igual que la textura que entregan los decodificadores
+		vector<u16> texels(ancho * alto);
+		u32 bloques = ancho / 4;
+		for(u32 y = 0 ; y < alto ; ++y)
+			for(u32 x = 0 ; x < ancho ; ++x)
+				texels[((y / 4) * bloques + x / 4) * 16 + (y % 4) * 4 + x % 4] = lineal[y * ancho + x];
+
+		// A partir de aquí, el mismo trabajo que la herramienta cocinar
+		textura::Cabecera& c = pagina.cabecera;
+		vector<u8> indices(ancho * alto);
+		u16 paleta[256];
+		u32 colores = indexar ? textura::indexar(&texels[0], ancho, alto, &indices[0], paleta) : 0;
+
+		c.version = textura::VERSION;
+		c.formato = (colores == 0) ? textura::RGB5A3 : (colores <= 16) ? textura::CI4 : textura::CI8;
+		c.ancho = ancho;
+		c.alto = alto;
+		c.colores = colores;
+		c.tam = textura::tam((textura::Formato)c.formato, ancho, alto);
+		c.paleta = 0;
+
+		u32 entradas = textura::entradasPaleta((textura::Formato)c.formato);
+		u32 tam = textura::TAM_CABECERA + c.tam;
+		if(entradas > 0)
+		{
+			c.paleta = (tam + 31) & ~31;
+			tam = c.paleta + entradas * sizeof(u16);
+		}
+
+		vector<u8> blob((tam + 31) & ~31, 0);
+		textura::escribirCabecera(c, &blob[0]);
+		if(entradas == 0)
+		{
+			for(u32 i = 0 ; i < texels.size() ; ++i)
+				escribir16(blob, textura::TAM_CABECERA + i * 2, texels[i]);
+		}
+		else
+		{
+			textura::codificarIndices(&indices[0], ancho, alto, (textura::Formato)c.formato,
+										&blob[textura::TAM_CABECERA]);
+			for(u32 i = 0 ; i < colores ; ++i)
+				escribir16(blob, c.paleta + i * 2, paleta[i]);
+		}
+
+		textura::Cabecera comprobacion;
+		if(not textura::leerCabecera(&blob[0], blob.size(), comprobacion))
+			return false;
+
+		ofstream archivo(pagina.destino.c_str(), ios::binary);
+		archivo.write((const char*)&blob[0], blob.size());
+		return archivo.good();
+	}
+
+	const char* nombreFormato(u8 formato)
+	{
+		switch(formato)
+		{
+			case textura::CI4:
+				return "CI4";
+			case textura::CI8:
+				return "CI8";
+			default:
+				return "RGB5A3";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u32 tam = 512;
+	u32 margen = 2;
+	u32 limite = 128;
+	string prefijo = "atlas";
+	bool indexar = true;
+	vector<string> argumentos;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-a" and i + 1 < argc)
+			alpha = strtoul(argv[++i], NULL, 16);
+		else if(arg == "-t" and i + 1 < argc)
+			tam = atoi(argv[++i]);
+		else if(arg == "-m" and i + 1 < argc)
+			margen = atoi(argv[++i]);
+		else if(arg == "-l" and i + 1 < argc)
+			limite = atoi(argv[++i]);
+		else if(arg == "-p" and i + 1 < argc)
+			prefijo = argv[++i];
+		else if(arg == "-n")
+			indexar = false;
+		else if(arg[0] == '-')
+			uso();
+		else
+			argumentos.push_back(arg);
+	}
+
+	// La GX no admite texturas de más de 1024 píxeles de lado
+	if(argumentos.size() != 3 or tam == 0 or tam > 1024 or tam % 8 != 0 or margen > 16 or prefijo.empty())
+		uso();
+
+	string app = argumentos[0];
+	while(app.length() > 1 and app[app.length() - 1] == '/')
+		app.erase(app.length() - 1);
+
+	vector<u8> xml;
+	if(not leerArchivo(argumentos[1], xml))
+	{
+		cerr << "agrupar - Error al leer el archivo: " << argumentos[1] << endl;
+		return 1;
+	}
+	string texto(xml.begin(), xml.end());
+
+	// Buscar las imágenes BMP y PNG que se pueden agrupar
+	vector<Pieza> piezas;
+	vector<string> codigos;
+	for(string::size_type p = texto.find("<imagen") ; p != string::npos ; p = texto.find("<imagen", p + 1))
+	{
+		string::size_type fin = texto.find('>', p);
+		if(fin == string::npos)
+			break;
+
+		Pieza pieza;
+		string formato;
+		if(not atributo(texto, p, fin, "codigo", pieza.codigo))
+			continue;
+		codigos.push_back(pieza.codigo);
+		if(not atributo(texto, p, fin, "formato", formato) or not atributo(texto, p, fin, "ruta", pieza.ruta)
+			or (formato != "bmp" and formato != "png"))
+			continue;
+
+		if(not localizar(app, pieza.ruta, pieza.origen))
+		{
+			cerr << "agrupar - No se encuentra la imagen '" << pieza.ruta << "' en " << app << endl;
+			return 1;
+		}
+
+		string error;
+		if(not decodificar(pieza, error))
+		{
+			cerr << "agrupar - " << pieza.ruta << ": " << error << endl;
+			return 1;
+		}
+		if(pieza.ancho > limite or pieza.alto > limite or pieza.ancho > tam or pieza.alto > tam)
+			continue;
+
+		pieza.inicio = p;
+		pieza.fin = fin + 1;
+		piezas.push_back(pieza);
+	}
+
+	if(piezas.empty())
+	{
+		cerr << "agrupar - No hay ninguna imagen que agrupar en " << argumentos[1] << endl;
+		return 1;
+	}
+
+	// Colocar las piezas de mayor a menor, cada una en la primera página en la que quepa
+	vector<Pieza*> orden;
+	for(vector<Pieza>::iterator i = piezas.begin() ; i != piezas.end() ; ++i)
+		orden.push_back(&*i);
+	sort(orden.begin(), orden.end(), mayor);
+
+	vector<Pagina> paginas;
+	for(vector<Pieza*>::iterator i = orden.begin() ; i != orden.end() ; ++i)
+	{
+		Pieza& p = **i;
+		p.pagina = 0;
+		while(p.pagina < paginas.size() and not paginas[p.pagina].atlas.colocar(p.ancho, p.alto, p.r))
+			++p.pagina;
+		if(p.pagina < paginas.size())
+			continue;
+
+		Pagina nueva(tam, margen);
+		stringstream codigo;
+		codigo << prefijo << paginas.size();
+		nueva.codigo = codigo.str();
+		if(find(codigos.begin(), codigos.end(), nueva.codigo) != codigos.end())
+		{
+			cerr << "agrupar - El código '" << nueva.codigo << "' ya existe en la galería, hay que cambiar el prefijo"
+					<< endl;
+			return 1;
+		}
+		nueva.ruta = directorio(p.ruta) + nueva.codigo + ".tex";
+		nueva.destino = directorio(p.origen) + nueva.codigo + ".tex";
+		nueva.atlas.colocar(p.ancho, p.alto, p.r);
+		paginas.push_back(nueva);
+	}
+
+	for(u32 i = 0 ; i < paginas.size() ; ++i)
+	{
+		if(not guardarPagina(paginas[i], orden, i, margen, indexar))
+		{
+			cerr << "agrupar - Error al escribir el archivo: " << paginas[i].destino << endl;
+			return 1;
+		}
+	}
+
+	// Sustituir las etiquetas desde el final para no mover las posiciones pendientes
+	for(vector<Pieza>::reverse_iterator p = piezas.rbegin() ; p != piezas.rend() ; ++p)
+	{
+		stringstream etiqueta;
+		etiqueta << "<imagen codigo=\"" << p->codigo << "\" atlas=\"" << paginas[p->pagina].codigo << "\" x=\""
+				<< p->r.x << "\" y=\"" << p->r.y << "\" ancho=\"" << p->r.ancho << "\" alto=\"" << p->r.alto << "\" />";
+		texto.replace(p->inicio, p->fin - p->inicio, etiqueta.str());
+	}
+
+	// Las páginas se añaden al final de la galería
+	stringstream nuevas;
+	for(vector<Pagina>::iterator p = paginas.begin() ; p != paginas.end() ; ++p)
+		nuevas << "\t<imagen codigo=\"" << p->codigo << "\" formato=\"tex\" ruta=\"" << p->ruta << "\" />\n";
+	string::size_type cierre = texto.rfind("</galeria>");
+	if(cierre == string::npos)
+	{
+		cerr << "agrupar - El archivo " << argumentos[1] << " no es una galería" << endl;
+		return 1;
+	}
+	texto.insert(cierre, nuevas.str());
+
+	for(u32 i = 0 ; i < paginas.size() ; ++i)
+	{
+		u32 imagenes = 0;
+		for(vector<Pieza>::iterator p = piezas.begin() ; p != piezas.end() ; ++p)
+			if(p->pagina == i)
+				++imagenes;
+		const textura::Cabecera& c = paginas[i].cabecera;
+		printf("%-40s %4ux%-4u %-6s %3u imágenes, %.1f%% ocupado\n", paginas[i].ruta.c_str(), c.ancho, c.alto,
+				nombreFormato(c.formato), imagenes, 100.0 * paginas[i].atlas.ocupados() / (c.ancho * c.alto));
+	}
+
+	ofstream salida(argumentos[2].c_str(), ios::binary);
+	salida << texto;
+	if(not salida.good())
+	{
+		cerr << "agrupar - Error al escribir el archivo: " << argumentos[2] << endl;
+		return 1;
+	}
+	printf("%s -> %s: %lu imágenes en %lu páginas\n", argumentos[1].c_str(), argumentos[2].c_str(),
+			(unsigned long)piezas.size(), (unsigned long)paginas.size());
+	return 0;
+}
@@ -0,0 +1,400 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * cocinar: prepara en el PC las imágenes de la galería de una aplicación, para que la consola no tenga que
+ * decodificarlas cada vez que arranca el juego. Para cada imagen BMP o PNG del archivo de la galería, hace el mismo
+ * trabajo que la clase Imagen al cargarla (decodificar, aplicar el color transparente, organizar en bloques de 4x4
+ * y, si tiene 256 colores o menos, convertir en una textura de índices con paleta), con el mismo código, y guarda el
+ * resultado como una textura cocinada (ver textura.h) junto a la imagen original, con la extensión .tex. Después,
+ * escribe una copia del archivo de la galería en la que esas imágenes tienen el formato 'tex' y la ruta del archivo
+ * cocinado. Las imágenes se procesan en paralelo, y sólo se vuelven a cocinar las que hayan cambiado.
+ *
+ * Las rutas de la galería son rutas absolutas en la tarjeta SD (por ejemplo, /apps/wiipang/media/fondo.bmp); cada
+ * una se busca en el directorio de la aplicación quitándole directorios del principio hasta que exista (en el
+ * ejemplo, media/fondo.bmp).
+ *
+ * Uso: cocinar [-a color] [-j hilos] [-n] [-f] directorio_app galeria.xml salida.xml
+ *   -a  Color transparente en hexadecimal, con la forma RRGGBBAA (por defecto, FF00FFFF); debe ser el mismo que
+ *       el del archivo de configuración del juego
+ *   -j  Número de hilos (por defecto, el número de procesadores)
+ *   -n  No convierte ninguna imagen en textura de índices (equivale a Imagen::indexar = false)
+ *   -f  Vuelve a cocinar todas las imágenes, aunque no hayan cambiado
+ */
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include "bmp.h"
+#include "pngdec.h"
+#include "textura.h"
+using namespace std;
+
+namespace
+{
+	// Imagen de la galería que hay que cocinar
+	struct Trabajo
+	{
+		string ruta;
+		string::size_type inicio_ruta, fin_ruta;
+		string::size_type inicio_formato, fin_formato;
+		string origen, destino;
+		bool hecho;
+		string error;
+		textura::Cabecera cabecera;
+	};
+
+	// Opciones comunes a todos los hilos
+	u32 alpha = 0xFF00FFFF;
+	bool indexar = true;
+	bool forzar = false;
+
+	void uso(void)
+	{
+		cerr << "Uso: cocinar [-a color] [-j hilos] [-n] [-f] directorio_app galeria.xml salida.xml" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	bool existe(const string& ruta, time_t* modificado = NULL)
+	{
+		struct stat info;
+		if(stat(ruta.c_str(), &info) != 0 or not S_ISREG(info.st_mode))
+			return false;
+		if(modificado != NULL)
+			*modificado = info.st_mtime;
+		return true;
+	}
+
+	// Busca el valor de un atributo dentro de una etiqueta, y devuelve sus posiciones en el texto
+	bool atributo(const string& texto, string::size_type inicio, string::size_type fin, const string& nombre,
+					string::size_type& inicio_valor, string::size_type& fin_valor)
+	{
+		for(string::size_type p = texto.find(nombre, inicio) ; p != string::npos and p < fin ;
+			p = texto.find(nombre, p + 1))
+		{
+			// El nombre debe ser un atributo completo, y no parte de otro
+			if(p == 0 or not isspace(texto[p - 1]))
+				continue;
+			string::size_type q = texto.find_first_not_of(" \t\r\n", p + nombre.length());
+			if(q == string::npos or q >= fin or texto[q] != '=')
+				continue;
+			q = texto.find_first_not_of(" \t\r\n", q + 1);
+			if(q == string::npos or q >= fin or (texto[q] != '"' and texto[q] != '\''))
+				continue;
+			string::size_type cierre = texto.find(texto[q], q + 1);
+			if(cierre == string::npos or cierre >= fin)
+				return false;
+			inicio_valor = q + 1;
+			fin_valor = cierre;
+			return true;
+		}
+		return false;
+	}
+
+	// Localiza en el directorio de la aplicación un archivo de la tarjeta SD
+	bool localizar(const string& app, const string& ruta, string& local)
+	{
+		for(string::size_type p = 0 ; p != string::npos ; p = ruta.find('/', p + 1))
+		{
+			string resto = ruta.substr(p);
+			if(not resto.empty() and resto[0] == '/')
+				resto.erase(0, 1);
+			if(not resto.empty() and existe(app + "/" + resto))
+			{
+				local = app + "/" + resto;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	string cambiarExtension(const string& ruta, const string& extension)
+	{
+		string::size_type punto = ruta.rfind('.');
+		if(punto == string::npos or ruta.find('/', punto) != string::npos)
+			return ruta + extension;
+		return ruta.substr(0, punto) + extension;
+	}
+
+	void escribir16(vector<u8>& v, u32 posicion, u16 x)
+	{
+		v[posicion] = (u8)(x >> 8);
+		v[posicion + 1] = (u8)x;
+	}
+
+	// Decodifica una imagen y la guarda como textura cocinada
+	void cocinar(Trabajo& t)
+	{
+		time_t origen = 0, destino = 0;
+		if(not existe(t.origen, &origen))
+		{
+			t.error = "no se puede leer el archivo";
+			return;
+		}
+		if(not forzar and existe(t.destino, &destino) and destino >= origen)
+		{
+			vector<u8> anterior;
+			if(leerArchivo(t.destino, anterior)
+				and textura::leerCabecera(anterior.empty() ? NULL : &anterior[0], anterior.size(), t.cabecera))
+				return;
+		}
+
+		vector<u8> datos;
+		if(not leerArchivo(t.origen, datos) or datos.empty())
+		{
+			t.error = "no se puede leer el archivo";
+			return;
+		}
+
+		// Decodificar con el mismo código que la consola, en una textura RGB5A3
+		u16 ancho = 0, alto = 0;
+		vector<u16> texels;
+		bmp::Info info_bmp;
+		png::Info info_png;
+		if(bmp::leerCabecera(&datos[0], datos.size(), info_bmp))
+		{
+			ancho = info_bmp.ancho;
+			alto = info_bmp.alto;
+			texels.resize(bmp::tamTextura(info_bmp) / sizeof(u16));
+			bmp::decodificar(&datos[0], info_bmp, alpha, &texels[0]);
+		}
+		else if(png::esPng(&datos[0], datos.size()) and png::leerCabecera(&datos[0], datos.size(), info_png))
+		{
+			ancho = info_png.ancho;
+			alto = info_png.alto;
+			texels.resize(png::tamTextura(info_png) / sizeof(u16));
+			if(not png::decodificar(&datos[0], info_png, alpha, &texels[0]))
+				texels.clear();
+		}
+		if(texels.empty())
+		{
+			t.error = "formato de imagen no soportado";
+			return;
+		}
+		if(ancho % 8 != 0 or alto % 8 != 0)
+		{
+			t.error = "las medidas de la imagen no son múltiplo de 8";
+			return;
+		}
+
+		// Convertir en una textura de índices, igual que Imagen::convertirIndexada()
+		textura::Cabecera& c = t.cabecera;
+		vector<u8> indices(ancho * alto);
+		u16 paleta[256];
+		u32 colores = indexar ? textura::indexar(&texels[0], ancho, alto, &indices[0], paleta) : 0;
+
+		c.version = textura::VERSION;
+		c.formato = (colores == 0) ? textura::RGB5A3 : (colores <= 16) ? textura::CI4 : textura::CI8;
+		c.ancho = ancho;
+		c.alto = alto;
+		c.colores = colores;
+		c.tam = textura::tam((textura::Formato)c.formato, ancho, alto);
+		c.paleta = 0;
+
+		u32 entradas = textura::entradasPaleta((textura::Formato)c.formato);
+		u32 tam = textura::TAM_CABECERA + c.tam;
+		if(entradas > 0)
+		{
+			c.paleta = (tam + 31) & ~31;
+			tam = c.paleta + entradas * sizeof(u16);
+		}
+
+		// El archivo se rellena con ceros hasta un múltiplo de 32 bytes, igual que los lee Sdcard::leer()
+		vector<u8> blob((tam + 31) & ~31, 0);
+		textura::escribirCabecera(c, &blob[0]);
+		if(entradas == 0)
+		{
+			// La textura ya está organizada en bloques; sólo hay que escribirla en big endian
+			for(u32 i = 0 ; i < texels.size() ; ++i)
+				escribir16(blob, textura::TAM_CABECERA + i * 2, texels[i]);
+		}
+		else
+		{
+			textura::codificarIndices(&indices[0], ancho, alto, (textura::Formato)c.formato,
+										&blob[textura::TAM_CABECERA]);
+			for(u32 i = 0 ; i < colores ; ++i)
+				escribir16(blob, c.paleta + i * 2, paleta[i]);
+		}
+
+		textura::Cabecera comprobacion;
+		if(not textura::leerCabecera(&blob[0], blob.size(), comprobacion))
+		{
+			t.error = "la textura cocinada no es válida";
+			return;
+		}
+
+		ofstream archivo(t.destino.c_str(), ios::binary);
+		archivo.write((const char*)&blob[0], blob.size());
+		if(not archivo.good())
+		{
+			t.error = "no se puede escribir el archivo " + t.destino;
+			return;
+		}
+		t.hecho = true;
+	}
+
+	const char* nombreFormato(u8 formato)
+	{
+		switch(formato)
+		{
+			case textura::CI4:
+				return "CI4";
+			case textura::CI8:
+				return "CI8";
+			default:
+				return "RGB5A3";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u32 hilos = thread::hardware_concurrency();
+	vector<string> argumentos;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-a" and i + 1 < argc)
+			alpha = strtoul(argv[++i], NULL, 16);
+		else if(arg == "-j" and i + 1 < argc)
+			hilos = atoi(argv[++i]);
+		else if(arg == "-n")
+			indexar = false;
+		else if(arg == "-f")
+			forzar = true;
+		else if(arg[0] == '-')
+			uso();
+		else
+			argumentos.push_back(arg);
+	}
+
+	if(argumentos.size() != 3)
+		uso();
+	if(hilos == 0)
+		hilos = 1;
+
+	string app = argumentos[0];
+	while(app.length() > 1 and app[app.length() - 1] == '/')
+		app.erase(app.length() - 1);
+
+	vector<u8> xml;
+	if(not leerArchivo(argumentos[1], xml))
+	{
+		cerr << "cocinar - Error al leer el archivo: " << argumentos[1] << endl;
+		return 1;
+	}
+	string texto(xml.begin(), xml.end());
+
+	// Buscar las etiquetas de imagen con formato bmp o png
+	vector<Trabajo> trabajos;
+	for(string::size_type p = texto.find("<imagen") ; p != string::npos ; p = texto.find("<imagen", p + 1))
+	{
+		string::size_type fin = texto.find('>', p);
+		if(fin == string::npos)
+			break;
+
+		Trabajo t;
+		t.hecho = false;
+		if(not atributo(texto, p, fin, "ruta", t.inicio_ruta, t.fin_ruta)
+			or not atributo(texto, p, fin, "formato", t.inicio_formato, t.fin_formato))
+			continue;
+		string formato = texto.substr(t.inicio_formato, t.fin_formato - t.inicio_formato);
+		if(formato != "bmp" and formato != "png")
+			continue;
+
+		t.ruta = texto.substr(t.inicio_ruta, t.fin_ruta - t.inicio_ruta);
+		if(not localizar(app, t.ruta, t.origen))
+		{
+			cerr << "cocinar - No se encuentra la imagen '" << t.ruta << "' en " << app << endl;
+			return 1;
+		}
+		t.destino = cambiarExtension(t.origen, ".tex");
+		trabajos.push_back(t);
+	}
+
+	// Cocinar las imágenes en paralelo; cada hilo toma la siguiente imagen pendiente
+	atomic<u32> siguiente(0);
+	vector<thread> grupo;
+	for(u32 i = 0 ; i < hilos and i < trabajos.size() ; ++i)
+		grupo.push_back(thread([&]() {
+			for(u32 j = siguiente++ ; j < trabajos.size() ; j = siguiente++)
+				cocinar(trabajos[j]);
+		}));
+	for(vector<thread>::iterator i = grupo.begin() ; i != grupo.end() ; ++i)
+		i->join();
+
+	// Escribir la nueva galería, sustituyendo desde el final para no mover las posiciones pendientes
+	int resultado = 0;
+	u32 cocinadas = 0;
+	for(vector<Trabajo>::reverse_iterator t = trabajos.rbegin() ; t != trabajos.rend() ; ++t)
+	{
+		if(not t->error.empty())
+		{
+			cerr << "cocinar - " << t->ruta << ": " << t->error << endl;
+			resultado = 1;
+			continue;
+		}
+		string ruta = cambiarExtension(t->ruta, ".tex");
+		if(t->inicio_ruta > t->inicio_formato)
+			texto.replace(t->inicio_ruta, t->fin_ruta - t->inicio_ruta, ruta);
+		texto.replace(t->inicio_formato, t->fin_formato - t->inicio_formato, "tex");
+		if(t->inicio_ruta < t->inicio_formato)
+			texto.replace(t->inicio_ruta, t->fin_ruta - t->inicio_ruta, ruta);
+		if(t->hecho)
+			++cocinadas;
+	}
+	if(resultado != 0)
+		return resultado;
+
+	for(vector<Trabajo>::iterator t = trabajos.begin() ; t != trabajos.end() ; ++t)
+		printf("%-40s %4ux%-4u %-6s %s\n", t->ruta.c_str(), t->cabecera.ancho, t->cabecera.alto,
+				nombreFormato(t->cabecera.formato), t->hecho ? "" : "(sin cambios)");
+
+	ofstream salida(argumentos[2].c_str(), ios::binary);
+	salida << texto;
+	if(not salida.good())
+	{
+		cerr << "cocinar - Error al escribir el archivo: " << argumentos[2] << endl;
+		return 1;
+	}
+	printf("%s -> %s: %lu imágenes, %u cocinadas\n", argumentos[1].c_str(), argumentos[2].c_str(),
+			(unsigned long)trabajos.size(), cocinadas);
+	return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * comprobartmx: lee en el PC las capas de tiles de varios archivos TMX con las mismas funciones que la clase Nivel
+ * (ver tiled.h), y comprueba que todos dan exactamente las mismas capas que el primero: mismo número de capas, con
+ * el mismo nombre, la misma marca de capa sólida y los mismos tiles. Sirve para comprobar que un mapa guardado por
+ * Tiled con los distintos formatos de capa (XML, CSV, base64 y base64 con zlib) se carga igual en la consola. Para
+ * cada archivo muestra el formato de cada capa y el número de tiles no vacíos, y termina con error si alguno no se
+ * puede leer o no coincide con el primero.
+ *
+ * Uso: comprobartmx referencia.tmx archivo.tmx [archivo.tmx ...]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "tiled.h"
+using namespace std;
+
+namespace
+{
+	struct Mapa
+	{
+		u32 tiles_capa;
+		vector<tiled::Capa> capas;
+		vector<string> formatos;
+		vector<tiled::Tile> tiles;
+	};
+
+	void uso(void)
+	{
+		cerr << "Uso: comprobartmx referencia.tmx archivo.tmx [archivo.tmx ...]" << endl;
+		exit(1);
+	}
+
+	// Lee todas las capas de tiles de un mapa, igual que Nivel::cargarDatosIniciales()
+	bool leerMapa(const string& ruta, Mapa& m)
+	{
+		TiXmlDocument doc(ruta);
+		if(not doc.LoadFile())
+		{
+			cerr << "comprobartmx - No se puede leer el archivo: " << ruta << endl;
+			return false;
+		}
+
+		TiXmlElement* raiz = doc.RootElement();
+		int ancho = 0;
+		int alto = 0;
+		raiz->QueryIntAttribute("width", &ancho);
+		raiz->QueryIntAttribute("height", &alto);
+		m.tiles_capa = (ancho > 0 and alto > 0) ? (u32)ancho * (u32)alto : 0;
+
+		u32 num_capas = 0;
+		for(TiXmlElement* capa = raiz->FirstChildElement("layer") ; capa ; capa = capa->NextSiblingElement("layer"))
+			++num_capas;
+		m.tiles.assign(num_capas * m.tiles_capa, 0);
+		m.capas.resize(num_capas);
+
+		u32 i = 0;
+		for(TiXmlElement* capa = raiz->FirstChildElement("layer") ; capa ;
+			capa = capa->NextSiblingElement("layer"), ++i)
+		{
+			const TiXmlElement* datos = capa->FirstChildElement("data");
+			const char* codificacion = datos ? datos->Attribute("encoding") : NULL;
+			const char* compresion = datos ? datos->Attribute("compression") : NULL;
+			m.formatos.push_back(string(codificacion ? codificacion : "xml") + (compresion ? "+" : "")
+									+ (compresion ? compresion : ""));
+
+			m.capas[i].tiles = m.tiles.empty() ? NULL : &m.tiles[i * m.tiles_capa];
+			try {
+				tiled::leerCapa(capa, m.capas[i], m.tiles_capa);
+			} catch(const ArchivoEx& e) {
+				cerr << "comprobartmx - " << ruta << ": " << e.what() << endl;
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+		uso();
+
+	Mapa referencia;
+	if(not leerMapa(argv[1], referencia))
+		return 1;
+
+	int resultado = 0;
+	for(int a = 1 ; a < argc ; ++a)
+	{
+		Mapa m;
+		if(a > 1 and not leerMapa(argv[a], m))
+		{
+			resultado = 1;
+			continue;
+		}
+		const Mapa& actual = (a > 1) ? m : referencia;
+
+		printf("%s:", argv[a]);
+		for(u32 i = 0 ; i < actual.capas.size() ; ++i)
+		{
+			u32 llenos = 0;
+			for(u32 t = 0 ; t < actual.tiles_capa ; ++t)
+				if(actual.capas[i].tiles[t] != 0)
+					++llenos;
+			printf(" %s (%s, %u tiles%s)", actual.capas[i].nombre.c_str(), actual.formatos[i].c_str(), llenos,
+					actual.capas[i].solida ? ", sólida" : "");
+		}
+
+		// Cada capa debe coincidir con la del mismo orden en el archivo de referencia
+		bool iguales = (actual.tiles_capa == referencia.tiles_capa and actual.capas.size() == referencia.capas.size()
+						and actual.tiles == referencia.tiles);
+		for(u32 i = 0 ; iguales and i < actual.capas.size() ; ++i)
+			iguales = (actual.capas[i].nombre == referencia.capas[i].nombre
+						and actual.capas[i].solida == referencia.capas[i].solida);
+
+		printf("  %s\n", (a == 1) ? "referencia" : (iguales ? "OK" : "DISTINTO"));
+		if(not iguales)
+			resultado = 1;
+	}
+	return resultado;
+}
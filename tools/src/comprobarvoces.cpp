@@ -0,0 +1,189 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * comprobarvoces: comprueba en el PC la política de reparto de voces de sonido de la clase Mezclador (ver voces.h),
+ * simulando una tabla de 16 voces, con la primera reservada para la música como en la consola. Cada prueba parte de
+ * la tabla vacía, lanza una serie de peticiones (ocupando la voz elegida, como hace el Mezclador) y comprueba la voz
+ * elegida y las estadísticas: fusión de peticiones del mismo efecto dentro de la ventana, límite de instancias,
+ * uso de voces libres, robo de la voz menos prioritaria o más antigua, y descarte. Termina con error si alguna
+ * decisión no es la esperada.
+ *
+ * Uso: comprobarvoces
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include "voces.h"
+using namespace std;
+
+namespace
+{
+	const u8 PRIMERA_VOZ = 1;
+	const u8 NUM_VOCES = 16;
+
+	// Ventana de fusión de un frame a 60 FPS, en microsegundos
+	const u32 VENTANA = 16667;
+
+	// Cada efecto se identifica por la dirección de una posición de este vector
+	const char EFECTOS[64] = {0};
+
+	struct Simulacion
+	{
+		voces::Voz tabla[NUM_VOCES];
+		voces::Estadisticas estadisticas;
+		u32 ventana;
+
+		Simulacion(void): ventana(VENTANA)
+		{
+			for(u8 v = 0 ; v < NUM_VOCES ; ++v)
+			{
+				tabla[v].efecto = NULL;
+				tabla[v].prioridad = 0;
+				tabla[v].inicio = 0;
+			}
+			voces::reiniciar(estadisticas);
+		}
+
+		// Pide una voz y, si se elige alguna, la ocupa con el efecto como haría el Mezclador
+		s16 pedir(u8 efecto, u8 prioridad, u8 instancias, u64 instante)
+		{
+			voces::Peticion p = {&EFECTOS[efecto], prioridad, instancias, instante};
+			s16 v = voces::elegir(tabla, PRIMERA_VOZ, NUM_VOCES, p, ventana, estadisticas);
+			if(v >= 0)
+			{
+				tabla[v].efecto = p.efecto;
+				tabla[v].prioridad = prioridad;
+				tabla[v].inicio = instante;
+				estadisticas.reproducciones++;
+			}
+			return v;
+		}
+
+		// Ocupa todas las voces de efectos con efectos distintos de la misma prioridad, un frame después cada uno
+		void llenar(u8 prioridad)
+		{
+			for(u8 i = 0 ; i < NUM_VOCES - PRIMERA_VOZ ; ++i)
+				pedir(i + 1, prioridad, 0, (u64)i * VENTANA);
+		}
+	};
+
+	bool informar(const char* nombre, bool correcto)
+	{
+		printf("  %-52s %s\n", nombre, correcto ? "OK" : "FALLO");
+		return correcto;
+	}
+
+	bool comprobarFusion(void)
+	{
+		Simulacion s;
+		bool correcto = (s.pedir(0, 10, 0, 0) == PRIMERA_VOZ);
+		correcto &= (s.pedir(0, 10, 0, VENTANA / 2) == voces::FUSIONADA);
+		correcto &= (s.pedir(0, 10, 0, VENTANA - 1) == voces::FUSIONADA);
+		correcto &= (s.pedir(0, 10, 0, VENTANA) == PRIMERA_VOZ + 1);
+		// Otro efecto dentro de la ventana no se fusiona
+		correcto &= (s.pedir(1, 10, 0, VENTANA + 1) == PRIMERA_VOZ + 2);
+		correcto &= (s.estadisticas.peticiones == 5 and s.estadisticas.fusiones == 2
+					and s.estadisticas.reproducciones == 3 and s.estadisticas.pico_voces == 3);
+		bool resultado = informar("fusión dentro de la ventana", correcto);
+
+		Simulacion sin_ventana;
+		sin_ventana.ventana = 0;
+		correcto = (sin_ventana.pedir(0, 10, 0, 0) == PRIMERA_VOZ);
+		correcto &= (sin_ventana.pedir(0, 10, 0, 0) == PRIMERA_VOZ + 1);
+		correcto &= (sin_ventana.estadisticas.fusiones == 0);
+		return resultado & informar("ventana 0: sin fusión", correcto);
+	}
+
+	bool comprobarInstancias(void)
+	{
+		Simulacion s;
+		bool correcto = (s.pedir(0, 10, 2, 0) == PRIMERA_VOZ);
+		correcto &= (s.pedir(0, 10, 2, VENTANA) == PRIMERA_VOZ + 1);
+		// La tercera instancia reutiliza la voz de la más antigua, aunque queden voces libres
+		correcto &= (s.pedir(0, 10, 2, 2 * VENTANA) == PRIMERA_VOZ);
+		correcto &= (s.pedir(0, 10, 2, 3 * VENTANA) == PRIMERA_VOZ + 1);
+		correcto &= (s.estadisticas.robos == 2 and s.estadisticas.voces_ocupadas == 2);
+		return informar("límite de instancias, se reutiliza la más antigua", correcto);
+	}
+
+	bool comprobarRobo(void)
+	{
+		bool resultado = true;
+
+		// Con todas las voces a la misma prioridad, se roba la más antigua
+		Simulacion s;
+		s.llenar(10);
+		bool correcto = (s.estadisticas.voces_ocupadas == NUM_VOCES - PRIMERA_VOZ and s.estadisticas.robos == 0);
+		correcto &= (s.pedir(40, 20, 0, 100 * VENTANA) == PRIMERA_VOZ);
+		correcto &= (s.pedir(41, 10, 0, 101 * VENTANA) == PRIMERA_VOZ + 1);
+		correcto &= (s.estadisticas.robos == 2);
+		resultado &= informar("robo de la voz más antigua", correcto);
+
+		// La prioridad manda sobre la antigüedad
+		Simulacion p;
+		p.llenar(10);
+		p.tabla[PRIMERA_VOZ + 7].prioridad = 5;
+		p.tabla[PRIMERA_VOZ + 9].prioridad = 5;
+		correcto = (p.pedir(40, 10, 0, 100 * VENTANA) == PRIMERA_VOZ + 7);
+		correcto &= (p.pedir(41, 10, 0, 101 * VENTANA) == PRIMERA_VOZ + 9);
+		correcto &= (p.pedir(42, 10, 0, 102 * VENTANA) == PRIMERA_VOZ);
+		resultado &= informar("robo de la voz menos prioritaria", correcto);
+
+		// Una voz que ha quedado libre se usa antes que robar
+		Simulacion l;
+		l.llenar(10);
+		l.tabla[PRIMERA_VOZ + 4].efecto = NULL;
+		correcto = (l.pedir(40, 20, 0, 100 * VENTANA) == PRIMERA_VOZ + 4);
+		correcto &= (l.estadisticas.robos == 0 and l.estadisticas.voces_ocupadas == NUM_VOCES - PRIMERA_VOZ);
+		resultado &= informar("voz libre antes que robo", correcto);
+
+		return resultado;
+	}
+
+	bool comprobarDescarte(void)
+	{
+		Simulacion s;
+		s.llenar(200);
+		bool correcto = (s.pedir(40, 100, 0, 100 * VENTANA) == voces::DESCARTADA);
+		correcto &= (s.estadisticas.descartes == 1 and s.estadisticas.robos == 0);
+		// La tabla no cambia al descartar
+		for(u8 v = PRIMERA_VOZ ; v < NUM_VOCES ; ++v)
+			correcto &= (s.tabla[v].efecto == &EFECTOS[v - PRIMERA_VOZ + 1]);
+		// La voz 0 (música) no se utiliza nunca
+		correcto &= (s.tabla[0].efecto == NULL);
+		return informar("descarte si todas son más prioritarias", correcto);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 1)
+	{
+		cerr << "Uso: comprobarvoces" << endl;
+		return 1;
+	}
+
+	printf("Reparto de voces\n");
+	bool correcto = comprobarFusion();
+	correcto &= comprobarInstancias();
+	correcto &= comprobarRobo();
+	correcto &= comprobarDescarte();
+	return correcto ? 0 : 1;
+}
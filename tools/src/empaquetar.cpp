@@ -0,0 +1,297 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * empaquetar: reúne en un único paquete de recursos (ver paquete.h) todos los archivos de los directorios media y
+ * xml de una aplicación, con los nombres relativos al directorio de la aplicación. Si el paquete se copia en el
+ * directorio de la aplicación en la tarjeta SD y se indica en el archivo de configuración (ver clase Juego), la
+ * consola leerá todos los recursos desde él, abriendo un único archivo. Cada archivo se comprime con LZ4 si así
+ * ocupa, como mucho, el porcentaje indicado de su tamaño original; si no (por ejemplo, un MP3), se guarda tal cual.
+ * Al terminar, vuelve a abrir el paquete generado con el mismo lector que utiliza la biblioteca y comprueba el
+ * contenido de cada archivo.
+ *
+ * Uso: empaquetar [-n] [-c porcentaje] directorio_app [salida.pak]
+ *      empaquetar -l paquete.pak
+ *   -n  No comprime ningún archivo
+ *   -c  Porcentaje máximo del tamaño original para guardar un archivo comprimido (por defecto, 90)
+ *   -l  Muestra el contenido de un paquete existente
+ * Si no se indica la salida, se crea el archivo datos.pak en el directorio de la aplicación.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "paquete.h"
+using namespace std;
+
+namespace
+{
+	// Directorios de la aplicación que se incluyen en el paquete
+	const char* DIRECTORIOS[] = { "media", "xml" };
+
+	struct Archivo
+	{
+		string nombre;
+		u32 hash;
+		vector<u8> datos;
+		vector<u8> comprimido;
+	};
+
+	bool menor(const Archivo& a, const Archivo& b)
+	{
+		if(a.hash != b.hash)
+			return a.hash < b.hash;
+		return a.nombre < b.nombre;
+	}
+
+	void uso(void)
+	{
+		cerr << "Uso: empaquetar [-n] [-c porcentaje] directorio_app [salida.pak]" << endl;
+		cerr << "     empaquetar -l paquete.pak" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	// Recorre recursivamente un directorio, añadiendo sus archivos con el nombre relativo al directorio base
+	bool recorrer(const string& base, const string& relativo, vector<Archivo>& archivos)
+	{
+		DIR* dir = opendir((base + "/" + relativo).c_str());
+		if(dir == NULL)
+			return false;
+
+		vector<string> nombres;
+		for(dirent* d = readdir(dir) ; d != NULL ; d = readdir(dir))
+			if(strcmp(d->d_name, ".") != 0 and strcmp(d->d_name, "..") != 0 and d->d_name[0] != '.')
+				nombres.push_back(d->d_name);
+		closedir(dir);
+
+		// Orden estable entre ejecuciones, para que dos paquetes de los mismos archivos sean idénticos
+		sort(nombres.begin(), nombres.end());
+
+		bool correcto = true;
+		for(vector<string>::iterator i = nombres.begin() ; i != nombres.end() and correcto ; ++i)
+		{
+			string nombre = relativo + "/" + *i;
+			struct stat info;
+			if(stat((base + "/" + nombre).c_str(), &info) != 0)
+				correcto = false;
+			else if(S_ISDIR(info.st_mode))
+				correcto = recorrer(base, nombre, archivos);
+			else if(S_ISREG(info.st_mode))
+			{
+				Archivo a;
+				a.nombre = nombre;
+				a.hash = fnv1a::hash(nombre);
+				correcto = leerArchivo(base + "/" + nombre, a.datos);
+				if(not correcto)
+					cerr << "empaquetar - Error al leer el archivo: " << base << "/" << nombre << endl;
+				archivos.push_back(a);
+			}
+		}
+		return correcto;
+	}
+
+	u32 alinear(u32 tam)
+	{
+		return (tam + paquete::ALINEACION - 1) & ~(paquete::ALINEACION - 1);
+	}
+
+	int listar(const string& ruta)
+	{
+		try {
+			Paquete p;
+			p.abrir(ruta);
+			for(u32 i = 0 ; i < p.entradas() ; ++i)
+			{
+				paquete::Entrada e = p.entrada(i);
+				printf("%08x %10u %10u %10u %s  %s\n", e.hash, e.offset, e.tam, e.tam_original,
+						e.compresion == paquete::LZ4 ? "lz4" : "   ", p.nombre(e).c_str());
+			}
+			printf("%u archivos\n", p.entradas());
+		} catch(const std::exception& e) {
+			cerr << "empaquetar - " << e.what() << endl;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc == 3 and string(argv[1]) == "-l")
+		return listar(argv[2]);
+
+	bool comprimir = true;
+	u32 porcentaje = 90;
+	string app, salida;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-n")
+			comprimir = false;
+		else if(arg == "-c" and i + 1 < argc)
+			porcentaje = atoi(argv[++i]);
+		else if(arg[0] == '-')
+			uso();
+		else if(app.empty())
+			app = arg;
+		else if(salida.empty())
+			salida = arg;
+		else
+			uso();
+	}
+
+	if(app.empty() or porcentaje == 0 or porcentaje > 100)
+		uso();
+
+	while(app.length() > 1 and app[app.length() - 1] == '/')
+		app.erase(app.length() - 1);
+	if(salida.empty())
+		salida = app + "/datos.pak";
+
+	// Leer todos los archivos de los directorios de recursos
+	vector<Archivo> archivos;
+	for(u32 i = 0 ; i < sizeof(DIRECTORIOS) / sizeof(DIRECTORIOS[0]) ; ++i)
+	{
+		if(not recorrer(app, DIRECTORIOS[i], archivos))
+		{
+			cerr << "empaquetar - Error al recorrer el directorio: " << app << "/" << DIRECTORIOS[i] << endl;
+			return 1;
+		}
+	}
+
+	// Comprimir cada archivo, y quedarse con la versión comprimida sólo si el ahorro merece la pena
+	if(comprimir)
+	{
+		for(vector<Archivo>::iterator i = archivos.begin() ; i != archivos.end() ; ++i)
+		{
+			if(i->datos.empty())
+				continue;
+			lz4::comprimir(&i->datos[0], i->datos.size(), i->comprimido);
+			if((u64)i->comprimido.size() * 100 > (u64)i->datos.size() * porcentaje)
+				i->comprimido.clear();
+		}
+	}
+
+	// El índice se ordena por hash, para que la consola pueda buscar en él con una búsqueda binaria
+	sort(archivos.begin(), archivos.end(), menor);
+
+	// Calcular la disposición del paquete: cabecera, índice, tabla de nombres y contenidos alineados
+	paquete::Cabecera c;
+	c.version = paquete::VERSION;
+	c.entradas = archivos.size();
+	c.nombres = paquete::TAM_CABECERA + c.entradas * paquete::TAM_ENTRADA;
+	c.tam_nombres = 0;
+	for(vector<Archivo>::iterator i = archivos.begin() ; i != archivos.end() ; ++i)
+		c.tam_nombres += i->nombre.length() + 1;
+	c.datos = alinear(c.nombres + c.tam_nombres);
+
+	vector<paquete::Entrada> entradas(archivos.size());
+	u32 nombre = 0;
+	u32 offset = c.datos;
+	for(u32 i = 0 ; i < archivos.size() ; ++i)
+	{
+		entradas[i].hash = archivos[i].hash;
+		entradas[i].nombre = nombre;
+		entradas[i].offset = offset;
+		entradas[i].tam_original = archivos[i].datos.size();
+		entradas[i].compresion = archivos[i].comprimido.empty() ? paquete::NINGUNA : paquete::LZ4;
+		entradas[i].tam = archivos[i].comprimido.empty() ? archivos[i].datos.size() : archivos[i].comprimido.size();
+		nombre += archivos[i].nombre.length() + 1;
+		offset += alinear(entradas[i].tam);
+	}
+
+	// Construir el paquete completo en memoria; el relleno queda a cero
+	vector<u8> pak(offset, 0);
+	paquete::escribirCabecera(c, &pak[0]);
+	for(u32 i = 0 ; i < archivos.size() ; ++i)
+	{
+		paquete::escribirEntrada(entradas[i], &pak[paquete::TAM_CABECERA + i * paquete::TAM_ENTRADA]);
+		memcpy(&pak[c.nombres + entradas[i].nombre], archivos[i].nombre.c_str(), archivos[i].nombre.length());
+		const vector<u8>& contenido = archivos[i].comprimido.empty() ? archivos[i].datos : archivos[i].comprimido;
+		if(not contenido.empty())
+			memcpy(&pak[entradas[i].offset], &contenido[0], entradas[i].tam);
+	}
+
+	ofstream destino(salida.c_str(), ios::binary);
+	destino.write((const char*)&pak[0], pak.size());
+	if(not destino.good())
+	{
+		cerr << "empaquetar - Error al escribir el archivo: " << salida << endl;
+		return 1;
+	}
+	destino.close();
+
+	// Comprobar el resultado con el mismo lector que utiliza la biblioteca
+	try {
+		Paquete p;
+		p.abrir(salida);
+		for(vector<Archivo>::iterator i = archivos.begin() ; i != archivos.end() ; ++i)
+		{
+			paquete::Entrada e;
+			u8* contenido = NULL;
+			if(p.buscar(i->nombre, e))
+				contenido = p.leer(e);
+			bool correcto = (contenido != NULL and e.tam_original == i->datos.size()
+								and e.offset % paquete::ALINEACION == 0
+								and (i->datos.empty() or memcmp(contenido, &i->datos[0], e.tam_original) == 0));
+			memoria::liberar(contenido);
+			if(not correcto)
+			{
+				cerr << "empaquetar - El archivo '" << i->nombre << "' no se ha empaquetado correctamente" << endl;
+				return 1;
+			}
+		}
+	} catch(const std::exception& e) {
+		cerr << "empaquetar - " << e.what() << endl;
+		return 1;
+	}
+
+	u64 total = 0;
+	u32 comprimidos = 0;
+	for(vector<Archivo>::iterator i = archivos.begin() ; i != archivos.end() ; ++i)
+	{
+		total += i->datos.size();
+		if(not i->comprimido.empty())
+			++comprimidos;
+	}
+	printf("%s -> %s: %u archivos (%u comprimidos), %llu bytes de recursos, %lu bytes de paquete (%.1f%%)\n",
+			app.c_str(), salida.c_str(), c.entradas, comprimidos, (unsigned long long)total, (unsigned long)pak.size(),
+			total > 0 ? 100.0 * pak.size() / total : 0.0);
+	return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * medirbmp: mide en el PC el decodificador de mapas de bits que utiliza la clase Imagen (ver bmp.h), comparándolo
+ * con el método anterior de la biblioteca, que convertía los píxeles uno a uno en orden lineal y después los
+ * reorganizaba en tiles de 4x4 con Screen::tiling4x4(). Para cada archivo, comprueba que ambos producen exactamente
+ * la misma textura (sólo en bitmaps de 24 bits, el único formato que admitía el método anterior) e informa del
+ * tiempo medio de cada uno y de los megapíxeles por segundo.
+ *
+ * Uso: medirbmp [-n repeticiones] [-a color] archivo.bmp [archivo.bmp ...]
+ *   -n  Número de veces que se decodifica cada archivo (por defecto, 50)
+ *   -a  Color transparente en hexadecimal, con la forma RRGGBBAA (por defecto, FF00FFFF)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bmp.h"
+using namespace std;
+
+namespace
+{
+	void uso(void)
+	{
+		cerr << "Uso: medirbmp [-n repeticiones] [-a color] archivo.bmp [archivo.bmp ...]" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	double ahora(void)
+	{
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return t.tv_sec + t.tv_nsec / 1e9;
+	}
+
+	// Método anterior: Imagen::cargarBmp24() seguido de Screen::tiling4x4(), tal y como estaban en la biblioteca
+	void referencia(const u8* pixeles, u16 ancho, u16 alto, u32 alpha, u16* destino)
+	{
+		u8 offset = ancho % 4;
+		u32 pixel_count = 0;
+		u32 pixel_num = alto * ancho;
+		u32 y = alto - 1;
+		u32 x = 0;
+		u8 r = (alpha >> 24) & 0xFF;
+		u8 g = (alpha >> 16) & 0xFF;
+		u8 b = (alpha >> 8) & 0xFF;
+
+		while(pixel_count < pixel_num)
+		{
+			u8 pb = *pixeles++;
+			u8 pg = *pixeles++;
+			u8 pr = *pixeles++;
+			if(pr == r and pg == g and pb == b)
+				destino[ancho * y + x] = (pb>>4) | ((pg>>4)<<4) | ((pr>>4)<<8) | (0<<13);
+			else
+				destino[ancho * y + x] = (pb>>3) | ((pg>>3)<<5) | ((pr>>3)<<10) | (1<<15);
+			pixel_count++;
+			x++;
+			if(pixel_count % ancho == 0)
+			{
+				x = 0;
+				y--;
+				pixeles += offset;
+			}
+		}
+
+		u16 mem_tile[1024*8];
+		u16* p1 = destino;
+		u16* p2 = mem_tile;
+		for(u16 n = 0 ; n < alto ; n += 4)
+		{
+			for(u16 l = 0 ; l < 4 ; l++)
+			{
+				for(u16 m = 0 ; m < ancho ; m += 4)
+				{
+					p2[((l+m)<<2)] = p1[(n+l)*ancho+m];
+					p2[((l+m)<<2)+1] = p1[(n+l)*ancho+m+1];
+					p2[((l+m)<<2)+2] = p1[(n+l)*ancho+m+2];
+					p2[((l+m)<<2)+3] = p1[(n+l)*ancho+m+3];
+				}
+			}
+			for(u16 l = 0 ; l < 4 ; l++)
+			{
+				for(u16 m = 0 ; m < ancho ; m++)
+					p1[(n+l)*ancho+m] = p2[(l)*ancho+m];
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u32 repeticiones = 50;
+	u32 alpha = 0xFF00FFFF;
+	vector<string> archivos;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-n" and i + 1 < argc)
+			repeticiones = atoi(argv[++i]);
+		else if(arg == "-a" and i + 1 < argc)
+			alpha = strtoul(argv[++i], NULL, 16);
+		else if(arg[0] == '-')
+			uso();
+		else
+			archivos.push_back(arg);
+	}
+
+	if(archivos.empty() or repeticiones == 0)
+		uso();
+
+	int resultado = 0;
+	for(vector<string>::iterator a = archivos.begin() ; a != archivos.end() ; ++a)
+	{
+		vector<u8> datos;
+		bmp::Info info;
+		if(not leerArchivo(*a, datos) or not bmp::leerCabecera(datos.empty() ? NULL : &datos[0], datos.size(), info))
+		{
+			cerr << "medirbmp - No se puede decodificar el archivo: " << *a << endl;
+			resultado = 1;
+			continue;
+		}
+
+		u32 pixeles = info.ancho * info.alto;
+		vector<u16> textura(pixeles);
+		double inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			bmp::decodificar(&datos[0], info, alpha, &textura[0]);
+		double nuevo = (ahora() - inicio) / repeticiones;
+
+		printf("%s: %ux%u, %u bits\n", a->c_str(), info.ancho, info.alto, info.bpp);
+		printf("  bmp::decodificar  %9.3f ms  %8.1f Mpx/s\n", nuevo * 1e3, pixeles / nuevo / 1e6);
+
+		// El método anterior sólo admitía 24 bits, de abajo a arriba, y texturas de hasta 2048 píxeles de ancho
+		if(info.bpp != 24 or not info.invertida or info.ancho > 2048)
+			continue;
+
+		vector<u16> anterior(pixeles);
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			referencia(&datos[info.inicio], info.ancho, info.alto, alpha, &anterior[0]);
+		double viejo = (ahora() - inicio) / repeticiones;
+
+		bool iguales = (anterior == textura);
+		printf("  método anterior   %9.3f ms  %8.1f Mpx/s  (x%.1f)  %s\n", viejo * 1e3, pixeles / viejo / 1e6,
+				viejo / nuevo, iguales ? "idénticas" : "DISTINTAS");
+		if(not iguales)
+			resultado = 1;
+	}
+	return resultado;
+}
@@ -0,0 +1,398 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * medirfijo: comprueba en el PC la precisión de las funciones de coma fija y de las tablas trigonométricas de la
+ * biblioteca (ver fijo.h y trigonometria.h) comparándolas con las funciones de la biblioteca estándar en doble
+ * precisión, y mide la velocidad de ambas. Las comprobaciones recorren todos los ángulos de una vuelta y una serie
+ * de valores pseudoaleatorios, siempre la misma, y el programa termina con error si alguna función se equivoca más
+ * de lo que indica su documentación. Las velocidades frente a la biblioteca estándar sólo sirven de orientación: el
+ * procesador del PC calcula la raíz cuadrada y divide enteros de 64 bits con una sola instrucción, y el de la
+ * consola no puede hacer ninguna de las dos cosas, así que allí sqrt() y el operador / de Fijo son mucho más lentos
+ * que en el PC. Por eso Fijo::raiz y Fijo::inverso tienen además un objetivo que sí se puede medir en el PC, y el
+ * programa también termina con error si no lo alcanzan: la raíz debe ser más rápida que la raíz calculada bit a bit,
+ * y el inverso seguido de cuatro productos, más rápido que cuatro divisiones entre el mismo número (aunque en el PC
+ * la división sea una sola instrucción).
+ *
+ * Uso: medirfijo [-n repeticiones]
+ *   -n  Número de llamadas a cada función en las medidas de velocidad (por defecto, 10000000)
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "fijo.h"
+#include "trigonometria.h"
+using namespace std;
+
+namespace
+{
+	const f64 PI2 = 6.283185307179586;
+
+	// Valores de prueba por cada comprobación
+	const u32 MUESTRAS = 1000000;
+
+	void uso(void)
+	{
+		cerr << "Uso: medirfijo [-n repeticiones]" << endl;
+		exit(1);
+	}
+
+	double ahora(void)
+	{
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return t.tv_sec + t.tv_nsec / 1e9;
+	}
+
+	// Generador congruencial, para que las pruebas sean iguales en todas las ejecuciones
+	u32 semilla = 12345;
+	u32 aleatorio(void)
+	{
+		semilla = semilla * 1664525u + 1013904223u;
+		return semilla;
+	}
+
+	// Diferencia entre dos ángulos, en unidades de ángulo y teniendo en cuenta la vuelta
+	f64 diferenciaAngulos(f64 a, f64 b)
+	{
+		f64 d = fmod(fabs(a - b), (f64)trigonometria::VUELTA);
+		return (d > trigonometria::VUELTA / 2) ? trigonometria::VUELTA - d : d;
+	}
+
+	// Ángulo en unidades de la biblioteca a partir de un vector, con el mismo criterio que trigonometria::angulo()
+	f64 anguloExacto(f64 x, f64 y)
+	{
+		f64 a = atan2(x, y) / PI2 * trigonometria::VUELTA;
+		return (a < 0) ? a + trigonometria::VUELTA : a;
+	}
+
+	bool informar(const char* nombre, f64 error, f64 limite, const char* unidad)
+	{
+		bool correcto = (error <= limite);
+		printf("  %-22s error máximo %10.4f %-8s (límite %8.4f)  %s\n", nombre, error, unidad, limite,
+				correcto ? "OK" : "FALLO");
+		return correcto;
+	}
+
+	void velocidad(const char* nombre, double segundos, u32 repeticiones, double referencia)
+	{
+		printf("  %-22s %8.2f ns/llamada", nombre, segundos / repeticiones * 1e9);
+		if(referencia > 0)
+			printf("  (x%.1f)", referencia / segundos);
+		printf("\n");
+	}
+
+	// Igual que velocidad(), pero la función debe ser más rápida que la referencia (su objetivo)
+	bool objetivo(const char* nombre, double segundos, u32 repeticiones, double referencia)
+	{
+		bool correcto = (segundos < referencia);
+		printf("  %-22s %8.2f ns/llamada  (x%.1f)  %s\n", nombre, segundos / repeticiones * 1e9, referencia / segundos,
+				correcto ? "OK" : "FALLO");
+		return correcto;
+	}
+
+	// Raíz cuadrada calculada bit a bit, dos bits del valor cada vez y sin saltos; es lo que haría falta en la consola
+	// sin Fijo::raiz, porque su procesador no tiene raíz cuadrada entera ni real
+	s32 raizBitABit(s32 v)
+	{
+		u32 raiz = 0, resto = 0, pendiente = (u32)v;
+		for(u32 i = 0 ; i < (32 + Fijo::BITS) / 2 ; ++i)
+		{
+			resto = (resto << 2) | (pendiente >> 30);
+			pendiente <<= 2;
+			raiz <<= 1;
+			u32 prueba = (raiz << 1) + 1;
+			u32 cabe = -(u32)(resto >= prueba);
+			resto -= prueba & cabe;
+			raiz += cabe & 1;
+		}
+		return (s32)raiz;
+	}
+
+	// Pruebas de velocidad con objetivo: cada una recorre los valores repeticiones veces y devuelve la suma de los
+	// resultados, para que el compilador no elimine las llamadas
+	typedef s64 (*Prueba)(const vector<s32>& valores, u32 repeticiones);
+
+	s64 pruebaRaiz(const vector<s32>& valores, u32 repeticiones)
+	{
+		s64 suma = 0;
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += Fijo::desdeBruto(valores[i & (valores.size() - 1)]).raiz().bruto();
+		return suma;
+	}
+
+	s64 pruebaRaizBitABit(const vector<s32>& valores, u32 repeticiones)
+	{
+		s64 suma = 0;
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += raizBitABit(valores[i & (valores.size() - 1)]);
+		return suma;
+	}
+
+	// El caso para el que existe el inverso: dividir varios valores (aquí, cuatro) entre el mismo número
+	s64 pruebaDivisiones(const vector<s32>& valores, u32 repeticiones)
+	{
+		s64 suma = 0;
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+		{
+			Fijo divisor = Fijo::desdeBruto(valores[i & (valores.size() - 1)]);
+			for(u32 j = 1 ; j <= 4 ; ++j)
+				suma += (Fijo::desdeBruto(valores[(i + j) & (valores.size() - 1)] >> 12) / divisor).bruto();
+		}
+		return suma;
+	}
+
+	s64 pruebaInverso(const vector<s32>& valores, u32 repeticiones)
+	{
+		s64 suma = 0;
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+		{
+			Fijo inverso = Fijo::desdeBruto(valores[i & (valores.size() - 1)]).inverso();
+			for(u32 j = 1 ; j <= 4 ; ++j)
+				suma += (Fijo::desdeBruto(valores[(i + j) & (valores.size() - 1)] >> 12) * inverso).bruto();
+		}
+		return suma;
+	}
+
+	// Menor tiempo de varias ejecuciones de una prueba, para que una pausa del sistema no dé un FALLO falso
+	double cronometrar(Prueba prueba, const vector<s32>& valores, u32 repeticiones, s64& suma)
+	{
+		double mejor = 0;
+		for(u32 vez = 0 ; vez < 3 ; ++vez)
+		{
+			double inicio = ahora();
+			suma += prueba(valores, repeticiones);
+			double segundos = ahora() - inicio;
+			if(vez == 0 or segundos < mejor)
+				mejor = segundos;
+		}
+		return mejor;
+	}
+
+	bool comprobarTrigonometria(void)
+	{
+		bool correcto = true;
+
+		// En los ángulos de la tabla, el seno sólo tiene el error del redondeo; entre ellos, se interpola
+		f64 error_tabla = 0, error_seno = 0;
+		for(u32 a = 0 ; a < trigonometria::VUELTA ; ++a)
+		{
+			f64 exacto = sin(PI2 * a / trigonometria::VUELTA) * trigonometria::UNIDAD;
+			if(a % (trigonometria::VUELTA / trigonometria::TAM_TABLA) == 0)
+				error_tabla = max(error_tabla, fabs(trigonometria::seno(a) - exacto));
+			error_seno = max(error_seno, fabs(trigonometria::seno(a) - exacto));
+			error_seno = max(error_seno, fabs(trigonometria::coseno(a)
+												- cos(PI2 * a / trigonometria::VUELTA) * trigonometria::UNIDAD));
+		}
+		correcto &= informar("seno (tabla)", error_tabla, 0.5, "unidades");
+		correcto &= informar("seno y coseno", error_seno, trigonometria::ERROR_SENO, "unidades");
+
+		// Dirección de vectores de todos los tamaños, también con componentes nulas o extremas
+		f64 error_angulo = 0;
+		for(u32 i = 0 ; i < MUESTRAS ; ++i)
+		{
+			s32 x = (s32)aleatorio() >> (aleatorio() % 31);
+			s32 y = (s32)aleatorio() >> (aleatorio() % 31);
+			if(i % 8 == 0)
+				x = 0;
+			if(x == 0 and y == 0)
+				continue;
+			error_angulo = max(error_angulo, diferenciaAngulos(trigonometria::angulo(x, y), anguloExacto(x, y)));
+		}
+		correcto &= informar("angulo", error_angulo, 1, "unidades");
+
+		// Rebote: reflexión del vector de dirección respecto a la superficie de normal dada
+		f64 error_rebote = 0;
+		for(u32 i = 0 ; i < MUESTRAS ; ++i)
+		{
+			u32 d = aleatorio() % trigonometria::VUELTA;
+			u32 n = aleatorio() % trigonometria::VUELTA;
+			f64 vx = sin(PI2 * d / trigonometria::VUELTA), vy = cos(PI2 * d / trigonometria::VUELTA);
+			f64 nx = sin(PI2 * n / trigonometria::VUELTA), ny = cos(PI2 * n / trigonometria::VUELTA);
+			f64 p = 2 * (vx * nx + vy * ny);
+			error_rebote = max(error_rebote, diferenciaAngulos(trigonometria::rebotar(d, n),
+																anguloExacto(vx - p * nx, vy - p * ny)));
+		}
+		correcto &= informar("rebotar", error_rebote, 1e-6, "unidades");
+
+		return correcto;
+	}
+
+	bool comprobarFijo(void)
+	{
+		bool correcto = true;
+
+		// Raíz cuadrada: exacta, redondeada hacia abajo
+		f64 error_raiz = 0;
+		for(u32 i = 0 ; i < MUESTRAS ; ++i)
+		{
+			s32 v = (s32)(aleatorio() >> 1) >> (aleatorio() % 31);
+			f64 exacto = sqrt((f64)v / Fijo::UNO) * Fijo::UNO;
+			error_raiz = max(error_raiz, fabs(Fijo::desdeBruto(v).raiz().bruto() - floor(exacto)));
+		}
+		correcto &= informar("Fijo::raiz", error_raiz, 0, "brutos");
+
+		// Inverso, sólo de los valores cuyo inverso cabe en un Fijo
+		f64 error_inverso = 0;
+		for(u32 i = 0 ; i < MUESTRAS ; ++i)
+		{
+			s32 v = (s32)aleatorio() >> (aleatorio() % 30);
+			f64 exacto = (f64)Fijo::UNO * Fijo::UNO / v;
+			if(fabs(exacto) >= 2147483647.0)
+				continue;
+			error_inverso = max(error_inverso, fabs(Fijo::desdeBruto(v).inverso().bruto() - exacto));
+		}
+		correcto &= informar("Fijo::inverso", error_inverso, 1, "brutos");
+
+		// Módulo y normalización de vectores
+		f64 error_modulo = 0, error_normal = 0;
+		for(u32 i = 0 ; i < MUESTRAS ; ++i)
+		{
+			VectorFijo v(Fijo::desdeBruto((s32)aleatorio() >> (1 + aleatorio() % 30)),
+						Fijo::desdeBruto((s32)aleatorio() >> (1 + aleatorio() % 30)));
+			f64 exacto = sqrt((f64)v.x.bruto() * v.x.bruto() + (f64)v.y.bruto() * v.y.bruto());
+			error_modulo = max(error_modulo, fabs(v.modulo().bruto() - floor(exacto)));
+			if(exacto >= Fijo::UNO)
+			{
+				VectorFijo n = v.normalizar();
+				error_normal = max(error_normal, fabs(n.x.bruto() - v.x.bruto() / exacto * Fijo::UNO));
+				error_normal = max(error_normal, fabs(n.y.bruto() - v.y.bruto() / exacto * Fijo::UNO));
+			}
+		}
+		correcto &= informar("VectorFijo::modulo", error_modulo, 0, "brutos");
+		correcto &= informar("VectorFijo::normalizar", error_normal, 2, "brutos");
+
+		// Reflexión contra las cuatro paredes de la pantalla: sólo cambia de signo una componente
+		bool paredes = true;
+		for(u32 i = 0 ; i < MUESTRAS / 100 ; ++i)
+		{
+			VectorFijo v(Fijo::desdeBruto((s32)aleatorio() >> 12), Fijo::desdeBruto((s32)aleatorio() >> 12));
+			paredes &= (v.reflejar(VectorFijo(Fijo::desdeEntero(1), Fijo())) == VectorFijo(-v.x, v.y));
+			paredes &= (v.reflejar(VectorFijo(Fijo::desdeEntero(-1), Fijo())) == VectorFijo(-v.x, v.y));
+			paredes &= (v.reflejar(VectorFijo(Fijo(), Fijo::desdeEntero(1))) == VectorFijo(v.x, -v.y));
+			paredes &= (v.reflejar(VectorFijo(Fijo(), Fijo::desdeEntero(-1))) == VectorFijo(v.x, -v.y));
+		}
+		correcto &= informar("VectorFijo::reflejar", paredes ? 0 : 1, 0, "errores");
+
+		return correcto;
+	}
+
+	bool medirVelocidad(u32 repeticiones)
+	{
+		vector<s32> valores(4096);
+		for(u32 i = 0 ; i < valores.size() ; ++i)
+			valores[i] = (s32)(aleatorio() >> 4) + 1;
+		u32 mascara = valores.size() - 1;
+
+		// Se acumulan los resultados para que el compilador no elimine las llamadas
+		volatile f64 sumidero = 0;
+		s64 suma = 0;
+		f64 suma_real = 0;
+		double inicio;
+
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += trigonometria::seno(valores[i & mascara]);
+		double t_seno = ahora() - inicio;
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma_real += sinf((f32)valores[i & mascara] * (f32)(PI2 / trigonometria::VUELTA));
+		double t_sin = ahora() - inicio;
+
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += trigonometria::angulo(valores[i & mascara], valores[(i + 1) & mascara] - (1 << 27));
+		double t_angulo = ahora() - inicio;
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma_real += atan2f((f32)valores[i & mascara], (f32)(valores[(i + 1) & mascara] - (1 << 27)));
+		double t_atan2 = ahora() - inicio;
+
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += Fijo::desdeBruto(valores[i & mascara]).raiz().bruto();
+		double t_raiz = ahora() - inicio;
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma_real += sqrt((f64)valores[i & mascara] / Fijo::UNO);
+		double t_sqrt = ahora() - inicio;
+
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += Fijo::desdeBruto(valores[i & mascara]).inverso().bruto();
+		double t_inverso = ahora() - inicio;
+		inicio = ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			suma += (Fijo::desdeEntero(1) / Fijo::desdeBruto(valores[i & mascara])).bruto();
+		double t_division = ahora() - inicio;
+
+		double t_bits = cronometrar(pruebaRaizBitABit, valores, repeticiones, suma);
+		double t_raiz_objetivo = cronometrar(pruebaRaiz, valores, repeticiones, suma);
+		double t_divisiones = cronometrar(pruebaDivisiones, valores, repeticiones, suma);
+		double t_inverso_objetivo = cronometrar(pruebaInverso, valores, repeticiones, suma);
+
+		sumidero = suma + suma_real;
+		(void)sumidero;
+
+		printf("Velocidad (%u llamadas)\n", repeticiones);
+		velocidad("sinf", t_sin, repeticiones, 0);
+		velocidad("trigonometria::seno", t_seno, repeticiones, t_sin);
+		velocidad("atan2f", t_atan2, repeticiones, 0);
+		velocidad("trigonometria::angulo", t_angulo, repeticiones, t_atan2);
+		velocidad("sqrt", t_sqrt, repeticiones, 0);
+		velocidad("Fijo::raiz", t_raiz, repeticiones, t_sqrt);
+		velocidad("Fijo::operator/", t_division, repeticiones, 0);
+		velocidad("Fijo::inverso", t_inverso, repeticiones, t_division);
+
+		printf("Objetivos (%u llamadas)\n", repeticiones);
+		velocidad("raíz bit a bit", t_bits, repeticiones, 0);
+		bool correcto = objetivo("Fijo::raiz", t_raiz_objetivo, repeticiones, t_bits);
+		velocidad("4 divisiones", t_divisiones, repeticiones, 0);
+		correcto &= objetivo("inverso y 4 productos", t_inverso_objetivo, repeticiones, t_divisiones);
+		return correcto;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u32 repeticiones = 10000000;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-n" and i + 1 < argc)
+			repeticiones = atoi(argv[++i]);
+		else
+			uso();
+	}
+
+	if(repeticiones == 0)
+		uso();
+
+	printf("Precisión\n");
+	bool correcto = comprobarTrigonometria();
+	correcto &= comprobarFijo();
+
+	correcto &= medirVelocidad(repeticiones);
+	return correcto ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * paletizar: reduce los colores de una imagen BMP o PNG y la guarda como un mapa de bits de 8 bits con paleta. La
+ * clase Imagen convierte al cargarlas, sin pérdida, las imágenes de hasta 256 colores en texturas indexadas (CI4 o
+ * CI8, ver textura.h), que ocupan la mitad o la cuarta parte que una textura RGB5A3; esta herramienta prepara para
+ * ello las imágenes que tienen más colores. La imagen se decodifica con el mismo código que utiliza la consola, así
+ * que los colores se cuantizan directamente en el espacio de 15 bits de RGB5A3, con el algoritmo de corte por la
+ * mediana (median cut). Los píxeles transparentes (alpha menor que 128) se escriben con el color transparente, que
+ * ocupa una entrada propia de la paleta; el resto de píxeles se consideran opacos.
+ *
+ * Uso: paletizar [-c colores] [-a color] entrada.(bmp|png) salida.bmp
+ *   -c  Número máximo de colores de la paleta, entre 2 y 256 (por defecto, 256; con 16 o menos, la textura es CI4)
+ *   -a  Color transparente en hexadecimal, con la forma RRGGBBAA (por defecto, FF00FFFF)
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bmp.h"
+#include "pngdec.h"
+using namespace std;
+
+namespace
+{
+	// Número de colores distintos en el espacio de 15 bits
+	const u32 NUM_COLORES = 32768;
+
+	// Conjunto de colores del histograma que se reparte en cada paso del corte por la mediana
+	struct Caja
+	{
+		u32 inicio, fin;
+		u8 minimo[3], maximo[3];
+	};
+
+	void uso(void)
+	{
+		cerr << "Uso: paletizar [-c colores] [-a color] entrada.(bmp|png) salida.bmp" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	void escribir16(vector<u8>& v, u16 x)
+	{
+		v.push_back((u8)x);
+		v.push_back((u8)(x >> 8));
+	}
+
+	void escribir32(vector<u8>& v, u32 x)
+	{
+		escribir16(v, (u16)x);
+		escribir16(v, (u16)(x >> 16));
+	}
+
+	u8 componente(u16 c, u32 i)
+	{
+		return (c >> (10 - 5 * i)) & 0x1F;
+	}
+
+	u8 expandir(u8 c5)
+	{
+		return (c5 << 3) | (c5 >> 2);
+	}
+
+	// Color de 15 bits de un texel RGB5A3, o -1 si el texel es transparente
+	s32 color15(u16 t)
+	{
+		if(t & 0x8000)
+			return t & 0x7FFF;
+		if(((t >> 12) & 7) < 4)
+			return -1;
+		u32 r = ((t >> 8) & 0xF) * 17, g = ((t >> 4) & 0xF) * 17, b = (t & 0xF) * 17;
+		return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+	}
+
+	void ajustar(Caja& c, const vector<u16>& colores)
+	{
+		for(u32 k = 0 ; k < 3 ; ++k)
+		{
+			c.minimo[k] = 31;
+			c.maximo[k] = 0;
+		}
+		for(u32 i = c.inicio ; i < c.fin ; ++i)
+			for(u32 k = 0 ; k < 3 ; ++k)
+			{
+				c.minimo[k] = min(c.minimo[k], componente(colores[i], k));
+				c.maximo[k] = max(c.maximo[k], componente(colores[i], k));
+			}
+	}
+
+	struct PorComponente
+	{
+		u32 k;
+		bool operator()(u16 a, u16 b) const { return componente(a, k) < componente(b, k); }
+	};
+
+	// Reparte los colores del histograma en, como mucho, num cajas, y devuelve el color medio de cada una
+	vector<u32> cortarPorMediana(const vector<u32>& histograma, u32 num, vector<u8>& indice)
+	{
+		vector<u16> colores;
+		for(u32 c = 0 ; c < NUM_COLORES ; ++c)
+			if(histograma[c] > 0)
+				colores.push_back(c);
+
+		vector<Caja> cajas(1);
+		cajas[0].inicio = 0;
+		cajas[0].fin = colores.size();
+		ajustar(cajas[0], colores);
+
+		while(cajas.size() < num)
+		{
+			// Se divide la caja con más píxeles de entre las que tienen más de un color
+			s32 elegida = -1;
+			u64 pixeles_elegida = 0;
+			for(u32 i = 0 ; i < cajas.size() ; ++i)
+			{
+				if(cajas[i].fin - cajas[i].inicio < 2)
+					continue;
+				u64 pixeles = 0;
+				for(u32 j = cajas[i].inicio ; j < cajas[i].fin ; ++j)
+					pixeles += histograma[colores[j]];
+				if(elegida < 0 or pixeles > pixeles_elegida)
+				{
+					elegida = i;
+					pixeles_elegida = pixeles;
+				}
+			}
+			if(elegida < 0)
+				break;
+
+			// Ordenar por la componente de mayor rango y cortar donde quede la mitad de los píxeles
+			Caja& c = cajas[elegida];
+			PorComponente orden;
+			orden.k = 0;
+			for(u32 k = 1 ; k < 3 ; ++k)
+				if(c.maximo[k] - c.minimo[k] > c.maximo[orden.k] - c.minimo[orden.k])
+					orden.k = k;
+			sort(colores.begin() + c.inicio, colores.begin() + c.fin, orden);
+
+			u64 acumulados = 0;
+			u32 corte = c.inicio + 1;
+			for( ; corte < c.fin - 1 ; ++corte)
+			{
+				acumulados += histograma[colores[corte - 1]];
+				if(acumulados * 2 >= pixeles_elegida)
+					break;
+			}
+
+			Caja nueva;
+			nueva.inicio = corte;
+			nueva.fin = c.fin;
+			c.fin = corte;
+			ajustar(c, colores);
+			ajustar(nueva, colores);
+			cajas.push_back(nueva);
+		}
+
+		// Color medio de cada caja, ponderado por el número de píxeles de cada color
+		vector<u32> paleta;
+		for(u32 i = 0 ; i < cajas.size() ; ++i)
+		{
+			u64 suma[3] = { 0, 0, 0 };
+			u64 pixeles = 0;
+			for(u32 j = cajas[i].inicio ; j < cajas[i].fin ; ++j)
+			{
+				u32 n = histograma[colores[j]];
+				for(u32 k = 0 ; k < 3 ; ++k)
+					suma[k] += (u64)expandir(componente(colores[j], k)) * n;
+				pixeles += n;
+				indice[colores[j]] = i;
+			}
+			u32 color = 0;
+			for(u32 k = 0 ; k < 3 ; ++k)
+				color = (color << 8) | (u32)((suma[k] + pixeles / 2) / pixeles);
+			paleta.push_back(color);
+		}
+		return paleta;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u32 maximo = 256;
+	u32 alpha = 0xFF00FFFF;
+	string entrada, salida;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-c" and i + 1 < argc)
+			maximo = atoi(argv[++i]);
+		else if(arg == "-a" and i + 1 < argc)
+			alpha = strtoul(argv[++i], NULL, 16);
+		else if(arg[0] == '-')
+			uso();
+		else if(entrada.empty())
+			entrada = arg;
+		else if(salida.empty())
+			salida = arg;
+		else
+			uso();
+	}
+
+	if(salida.empty() or maximo < 2 or maximo > 256)
+		uso();
+
+	// Decodificar la imagen en una textura RGB5A3, con el mismo código que la consola
+	vector<u8> datos;
+	if(not leerArchivo(entrada, datos) or datos.empty())
+	{
+		cerr << "paletizar - Error al leer el archivo: " << entrada << endl;
+		return 1;
+	}
+
+	u16 ancho = 0, alto = 0;
+	vector<u16> textura;
+	bmp::Info info_bmp;
+	png::Info info_png;
+	if(bmp::leerCabecera(&datos[0], datos.size(), info_bmp))
+	{
+		ancho = info_bmp.ancho;
+		alto = info_bmp.alto;
+		textura.resize(bmp::tamTextura(info_bmp) / sizeof(u16));
+		bmp::decodificar(&datos[0], info_bmp, alpha, &textura[0]);
+	}
+	else if(png::esPng(&datos[0], datos.size()) and png::leerCabecera(&datos[0], datos.size(), info_png))
+	{
+		ancho = info_png.ancho;
+		alto = info_png.alto;
+		textura.resize(png::tamTextura(info_png) / sizeof(u16));
+		if(not png::decodificar(&datos[0], info_png, alpha, &textura[0]))
+			textura.clear();
+	}
+	if(textura.empty())
+	{
+		cerr << "paletizar - Formato de imagen no soportado: " << entrada << endl;
+		return 1;
+	}
+
+	// Deshacer los tiles de 4x4 y construir el histograma de colores de 15 bits
+	vector<s32> pixeles(ancho * alto);
+	vector<u32> histograma(NUM_COLORES, 0);
+	bool transparencia = false;
+	for(u32 y = 0 ; y < alto ; ++y)
+	{
+		for(u32 x = 0 ; x < ancho ; ++x)
+		{
+			s32 c = color15(textura[(y >> 2) * ancho * 4 + (x >> 2) * 16 + (y & 3) * 4 + (x & 3)]);
+			pixeles[y * ancho + x] = c;
+			if(c < 0)
+				transparencia = true;
+			else
+				++histograma[c];
+		}
+	}
+
+	u32 originales = 0;
+	for(u32 c = 0 ; c < NUM_COLORES ; ++c)
+		if(histograma[c] > 0)
+			++originales;
+
+	// El color transparente ocupa la primera entrada de la paleta
+	vector<u8> indice(NUM_COLORES, 0);
+	vector<u32> paleta;
+	if(transparencia)
+		paleta.push_back(alpha >> 8);
+	u32 base = paleta.size();
+	if(originales > 0)
+	{
+		vector<u32> colores = cortarPorMediana(histograma, maximo - base, indice);
+		paleta.insert(paleta.end(), colores.begin(), colores.end());
+	}
+
+	// Escribir el mapa de bits de 8 bits, con las filas de abajo a arriba y alineadas a 4 bytes
+	u32 paso = (ancho + 3) & ~3;
+	u32 inicio = 14 + 40 + 256 * 4;
+	vector<u8> bmp;
+	bmp.push_back('B');
+	bmp.push_back('M');
+	escribir32(bmp, inicio + paso * alto);
+	escribir32(bmp, 0);
+	escribir32(bmp, inicio);
+	escribir32(bmp, 40);
+	escribir32(bmp, ancho);
+	escribir32(bmp, alto);
+	escribir16(bmp, 1);
+	escribir16(bmp, 8);
+	escribir32(bmp, 0);
+	escribir32(bmp, paso * alto);
+	escribir32(bmp, 2835);
+	escribir32(bmp, 2835);
+	escribir32(bmp, paleta.size());
+	escribir32(bmp, 0);
+	for(u32 i = 0 ; i < 256 ; ++i)
+	{
+		u32 c = (i < paleta.size()) ? paleta[i] : 0;
+		bmp.push_back((u8)c);
+		bmp.push_back((u8)(c >> 8));
+		bmp.push_back((u8)(c >> 16));
+		bmp.push_back(0);
+	}
+	for(s32 y = alto - 1 ; y >= 0 ; --y)
+	{
+		for(u32 x = 0 ; x < paso ; ++x)
+		{
+			s32 c = (x < ancho) ? pixeles[y * ancho + x] : -1;
+			bmp.push_back((c < 0) ? 0 : base + indice[c]);
+		}
+	}
+
+	ofstream destino(salida.c_str(), ios::binary);
+	destino.write((const char*)&bmp[0], bmp.size());
+	if(not destino.good())
+	{
+		cerr << "paletizar - Error al escribir el archivo: " << salida << endl;
+		return 1;
+	}
+
+	printf("%s -> %s: %ux%u, %u colores -> %lu%s\n", entrada.c_str(), salida.c_str(), ancho, alto, originales,
+			(unsigned long)paleta.size(), transparencia ? " (con el color transparente)" : "");
+	return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * pcm2adpcm: convierte un efecto de sonido en PCM crudo (16 bits con signo, big endian, el formato que espera la
+ * clase Sonido) en un archivo IMA ADPCM de 4 bits por muestra, que la clase Sonido reproduce decodificándolo por
+ * bloques. Al terminar, decodifica el resultado con el mismo código que la consola e informa de la relación de
+ * compresión y de la relación señal/ruido obtenida.
+ *
+ * Uso: pcm2adpcm [-m] [-f frecuencia] [-b muestras] entrada.pcm [salida.adpcm]
+ *   -m  La entrada es mono (por defecto, estéreo)
+ *   -f  Frecuencia de muestreo de la entrada en Hz (por defecto, 48000)
+ *   -b  Muestras por canal de cada bloque, número par entre 2 y 1024 (por defecto, 1024)
+ * Si no se indica la salida, se utiliza el nombre de la entrada con la extensión .adpcm.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "adpcm.h"
+using namespace std;
+
+namespace
+{
+	void uso(void)
+	{
+		cerr << "Uso: pcm2adpcm [-m] [-f frecuencia] [-b muestras] entrada.pcm [salida.adpcm]" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u8 canales = 2;
+	u32 frecuencia = 48000;
+	u32 muestras_bloque = adpcm::MAX_MUESTRAS_BLOQUE;
+	string entrada, salida;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-m")
+			canales = 1;
+		else if(arg == "-f" and i + 1 < argc)
+			frecuencia = atoi(argv[++i]);
+		else if(arg == "-b" and i + 1 < argc)
+			muestras_bloque = atoi(argv[++i]);
+		else if(arg[0] == '-')
+			uso();
+		else if(entrada.empty())
+			entrada = arg;
+		else if(salida.empty())
+			salida = arg;
+		else
+			uso();
+	}
+
+	if(entrada.empty() or frecuencia == 0 or muestras_bloque < 2 or muestras_bloque % 2 != 0
+		or muestras_bloque > adpcm::MAX_MUESTRAS_BLOQUE)
+		uso();
+
+	if(salida.empty())
+		salida = entrada.substr(0, entrada.rfind('.')) + ".adpcm";
+
+	vector<u8> pcm;
+	if(not leerArchivo(entrada, pcm))
+	{
+		cerr << "pcm2adpcm - Error al leer el archivo: " << entrada << endl;
+		return 1;
+	}
+
+	// Convertir las muestras big endian al orden de la máquina, rellenando con silencio el último bloque
+	adpcm::Cabecera c;
+	c.version = 1;
+	c.canales = canales;
+	c.muestras_bloque = muestras_bloque;
+	c.frecuencia = frecuencia;
+	c.muestras = pcm.size() / (2 * canales);
+	c.bloques = (c.muestras + muestras_bloque - 1) / muestras_bloque;
+
+	vector<s16> muestras(c.bloques * muestras_bloque * canales, 0);
+	for(u32 i = 0 ; i < c.muestras * canales ; ++i)
+		muestras[i] = (s16)((pcm[2 * i] << 8) | pcm[2 * i + 1]);
+
+	// Codificar todos los bloques, arrastrando el estado del codificador de un bloque al siguiente
+	u32 tam_bloque = adpcm::tamBloque(canales, muestras_bloque);
+	vector<u8> archivo(adpcm::TAM_CABECERA + c.bloques * tam_bloque);
+	adpcm::escribirCabecera(c, &archivo[0]);
+
+	adpcm::Estado estados[2] = { { 0, 0 }, { 0, 0 } };
+	for(u32 b = 0 ; b < c.bloques ; ++b)
+		adpcm::codificarBloque(&muestras[b * muestras_bloque * canales], canales, muestras_bloque, estados,
+								&archivo[adpcm::TAM_CABECERA + b * tam_bloque]);
+
+	ofstream destino(salida.c_str(), ios::binary);
+	destino.write((const char*)&archivo[0], archivo.size());
+	if(not destino.good())
+	{
+		cerr << "pcm2adpcm - Error al escribir el archivo: " << salida << endl;
+		return 1;
+	}
+	destino.close();
+
+	// Comprobar el resultado con el mismo decodificador que utiliza la consola
+	adpcm::Cabecera comprobacion;
+	if(not adpcm::leerCabecera(&archivo[0], archivo.size(), comprobacion))
+	{
+		cerr << "pcm2adpcm - La cabecera generada no es válida" << endl;
+		return 1;
+	}
+
+	vector<s16> decodificado(muestras_bloque * canales);
+	f64 senal = 0, ruido = 0;
+	for(u32 b = 0 ; b < c.bloques ; ++b)
+	{
+		adpcm::decodificarBloque(&archivo[adpcm::TAM_CABECERA + b * tam_bloque], canales, muestras_bloque,
+									&decodificado[0]);
+		for(u32 i = 0 ; i < muestras_bloque * canales ; ++i)
+		{
+			f64 original = muestras[b * muestras_bloque * canales + i];
+			senal += original * original;
+			ruido += (original - decodificado[i]) * (original - decodificado[i]);
+		}
+	}
+
+	printf("%s -> %s: %u muestras, %u bloques, %lu -> %lu bytes (%.1f%%), SNR %.1f dB\n", entrada.c_str(),
+			salida.c_str(), c.muestras, c.bloques, (unsigned long)pcm.size(), (unsigned long)archivo.size(),
+			pcm.empty() ? 0.0 : 100.0 * archivo.size() / pcm.size(),
+			ruido > 0 ? 10.0 * log10(senal / ruido) : 0.0);
+	return 0;
+}
+
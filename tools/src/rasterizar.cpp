@@ -0,0 +1,384 @@
+/**
+ * Licencia GPLv3
+ *
+ * Este archivo es parte de libWiiEsp. Copyright (C) 2011 Ezequiel Vázquez de la Calle
+ *
+ * libWiiEsp es software libre: usted puede redistribuirlo y/o modificarlo bajo los términos de la
+ * Licencia Pública General GNU publicada por la Fundación para el Software Libre, ya sea la versión 3
+ * de la Licencia, o (a su elección) cualquier versión posterior.
+ *
+ * libWiiEsp se distribuye con la esperanza de que sea útil, pero SIN GARANTÍA ALGUNA; ni siquiera
+ * la garantía implícita MERCANTIL o de APTITUD PARA UN PROPÓSITO DETERMINADO. Consulte los detalles de
+ * la Licencia Pública General GNU para obtener una información más detallada.
+ *
+ * Debería haber recibido una copia de la Licencia Pública General GNU junto a libWiiEsp. En caso
+ * contrario, consulte <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * rasterizar: dibuja en el PC una escena descrita en un archivo de texto con la clase Rasterizador, que reproduce
+ * las primitivas y la configuración de la GX de la clase Screen, y guarda el resultado como un mapa de bits de 24
+ * bits. Si se indica una imagen de referencia (normalmente, una generada antes por la propia herramienta), compara
+ * con ella el resultado píxel a píxel y termina con error si alguno difiere más de la tolerancia; así, una escena y
+ * su imagen de referencia sirven para comprobar que un cambio en la forma de dibujar no cambia lo que se ve. Con
+ * la opción -b, además, dibuja la escena repetidas veces y mide el tiempo por frame y los fragmentos por segundo.
+ * Siempre muestra los contadores de trabajo del frame (ver clase Contadores), los mismos que contaría Screen.
+ *
+ * Cada línea del archivo de escena es una orden; las líneas vacías y las que comienzan por # se ignoran. Las
+ * coordenadas y los parámetros son los de los métodos de Screen, y los colores se escriben en hexadecimal, con la
+ * forma RRGGBBAA. Las rutas de las imágenes son relativas al directorio del archivo de escena.
+ *
+ *   imagen codigo ruta                        Carga una imagen BMP o PNG como textura RGB5A3
+ *   fondo color                               Color con el que se limpia la pantalla (por defecto, 000000FF)
+ *   textura codigo x y z [ancho alto]         Screen::dibujarTextura(), con las medidas de la imagen por defecto
+ *   cuadro codigo x y z cx cy ancho alto [i]  Screen::dibujarCuadro(); con i, invertido
+ *   punto x y z color                         Screen::dibujarPunto()
+ *   linea x1 y1 x2 y2 z ancho color           Screen::dibujarLinea()
+ *   rectangulo x1 y1 x2 y2 x3 y3 x4 y4 z color  Screen::dibujarRectangulo()
+ *   circulo x y z diametro color              Screen::dibujarCirculo()
+ *
+ * Uso: rasterizar [-a color] [-p ancho alto] [-c referencia.bmp] [-t tolerancia] [-b repeticiones] escena.txt
+ *      [salida.bmp]
+ *   -a  Color transparente de las imágenes en hexadecimal, con la forma RRGGBBAA (por defecto, FF00FFFF)
+ *   -p  Medidas de la pantalla (por defecto, 640x480)
+ *   -c  Imagen de referencia con la que se compara el resultado
+ *   -t  Diferencia máxima admitida en cada componente al comparar (por defecto, 0)
+ *   -b  Número de veces que se dibuja la escena para medir su velocidad
+ * Si no se indica la salida, no se guarda el resultado.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bmp.h"
+#include "pngdec.h"
+#include "rasterizador.h"
+#include "ritmo.h"
+using namespace std;
+
+namespace
+{
+	u32 alpha = 0xFF00FFFF;
+
+	struct Imagen
+	{
+		vector<u16> texels;
+		Rasterizador::Textura textura;
+	};
+
+	void uso(void)
+	{
+		cerr << "Uso: rasterizar [-a color] [-p ancho alto] [-c referencia.bmp] [-t tolerancia] [-b repeticiones]"
+			<< " escena.txt [salida.bmp]" << endl;
+		exit(1);
+	}
+
+	bool leerArchivo(const string& ruta, vector<u8>& datos)
+	{
+		ifstream archivo(ruta.c_str(), ios::binary);
+		if(not archivo.good())
+			return false;
+		archivo.seekg(0, ios::end);
+		datos.resize((size_t)archivo.tellg());
+		archivo.seekg(0, ios::beg);
+		if(not datos.empty())
+			archivo.read((char*)&datos[0], datos.size());
+		return archivo.good();
+	}
+
+	string directorio(const string& ruta)
+	{
+		string::size_type barra = ruta.rfind('/');
+		return (barra == string::npos) ? string() : ruta.substr(0, barra + 1);
+	}
+
+	u32 hex(const string& texto)
+	{
+		return (u32)strtoul(texto.c_str(), NULL, 16);
+	}
+
+	// Decodifica una imagen con el mismo código que la consola; la textura queda en bloques de 4x4, como en Imagen
+	bool cargarImagen(const string& ruta, Imagen& imagen)
+	{
+		vector<u8> datos;
+		if(not leerArchivo(ruta, datos) or datos.empty())
+			return false;
+
+		bmp::Info info_bmp;
+		png::Info info_png;
+		u16 ancho = 0, alto = 0;
+		if(bmp::leerCabecera(&datos[0], datos.size(), info_bmp))
+		{
+			ancho = info_bmp.ancho;
+			alto = info_bmp.alto;
+			imagen.texels.resize(bmp::tamTextura(info_bmp) / sizeof(u16));
+			bmp::decodificar(&datos[0], info_bmp, alpha, &imagen.texels[0]);
+		}
+		else if(png::esPng(&datos[0], datos.size()) and png::leerCabecera(&datos[0], datos.size(), info_png))
+		{
+			ancho = info_png.ancho;
+			alto = info_png.alto;
+			imagen.texels.resize(png::tamTextura(info_png) / sizeof(u16));
+			if(not png::decodificar(&datos[0], info_png, alpha, &imagen.texels[0]))
+				imagen.texels.clear();
+		}
+		if(imagen.texels.empty())
+			return false;
+
+		Rasterizador::Textura t = { &imagen.texels[0], ancho, alto, textura::RGB5A3, NULL };
+		imagen.textura = t;
+		return true;
+	}
+
+	// Ejecuta las órdenes de dibujo de la escena; las de carga ya se han ejecutado al leerla
+	bool dibujar(Rasterizador& r, const vector<vector<string> >& ordenes, const map<string, Imagen>& imagenes,
+					u32 fondo, string& error)
+	{
+		r.limpiar(fondo);
+		for(vector<vector<string> >::const_iterator i = ordenes.begin() ; i != ordenes.end() ; ++i)
+		{
+			const vector<string>& o = *i;
+			vector<s32> n;
+			for(u32 j = 1 ; j < o.size() ; ++j)
+				n.push_back(atoi(o[j].c_str()));
+
+			if((o[0] == "textura" and (o.size() == 5 or o.size() == 7))
+				or (o[0] == "cuadro" and (o.size() == 9 or o.size() == 10)))
+			{
+				map<string, Imagen>::const_iterator img = imagenes.find(o[1]);
+				if(img == imagenes.end())
+				{
+					error = "imagen desconocida: " + o[1];
+					return false;
+				}
+				const Rasterizador::Textura& t = img->second.textura;
+				bool medidas = (o.size() == 7);
+				if(o[0] == "textura")
+					r.dibujarTextura(t, n[1], n[2], n[3], medidas ? n[4] : t.ancho, medidas ? n[5] : t.alto);
+				else
+					r.dibujarCuadro(t, n[1], n[2], n[3], n[4], n[5], n[6], n[7], o.size() == 10 and o[9] == "i");
+			}
+			else if(o[0] == "punto" and o.size() == 5)
+				r.dibujarPunto(n[0], n[1], n[2], hex(o[4]));
+			else if(o[0] == "linea" and o.size() == 8)
+				r.dibujarLinea(n[0], n[1], n[2], n[3], n[4], n[5], hex(o[7]));
+			else if(o[0] == "rectangulo" and o.size() == 11)
+				r.dibujarRectangulo(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8], hex(o[10]));
+			else if(o[0] == "circulo" and o.size() == 6)
+				r.dibujarCirculo(n[0], n[1], n[2], (f32)atof(o[4].c_str()), hex(o[5]));
+			else
+			{
+				error = "orden incorrecta: " + o[0];
+				return false;
+			}
+		}
+		r.cerrarFrame();
+		return true;
+	}
+
+	void escribir32(vector<u8>& v, u32 posicion, u32 x)
+	{
+		for(u32 i = 0 ; i < 4 ; ++i)
+			v[posicion + i] = (u8)(x >> (i * 8));
+	}
+
+	u32 leer32(const vector<u8>& v, u32 posicion)
+	{
+		return (u32)v[posicion] | ((u32)v[posicion + 1] << 8) | ((u32)v[posicion + 2] << 16)
+			| ((u32)v[posicion + 3] << 24);
+	}
+
+	// Mapa de bits de 24 bits, de abajo a arriba, con las filas rellenas hasta un múltiplo de 4 bytes
+	bool guardarBmp(const string& ruta, const Rasterizador& r)
+	{
+		u32 paso = (r.ancho() * 3 + 3) & ~3;
+		vector<u8> bmp(54 + paso * r.alto(), 0);
+		bmp[0] = 'B';
+		bmp[1] = 'M';
+		escribir32(bmp, 2, bmp.size());
+		escribir32(bmp, 10, 54);
+		escribir32(bmp, 14, 40);
+		escribir32(bmp, 18, r.ancho());
+		escribir32(bmp, 22, r.alto());
+		bmp[26] = 1;
+		bmp[28] = 24;
+		escribir32(bmp, 34, paso * r.alto());
+
+		for(u32 y = 0 ; y < r.alto() ; ++y)
+		{
+			u8* fila = &bmp[54 + (r.alto() - 1 - y) * paso];
+			for(u32 x = 0 ; x < r.ancho() ; ++x)
+			{
+				u32 c = r.pixel(x, y);
+				fila[x * 3] = (u8)(c >> 8);
+				fila[x * 3 + 1] = (u8)(c >> 16);
+				fila[x * 3 + 2] = (u8)(c >> 24);
+			}
+		}
+
+		ofstream archivo(ruta.c_str(), ios::binary);
+		archivo.write((const char*)&bmp[0], bmp.size());
+		return archivo.good();
+	}
+
+	// Compara el resultado con un mapa de bits de 24 bits de las mismas medidas; devuelve los píxeles distintos
+	bool comparar(const string& ruta, const Rasterizador& r, u32 tolerancia, u32& distintos, string& error)
+	{
+		vector<u8> bmp;
+		if(not leerArchivo(ruta, bmp) or bmp.size() < 54 or bmp[0] != 'B' or bmp[1] != 'M' or bmp[28] != 24)
+		{
+			error = "la referencia no es un mapa de bits de 24 bits";
+			return false;
+		}
+		u32 inicio = leer32(bmp, 10);
+		s32 alto = (s32)leer32(bmp, 22);
+		u32 paso = (r.ancho() * 3 + 3) & ~3;
+		if(leer32(bmp, 18) != r.ancho() or (u32)(alto < 0 ? -alto : alto) != r.alto()
+			or inicio + paso * r.alto() > bmp.size())
+		{
+			error = "la referencia no tiene las medidas de la pantalla";
+			return false;
+		}
+
+		distintos = 0;
+		for(u32 y = 0 ; y < r.alto() ; ++y)
+		{
+			const u8* fila = &bmp[inicio + (alto > 0 ? r.alto() - 1 - y : y) * paso];
+			for(u32 x = 0 ; x < r.ancho() ; ++x)
+			{
+				u32 c = r.pixel(x, y);
+				u8 componentes[3] = { (u8)(c >> 8), (u8)(c >> 16), (u8)(c >> 24) };
+				for(u32 i = 0 ; i < 3 ; ++i)
+					if((u32)abs((s32)componentes[i] - (s32)fila[x * 3 + i]) > tolerancia)
+					{
+						++distintos;
+						break;
+					}
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	u16 ancho = 640, alto = 480;
+	u32 tolerancia = 0, repeticiones = 0;
+	string escena, salida, referencia;
+
+	for(int i = 1 ; i < argc ; ++i)
+	{
+		string arg = argv[i];
+		if(arg == "-a" and i + 1 < argc)
+			alpha = hex(argv[++i]);
+		else if(arg == "-p" and i + 2 < argc)
+		{
+			ancho = atoi(argv[++i]);
+			alto = atoi(argv[++i]);
+		}
+		else if(arg == "-c" and i + 1 < argc)
+			referencia = argv[++i];
+		else if(arg == "-t" and i + 1 < argc)
+			tolerancia = atoi(argv[++i]);
+		else if(arg == "-b" and i + 1 < argc)
+			repeticiones = atoi(argv[++i]);
+		else if(arg[0] == '-')
+			uso();
+		else if(escena.empty())
+			escena = arg;
+		else if(salida.empty())
+			salida = arg;
+		else
+			uso();
+	}
+
+	if(escena.empty() or ancho == 0 or alto == 0)
+		uso();
+
+	// Leer la escena: las imágenes se cargan al leerla, y el resto de órdenes se guardan para dibujarlas
+	ifstream archivo(escena.c_str());
+	if(not archivo.good())
+	{
+		cerr << "rasterizar - Error al leer el archivo: " << escena << endl;
+		return 1;
+	}
+
+	map<string, Imagen> imagenes;
+	vector<vector<string> > ordenes;
+	u32 fondo = 0x000000FF;
+	string linea;
+	for(u32 numero = 1 ; getline(archivo, linea) ; ++numero)
+	{
+		istringstream campos(linea);
+		vector<string> o;
+		for(string campo ; campos >> campo ; )
+			o.push_back(campo);
+		if(o.empty() or o[0][0] == '#')
+			continue;
+
+		if(o[0] == "imagen" and o.size() == 3)
+		{
+			if(not cargarImagen(directorio(escena) + o[2], imagenes[o[1]]))
+			{
+				cerr << "rasterizar - Error al cargar la imagen: " << o[2] << endl;
+				return 1;
+			}
+		}
+		else if(o[0] == "fondo" and o.size() == 2)
+			fondo = hex(o[1]);
+		else
+			ordenes.push_back(o);
+	}
+
+	Rasterizador r(ancho, alto);
+	string error;
+	if(not dibujar(r, ordenes, imagenes, fondo, error))
+	{
+		cerr << "rasterizar - " << escena << ": " << error << endl;
+		return 1;
+	}
+	cout << r.contadores().informe() << endl;
+
+	// Medir la velocidad, dibujando la escena completa repetidas veces
+	if(repeticiones > 0)
+	{
+		u64 fragmentos = r.fragmentos();
+		u64 inicio = Ritmo::ahora();
+		for(u32 i = 0 ; i < repeticiones ; ++i)
+			dibujar(r, ordenes, imagenes, fondo, error);
+		f64 segundos = (Ritmo::ahora() - inicio) / 1e9;
+		fragmentos = r.fragmentos() - fragmentos;
+		printf("%u frames: %.3f ms por frame, %.1f millones de fragmentos por segundo\n", repeticiones,
+				segundos * 1000.0 / repeticiones, segundos > 0 ? fragmentos / segundos / 1e6 : 0.0);
+	}
+
+	if(not salida.empty() and not guardarBmp(salida, r))
+	{
+		cerr << "rasterizar - Error al escribir el archivo: " << salida << endl;
+		return 1;
+	}
+
+	if(not referencia.empty())
+	{
+		u32 distintos = 0;
+		if(not comparar(referencia, r, tolerancia, distintos, error))
+		{
+			cerr << "rasterizar - " << referencia << ": " << error << endl;
+			return 1;
+		}
+		if(distintos > 0)
+		{
+			cerr << "rasterizar - " << distintos << " píxeles distintos de la referencia " << referencia << endl;
+			return 1;
+		}
+		cout << "Igual que la referencia " << referencia << endl;
+	}
+	return 0;
+}